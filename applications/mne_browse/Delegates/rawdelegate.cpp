@@ -51,6 +51,14 @@
 #include <QBrush>
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <limits>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -134,11 +142,28 @@ void RawDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, c
 
         const RawModel* t_rawModel = (static_cast<const RawModel*>(index.model()));
 
-        QPainterPath path(QPointF(option.rect.x()+t_rawModel->relFiffCursor()-1,option.rect.y()));
+        //zoomed out only the visible pixel columns are drawn
+        bool bZoomedOut = t_rawModel->samplesPerPixel() > 1;
+        int pixelFrom = qMax(option.rect.x(), 0) - option.rect.x();
+        int pixelTo = qMin(option.rect.x()+option.rect.width(), m_pRawView->viewport()->width()) - option.rect.x();
+
+        if(bZoomedOut && pixelTo <= pixelFrom) {
+            painter->restore();
+            break;
+        }
+
+        QPainterPath path;
+        if(bZoomedOut)
+            path = QPainterPath(QPointF(option.rect.x()+pixelFrom,option.rect.y()));
+        else
+            path = QPainterPath(QPointF(option.rect.x()+t_rawModel->relFiffCursor()-1,option.rect.y()));
 
         //Plot grid
         painter->setRenderHint(QPainter::Antialiasing, false);
-        createGridPath(path,option,listPairs);
+        if(bZoomedOut)
+            createGridPath(path,option,pixelTo-pixelFrom);
+        else if(!listPairs.empty())
+            createGridPath(path,option,listPairs[0].second*listPairs.size()*m_dDx);
 
         painter->save();
         QPen pen;
@@ -149,8 +174,14 @@ void RawDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, c
         painter->restore();
 
         //Plot data path
-        path = QPainterPath(QPointF(option.rect.x()+t_rawModel->relFiffCursor(), option.rect.y()));
-        createPlotPath(index, option, path, listPairs, channelMean);
+        if(bZoomedOut) {
+            path = QPainterPath(QPointF(option.rect.x()+pixelFrom, option.rect.y()));
+            createOverviewPath(index, option, path, listPairs, pixelFrom, pixelTo, channelMean);
+        }
+        else {
+            path = QPainterPath(QPointF(option.rect.x()+t_rawModel->relFiffCursor(), option.rect.y()));
+            createPlotPath(index, option, path, listPairs, channelMean);
+        }
 
         if(option.state & QStyle::State_Selected) {
             pen.setStyle(Qt::SolidLine);
@@ -190,7 +221,7 @@ QSize RawDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelInde
         QList<RowVectorPair> listPairs = index.model()->data(index).value<QList<RowVectorPair> >();
         qint32 nsamples = (static_cast<const RawModel*>(index.model()))->lastSample()-(static_cast<const RawModel*>(index.model()))->firstSample();
 
-        size = QSize(nsamples*m_dDx,option.rect.height());
+        size = QSize(nsamples*m_dDx/(static_cast<const RawModel*>(index.model()))->samplesPerPixel(),option.rect.height());
         break;
     }
 
@@ -220,7 +251,7 @@ void RawDelegate::setScaleMap(const QMap<QString,double> &scaleMap)
 
 //*************************************************************************************************************
 
-void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, double channelMean) const
+double RawDelegate::channelMaxValue(const QModelIndex &index) const
 {
     //get maximum range of respective channel type (range value in FiffChInfo does not seem to contain a reasonable value)
     qint32 kind = (static_cast<const RawModel*>(index.model()))->m_chInfolist[index.row()].kind;
@@ -258,6 +289,16 @@ void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionVie
     }
     }
 
+    return dMaxValue;
+}
+
+
+//*************************************************************************************************************
+
+void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, double channelMean) const
+{
+    double dMaxValue = channelMaxValue(index);
+
     double dValue;
     double dScaleY = option.rect.height()/(2*dMaxValue);
 
@@ -291,13 +332,86 @@ void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionVie
 
 //*************************************************************************************************************
 
-void RawDelegate::createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, QList<RowVectorPair>& listPairs) const
+void RawDelegate::createOverviewPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, int pixelFrom, int pixelTo, double channelMean) const
+{
+    const RawModel* t_rawModel = static_cast<const RawModel*>(index.model());
+
+    int spp = t_rawModel->samplesPerPixel();
+    int numBins = pixelTo - pixelFrom;
+    qint32 from = pixelFrom*spp;
+    qint32 to = pixelTo*spp;
+
+    //samples [from,to) relative to the first sample of the fiff file
+    qint32 loadedFrom = t_rawModel->relFiffCursor();
+    qint32 loadedTo = loadedFrom;
+    for(int i = 0; i < listPairs.size(); ++i)
+        loadedTo += listPairs[i].second;
+
+    VectorXf vecMin, vecMax;
+    int numValid = 0;
+
+    if(from >= loadedFrom && to <= loadedTo) {
+        //the loaded windows cover the visible range and hold the filtered data
+        vecMin.resize(numBins);
+        vecMax.resize(numBins);
+
+        int iPair = 0;
+        qint32 pairStart = loadedFrom;
+
+        for(int b = 0; b < numBins; ++b) {
+            float fMin = std::numeric_limits<float>::max();
+            float fMax = -std::numeric_limits<float>::max();
+
+            for(qint32 s = from + b*spp; s < from + (b+1)*spp; ++s) {
+                while(s >= pairStart + listPairs[iPair].second) {
+                    pairStart += listPairs[iPair].second;
+                    ++iPair;
+                }
+
+                float val = (float)*(listPairs[iPair].first + s - pairStart);
+                fMin = qMin(fMin, val);
+                fMax = qMax(fMax, val);
+            }
+
+            vecMin[b] = fMin;
+            vecMax[b] = fMax;
+        }
+
+        numValid = numBins;
+    }
+    else {
+        numValid = t_rawModel->overviewData(index.row(), from, to, numBins, vecMin, vecMax);
+    }
+
+    double dScaleY = option.rect.height()/(2*channelMaxValue(index));
+    double y_base = -path.currentPosition().y();
+    double x = path.currentPosition().x();
+
+    //one vertical line per pixel column, stretched to the previous column so the envelope has no gaps
+    for(int b = 0; b < numValid; ++b) {
+        double dLow = vecMin[b];
+        double dHigh = vecMax[b];
+
+        if(b > 0) {
+            dLow = qMin(dLow, (double)vecMax[b-1]);
+            dHigh = qMax(dHigh, (double)vecMin[b-1]);
+        }
+
+        path.moveTo(x + b, -(y_base + (dHigh - channelMean)*dScaleY));
+        path.lineTo(x + b, -(y_base + (dLow - channelMean)*dScaleY));
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RawDelegate::createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, double width) const
 {
     //horizontal lines
     double distance = double(option.rect.height()) / m_nhlines;
 
     QPointF startpos = path.currentPosition();
-    QPointF endpoint(path.currentPosition().x()+listPairs[0].second*listPairs.size()*m_dDx,path.currentPosition().y());
+    QPointF endpoint(path.currentPosition().x()+width,path.currentPosition().y());
 
     for(qint8 i=0; i < m_nhlines-1; ++i) {
         endpoint.setY(endpoint.y()+distance);
@@ -318,6 +432,13 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
     qint32 sampleRangeLow = rawModel->relFiffCursor();
     qint32 sampleRangeHigh = sampleRangeLow + rawModel->sizeOfPreloadedData();
 
+    //zoomed out the events of the whole file are placed on their pixel column
+    int spp = rawModel->samplesPerPixel();
+    if(spp > 1) {
+        sampleRangeLow = 0;
+        sampleRangeHigh = rawModel->lastSample() - rawModel->firstSample();
+    }
+
     QPen pen;
     pen.setWidth(EVENT_MARKER_WIDTH);
 
@@ -340,7 +461,7 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
                 painter->setPen(pen);
 
                 //Draw line from sample position (x) and highest to lowest y position of the column widget - Add -m_qSettings.value("EventDesignParameters/event_marker_width").toInt() to avoid painting ovre the edge of the column widget
-                painter->drawLine(option.rect.x() + sampleValue, option.rect.y(), option.rect.x() + sampleValue, option.rect.y() + option.rect.height() - EVENT_MARKER_WIDTH);
+                painter->drawLine(option.rect.x() + sampleValue/spp, option.rect.y(), option.rect.x() + sampleValue/spp, option.rect.y() + option.rect.height() - EVENT_MARKER_WIDTH);
             } // END for statement
         } // END if statement event in data range
     } // END if statement plot all
@@ -365,7 +486,7 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
                 painter->setPen(pen);
 
                 //Draw line from sample position (x) and highest to lowest y position of the column widget - Add +m_qSettings.value("EventDesignParameters/event_marker_width").toInt() to avoid painting ovre the edge of the column widget
-                painter->drawLine(option.rect.x() + sampleValue, option.rect.y(), option.rect.x() + sampleValue, option.rect.y() - option.rect.height() + EVENT_MARKER_WIDTH);
+                painter->drawLine(option.rect.x() + sampleValue/spp, option.rect.y(), option.rect.x() + sampleValue/spp, option.rect.y() - option.rect.height() + EVENT_MARKER_WIDTH);
             } // END for statement
         } // END if statement
     } // END else statement
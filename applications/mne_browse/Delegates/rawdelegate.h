@@ -175,14 +175,38 @@ private:
     */
     void createPlotPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, double channelMean) const;
 
+    //=========================================================================================================
+    /**
+    * createOverviewPath creates the QPointer path for the zoomed out data plot. Only the visible pixel columns are
+    * drawn as vertical min/max lines. They are computed from the loaded windows when these cover the visible range,
+    * otherwise they are taken from the overview of the model.
+    *
+    * @param[in] index QModelIndex for accessing associated data and model object.
+    * @param[in,out] path The QPointerPath to create for the data plot.
+    * @param[in] listPairs the loaded windows of the channel.
+    * @param[in] pixelFrom the first visible pixel column of the plot.
+    * @param[in] pixelTo the pixel column after the last visible one.
+    * @param[in] channelMean the mean which is subtracted.
+    */
+    void createOverviewPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, int pixelFrom, int pixelTo, double channelMean) const;
+
     //=========================================================================================================
     /**
     * createGridPath Creates the QPointer path for the grid plot.
     *
     * @param[in,out] path The row vector of the data matrix <1 x nsamples>.
-    * @param[in] data The row vector of the data matrix <1 x nsamples>.
+    * @param[in] width The width of the grid in pixels.
+    */
+    void createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, double width) const;
+
+    //=========================================================================================================
+    /**
+    * channelMaxValue returns the maximum range of the channel type, which is mapped to half of the plot height.
+    *
+    * @param[in] index QModelIndex for accessing associated data and model object.
+    * @return the maximum value of the channel.
     */
-    void createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, QList<RowVectorPair>& listPairs) const;
+    double channelMaxValue(const QModelIndex &index) const;
 
     //=========================================================================================================
     /**
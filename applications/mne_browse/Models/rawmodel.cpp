@@ -43,6 +43,16 @@
 #include "rawmodel.h"
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDateTime>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // Eigen INCLUDES
@@ -80,11 +90,15 @@ RawModel::RawModel(QObject *parent)
 , m_bReloadBefore(0)
 , m_iAbsFiffCursor(0)
 , m_iCurAbsScrollPos(0)
+, m_iSamplesPerPixel(1)
+, m_iTileGeneration(0)
+, m_iPrefetchStart(0)
 {
     m_iWindowSize = MODEL_WINDOW_SIZE;
     m_reloadPos = MODEL_RELOAD_POS;
     m_maxWindows = MODEL_MAX_WINDOWS;
     m_iFilterTaps = MODEL_NUM_FILTER_TAPS;
+    m_qCacheTiles.setMaxCost(MODEL_TILE_CACHE_SIZE);
 
     //Set default sampling freq to 1024
     m_pFiffInfo->sfreq = 1024;
@@ -112,6 +126,13 @@ RawModel::RawModel(QObject *parent)
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::progressValueChanged,[this](int progressValue){
 //        qDebug() << "RawModel: ProgressValue m_operatorFutureWatcher, " << progressValue << " items processed out of" << m_listTmpChData.size();
 //    });
+
+    //connect prefetching of the next window - the prefetched window is kept in the tile cache
+    connect(&m_prefetchFutureWatcher,&QFutureWatcher<QSharedPointer<DataPackage> >::finished,[this](){
+        QSharedPointer<DataPackage> dataPackage = m_prefetchFutureWatcher.future().result();
+        if(dataPackage && m_sPrefetchKey == tileKey(m_iPrefetchStart))
+            parkWindow(dataPackage, m_iPrefetchStart);
+    });
 }
 
 
@@ -127,11 +148,15 @@ RawModel::RawModel(QFile &qFile, QObject *parent)
 , m_pFiffInfo(new FiffInfo())
 , m_pfiffIO(QSharedPointer<FiffIO>(new FiffIO()))
 , m_filterChType("All")
+, m_iSamplesPerPixel(1)
+, m_iTileGeneration(0)
+, m_iPrefetchStart(0)
 {
     m_iWindowSize = MODEL_WINDOW_SIZE;
     m_reloadPos = MODEL_RELOAD_POS;
     m_maxWindows = MODEL_MAX_WINDOWS;
     m_iFilterTaps = MODEL_NUM_FILTER_TAPS;
+    m_qCacheTiles.setMaxCost(MODEL_TILE_CACHE_SIZE);
 
     //read fiff data
     loadFiffData(&qFile);
@@ -158,6 +183,22 @@ RawModel::RawModel(QFile &qFile, QObject *parent)
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::progressValueChanged,[this](int progressValue){
 //        qDebug() << "RawModel: ProgressValue m_operatorFutureWatcher, " << progressValue << " items processed out of" << m_listTmpChData.size();
 //    });
+
+    //connect prefetching of the next window - the prefetched window is kept in the tile cache
+    connect(&m_prefetchFutureWatcher,&QFutureWatcher<QSharedPointer<DataPackage> >::finished,[this](){
+        QSharedPointer<DataPackage> dataPackage = m_prefetchFutureWatcher.future().result();
+        if(dataPackage && m_sPrefetchKey == tileKey(m_iPrefetchStart))
+            parkWindow(dataPackage, m_iPrefetchStart);
+    });
+}
+
+
+//*************************************************************************************************************
+
+RawModel::~RawModel()
+{
+    stopOverview();
+    m_prefetchFutureWatcher.waitForFinished();
 }
 
 
@@ -382,6 +423,7 @@ bool RawModel::loadFiffData(QFile* qFile)
     QSharedPointer<DataPackage> newDataPackage;
 
     m_pfiffIO = QSharedPointer<FiffIO>(new FiffIO(*qFile));
+    m_sFileName = QFileInfo(*qFile).absoluteFilePath();
     if(!m_pfiffIO->m_qlistRaw.empty()) {
         m_iAbsFiffCursor = m_pfiffIO->m_qlistRaw[0]->first_samp; //Set cursor somewhere into fiff file [in samples]
         m_iCurAbsScrollPos = 0;
@@ -414,6 +456,8 @@ bool RawModel::loadFiffData(QFile* qFile)
 
     qFile->close();
 
+    startOverview();
+
     emit fileLoaded(m_pFiffInfo);
     emit assignedOperatorsChanged(m_assignedOperators);
 
@@ -478,6 +522,27 @@ bool RawModel::writeFiffData(QIODevice *p_IODevice)
 }
 
 
+//*************************************************************************************************************
+
+void RawModel::setSamplesPerPixel(int iSamplesPerPixel)
+{
+    m_iSamplesPerPixel = qMax(1, iSamplesPerPixel);
+
+    emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
+}
+
+
+//*************************************************************************************************************
+
+int RawModel::overviewData(int row, qint32 from, qint32 to, int numBins, VectorXf &vecMin, VectorXf &vecMax) const
+{
+    if(!m_pOverview)
+        return 0;
+
+    return m_pOverview->summary(row, from, to, numBins, vecMin, vecMax);
+}
+
+
 //*************************************************************************************************************
 //non-virtual functions
 //private
@@ -496,6 +561,11 @@ void RawModel::loadFiffInfos()
 
 void RawModel::clearModel()
 {
+    //Background reading of the overview and the next window
+    stopOverview();
+    m_prefetchFutureWatcher.waitForFinished();
+    m_qCacheTiles.clear();
+
     //FiffIO object
     m_pfiffIO.clear();
     m_chInfolist.clear();
@@ -522,6 +592,11 @@ void RawModel::resetPosition(qint32 position)
 {
     beginResetModel();
 
+    //keep the loaded windows in the tile cache, they are likely to be visited again
+    if(!m_bProcessing)
+        for(int i = 0; i < m_data.size(); ++i)
+            parkWindow(m_data[i], m_iAbsFiffCursor + i*m_iWindowSize);
+
     //reset members
     m_data.clear();
 
@@ -536,32 +611,39 @@ void RawModel::resetPosition(qint32 position)
 
     m_iAbsFiffCursor = firstSample() + mult*m_iWindowSize;
 
-    MatrixXd t_data,t_times; //type is later on (when append to m_data) casted into MatrixXdR (Row-Major)
+    //take the window from the tile cache, it is already processed with the current operators
+    QSharedPointer<DataPackage> newDataPackage = takeWindow(m_iAbsFiffCursor);
 
-    int start = m_iAbsFiffCursor;
-    int end = start + m_iWindowSize - 1;
+    if(newDataPackage) {
+        m_data.append(newDataPackage);
+    }
+    else {
+        MatrixXd t_data,t_times; //type is later on (when append to m_data) casted into MatrixXdR (Row-Major)
 
-    m_Mutex.lock();
-    if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(t_data, t_times, start, end))
-        qDebug() << "RawModel: Error resetting position of Fiff file!";
-    m_Mutex.unlock();
+        int start = m_iAbsFiffCursor;
+        int end = start + m_iWindowSize - 1;
 
-    //build data package
-    QSharedPointer<DataPackage> newDataPackage;
-    newDataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)t_data, (MatrixXdR)t_times));
+        m_Mutex.lock();
+        if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(t_data, t_times, start, end))
+            qDebug() << "RawModel: Error resetting position of Fiff file!";
+        m_Mutex.unlock();
 
-    //append loaded block
-    m_data.append(newDataPackage);
+        //build data package
+        newDataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)t_data, (MatrixXdR)t_times));
 
-    if(!m_assignedOperators.empty())
-        updateOperators();
+        //append loaded block
+        m_data.append(newDataPackage);
+
+        if(!m_assignedOperators.empty())
+            updateOperators();
+    }
 
     endResetModel();
 
 //    if(!(m_iAbsFiffCursor<=firstSample()))
 //        updateScrollPos(m_iCurAbsScrollPos-firstSample()); //little hack: if the m_iCurAbsScrollPos is now close to the edge -> force reloading w/o scrolling
 
-    qDebug() << "RawModel: Model Position RESET, samples from " << m_iAbsFiffCursor << "to" << m_iAbsFiffCursor+m_iWindowSize-1 << "reloaded. actual loaded t_data cols: " << t_data.cols();
+    qDebug() << "RawModel: Model Position RESET, samples from " << m_iAbsFiffCursor << "to" << m_iAbsFiffCursor+m_iWindowSize-1 << "reloaded. actual loaded t_data cols: " << newDataPackage->dataRaw().cols();
 
     emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size(),1));
 }
@@ -607,6 +689,23 @@ void RawModel::reloadFiffData(bool before)
         }
     }
 
+    //take the window from the tile cache if it was visited or prefetched before
+    QSharedPointer<DataPackage> cachedDataPackage = m_bProcessing ? QSharedPointer<DataPackage>() : takeWindow(start);
+
+    if(cachedDataPackage) {
+        insertDataPackage(cachedDataPackage);
+
+        if(!m_assignedOperators.empty())
+            performOverlapAdd();
+
+        emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
+
+        prefetchFiffData(before);
+
+        qDebug() << "RawModel: Fiff data taken from the tile cache, samples from" << start << "to" << end;
+        return;
+    }
+
     m_bReloading = true;
 
     //read data with respect to start and end point
@@ -626,24 +725,272 @@ QPair<MatrixXd,MatrixXd> RawModel::readSegment(fiff_int_t from, fiff_int_t to)
 {
     QPair<MatrixXd,MatrixXd> datatime;
 
-    m_Mutex.lock();
-    if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(datatime.first, datatime.second, from, to)) {
+    QMutexLocker locker(&m_Mutex);
+    if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(datatime.first, datatime.second, from, to))
         printf("RawModel: Error when reading raw data!");
-        return datatime;
-    }
-    m_Mutex.unlock();
 
     return datatime;
 }
 
 
+//*************************************************************************************************************
+
+void RawModel::insertDataPackage(QSharedPointer<DataPackage> dataPackage)
+{
+    //extend m_data with reloaded data
+    if(m_bReloadBefore) {
+        m_data.prepend(dataPackage);
+
+        //maintain at maximum m_maxWindows data windows and park the rest in the tile cache
+        if(m_data.size() > m_maxWindows) {
+            if(!m_bProcessing)
+                parkWindow(m_data.last(), m_iAbsFiffCursor + (m_data.size()-1)*m_iWindowSize);
+            m_data.removeLast();
+        }
+    }
+    else {
+        m_data.append(dataPackage);
+
+        //maintain at maximum m_maxWindows data windows and park the rest in the tile cache
+        if(m_data.size() > m_maxWindows) {
+            if(!m_bProcessing)
+                parkWindow(m_data.first(), m_iAbsFiffCursor);
+            m_data.removeFirst();
+            m_iAbsFiffCursor += m_iWindowSize;
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::parkWindow(QSharedPointer<DataPackage> dataPackage, fiff_int_t start)
+{
+    if(!dataPackage)
+        return;
+
+    //the cost is the memory of the package in MB
+    qint64 size = dataPackage->dataRawOrig().size() + dataPackage->dataRaw().size()
+                  + dataPackage->dataProcOrig().size() + dataPackage->dataProc().size();
+    int cost = qMax(1, (int)(size*sizeof(double)/(1024*1024)));
+
+    m_qCacheTiles.insert(tileKey(start), new QSharedPointer<DataPackage>(dataPackage), cost);
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<DataPackage> RawModel::takeWindow(fiff_int_t start)
+{
+    QSharedPointer<DataPackage>* pTile = m_qCacheTiles.take(tileKey(start));
+
+    if(!pTile)
+        return QSharedPointer<DataPackage>();
+
+    QSharedPointer<DataPackage> dataPackage = *pTile;
+    delete pTile;
+
+    return dataPackage;
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::invalidateTiles()
+{
+    //a running prefetch is dropped since its key refers to the old generation
+    ++m_iTileGeneration;
+    m_qCacheTiles.clear();
+
+    //the loaded windows must not be parked by resetPosition
+    m_data.clear();
+}
+
+
+//*************************************************************************************************************
+
+QString RawModel::tileKey(fiff_int_t start) const
+{
+    return QString("%1:%2:%3").arg(m_iTileGeneration).arg(start).arg(operatorChainKey());
+}
+
+
+//*************************************************************************************************************
+
+QString RawModel::operatorChainKey() const
+{
+    if(m_assignedOperators.empty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    QList<int> listFilteredChs = m_assignedOperators.uniqueKeys();
+    for(int i = 0; i < listFilteredChs.size(); ++i) {
+        hash.addData((const char*)&listFilteredChs[i], sizeof(int));
+
+        QList<QSharedPointer<MNEOperator> > ops = m_assignedOperators.values(listFilteredChs[i]);
+        for(int j = 0; j < ops.size(); ++j) {
+            hash.addData(ops[j]->m_sName.toUtf8());
+
+            //the user defined filter keeps its name when it is redesigned
+            if(ops[j]->m_OperatorType == MNEOperator::FILTER) {
+                QSharedPointer<FilterOperator> filter = ops[j].staticCast<FilterOperator>();
+                hash.addData((const char*)filter->m_dCoeffA.data(), filter->m_dCoeffA.size()*sizeof(double));
+            }
+        }
+    }
+
+    return QString(hash.result().toHex());
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::prefetchFiffData(bool before)
+{
+    //zoomed out the rows are drawn from the overview, no windows are needed
+    if(!m_bFileloaded || m_prefetchFutureWatcher.isRunning() || m_iSamplesPerPixel > 1)
+        return;
+
+    fiff_int_t start = before ? m_iAbsFiffCursor - m_iWindowSize : m_iAbsFiffCursor + sizeOfPreloadedData();
+
+    if(start < firstSample() || start > lastSample())
+        return;
+
+    fiff_int_t end = qMin(start + m_iWindowSize - 1, lastSample());
+
+    QString key = tileKey(start);
+    if(m_qCacheTiles.contains(key))
+        return;
+
+    m_iPrefetchStart = start;
+    m_sPrefetchKey = key;
+
+    QFuture<QSharedPointer<DataPackage> > future = QtConcurrent::run(this,&RawModel::prefetchSegment,start,end,m_assignedOperators);
+
+    m_prefetchFutureWatcher.setFuture(future);
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<DataPackage> RawModel::prefetchSegment(fiff_int_t from, fiff_int_t to, QMap<int,QSharedPointer<MNEOperator> > operators)
+{
+    QPair<MatrixXd,MatrixXd> datatime = readSegment(from, to);
+
+    if(datatime.first.cols() != to - from + 1)
+        return QSharedPointer<DataPackage>();
+
+    QSharedPointer<DataPackage> dataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)datatime.first, (MatrixXdR)datatime.second));
+
+    if(operators.empty())
+        return dataPackage;
+
+    //filter the window the same way updateOperatorsConcurrently does, this thread waits for the workers
+    QList<int> listFilteredChs = operators.uniqueKeys();
+    QList<QPair<int,RowVectorXd> > listChData;
+    for(qint32 i=0; i < listFilteredChs.size(); ++i)
+        listChData.append(QPair<int,RowVectorXd>(listFilteredChs[i],dataPackage->dataRawOrig().row(listFilteredChs[i])));
+
+    QtConcurrent::blockingMap(listChData,[&operators](QPair<int,RowVectorXd>& chdata) {
+        applyOperators(operators.values(chdata.first), chdata.second);
+    });
+
+    int dataLength = dataPackage->dataRaw().cols();
+    int cutFront = m_iCurrentFFTLength/4;
+    int cutBack = m_iCurrentFFTLength/4 + (listChData[0].second.cols()-m_iCurrentFFTLength/2-dataLength);
+
+    for(qint32 i=0; i < listChData.size(); ++i)
+        dataPackage->setOrigProcData(listChData[i].second, listChData[i].first, cutFront, cutBack);
+
+    return dataPackage;
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::startOverview()
+{
+    stopOverview();
+
+    if(!m_bFileloaded || !m_pfiffIO || m_pfiffIO->m_qlistRaw.empty())
+        return;
+
+    RawOverview::SPtr pOverview = RawOverview::SPtr(new RawOverview());
+    if(!pOverview->open(RawOverview::cacheFilePath(overviewKey()), m_chInfolist.size(), lastSample()-firstSample()+1)) {
+        qDebug() << "RawModel: Could not open the overview cache file.";
+        return;
+    }
+
+    m_pOverview = pOverview;
+
+    //repaint the zoomed out rows while the overview grows
+    connect(pOverview.data(), &RawOverview::progressChanged, this, [this](){
+        if(m_iSamplesPerPixel > 1)
+            emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
+    });
+
+    if(pOverview->isComplete()) {
+        qDebug() << "RawModel: Overview loaded from the cache.";
+        return;
+    }
+
+    //the overview is built from the unfiltered data in a background-thread, sharing the fiff stream via readSegment
+    fiff_int_t first = firstSample();
+    m_overviewFuture = QtConcurrent::run([this, pOverview, first]() {
+        return pOverview->build([this, first](qint32 from, qint32 to, MatrixXd &data) {
+            data = readSegment(first + from, first + to - 1).first;
+            return data.cols() == to - from;
+        });
+    });
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::stopOverview()
+{
+    if(m_pOverview)
+        m_pOverview->cancel();
+
+    m_overviewFuture.waitForFinished();
+    m_pOverview.clear();
+}
+
+
+//*************************************************************************************************************
+
+QByteArray RawModel::overviewKey() const
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    QFileInfo fileInfo(m_sFileName);
+    hash.addData(fileInfo.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(fileInfo.size()));
+    hash.addData(QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(firstSample()));
+    hash.addData(QByteArray::number(lastSample()));
+
+    //the data is read with the current compensator and projector
+    const FiffRawData &raw = *m_pfiffIO->m_qlistRaw[0];
+    hash.addData(QByteArray::number(raw.comp.kind));
+    hash.addData((const char*)raw.proj.data(), raw.proj.size()*sizeof(double));
+
+    return hash.result();
+}
+
+
 //*************************************************************************************************************
 //public SLOTS
 void RawModel::updateScrollPos(int value)
 {
-    m_iCurAbsScrollPos = firstSample() + value;
+    m_iCurAbsScrollPos = firstSample() + value*m_iSamplesPerPixel;
     qDebug() << "RawModel: absolute Fiff Scroll Cursor" << m_iCurAbsScrollPos << "(m_iAbsFiffCursor" << m_iAbsFiffCursor << ", sizeOfPreloadedData" << sizeOfPreloadedData() << ", firstSample()" << firstSample() << ")";
 
+    //zoomed out the rows are drawn from the overview, the loaded windows are kept until zooming in again
+    if(m_iSamplesPerPixel > 1)
+        return;
+
     //if a scroll position is selected, which is not within the loaded data range -> reset position of model
     if(m_iCurAbsScrollPos > (m_iAbsFiffCursor+sizeOfPreloadedData()+m_iWindowSize) || m_iCurAbsScrollPos < m_iAbsFiffCursor) {
         qDebug() << "RawModel: Reset position requested, m_iAbsFiffCursor:" << m_iAbsFiffCursor << "m_iCurAbsScrollPos:" << m_iCurAbsScrollPos;
@@ -772,24 +1119,31 @@ void RawModel::applyOperator(QModelIndexList chlist, const QSharedPointer<MNEOpe
 
 void RawModel::applyOperatorsConcurrently(QPair<int,RowVectorXd>& chdata) const
 {
-    QSharedPointer<FilterOperator> filter;
-
     //QList<int> listFilteredChs = m_assignedOperators.keys();
 
-    QList<QSharedPointer<MNEOperator> > ops = m_assignedOperators.values(chdata.first);
-    for(qint32 i=0; i < ops.size(); ++i) {
-        switch(ops[i]->m_OperatorType) {
+    applyOperators(m_assignedOperators.values(chdata.first), chdata.second);
+//    return chdata;
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::applyOperators(const QList<QSharedPointer<MNEOperator> > &operators, RowVectorXd &data)
+{
+    QSharedPointer<FilterOperator> filter;
+
+    for(qint32 i=0; i < operators.size(); ++i) {
+        switch(operators[i]->m_OperatorType) {
         case MNEOperator::FILTER: {
-            filter = ops[i].staticCast<FilterOperator>();
-            RowVectorXd tmp = filter->applyFFTFilter(chdata.second);
-            chdata.second = tmp;
+            filter = operators[i].staticCast<FilterOperator>();
+            RowVectorXd tmp = filter->applyFFTFilter(data);
+            data = tmp;
         }
         case MNEOperator::PCA: {
             //do something
         }
         }
     }
-//    return chdata;
 }
 
 
@@ -975,6 +1329,10 @@ void RawModel::updateProjections()
             m_pfiffIO->m_qlistRaw[0]->proj.resize(0,0);
         }
 
+        //the cached windows and the overview were read with the old projector
+        invalidateTiles();
+        startOverview();
+
         if(m_iCurAbsScrollPos == 0)
             resetPosition(m_iCurAbsScrollPos + firstSample());
         else
@@ -1008,6 +1366,10 @@ void RawModel::updateCompensator(int to)
         //set compensator for upcoming read raw segement calls
         m_pfiffIO->m_qlistRaw[0]->comp = newComp;
 
+        //the cached windows and the overview were read with the old compensator
+        invalidateTiles();
+        startOverview();
+
         if(m_iCurAbsScrollPos == 0)
             resetPosition(m_iCurAbsScrollPos + firstSample());
         else
@@ -1022,30 +1384,16 @@ void RawModel::insertReloadedData(QPair<MatrixXd,MatrixXd> dataTimesPair)
 {
     QSharedPointer<DataPackage> newDataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)dataTimesPair.first, (MatrixXdR)dataTimesPair.second));
 
-    //extend m_data with reloaded data
-    if(m_bReloadBefore) {
-        m_data.prepend(newDataPackage);
-
-        //maintain at maximum m_maxWindows data windows and drop the rest
-        if(m_data.size() > m_maxWindows) {
-            m_data.removeLast();
-        }
-    }
-    else {
-        m_data.append(newDataPackage);
-
-        //maintain at maximum m_maxWindows data windows and drop the rest
-        if(m_data.size() > m_maxWindows) {
-            m_data.removeFirst();
-            m_iAbsFiffCursor += m_iWindowSize;
-        }
-    }
+    insertDataPackage(newDataPackage);
 
     m_bReloading = false;
 
     emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
     emit dataReloaded();
 
+    //read the next window in scroll direction while the user looks at this one
+    prefetchFiffData(m_bReloadBefore);
+
     qDebug() << "RawModel: Fiff data Reloaded from " << dataTimesPair.second.coeff(0) << "secs to" << dataTimesPair.second.coeff(dataTimesPair.second.cols()-1) << "secs";
 }
 
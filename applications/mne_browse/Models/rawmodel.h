@@ -75,6 +75,7 @@
 #include "../Utils/filteroperator.h"
 #include "../Utils/rawsettings.h"
 #include "../Utils/datapackage.h"
+#include "../Utils/rawoverview.h"
 
 
 //*************************************************************************************************************
@@ -89,6 +90,7 @@
 #include <QPalette>
 #include <QtConcurrent>
 #include <QProgressDialog>
+#include <QCache>
 
 
 //*************************************************************************************************************
@@ -152,6 +154,12 @@ public:
     RawModel(QObject *parent);
     RawModel(QFile& qFile, QObject *parent);
 
+    //=========================================================================================================
+    /**
+    * Destructor, stops the building of the overview and waits for a running prefetch
+    */
+    ~RawModel();
+
     //=========================================================================================================
     /**
     * Reimplemented virtual functions
@@ -179,6 +187,30 @@ public:
     */
     bool writeFiffData(QIODevice *p_IODevice);
 
+    //=========================================================================================================
+    /**
+    * setSamplesPerPixel sets the zoom of the data plot. When more than one sample falls on a pixel the loaded windows
+    * are not reloaded anymore and the view draws the rows from the overview.
+    *
+    * @param iSamplesPerPixel number of samples per pixel (1 = full resolution)
+    */
+    void setSamplesPerPixel(int iSamplesPerPixel);
+
+    //=========================================================================================================
+    /**
+    * overviewData summarizes the samples [from,to) of a channel from the multi-resolution overview of the whole file.
+    * The overview holds the unfiltered data, it is built in a background-thread after a file was loaded.
+    *
+    * @param row the channel index
+    * @param from the first sample relative to the first sample of the fiff file
+    * @param to the sample after the last one relative to the first sample of the fiff file
+    * @param numBins number of bins, i.e. pixels
+    * @param[out] vecMin the minimum of each bin
+    * @param[out] vecMax the maximum of each bin
+    * @return the number of leading bins which are available
+    */
+    int overviewData(int row, qint32 from, qint32 to, int numBins, VectorXf &vecMin, VectorXf &vecMax) const;
+
     //VARIABLES
     bool                                        m_bFileloaded;  /**< true when a Fiff file is loaded */
     QList<FiffChInfo>                           m_chInfolist;   /**< List of FiffChInfo objects that holds the corresponding channels information */
@@ -232,6 +264,104 @@ private:
     */
     QPair<MatrixXd,MatrixXd> readSegment(fiff_int_t from, fiff_int_t to);
 
+    //=========================================================================================================
+    /**
+    * insertDataPackage prepends (m_bReloadBefore = true) or appends a data window to m_data. The window which
+    * drops out of m_data is parked in the tile cache.
+    *
+    * @param dataPackage the window to insert
+    */
+    void insertDataPackage(QSharedPointer<DataPackage> dataPackage);
+
+    //=========================================================================================================
+    /**
+    * parkWindow stores a data window which is dropped from m_data in the tile cache
+    *
+    * @param dataPackage the data window
+    * @param start the first sample of the window
+    */
+    void parkWindow(QSharedPointer<DataPackage> dataPackage, fiff_int_t start);
+
+    //=========================================================================================================
+    /**
+    * takeWindow removes a data window from the tile cache if it was cached with the current operators
+    *
+    * @param start the first sample of the window
+    * @return the data window or a null pointer
+    */
+    QSharedPointer<DataPackage> takeWindow(fiff_int_t start);
+
+    //=========================================================================================================
+    /**
+    * invalidateTiles drops all cached and loaded data windows, e.g. because a new projector or compensator is read
+    */
+    void invalidateTiles();
+
+    //=========================================================================================================
+    /**
+    * tileKey returns the key of a data window in the tile cache
+    *
+    * @param start the first sample of the window
+    * @return the key, made of the start sample and the chain of the assigned operators
+    */
+    QString tileKey(fiff_int_t start) const;
+
+    //=========================================================================================================
+    /**
+    * operatorChainKey returns a hash of the operators assigned to the channels, including the filter coefficients
+    *
+    * @return the hash (empty when no operators are assigned)
+    */
+    QString operatorChainKey() const;
+
+    //=========================================================================================================
+    /**
+    * prefetchFiffData loads the next window in scroll direction into the tile cache in a background-thread
+    *
+    * @param before true to prefetch the window before the loaded data, false for the window after it
+    */
+    void prefetchFiffData(bool before);
+
+    //=========================================================================================================
+    /**
+    * prefetchSegment reads a segment of the fiff file and applies the given operators (runs in a background-thread)
+    *
+    * @param from the start point to read from the file
+    * @param to the end point to read from the file
+    * @param operators the operators assigned to the channels
+    * @return the data window
+    */
+    QSharedPointer<DataPackage> prefetchSegment(fiff_int_t from, fiff_int_t to, QMap<int,QSharedPointer<MNEOperator> > operators);
+
+    //=========================================================================================================
+    /**
+    * startOverview opens the overview of the loaded file and builds it in a background-thread if it is not cached yet
+    */
+    void startOverview();
+
+    //=========================================================================================================
+    /**
+    * stopOverview cancels the building of the overview and releases it
+    */
+    void stopOverview();
+
+    //=========================================================================================================
+    /**
+    * overviewKey identifies the loaded file and the projector and compensator used for reading
+    *
+    * @return the key of the overview cache file
+    */
+    QByteArray overviewKey() const;
+
+    //=========================================================================================================
+    /**
+    * applyOperators applies a list of MNEOperators to a RowVectorXd and modifies it in-place
+    *
+    * @param operators the operators to apply
+    * @param data[in,out] the channel data
+    */
+    static void applyOperators(const QList<QSharedPointer<MNEOperator> > &operators, RowVectorXd &data);
+
     //VARIABLES
     //Reload control
     bool                                    m_bStartReached;            /**< signals, whether the start of the fiff data file is reached. */
@@ -265,6 +395,19 @@ private:
     qint8                                   m_maxWindows;               /**< number of windows that are at maximum remained in m_data. */
     qint16                                  m_iFilterTaps;              /**< Number of Filter taps */
     int                                     m_iCurrentFFTLength;        /**< Currently used fft length */
+    int                                     m_iSamplesPerPixel;         /**< Zoom of the data plot [in samples per pixel]. */
+
+    //Tile cache and prefetching
+    QCache<QString,QSharedPointer<DataPackage> > m_qCacheTiles;         /**< Data windows which were dropped from m_data or prefetched, keyed by tileKey(). */
+    int                                     m_iTileGeneration;          /**< Incremented whenever the cached windows become invalid. */
+    QFutureWatcher<QSharedPointer<DataPackage> > m_prefetchFutureWatcher; /**< QFutureWatcher for watching process of prefetching the next window. */
+    fiff_int_t                              m_iPrefetchStart;           /**< First sample of the window which is prefetched. */
+    QString                                 m_sPrefetchKey;             /**< Tile key of the prefetched window at the time the prefetch was started. */
+
+    //Overview
+    QString                                 m_sFileName;                /**< Absolute path of the loaded fiff file. */
+    RawOverview::SPtr                       m_pOverview;                /**< Multi-resolution min/max summary of the whole file. */
+    QFuture<bool>                           m_overviewFuture;           /**< QFuture of building the overview. */
 
 signals:
     //=========================================================================================================
@@ -511,6 +654,14 @@ public:
     * @return the absolute cursor in the fiff file
     */
     inline qint32 absFiffCursor() const;
+
+    //=========================================================================================================
+    /**
+    * samplesPerPixel
+    *
+    * @return the zoom of the data plot [in samples per pixel]
+    */
+    inline int samplesPerPixel() const;
 };
 
 //*************************************************************************************************************
@@ -566,6 +717,13 @@ inline qint32 RawModel::absFiffCursor() const {
     return m_iAbsFiffCursor;
 }
 
+
+//*************************************************************************************************************
+
+inline int RawModel::samplesPerPixel() const {
+    return m_iSamplesPerPixel;
+}
+
 } // NAMESPACE
 
 #endif // RAWMODEL_H
@@ -0,0 +1,430 @@
+//=============================================================================================================
+/**
+* @file     rawoverview.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the implementation of the RawOverview class.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rawoverview.h"
+
+#include <string.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNEBROWSE;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define OVERVIEW_FILE_VERSION 2     //version of the cache file layout
+#define OVERVIEW_DATA_OFFSET 64     //offset of the summary data in the cache file [in bytes]
+
+namespace {
+
+struct OverviewHeader {
+    char    magic[4];               /**< Always "MNEO". */
+    qint32  iVersion;               /**< Version of the cache file layout. */
+    qint32  iNumChannels;           /**< Number of channels. */
+    qint32  iNumSamples;            /**< Number of samples. */
+    qint32  iBucketSize;            /**< Bucket size of the finest level. */
+    qint32  iLevelFactor;           /**< Number of buckets combined into one bucket of the next level. */
+    qint32  iNumLevels;             /**< Number of levels. */
+    qint32  iComplete;              /**< 1 when all levels were built. */
+};
+
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RawOverview::RawOverview(QObject *parent)
+: QObject(parent)
+, m_pMapped(Q_NULLPTR)
+, m_pData(Q_NULLPTR)
+, m_iNumChannels(0)
+, m_iNumSamples(0)
+, m_iSamplesDone(0)
+, m_iCancel(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+RawOverview::~RawOverview()
+{
+    if(m_pMapped)
+        m_file.unmap(m_pMapped);
+
+    m_file.close();
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverview::open(const QString &sFileName, qint32 iNumChannels, qint32 iNumSamples)
+{
+    if(m_pMapped)
+        m_file.unmap(m_pMapped);
+    m_file.close();
+
+    m_pMapped = Q_NULLPTR;
+    m_pData = Q_NULLPTR;
+    m_iSamplesDone.storeRelease(0);
+
+    if(iNumChannels <= 0 || iNumSamples <= 0)
+        return false;
+
+    m_iNumChannels = iNumChannels;
+    m_iNumSamples = iNumSamples;
+
+    //Add levels until the coarsest one is short enough to be drawn at once
+    m_vecNumBuckets.clear();
+    m_vecLevelOffset.clear();
+
+    qint64 offset = 0;
+    for(int level = 0; ; ++level) {
+        qint32 size = bucketSize(level);
+        qint32 numBuckets = (iNumSamples + size - 1) / size;
+
+        m_vecNumBuckets.append(numBuckets);
+        m_vecLevelOffset.append(offset);
+        offset += 2 * (qint64)iNumChannels * numBuckets;
+
+        if(numBuckets <= MODEL_OVERVIEW_MIN_BUCKETS)
+            break;
+    }
+
+    m_vecLevelDone.fill(0, m_vecNumBuckets.size());
+
+    qint64 iFileSize = OVERVIEW_DATA_OFFSET + offset * (qint64)sizeof(float);
+
+    OverviewHeader header;
+    memset(&header, 0, sizeof(OverviewHeader));
+    memcpy(header.magic, "MNEO", 4);
+    header.iVersion = OVERVIEW_FILE_VERSION;
+    header.iNumChannels = iNumChannels;
+    header.iNumSamples = iNumSamples;
+    header.iBucketSize = MODEL_OVERVIEW_BUCKET_SIZE;
+    header.iLevelFactor = MODEL_OVERVIEW_LEVEL_FACTOR;
+    header.iNumLevels = m_vecNumBuckets.size();
+    header.iComplete = 1;
+
+    m_file.setFileName(sFileName);
+
+    //Reuse a complete cache file, rewriting the header updates the modification time used by cleanCache()
+    if(m_file.exists() && m_file.size() == iFileSize && m_file.open(QIODevice::ReadWrite)) {
+        OverviewHeader fileHeader;
+        if(m_file.read((char*)&fileHeader, sizeof(OverviewHeader)) == sizeof(OverviewHeader)
+                && memcmp(&fileHeader, &header, sizeof(OverviewHeader)) == 0
+                && m_file.seek(0) && m_file.write((const char*)&header, sizeof(OverviewHeader)) == sizeof(OverviewHeader)
+                && m_file.flush()) {
+            m_pMapped = m_file.map(0, iFileSize);
+
+            if(m_pMapped) {
+                m_pData = (float*)(m_pMapped + OVERVIEW_DATA_OFFSET);
+                m_vecLevelDone = m_vecNumBuckets;
+                m_iSamplesDone.storeRelease(m_iNumSamples);
+
+                qDebug() << "RawOverview: Reusing overview" << sFileName;
+                return true;
+            }
+        }
+
+        m_file.close();
+    }
+
+    //(Re-)create the cache file, it is marked as complete at the end of build()
+    header.iComplete = 0;
+
+    cleanCache(QFileInfo(sFileName).absolutePath(), (qint64)MODEL_OVERVIEW_CACHE_SIZE * 1024 * 1024 - iFileSize, sFileName);
+
+    if(!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !m_file.resize(iFileSize)
+            || m_file.write((const char*)&header, sizeof(OverviewHeader)) != sizeof(OverviewHeader)) {
+        qDebug() << "RawOverview: Could not create overview" << sFileName << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_pMapped = m_file.map(0, iFileSize);
+
+    if(!m_pMapped) {
+        qDebug() << "RawOverview: Could not map overview" << sFileName << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_pData = (float*)(m_pMapped + OVERVIEW_DATA_OFFSET);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverview::build(const ReadFunction &readFunction)
+{
+    if(!m_pData)
+        return false;
+
+    if(isComplete())
+        return true;
+
+    qint32 iBucket = MODEL_OVERVIEW_BUCKET_SIZE;
+    qint32 iLastPercent = 0;
+    MatrixXd matData;
+
+    for(qint32 from = 0; from < m_iNumSamples; from += MODEL_OVERVIEW_CHUNK_SIZE) {
+        if(m_iCancel.loadAcquire())
+            return false;
+
+        qint32 to = qMin(from + MODEL_OVERVIEW_CHUNK_SIZE, m_iNumSamples);
+
+        if(!readFunction(from, to, matData) || matData.rows() < m_iNumChannels || matData.cols() < to - from) {
+            qDebug() << "RawOverview: Error reading samples" << from << "to" << to;
+            return false;
+        }
+
+        //Finest level, the chunks start at bucket boundaries
+        qint32 k0 = from / iBucket;
+        qint32 k1 = (to + iBucket - 1) / iBucket;
+
+        for(int row = 0; row < m_iNumChannels; ++row) {
+            float* pMin = levelRow(0, row, 0);
+            float* pMax = levelRow(0, row, 1);
+
+            for(qint32 k = k0; k < k1; ++k) {
+                qint32 start = k * iBucket - from;
+                qint32 n = qMin(iBucket, to - k * iBucket);
+
+                pMin[k] = (float)matData.row(row).segment(start, n).minCoeff();
+                pMax[k] = (float)matData.row(row).segment(start, n).maxCoeff();
+            }
+        }
+
+        m_vecLevelDone[0] = k1;
+
+        //Coarser levels, as far as the buckets of the level below are complete
+        for(int level = 1; level < m_vecNumBuckets.size(); ++level) {
+            if(to == m_iNumSamples)
+                updateLevel(level, m_vecNumBuckets[level]);
+            else
+                updateLevel(level, m_vecLevelDone[level-1] / MODEL_OVERVIEW_LEVEL_FACTOR);
+        }
+
+        m_iSamplesDone.storeRelease(to);
+
+        qint32 iPercent = (qint32)(100 * (qint64)to / m_iNumSamples);
+        if(iPercent != iLastPercent) {
+            iLastPercent = iPercent;
+            emit progressChanged(to);
+        }
+    }
+
+    reinterpret_cast<OverviewHeader*>(m_pMapped)->iComplete = 1;
+
+    qDebug() << "RawOverview: Overview of" << m_iNumSamples << "samples built in" << m_vecNumBuckets.size() << "levels.";
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void RawOverview::cancel()
+{
+    m_iCancel.storeRelease(1);
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverview::isComplete() const
+{
+    return m_pData && m_iSamplesDone.loadAcquire() >= m_iNumSamples;
+}
+
+
+//*************************************************************************************************************
+
+qint32 RawOverview::samplesDone() const
+{
+    return m_iSamplesDone.loadAcquire();
+}
+
+
+//*************************************************************************************************************
+
+int RawOverview::summary(int row, qint32 from, qint32 to, int numBins, VectorXf &vecMin, VectorXf &vecMax) const
+{
+    if(!m_pData || row < 0 || row >= m_iNumChannels || numBins <= 0 || from < 0 || to <= from)
+        return 0;
+
+    vecMin.resize(numBins);
+    vecMax.resize(numBins);
+
+    double dSamplesPerBin = double(to - from) / numBins;
+
+    //Coarsest level whose buckets still fit into a bin
+    int level = 0;
+    while(level + 1 < m_vecNumBuckets.size() && bucketSize(level + 1) <= dSamplesPerBin)
+        ++level;
+
+    qint32 iBucket = bucketSize(level);
+    qint32 iNumBuckets = m_vecNumBuckets[level];
+    qint32 iDone = m_iSamplesDone.loadAcquire();
+    qint32 iAvailable = iDone >= m_iNumSamples ? iNumBuckets : iDone / iBucket;
+
+    const float* pMin = levelRow(level, row, 0);
+    const float* pMax = levelRow(level, row, 1);
+
+    int bin = 0;
+    for(; bin < numBins; ++bin) {
+        qint64 s0 = from + (qint64)(bin * dSamplesPerBin);
+        qint64 s1 = from + (qint64)((bin + 1) * dSamplesPerBin);
+
+        qint32 k0 = (qint32)(s0 / iBucket);
+        qint32 k1 = qMin(qMax(k0 + 1, (qint32)((s1 + iBucket - 1) / iBucket)), iNumBuckets);
+
+        if(k0 >= k1 || k1 > iAvailable)
+            break;
+
+        float fMin = pMin[k0];
+        float fMax = pMax[k0];
+
+        for(qint32 k = k0 + 1; k < k1; ++k) {
+            fMin = qMin(fMin, pMin[k]);
+            fMax = qMax(fMax, pMax[k]);
+        }
+
+        vecMin[bin] = fMin;
+        vecMax[bin] = fMax;
+    }
+
+    return bin;
+}
+
+
+//*************************************************************************************************************
+
+QString RawOverview::cacheFilePath(const QByteArray &key)
+{
+    QString sPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/overview";
+    QDir().mkpath(sPath);
+
+    return sPath + "/" + QString(key.toHex()) + ".ovr";
+}
+
+
+//*************************************************************************************************************
+
+void RawOverview::cleanCache(const QString &sDir, qint64 iMaxSize, const QString &sKeep)
+{
+    QString sKeepPath = QFileInfo(sKeep).absoluteFilePath();
+    QFileInfoList listFiles = QDir(sDir).entryInfoList(QStringList() << "*.ovr", QDir::Files, QDir::Time);
+
+    qint64 iSize = 0;
+
+    //Newest files first, the older ones are removed once the budget is used up
+    for(int i = 0; i < listFiles.size(); ++i) {
+        if(listFiles[i].absoluteFilePath() == sKeepPath)
+            continue;
+
+        iSize += listFiles[i].size();
+
+        if(iSize > iMaxSize) {
+            if(QFile::remove(listFiles[i].absoluteFilePath()))
+                qDebug() << "RawOverview: Removed overview" << listFiles[i].fileName() << "from the cache.";
+            iSize -= listFiles[i].size();
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RawOverview::updateLevel(int level, qint32 iNumBuckets)
+{
+    qint32 iNumChildren = m_vecNumBuckets[level - 1];
+
+    for(int row = 0; row < m_iNumChannels; ++row) {
+        const float* pChildMin = levelRow(level - 1, row, 0);
+        const float* pChildMax = levelRow(level - 1, row, 1);
+
+        float* pMin = levelRow(level, row, 0);
+        float* pMax = levelRow(level, row, 1);
+
+        for(qint32 k = m_vecLevelDone[level]; k < iNumBuckets; ++k) {
+            qint32 c0 = k * MODEL_OVERVIEW_LEVEL_FACTOR;
+            qint32 c1 = qMin(c0 + MODEL_OVERVIEW_LEVEL_FACTOR, iNumChildren);
+
+            float fMin = pChildMin[c0];
+            float fMax = pChildMax[c0];
+
+            for(qint32 c = c0 + 1; c < c1; ++c) {
+                fMin = qMin(fMin, pChildMin[c]);
+                fMax = qMax(fMax, pChildMax[c]);
+            }
+
+            pMin[k] = fMin;
+            pMax[k] = fMax;
+        }
+    }
+
+    m_vecLevelDone[level] = qMax(m_vecLevelDone[level], iNumBuckets);
+}
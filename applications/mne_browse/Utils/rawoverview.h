@@ -0,0 +1,274 @@
+//=============================================================================================================
+/**
+* @file     rawoverview.h
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the declaration of the RawOverview class.
+*
+*/
+
+#ifndef RAWOVERVIEW_H
+#define RAWOVERVIEW_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rawsettings.h"
+
+#include <functional>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QObject>
+#include <QFile>
+#include <QVector>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNEBROWSE
+//=============================================================================================================
+
+namespace MNEBROWSE
+{
+
+//=============================================================================================================
+/**
+* RawOverview...
+*
+* @brief The RawOverview class holds a multi-resolution min/max summary of a whole raw recording.
+*
+* Level 0 summarizes buckets of MODEL_OVERVIEW_BUCKET_SIZE samples, every further level combines
+* MODEL_OVERVIEW_LEVEL_FACTOR buckets of the level below until a level has at most MODEL_OVERVIEW_MIN_BUCKETS
+* buckets. The summary lives in a memory mapped cache file, so it is only built once per recording and only the
+* touched parts are paged in. The build runs in a background thread and publishes its progress, the summary of the
+* samples read so far can be queried while the build is running. The cache directory is limited to
+* MODEL_OVERVIEW_CACHE_SIZE, the least recently used cache files are removed when a new one is created.
+*/
+class RawOverview : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QSharedPointer<RawOverview> SPtr;                                               /**< Shared pointer type for RawOverview. */
+    typedef std::function<bool (qint32 from, qint32 to, MatrixXd& data)> ReadFunction;      /**< Reads the samples [from,to) relative to the first sample. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a RawOverview.
+    *
+    * @param parent the parent object
+    */
+    RawOverview(QObject *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Destructor, unmaps and closes the cache file.
+    */
+    ~RawOverview();
+
+    //=========================================================================================================
+    /**
+    * Opens the cache file. A complete cache file with matching dimensions is reused, otherwise the file is
+    * (re-)created and needs to be filled by build(). Opening a cache file marks it as recently used.
+    *
+    * @param sFileName the path of the cache file
+    * @param iNumChannels number of channels of the recording
+    * @param iNumSamples number of samples of the recording
+    * @return true if the cache file could be opened and mapped
+    */
+    bool open(const QString &sFileName, qint32 iNumChannels, qint32 iNumSamples);
+
+    //=========================================================================================================
+    /**
+    * Reads the whole recording chunk wise and fills all levels. This method is meant to run in a background
+    * thread, it returns early when cancel() is called.
+    *
+    * @param readFunction the function which reads a chunk of the recording
+    * @return true if the overview was built completely
+    */
+    bool build(const ReadFunction &readFunction);
+
+    //=========================================================================================================
+    /**
+    * Requests a running build() to return.
+    */
+    void cancel();
+
+    //=========================================================================================================
+    /**
+    * Returns true when all levels were built.
+    *
+    * @return true when complete
+    */
+    bool isComplete() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples which were summarized so far.
+    *
+    * @return the number of summarized samples
+    */
+    qint32 samplesDone() const;
+
+    //=========================================================================================================
+    /**
+    * Summarizes the samples [from,to) of a channel in numBins equally wide bins. The coarsest level whose buckets
+    * are not wider than a bin is used.
+    *
+    * @param row the channel index
+    * @param from the first sample relative to the first sample of the recording
+    * @param to the sample after the last one relative to the first sample of the recording
+    * @param numBins number of bins
+    * @param[out] vecMin the minimum of each bin
+    * @param[out] vecMax the maximum of each bin
+    * @return the number of leading bins which are available, the remaining bins are not built yet or outside of the recording
+    */
+    int summary(int row, qint32 from, qint32 to, int numBins, VectorXf &vecMin, VectorXf &vecMax) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the path of the cache file for a given key in the application's cache location.
+    *
+    * @param key the key which identifies the recording and its read settings
+    * @return the path of the cache file
+    */
+    static QString cacheFilePath(const QByteArray &key);
+
+    //=========================================================================================================
+    /**
+    * Removes the least recently modified cache files of a directory until the remaining files fit into iMaxSize.
+    *
+    * @param sDir the cache directory
+    * @param iMaxSize the maximal size of all cache files in bytes
+    * @param sKeep the cache file which is about to be (re-)created, it is neither counted nor removed
+    */
+    static void cleanCache(const QString &sDir, qint64 iMaxSize, const QString &sKeep);
+
+signals:
+    //=========================================================================================================
+    /**
+    * progressChanged is emitted from the building thread whenever another percent of the recording was summarized.
+    *
+    * @param iSamplesDone the number of summarized samples
+    */
+    void progressChanged(qint32 iSamplesDone);
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the bucket size of a level.
+    *
+    * @param level the level
+    * @return the number of samples per bucket
+    */
+    inline qint32 bucketSize(int level) const;
+
+    //=========================================================================================================
+    /**
+    * Returns pointers to the first bucket of a channel in a level.
+    *
+    * @param level the level
+    * @param row the channel index
+    * @param type 0 for the minimum and 1 for the maximum
+    * @return pointer to the first bucket
+    */
+    inline float* levelRow(int level, int row, int type) const;
+
+    //=========================================================================================================
+    /**
+    * Combines the buckets of the level below into the buckets of a level, up to iNumBuckets of the level.
+    *
+    * @param level the level to update (>= 1)
+    * @param iNumBuckets the number of buckets of the level which can be computed
+    */
+    void updateLevel(int level, qint32 iNumBuckets);
+
+    QFile           m_file;                 /**< The cache file. */
+    uchar*          m_pMapped;              /**< The mapped cache file. */
+    float*          m_pData;                /**< The first float of the summary data in the mapped cache file. */
+
+    qint32          m_iNumChannels;         /**< Number of channels. */
+    qint32          m_iNumSamples;          /**< Number of samples. */
+    QVector<qint32> m_vecNumBuckets;        /**< Number of buckets of each level. */
+    QVector<qint64> m_vecLevelOffset;       /**< Offset of each level in floats from m_pData. */
+    QVector<qint32> m_vecLevelDone;         /**< Number of built buckets of each level, only accessed by the building thread. */
+
+    QAtomicInt      m_iSamplesDone;         /**< Number of summarized samples, published after all levels were updated. */
+    QAtomicInt      m_iCancel;              /**< Set to 1 to cancel a running build. */
+};
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline qint32 RawOverview::bucketSize(int level) const
+{
+    qint32 size = MODEL_OVERVIEW_BUCKET_SIZE;
+    for(int i = 0; i < level; ++i)
+        size *= MODEL_OVERVIEW_LEVEL_FACTOR;
+    return size;
+}
+
+
+//*************************************************************************************************************
+
+inline float* RawOverview::levelRow(int level, int row, int type) const
+{
+    return m_pData + m_vecLevelOffset[level] + ((qint64)type*m_iNumChannels + row)*m_vecNumBuckets[level];
+}
+
+} // NAMESPACE
+
+#endif // RAWOVERVIEW_H
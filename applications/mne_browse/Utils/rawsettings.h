@@ -82,6 +82,12 @@
 #define MODEL_MAX_WINDOWS 3 //number of windows that are at maximum remained in m_data
 #define MODEL_NUM_FILTER_TAPS 80 //number of filter taps, required to take into account because of FFT convolution (zero padding)
 #define MODEL_MAX_NUM_FILTER_TAPS 0 //number of maximal filter taps
+#define MODEL_TILE_CACHE_SIZE 512 //size of the cache for data windows which were scrolled out of the loaded range [in MB]
+#define MODEL_OVERVIEW_BUCKET_SIZE 128 //number of samples summarized by one bucket of the finest overview level
+#define MODEL_OVERVIEW_LEVEL_FACTOR 4 //number of buckets which are combined into one bucket of the next coarser overview level
+#define MODEL_OVERVIEW_MIN_BUCKETS 512 //no coarser overview level is added once a level has at most this number of buckets
+#define MODEL_OVERVIEW_CHUNK_SIZE 16384 //number of samples read at once while building the overview, multiple integer of MODEL_OVERVIEW_BUCKET_SIZE
+#define MODEL_OVERVIEW_CACHE_SIZE 2048 //size of all overview cache files, the least recently used files are removed beyond it [in MB]
 
 //RawDelegate
 //Look
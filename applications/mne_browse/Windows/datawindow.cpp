@@ -428,6 +428,15 @@ bool DataWindow::eventFilter(QObject *object, QEvent *event)
         return true;
     }
 
+    //Zoom the time axis with ctrl + mouse wheel
+    if (object == ui->m_tableView_rawTableView->viewport() && event->type() == QEvent::Wheel) {
+        QWheelEvent* wheelEventCast = static_cast<QWheelEvent*>(event);
+        if(wheelEventCast->modifiers() & Qt::ControlModifier) {
+            zoomDataPlot(wheelEventCast->angleDelta().y(), wheelEventCast->pos().x());
+            return true;
+        }
+    }
+
     //Look for swipe gesture in order to scale the channels
     if (object == ui->m_tableView_rawTableView && event->type() == QEvent::Gesture) {
         QGestureEvent* gestureEventCast = static_cast<QGestureEvent*>(event);
@@ -437,6 +446,45 @@ bool DataWindow::eventFilter(QObject *object, QEvent *event)
     return false;
 }
 
+
+//*************************************************************************************************************
+
+void DataWindow::zoomDataPlot(int steps, int pivot)
+{
+    if(!m_pRawModel->m_bFileloaded || steps == 0)
+        return;
+
+    QScrollBar* horizontalScrollBar = ui->m_tableView_rawTableView->horizontalScrollBar();
+    int viewportWidth = qMax(1, ui->m_tableView_rawTableView->viewport()->width());
+    qint32 nsamples = m_pRawModel->lastSample()-m_pRawModel->firstSample();
+
+    //zoom out at most until the whole file fits into the view
+    int maxSamplesPerPixel = 1;
+    while(nsamples/maxSamplesPerPixel > viewportWidth)
+        maxSamplesPerPixel *= 2;
+
+    int samplesPerPixel = m_pRawModel->samplesPerPixel();
+    int newSamplesPerPixel = steps > 0 ? qMax(1, samplesPerPixel/2) : qMin(maxSamplesPerPixel, samplesPerPixel*2);
+
+    if(newSamplesPerPixel == samplesPerPixel)
+        return;
+
+    //sample under the mouse cursor
+    qint64 pivotSample = (qint64)(horizontalScrollBar->value() + pivot) * samplesPerPixel;
+
+    m_pRawModel->setSamplesPerPixel(newSamplesPerPixel);
+    ui->m_tableView_rawTableView->resizeColumnsToContents();
+
+    horizontalScrollBar->setValue(pivotSample/newSamplesPerPixel - pivot);
+
+    //valueChanged is not emitted if the scroll bar value did not change, but the scroll position in samples did
+    m_pRawModel->updateScrollPos(horizontalScrollBar->value());
+
+    setRangeSampleLabels();
+    setMarkerSampleLabel();
+}
+
+
 //*************************************************************************************************************
 
 void DataWindow::customContextMenuRequested(QPoint pos)
@@ -538,8 +586,8 @@ void DataWindow::setRangeSampleLabels()
 
     //calculate sample range which is currently displayed in the view
     //Note: the viewport holds the width of the area which is changed through scrolling
-    int minSampleRange = ui->m_tableView_rawTableView->horizontalScrollBar()->value()/* + m_pMainWindow->m_pRawModel->firstSample()*/;
-    int maxSampleRange = minSampleRange + ui->m_tableView_rawTableView->viewport()->width();
+    int minSampleRange = ui->m_tableView_rawTableView->horizontalScrollBar()->value()*m_pRawModel->samplesPerPixel()/* + m_pMainWindow->m_pRawModel->firstSample()*/;
+    int maxSampleRange = minSampleRange + ui->m_tableView_rawTableView->viewport()->width()*m_pRawModel->samplesPerPixel();
 
     //Set values as string
     QString stringTemp;
@@ -557,8 +605,8 @@ void DataWindow::setMarkerSampleLabel()
     m_pCurrentDataMarkerLabel->raise();
 
     //Update the text and position in the current sample marker label
-    m_iCurrentMarkerSample = ui->m_tableView_rawTableView->horizontalScrollBar()->value() +
-            (m_pDataMarker->geometry().x() - ui->m_tableView_rawTableView->geometry().x() - ui->m_tableView_rawTableView->verticalHeader()->width());
+    m_iCurrentMarkerSample = (ui->m_tableView_rawTableView->horizontalScrollBar()->value() +
+            (m_pDataMarker->geometry().x() - ui->m_tableView_rawTableView->geometry().x() - ui->m_tableView_rawTableView->verticalHeader()->width())) * m_pRawModel->samplesPerPixel();
 
     int currentSeconds = (m_iCurrentMarkerSample/m_pRawModel->m_pFiffInfo->sfreq)*1000;
 
@@ -221,6 +221,16 @@ private:
     */
     bool pinchTriggered(QPinchGesture *gesture);
 
+    //=========================================================================================================
+    /**
+    * zoomDataPlot zooms the time axis of the data plot in powers of two samples per pixel, at most until the whole
+    * file fits into the view. The sample under the mouse cursor keeps its position.
+    *
+    * @param [in] steps positive to zoom in, negative to zoom out.
+    * @param [in] pivot the x position of the mouse cursor in the viewport.
+    */
+    void zoomDataPlot(int steps, int pivot);
+
     Ui::DataWindowDockWidget *ui;                   /**< Pointer to the qt designer generated ui class.*/
 
     MainWindow*     m_pMainWindow;                  /**< pointer to the main window (parent). */
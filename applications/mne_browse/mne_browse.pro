@@ -101,6 +101,7 @@ SOURCES += \
     Windows/scalewindow.cpp \
     Windows/chinfowindow.cpp \
     Utils/datapackage.cpp \    
+    Utils/rawoverview.cpp \
     Windows/noisereductionwindow.cpp
 
 HEADERS += \
@@ -129,6 +130,7 @@ HEADERS += \
     Windows/chinfowindow.h \
     Windows/noisereductionwindow.h \
     Utils/datapackage.h \
+    Utils/rawoverview.h \
 
 FORMS += \
     Windows/eventwindowdock.ui \
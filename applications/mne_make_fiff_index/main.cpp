@@ -0,0 +1,130 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Implements the mne_make_fiff_index application.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_make_fiff_index_settings.h"
+
+#include <fiff/fiff_stream.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QCoreApplication>
+#include <QFile>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MAKEFIFFINDEX;
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the mne_make_fiff_index application.
+* By default, main has the storage class extern.
+*
+* @param [in] argc  (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv  (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return 0 if all indices were created, 1 otherwise.
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    MneMakeFiffIndexSettings settings(&argc,argv);
+    if (!settings.ok)
+        return 1;
+
+    QStringList t_listFiles = settings.files();
+    int nfail = 0;
+
+    for (int k = 0; k < t_listFiles.size(); k++) {
+        //
+        //   A forced rebuild must not pick up the old index while opening
+        //
+        if (settings.force)
+            QFile::remove(FiffStream::dir_index_name(t_listFiles[k]));
+
+        QFile t_file(t_listFiles[k]);
+        FiffStream t_stream(&t_file);
+
+        if (!t_stream.open()) {
+            fprintf(stderr,"%s : cannot be opened\n",t_listFiles[k].toUtf8().constData());
+            nfail++;
+            continue;
+        }
+
+        QList<FiffDirEntry::SPtr> t_dir;
+        if (t_stream.has_dir_pointer()) {
+            //
+            //   The directory is read through the pointer, a sidecar index would never be used
+            //
+            printf("%s : has a directory pointer, no index needed\n",t_listFiles[k].toUtf8().constData());
+        }
+        else if (!settings.force && t_stream.read_dir_index(t_dir)) {
+            printf("%s : index is up to date\n",t_listFiles[k].toUtf8().constData());
+        }
+        else if (t_stream.write_dir_index()) {
+            printf("%s : index with %d entries written\n",t_listFiles[k].toUtf8().constData(),t_stream.nent());
+        }
+        else {
+            fprintf(stderr,"%s : index could not be written\n",t_listFiles[k].toUtf8().constData());
+            nfail++;
+        }
+
+        t_stream.close();
+    }
+
+    printf("%d of %d files indexed.\n",t_listFiles.size()-nfail,t_listFiles.size());
+
+    return nfail > 0 ? 1 : 0;
+}
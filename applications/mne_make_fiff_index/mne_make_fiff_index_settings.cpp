@@ -0,0 +1,218 @@
+//=============================================================================================================
+/**
+* @file     mne_make_fiff_index_settings.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the MneMakeFiffIndexSettings Class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_make_fiff_index_settings.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QDirIterator>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MAKEFIFFINDEX;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+#ifndef PROGRAM_VERSION
+#define PROGRAM_VERSION     "1.0"
+#endif
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+MneMakeFiffIndexSettings::MneMakeFiffIndexSettings()
+: force(false)
+, ok(false)
+{
+
+}
+
+
+//*************************************************************************************************************
+
+MneMakeFiffIndexSettings::MneMakeFiffIndexSettings(int *argc,char **argv)
+: force(false)
+, ok(false)
+{
+    if (!check_args(argc,argv))
+        return;
+
+    fprintf(stderr,"%s version %s compiled at %s %s\n",argv[0],PROGRAM_VERSION,__DATE__,__TIME__);
+
+    if (innames.isEmpty() && indirs.isEmpty()) {
+        usage(argv[0]);
+        return;
+    }
+
+    ok = true;
+}
+
+
+//*************************************************************************************************************
+
+MneMakeFiffIndexSettings::~MneMakeFiffIndexSettings()
+{
+
+}
+
+
+//*************************************************************************************************************
+
+QStringList MneMakeFiffIndexSettings::files() const
+{
+    QStringList t_listFiles = innames;
+
+    for (int k = 0; k < indirs.size(); k++) {
+        QDirIterator it(indirs[k], QStringList() << "*.fif", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            t_listFiles.append(it.next());
+    }
+
+    return t_listFiles;
+}
+
+
+//*************************************************************************************************************
+
+void MneMakeFiffIndexSettings::usage(char *name)
+{
+    fprintf(stderr,"usage: %s [options]\n",name);
+    fprintf(stderr,"Create tag directory indices for fif files which do not contain a directory\n");
+    fprintf(stderr,"\t--in name         An input file (can have multiple of these).\n");
+    fprintf(stderr,"\t--fif name        Synonym for the above.\n");
+    fprintf(stderr,"\t--dir name        Index all fif files in this directory and its subdirectories (can have multiple of these).\n");
+    fprintf(stderr,"\t--force           Rebuild indices even if they are up to date.\n");
+    fprintf(stderr,"\t--help            print this info.\n");
+    fprintf(stderr,"\t--version         print version info.\n\n");
+}
+
+
+//*************************************************************************************************************
+
+bool MneMakeFiffIndexSettings::check_unrecognized_args(int argc, char **argv)
+{
+    int k;
+
+    if (argc > 1) {
+        fprintf(stderr,"Unrecognized arguments : ");
+        for (k = 1; k < argc; k++)
+            fprintf(stderr,"%s ",argv[k]);
+        fprintf(stderr,"\n");
+        qCritical("Check the command line.");
+        return false;
+    }
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool MneMakeFiffIndexSettings::check_args (int *argc,char **argv)
+{
+    int k;
+    int p;
+    int found;
+
+    for (k = 0; k < *argc; k++) {
+        found = 0;
+        if (strcmp(argv[k],"--version") == 0) {
+            fprintf(stderr,"%s version %s compiled at %s %s\n", argv[0],PROGRAM_VERSION,__DATE__,__TIME__);
+            exit(0);
+        }
+        else if (strcmp(argv[k],"--help") == 0) {
+            usage(argv[0]);
+            exit(1);
+        }
+        else if (strcmp(argv[k],"--in") == 0 || strcmp(argv[k],"--fif") == 0) {
+            found = 2;
+            if (k == *argc - 1) {
+                qCritical("%s: argument required.",argv[k]);
+                return false;
+            }
+            innames.append(QString(argv[k+1]));
+        }
+        else if (strcmp(argv[k],"--dir") == 0) {
+            found = 2;
+            if (k == *argc - 1) {
+                qCritical("--dir: argument required.");
+                return false;
+            }
+            indirs.append(QString(argv[k+1]));
+        }
+        else if (strcmp(argv[k],"--force") == 0) {
+            found = 1;
+            force = true;
+        }
+        if (found) {
+            for (p = k; p < *argc-found; p++)
+                argv[p] = argv[p+found];
+            *argc = *argc - found;
+            k = k - found;
+        }
+    }
+    return check_unrecognized_args(*argc,argv);
+}
@@ -0,0 +1,113 @@
+//=============================================================================================================
+/**
+* @file     mne_make_fiff_index_settings.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    MneMakeFiffIndexSettings class declaration.
+*
+*/
+
+#ifndef MNEMAKEFIFFINDEXSETTINGS_H
+#define MNEMAKEFIFFINDEXSETTINGS_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MAKEFIFFINDEX
+//=============================================================================================================
+
+namespace MAKEFIFFINDEX
+{
+
+//=============================================================================================================
+/**
+* Implements the make fiff index setting parser
+*
+* @brief Make fiff index setting implementation
+*/
+class MneMakeFiffIndexSettings
+{
+public:
+    typedef QSharedPointer<MneMakeFiffIndexSettings> SPtr;             /**< Shared pointer type for MneMakeFiffIndexSettings. */
+    typedef QSharedPointer<const MneMakeFiffIndexSettings> ConstSPtr;  /**< Const shared pointer type for MneMakeFiffIndexSettings. */
+
+    //=========================================================================================================
+    /**
+    * Default Constructor
+    */
+    explicit MneMakeFiffIndexSettings();
+
+    //=========================================================================================================
+    /**
+    * Constructs Make Fiff Index Settings
+    *
+    * @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+    * @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+    */
+    explicit MneMakeFiffIndexSettings(int *argc,char **argv);
+
+    //=========================================================================================================
+    /**
+    * Destructs the Make Fiff Index Settings
+    */
+    virtual ~MneMakeFiffIndexSettings();
+
+    //=========================================================================================================
+    /**
+    * Collects the files to index from the input names and directories.
+    *
+    * @return the list of fiff files to index.
+    */
+    QStringList files() const;
+
+public:
+    QStringList innames;        /**< The input files (can have multiple of these). */
+    QStringList indirs;         /**< Directories which are searched recursively for fif files (can have multiple of these). */
+    bool        force;          /**< Rebuild indices even if a valid one exists. */
+    bool        ok;             /**< Whether the command line was parsed successfully. */
+
+private:
+    void usage(char *name);
+    bool check_unrecognized_args(int argc, char **argv);
+    bool check_args (int *argc,char **argv);
+
+};
+
+} //NAMESPACE MAKEFIFFINDEX
+
+#endif // MNEMAKEFIFFINDEXSETTINGS_H
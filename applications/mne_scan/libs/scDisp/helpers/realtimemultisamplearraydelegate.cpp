@@ -72,6 +72,7 @@ RealTimeMultiSampleArrayDelegate::RealTimeMultiSampleArrayDelegate(QObject *pare
 , m_fMaxValue(0.0)
 , m_fScaleY(0.0)
 , m_iActiveRow(0)
+, m_bMinMaxDecimation(true)
 {
 
 }
@@ -462,6 +463,14 @@ void RealTimeMultiSampleArrayDelegate::markerMoved(QPoint position, int activeRo
 }
 
 
+//*************************************************************************************************************
+
+void RealTimeMultiSampleArrayDelegate::setMinMaxDecimation(bool bActivate)
+{
+    m_bMinMaxDecimation = bActivate;
+}
+
+
 //*************************************************************************************************************
 
 void RealTimeMultiSampleArrayDelegate::setSignalColor(const QColor& signalColor)
@@ -567,6 +576,22 @@ void RealTimeMultiSampleArrayDelegate::createPlotPath(const QModelIndex &index,
         path.moveTo(qSamplePosition);
     }
 
+    //With more samples than pixels draw the min/max envelope instead of every sample
+    if(m_bMinMaxDecimation && createDecimatedPlotPath(index, option, path, data, fScaleY)) {
+        qint32 j = (qint32)(m_markerPosition.x()/fDx);
+
+        if(j >= 0 && j < data.second) {
+            float val = j < currentSampleIndex ? *(data.first+j) - *(data.first) : *(data.first+j) - lastFirstValue;
+
+            ellipsePos.setX(option.rect.x()+(j+1)*fDx);
+            ellipsePos.setY(y_base-val*fScaleY);
+
+            amplitude = QString::number(*(data.first+j));
+        }
+
+        return;
+    }
+
     float val;
 
     for(qint32 j=0; j < data.second; ++j)
@@ -596,6 +621,103 @@ void RealTimeMultiSampleArrayDelegate::createPlotPath(const QModelIndex &index,
 }
 
 
+//*************************************************************************************************************
+
+bool RealTimeMultiSampleArrayDelegate::createDecimatedPlotPath(const QModelIndex &index,
+                                                               const QStyleOptionViewItem &option,
+                                                               QPainterPath& path,
+                                                               const RowVectorPair &data,
+                                                               float fScaleY) const
+{
+    const RealTimeMultiSampleArrayModel* t_pModel = static_cast<const RealTimeMultiSampleArrayModel*>(index.model());
+
+    qint32 iPixels = option.rect.width();
+
+    if(iPixels <= 0 || data.second != t_pModel->getMaxSamples())
+        return false;
+
+    //Pick the coarsest level which still has at least one bucket per pixel
+    qint32 iLevel = -1;
+    for(qint32 l = 0; l < t_pModel->getNumMinMaxLevels(); ++l) {
+        if(RealTimeMultiSampleArrayModel::getMinMaxBucketSize(l) * iPixels <= data.second)
+            iLevel = l;
+    }
+
+    if(iLevel < 0)
+        return false;
+
+    MinMaxRowPair minMax = t_pModel->getMinMaxRow(index.row(), iLevel);
+
+    if(!minMax.first || !minMax.second)
+        return false;
+
+    qint32 iBucketSize = RealTimeMultiSampleArrayModel::getMinMaxBucketSize(iLevel);
+    qint32 iBuckets = (data.second + iBucketSize - 1) / iBucketSize;
+
+    int currentSampleIndex = t_pModel->getCurrentSampleIndex();
+    float firstValue = *(data.first);
+    float lastFirstValue = t_pModel->getLastBlockFirstValue(index.row());
+
+    float y_base = path.currentPosition().y();
+    float fLastY = y_base;
+    float fPixelDx = ((float)option.rect.width()) / iPixels;
+
+    for(qint32 p = 0; p < iPixels; ++p) {
+        //Buckets k0 <= k < k1 belong to this pixel column
+        qint32 k0 = (qint64)p * iBuckets / iPixels;
+        qint32 k1 = (qint64)(p+1) * iBuckets / iPixels;
+
+        if(k1 <= k0)
+            continue;
+
+        qint32 s0 = k0 * iBucketSize;
+        qint32 s1 = qMin(k1 * iBucketSize, data.second);
+
+        float fMin, fMax;
+
+        if(s0 < currentSampleIndex && s1 > currentSampleIndex) {
+            //The new and the last data part meet here, they have different offsets
+            fMin = fMax = *(data.first+s0) - firstValue;
+            for(qint32 j = s0; j < s1; ++j) {
+                float val = j < currentSampleIndex ? *(data.first+j) - firstValue : *(data.first+j) - lastFirstValue;
+                fMin = qMin(fMin, val);
+                fMax = qMax(fMax, val);
+            }
+        } else {
+            float fOffset = s0 < currentSampleIndex ? firstValue : lastFirstValue;
+
+            fMin = minMax.first[k0];
+            fMax = minMax.second[k0];
+            for(qint32 k = k0+1; k < k1; ++k) {
+                fMin = qMin(fMin, minMax.first[k]);
+                fMax = qMax(fMax, minMax.second[k]);
+            }
+
+            fMin -= fOffset;
+            fMax -= fOffset;
+        }
+
+        //Reverse direction -> plot the right way
+        float fYMin = y_base - fMin*fScaleY;
+        float fYMax = y_base - fMax*fScaleY;
+        float fX = option.rect.x() + (p+1)*fPixelDx;
+
+        //Start the stroke at the end which is closer to the previous one
+        if(qAbs(fLastY - fYMax) < qAbs(fLastY - fYMin)) {
+            path.lineTo(fX, fYMax);
+            path.lineTo(fX, fYMin);
+            fLastY = fYMin;
+        } else {
+            path.lineTo(fX, fYMin);
+            path.lineTo(fX, fYMax);
+            fLastY = fYMax;
+        }
+    }
+
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 void RealTimeMultiSampleArrayDelegate::createCurrentPositionMarkerPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path) const
@@ -36,6 +36,14 @@
 #ifndef REALTIMEMULTISAMPLEARRAYDELEGATE_H
 #define REALTIMEMULTISAMPLEARRAYDELEGATE_H
 
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../scdisp_global.h"
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // QT INCLUDES
@@ -87,7 +95,7 @@ using namespace Eigen;
 *
 * @brief The RealTimeMultiSampleArrayDelegate class represents a RTMSA delegate which creates the plot paths
 */
-class RealTimeMultiSampleArrayDelegate : public QAbstractItemDelegate
+class SCDISPSHARED_EXPORT RealTimeMultiSampleArrayDelegate : public QAbstractItemDelegate
 {
     Q_OBJECT
 public:
@@ -140,6 +148,15 @@ public:
     */
     void markerMoved(QPoint position, int activeRow);
 
+    //=========================================================================================================
+    /**
+    * Turns the min/max decimation on or off. When on, rows with more samples than pixels are drawn from the min/max
+    * pyramid of the model with at most two vertices per pixel column.
+    *
+    * @param[in] bActivate  Whether to draw decimated rows (default on).
+    */
+    void setMinMaxDecimation(bool bActivate);
+
 public slots:
     //=========================================================================================================
     /**
@@ -168,6 +185,25 @@ private:
                         QString &amplitude,
                         SCDISPLIB::RowVectorPair &data) const;
 
+    //=========================================================================================================
+    /**
+    * createDecimatedPlotPath creates the QPointer path for the data plot from the min/max pyramid of the model. Each
+    * pixel column gets one vertical stroke from the minimum to the maximum of its samples.
+    *
+    * @param[in] index      Used to locate data in a data model.
+    * @param[in] option     Describes the parameters used to draw an item in a view widget
+    * @param[in,out] path   The QPointerPath to create for the data plot.
+    * @param[in] data       Current data for the given row.
+    * @param[in] fScaleY    Scaling from data values to pixels.
+    *
+    * @return false if the row has not enough samples per pixel or the pyramid is not available.
+    */
+    bool createDecimatedPlotPath(const QModelIndex &index,
+                                 const QStyleOptionViewItem &option,
+                                 QPainterPath& path,
+                                 const SCDISPLIB::RowVectorPair &data,
+                                 float fScaleY) const;
+
     //=========================================================================================================
     /**
     * createCurrentPositionMarkerPath Creates the QPointer path for the current marker position plot.
@@ -240,6 +276,7 @@ private:
     float       m_fMaxValue;        /**< Maximum value of the data to plot. */
     float       m_fScaleY;          /**< Maximum amplitude of plot (max is m_dPlotHeight/2). */
     int         m_iActiveRow;       /**< The current row which the mouse is moved over. */
+    bool        m_bMinMaxDecimation;    /**< Whether to draw rows from the min/max pyramid when there are more samples than pixels. */
 
     QPoint              m_markerPosition;   /**< Current mouse position used to draw the marker in the plot. */
     QList<QPainterPath> m_painterPaths;     /**< List of all current painter paths for each row. */
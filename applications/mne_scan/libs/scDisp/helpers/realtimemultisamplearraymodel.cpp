@@ -78,6 +78,7 @@ RealTimeMultiSampleArrayModel::RealTimeMultiSampleArrayModel(QObject *parent)
 , m_iDetectedTriggers(0)
 , m_iCurrentSampleFreeze(0)
 , m_iCurrentTriggerChIndex(0)
+, m_pMinMaxSource(0)
 {
     init();
 }
@@ -368,6 +369,8 @@ void RealTimeMultiSampleArrayModel::setFiffInfo(FiffInfo::SPtr& p_pFiffInfo)
 
         //Init the sphara operators
         initSphara();
+
+        updateMinMaxPyramid(0, 0, true);
     }
     else {
         m_vecBadIdcs = RowVectorXi(0,0);
@@ -396,6 +399,8 @@ void RealTimeMultiSampleArrayModel::setSamplingInfo(float sps, int T)
     if(m_iCurrentSample>m_iMaxSamples)
         m_iCurrentSample = 0;
 
+    updateMinMaxPyramid(0, 0, true);
+
     endResetModel();
 }
 
@@ -467,6 +472,10 @@ void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
                 }
             }
 
+            if(!m_bIsFreezed && m_filterData.isEmpty()) {
+                updateMinMaxPyramid(m_iCurrentSample, m_iCurrentSample + m_iResidual);
+            }
+
             m_iCurrentSample = 0;
 
             if(!m_bIsFreezed) {
@@ -535,6 +544,15 @@ void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
             }
         }
 
+        //Update the min/max pyramid of the changed columns, the filter writes with a delay and around the wrap
+        if(!m_bIsFreezed) {
+            if(m_filterData.isEmpty()) {
+                updateMinMaxPyramid(m_iCurrentSample, m_iCurrentSample + nCol);
+            } else {
+                updateMinMaxPyramid(m_iCurrentSample - 2*m_iMaxFilterLength - m_iResidual, m_iCurrentSample + nCol + m_iMaxFilterLength);
+            }
+        }
+
         m_iCurrentSample += nCol;
         m_iCurrentBlockSize = nCol;
 
@@ -609,6 +627,115 @@ fiff_int_t RealTimeMultiSampleArrayModel::getCoil(qint32 row) const
 }
 
 
+//*************************************************************************************************************
+
+MinMaxRowPair RealTimeMultiSampleArrayModel::getMinMaxRow(qint32 row, qint32 level) const
+{
+    const MatrixXdR& matData = displayedData();
+
+    if(level < 0 || level >= m_qListMinPyramid.size() || m_pMinMaxSource != matData.data()
+            || m_qListMinPyramid.at(level).rows() != matData.rows()) {
+        return MinMaxRowPair(0, 0);
+    }
+
+    qint32 chRow = m_qMapIdxRowSelection.value(row,0);
+
+    if(chRow >= m_qListMinPyramid.at(level).rows())
+        return MinMaxRowPair(0, 0);
+
+    return MinMaxRowPair(m_qListMinPyramid.at(level).row(chRow).data(), m_qListMaxPyramid.at(level).row(chRow).data());
+}
+
+
+//*************************************************************************************************************
+
+void RealTimeMultiSampleArrayModel::updateMinMaxPyramid(qint32 from, qint32 to, bool bRebuild)
+{
+    const MatrixXdR& matData = displayedData();
+    qint32 iRows = matData.rows();
+    qint32 iCols = matData.cols();
+
+    //Rebuild if the displayed data matrix was switched or resized
+    if(m_pMinMaxSource != matData.data() || m_qListMinPyramid.isEmpty()
+            || m_qListMinPyramid.first().rows() != iRows
+            || m_qListMinPyramid.first().cols() != (iCols + 1) / 2) {
+        bRebuild = true;
+    }
+
+    if(bRebuild) {
+        m_qListMinPyramid.clear();
+        m_qListMaxPyramid.clear();
+
+        //Stop when a level would have less than 64 buckets, no screen is that narrow
+        for(qint32 l = 0; iCols / getMinMaxBucketSize(l) >= 64; ++l) {
+            qint32 iBuckets = (iCols + getMinMaxBucketSize(l) - 1) / getMinMaxBucketSize(l);
+            m_qListMinPyramid.append(MatrixXfR(iRows, iBuckets));
+            m_qListMaxPyramid.append(MatrixXfR(iRows, iBuckets));
+        }
+
+        m_pMinMaxSource = matData.data();
+        from = 0;
+        to = iCols;
+    }
+
+    if(m_qListMinPyramid.isEmpty())
+        return;
+
+    //Changed columns before the start wrapped around to the end of the data
+    if(from < 0) {
+        updateMinMaxPyramid(qMax(iCols + from, 0), iCols);
+        from = 0;
+    }
+
+    to = qMin(to, iCols);
+    if(from >= to)
+        return;
+
+    //Level 0 from the data, every higher level from the level below
+    qint32 k0 = from / 2;
+    qint32 k1 = (to + 1) / 2;
+
+    for(qint32 r = 0; r < iRows; ++r) {
+        const double* pData = matData.data() + r*iCols;
+        float* pMin = m_qListMinPyramid[0].data() + r*m_qListMinPyramid[0].cols();
+        float* pMax = m_qListMaxPyramid[0].data() + r*m_qListMaxPyramid[0].cols();
+
+        for(qint32 k = k0; k < k1; ++k) {
+            double dMin = pData[2*k];
+            double dMax = dMin;
+            if(2*k+1 < iCols) {
+                dMin = qMin(dMin, pData[2*k+1]);
+                dMax = qMax(dMax, pData[2*k+1]);
+            }
+            pMin[k] = (float)dMin;
+            pMax[k] = (float)dMax;
+        }
+    }
+
+    for(qint32 l = 1; l < m_qListMinPyramid.size(); ++l) {
+        qint32 iBelow = m_qListMinPyramid[l-1].cols();
+        k0 = k0 / 2;
+        k1 = (k1 + 1) / 2;
+
+        for(qint32 r = 0; r < iRows; ++r) {
+            const float* pMinBelow = m_qListMinPyramid[l-1].data() + r*iBelow;
+            const float* pMaxBelow = m_qListMaxPyramid[l-1].data() + r*iBelow;
+            float* pMin = m_qListMinPyramid[l].data() + r*m_qListMinPyramid[l].cols();
+            float* pMax = m_qListMaxPyramid[l].data() + r*m_qListMaxPyramid[l].cols();
+
+            for(qint32 k = k0; k < k1; ++k) {
+                pMin[k] = pMinBelow[2*k];
+                pMax[k] = pMaxBelow[2*k];
+                if(2*k+1 < iBelow) {
+                    pMin[k] = qMin(pMin[k], pMinBelow[2*k+1]);
+                    pMax[k] = qMax(pMax[k], pMaxBelow[2*k+1]);
+                }
+            }
+        }
+    }
+}
+
+
 //*************************************************************************************************************
 
 void RealTimeMultiSampleArrayModel::selectRows(const QList<qint32> &selection)
@@ -678,6 +805,8 @@ void RealTimeMultiSampleArrayModel::toggleFreeze(const QModelIndex &)
         m_iCurrentSampleFreeze = m_iCurrentSample;
     }
 
+    updateMinMaxPyramid(0, 0, true);
+
     //Update data content
     QModelIndex topLeft = this->index(0,1);
     QModelIndex bottomRight = this->index(m_qListChInfo.size()-1,1);
@@ -1195,6 +1324,8 @@ void RealTimeMultiSampleArrayModel::filterChannelsConcurrently()
         m_vecLastBlockFirstValuesFiltered = m_matDataFiltered.col(0);
     }
 
+    updateMinMaxPyramid(0, 0, true);
+
     //std::cout<<"END RealTimeMultiSampleArrayModel::filterChannelsConcurrently"<<std::endl;
 }
 
@@ -1328,6 +1459,8 @@ void RealTimeMultiSampleArrayModel::clearModel()
     m_vecLastBlockFirstValuesRaw.setZero();
     m_matOverlap.setZero();
 
+    updateMinMaxPyramid(0, 0, true);
+
     endResetModel();
 
     qDebug("RealTimeMultiSampleArrayModel cleared.");
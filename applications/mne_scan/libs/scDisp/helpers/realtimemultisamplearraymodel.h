@@ -42,6 +42,8 @@
 // INCLUDES
 //=============================================================================================================
 
+#include "../scdisp_global.h"
+
 #include <scMeas/realtimesamplearraychinfo.h>
 #include <fiff/fiff_types.h>
 #include <fiff/fiff_info.h>
@@ -100,7 +102,9 @@ using namespace UTILSLIB;
 //=============================================================================================================
 
 typedef QPair<const double*,qint32> RowVectorPair;
+typedef QPair<const float*,const float*> MinMaxRowPair;
 typedef Matrix<double,Dynamic,Dynamic,RowMajor> MatrixXdR;
+typedef Matrix<float,Dynamic,Dynamic,RowMajor> MatrixXfR;
 
 //=============================================================================================================
 /**
@@ -108,7 +112,7 @@ typedef Matrix<double,Dynamic,Dynamic,RowMajor> MatrixXdR;
 *
 * @brief The RealTimeMultiSampleArrayModel class implements the data access model for a real-time multi sample array data stream
 */
-class RealTimeMultiSampleArrayModel : public QAbstractTableModel
+class SCDISPSHARED_EXPORT RealTimeMultiSampleArrayModel : public QAbstractTableModel
 {
     Q_OBJECT
 public:
@@ -257,6 +261,36 @@ public:
     */
     inline double getLastBlockFirstValue(int row) const;
 
+    //=========================================================================================================
+    /**
+    * Returns the number of levels of the min/max pyramid of the displayed data
+    *
+    * @return the number of pyramid levels
+    */
+    inline qint32 getNumMinMaxLevels() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples which are summarized by one min/max bucket of the given pyramid level
+    *
+    * @param[in] level  the pyramid level
+    *
+    * @return the bucket size in samples
+    */
+    static inline qint32 getMinMaxBucketSize(qint32 level);
+
+    //=========================================================================================================
+    /**
+    * Returns the minima and maxima of the buckets of the given pyramid level for the displayed data of a row. The
+    * number of buckets is getMaxSamples() divided by getMinMaxBucketSize(level), rounded up.
+    *
+    * @param[in] row    row for which the min/max buckets are to be returned
+    * @param[in] level  the pyramid level
+    *
+    * @return pointers to the minima and maxima, both are null if the pyramid is not up to date
+    */
+    MinMaxRowPair getMinMaxRow(qint32 row, qint32 level) const;
+
     //=========================================================================================================
     /**
     * Returns a map which conatins the channel idx and its corresponding selection status
@@ -540,6 +574,25 @@ private:
     */
     void clearModel();
 
+    //=========================================================================================================
+    /**
+    * Returns the data matrix which is currently displayed (raw or filtered, streamed or freezed)
+    *
+    * @return the displayed data
+    */
+    inline const MatrixXdR& displayedData() const;
+
+    //=========================================================================================================
+    /**
+    * Updates the min/max pyramid for the columns [from, to) of the displayed data. A negative from wraps around to
+    * the end of the data. The whole pyramid is rebuilt if the displayed data matrix changed.
+    *
+    * @param [in] from      first changed column
+    * @param [in] to        column after the last changed column
+    * @param [in] bRebuild  whether to rebuild the whole pyramid
+    */
+    void updateMinMaxPyramid(qint32 from, qint32 to, bool bRebuild = false);
+
     bool                                m_bProjActivated;                           /**< Projections activated */
     bool                                m_bCompActivated;                           /**< Compensator activated */
     bool                                m_bSpharaActivated;                         /**< Sphara activated */
@@ -575,6 +628,10 @@ private:
     MatrixXdR                           m_matDataFilteredFreeze;                    /**< The raw filtered data in freeze mode */
     MatrixXd                            m_matOverlap;                               /**< Last overlap block for the back */
 
+    QList<MatrixXfR>                    m_qListMinPyramid;                          /**< Bucket minima of the displayed data, level l summarizes 2^(l+1) samples */
+    QList<MatrixXfR>                    m_qListMaxPyramid;                          /**< Bucket maxima of the displayed data, level l summarizes 2^(l+1) samples */
+    const double*                       m_pMinMaxSource;                            /**< The displayed data the pyramid was built from */
+
     Eigen::VectorXi                     m_vecIndicesFirstVV;                        /**< The indices of the channels to pick for the first SPHARA operator in case of a VectorView system.*/
     Eigen::VectorXi                     m_vecIndicesSecondVV;                       /**< The indices of the channels to pick for the second SPHARA operator in case of a VectorView system.*/
     Eigen::VectorXi                     m_vecIndicesFirstBabyMEG;                   /**< The indices of the channels to pick for the first SPHARA operator in case of a BabyMEG system.*/
@@ -676,6 +733,33 @@ inline double RealTimeMultiSampleArrayModel::getLastBlockFirstValue(int row) con
 }
 
 
+//*************************************************************************************************************
+
+inline qint32 RealTimeMultiSampleArrayModel::getNumMinMaxLevels() const
+{
+    return m_qListMinPyramid.size();
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 RealTimeMultiSampleArrayModel::getMinMaxBucketSize(qint32 level)
+{
+    return 2 << level;
+}
+
+
+//*************************************************************************************************************
+
+inline const MatrixXdR& RealTimeMultiSampleArrayModel::displayedData() const
+{
+    if(m_bIsFreezed)
+        return m_filterData.isEmpty() ? m_matDataRawFreeze : m_matDataFilteredFreeze;
+
+    return m_filterData.isEmpty() ? m_matDataRaw : m_matDataFiltered;
+}
+
+
 //*************************************************************************************************************
 
 inline const QMap<qint32,qint32>& RealTimeMultiSampleArrayModel::getIdxSelMap() const
@@ -94,6 +94,7 @@ Averaging::Averaging()
 , m_pAveragingBuffer(CircularMatrixBuffer<double>::SPtr())
 , m_bIsRunning(false)
 , m_bProcessData(false)
+, m_bEvokedSetUpdated(false)
 , m_iPreStimSeconds(100)
 , m_iPostStimSeconds(400)
 , m_dArtifactThresholdFirst(250)
@@ -199,6 +200,10 @@ bool Averaging::start()
     if(this->isRunning())
         QThread::wait();
 
+    //Drop the blocks and releases left over from the last run
+    if(m_pAveragingBuffer)
+        m_pAveragingBuffer->reset();
+
     m_qMutex.lock();
     m_bIsRunning = true;
     m_qMutex.unlock();
@@ -557,30 +562,26 @@ void Averaging::changeBaselineActive(bool state)
 
 //*************************************************************************************************************
 
-void Averaging::appendEvoked(FIFFLIB::FiffEvokedSet::SPtr p_pEvokedSet)
+void Averaging::updateEvoked(FIFFLIB::FiffEvoked::SPtr p_pEvoked)
 {
-//    qDebug() << "";
-//    qDebug() << "Averaging::appendEvoked - p_pEvokedSet INFO:";
-//    qDebug() << "p_pEvokedSet->evoked.size():" << p_pEvokedSet->evoked.size();
-//    qDebug() << "";
-
-//    for(int i = 0; i < p_pEvokedSet->evoked.size(); ++i) {
-//        qDebug() << p_pEvokedSet->evoked.at(i).comment <<"rows x cols:" << p_pEvokedSet->evoked.at(i).data.rows() << "x" << p_pEvokedSet->evoked.at(i).data.cols() << "-" << p_pEvokedSet->evoked.at(i).nave << "averages";
-//        //std::cout << p_pEvokedSet->evoked.at(i).data.block(0,0,10,10);
-//    }
+    QMutexLocker locker(&m_qMutex);
 
-    // << p_pEvoked->comment;
-//    qDebug() << p_pEvoked->comment;
-//    QString t_sStimulusChannel = m_pFiffInfo->chs[m_qListStimChs[m_iStimChan]].ch_name;
+    for(int i = 0; i < m_evokedSet.evoked.size(); ++i) {
+        if(m_evokedSet.evoked.at(i).comment == p_pEvoked->comment) {
+            FiffEvoked& evoked = m_evokedSet.evoked[i];
+            evoked.nave = p_pEvoked->nave;
+            evoked.baseline = p_pEvoked->baseline;
+            evoked.data = p_pEvoked->data;
+            m_bEvokedSetUpdated = true;
+            return;
+        }
+    }
 
-//    if(p_pEvoked->comment == t_sStimulusChannel)
-//    {
-//        qDebug()<< "append" << p_pEvoked->comment << "=" << t_sStimulusChannel;
-        m_qMutex.lock();
-        m_qVecEvokedData.push_back(p_pEvokedSet);
-        m_qMutex.unlock();
-//        qDebug() << "append after" << m_qVecEvokedData.size();
-//    }
+    //New trigger type
+    FiffEvoked evoked = *p_pEvoked;
+    evoked.setInfo(*m_pFiffInfo.data());
+    m_evokedSet.evoked.append(evoked);
+    m_bEvokedSetUpdated = true;
 }
 
 
@@ -606,6 +607,9 @@ void Averaging::resetAverage(bool state)
     if(m_pRtAve) {
         m_pRtAve->reset();
     }
+
+    m_evokedSet.evoked.clear();
+    m_bEvokedSetUpdated = false;
 }
 
 
@@ -636,6 +640,11 @@ void Averaging::run()
 
     m_bProcessData = true;
 
+    m_qMutex.lock();
+    m_evokedSet.evoked.clear();
+    m_bEvokedSetUpdated = false;
+    m_qMutex.unlock();
+
     //
     // Init Real-Time average
     //
@@ -646,8 +655,8 @@ void Averaging::run()
     m_pRtAve->setAverageMode(m_iAverageMode);
     m_pRtAve->setArtifactReduction(m_bDoArtifactThresholdReduction, m_dArtifactThresholdFirst * pow(10, m_iArtifactThresholdSecond), m_bDoArtifactVarianceReduction, m_dArtifactVariance);
 
-    connect(m_pRtAve.data(), &RtAve::evokedStim,
-            this, &Averaging::appendEvoked);
+    connect(m_pRtAve.data(), &RtAve::evokedStimUpdated,
+            this, &Averaging::updateEvoked);
 
     m_pRtAve->start();
 
@@ -673,17 +682,14 @@ void Averaging::run()
             m_pRtAve->append(rawSegment);
 
             m_qMutex.lock();
-            if(m_qVecEvokedData.size() > 0)
+            if(m_bEvokedSetUpdated)
             {
-                FiffEvokedSet t_fiffEvokedSet = *m_qVecEvokedData[0].data();
-
 #ifdef DEBUG_AVERAGING
-                std::cout << "EVK:" << t_fiffEvoked.data.row(0) << std::endl;
+                std::cout << "EVK:" << m_evokedSet.evoked.at(0).data.row(0) << std::endl;
 #endif
-                m_pAveragingOutput->data()->setValue(t_fiffEvokedSet, m_pFiffInfo);
-
-                m_qVecEvokedData.pop_front();
+                m_pAveragingOutput->data()->setValue(m_evokedSet, m_pFiffInfo);
 
+                m_bEvokedSetUpdated = false;
             }
             m_qMutex.unlock();
 
@@ -243,11 +243,12 @@ public:
 
     //=========================================================================================================
     /**
-    * Append new FiffEvokedSet to the buffer
+    * Updates the evoked of one trigger type in the evoked data set. The measurement info is only attached when a
+    * trigger type is seen for the first time.
     *
-    * @param[in] p_pEvokedSet     the new FiffEvokedSet
+    * @param[in] p_pEvoked     the updated evoked of one trigger type
     */
-    void appendEvoked(FIFFLIB::FiffEvokedSet::SPtr p_pEvokedSet);
+    void updateEvoked(FIFFLIB::FiffEvoked::SPtr p_pEvoked);
 
     //=========================================================================================================
     /**
@@ -280,7 +281,7 @@ private:
 
     QSharedPointer<AveragingSettingsWidget>         m_pAveragingWidget;                 /**< Holds averaging settings widget.*/
 
-    QVector<FIFFLIB::FiffEvokedSet::SPtr>           m_qVecEvokedData;                   /**< Evoked data set. */
+    FIFFLIB::FiffEvokedSet                          m_evokedSet;                        /**< Evoked data set. */
 
     QMutex                                          m_qMutex;                           /**< Provides access serialization between threads. */
 
@@ -291,6 +292,7 @@ private:
 
     bool                                            m_bIsRunning;                       /**< If this thread is running. */
     bool                                            m_bProcessData;                     /**< If data should be received for processing. */
+    bool                                            m_bEvokedSetUpdated;                /**< If the evoked data set was updated since it was last sent. */
     bool                                            m_bDoArtifactThresholdReduction;    /**< If trial rejection is to be done based on threshold. */
     bool                                            m_bDoArtifactVarianceReduction;     /**< If trial rejection is to be done based on variance. */
     bool                                            m_bDoBaselineCorrection;            /**< If baseline correction is to be performed. */
@@ -515,6 +515,9 @@ void MNE::run()
 
     qint32 skip_count = 0;
 
+    //The source estimate memory is reused between data blocks
+    MNESourceEstimate sourceEstimate;
+
 //    //
 //    // TEMP INV LOADING START
 //    //
@@ -572,11 +575,12 @@ void MNE::run()
                 m_qMutex.lock();
 
                 //TODO: Add picking here. See evoked part as input.
-                MNESourceEstimate sourceEstimate = m_pMinimumNorm->calculateInverse(rawSegment, tmin, tstep);
+                bool bSuccess = m_pMinimumNorm->calculateInverse(rawSegment, tmin, tstep, sourceEstimate);
 
                 m_qMutex.unlock();
 
-                m_pRTSEOutput->data()->setValue(sourceEstimate);
+                if(bSuccess)
+                    m_pRTSEOutput->data()->setValue(sourceEstimate);
             }
             else
             {
@@ -605,11 +609,12 @@ void MNE::run()
 
                 t_fiffEvoked = t_fiffEvoked.pick_channels(m_pInvOp->noise_cov->names);
 
-                MNESourceEstimate sourceEstimate = m_pMinimumNorm->calculateInverse(t_fiffEvoked.data, tmin, tstep);
+                bool bSuccess = m_pMinimumNorm->calculateInverse(t_fiffEvoked.data, tmin, tstep, sourceEstimate);
 
                 m_qMutex.unlock();
 
-                m_pRTSEOutput->data()->setValue(sourceEstimate);
+                if(bSuccess)
+                    m_pRTSEOutput->data()->setValue(sourceEstimate);
             }
             else
             {
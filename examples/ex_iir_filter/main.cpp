@@ -0,0 +1,181 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Example of filtering raw data with an IIR filter
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <iostream>
+
+#include <fiff/fiff.h>
+
+#include <utils/filterTools/iirfilter.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the program.
+* By default, main has the storage class extern.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return the value that was set to exit() (which is 0 if exit() is called via quit()).
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("IIR Filter Example");
+    parser.addHelpOption();
+
+    QCommandLineOption inputOption("fileIn", "The input file <in>.", "in", "./MNE-sample-data/MEG/sample/sample_audvis_raw.fif");
+    QCommandLineOption fromOption("from", "Read data from <from> (in seconds).", "from", "42.956");
+    QCommandLineOption toOption("to", "Read data to <to> (in seconds).", "to", "52.956");
+    QCommandLineOption lowOption("low", "High pass cutoff frequency <low> (in Hz).", "low", "1.0");
+    QCommandLineOption highOption("high", "Low pass cutoff frequency <high> (in Hz).", "high", "40.0");
+    QCommandLineOption orderOption("order", "Order <order> of the Butterworth prototype.", "order", "4");
+    QCommandLineOption blockOption("blockSize", "Number of samples per block <blockSize> for the causal filtering.", "blockSize", "200");
+
+    parser.addOption(inputOption);
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.addOption(lowOption);
+    parser.addOption(highOption);
+    parser.addOption(orderOption);
+    parser.addOption(blockOption);
+
+    parser.process(app);
+
+    QFile t_fileRaw(parser.value(inputOption));
+
+    float from = parser.value(fromOption).toFloat();
+    float to = parser.value(toOption).toFloat();
+    double dLow = parser.value(lowOption).toDouble();
+    double dHigh = parser.value(highOption).toDouble();
+    int iOrder = parser.value(orderOption).toInt();
+    int iBlockSize = qMax(parser.value(blockOption).toInt(), 1);
+
+    //
+    //   Read a data segment of the MEG and EEG channels
+    //
+    FiffRawData raw(t_fileRaw);
+
+    RowVectorXi picks = raw.info.pick_types(true, true, false, QStringList(), raw.info.bads);
+
+    MatrixXd data;
+    MatrixXd times;
+    if(!raw.read_raw_segment_times(data, times, from, to, picks)) {
+        printf("Could not read raw segment.\n");
+        return -1;
+    }
+
+    printf("Read %d channels with %d samples.\n", (qint32)data.rows(), (qint32)data.cols());
+
+    //
+    //   Design the band pass
+    //
+    IirFilter filter("BPF", IirFilter::BPF, IirFilter::Butterworth, iOrder, dLow, dHigh, raw.info.sfreq);
+
+    printf("Butterworth band pass %.1f - %.1f Hz with %d second order sections\n", dLow, dHigh, filter.numSections());
+    printf("Gain at %.1f Hz: %f\n", dLow / 10.0, std::abs(filter.frequencyResponse(dLow / 10.0)));
+    printf("Gain at %.1f Hz: %f\n", (dLow + dHigh) / 2.0, std::abs(filter.frequencyResponse((dLow + dHigh) / 2.0)));
+    printf("Gain at %.1f Hz: %f\n", 2.0 * dHigh, std::abs(filter.frequencyResponse(2.0 * dHigh)));
+
+    //
+    //   Causal filtering block by block, the filter keeps its state between the blocks as in real-time processing
+    //
+    MatrixXd dataCausal(data.rows(), data.cols());
+    MatrixXd dataBlock;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for(int i = 0; i < data.cols(); i += iBlockSize) {
+        int iCols = qMin(iBlockSize, (int)data.cols() - i);
+        filter.filterData(data.middleCols(i, iCols), dataBlock);
+        dataCausal.middleCols(i, iCols) = dataBlock;
+    }
+
+    printf("Causal filtering in blocks of %d samples took %d ms.\n", iBlockSize, (int)timer.elapsed());
+
+    //
+    //   Zero-phase filtering of the whole segment for offline analysis
+    //
+    timer.restart();
+
+    MatrixXd dataZeroPhase = filter.filterDataZeroPhase(data);
+
+    printf("Zero-phase filtering took %d ms.\n", (int)timer.elapsed());
+
+    std::cout << "Causal:" << std::endl << dataCausal.block(0,0,5,10) << std::endl;
+    std::cout << "Zero-phase:" << std::endl << dataZeroPhase.block(0,0,5,10) << std::endl;
+
+    return app.exec();
+}
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
@@ -50,6 +50,7 @@
 #include <mne/mne.h>
 #include <mne/mne_sourceestimate.h>
 
+#include <inverse/rapMusic/rapmusic.h>
 #include <inverse/rapMusic/pwlrapmusic.h>
 
 #include <disp3D/engine/view/view3D.h>
@@ -69,6 +70,7 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
 
 
 //*************************************************************************************************************
@@ -89,6 +91,122 @@ using namespace DISP3DLIB;
 // MAIN
 //=============================================================================================================
 
+//=============================================================================================================
+/**
+* Localization error of a found dipole pair: mean distance of both dipoles to the simulated ones, taking the
+* better of the two possible assignments.
+*
+* @param [in] rr        The source locations.
+* @param [in] iTrue1    Index of the first simulated dipole.
+* @param [in] iTrue2    Index of the second simulated dipole.
+* @param [in] dipoles   The found dipole pairs (the first one is evaluated).
+* @return the localization error in mm.
+*/
+double localizationError(const MatrixX3f& rr, int iTrue1, int iTrue2, const QList< DipolePair<double> >& dipoles)
+{
+    if(dipoles.isEmpty()) {
+        return -1;
+    }
+
+    int iIdx1 = dipoles[0].m_iIdx1;
+    int iIdx2 = dipoles[0].m_iIdx2;
+
+    float fErrA = (rr.row(iTrue1) - rr.row(iIdx1)).norm() + (rr.row(iTrue2) - rr.row(iIdx2)).norm();
+    float fErrB = (rr.row(iTrue1) - rr.row(iIdx2)).norm() + (rr.row(iTrue2) - rr.row(iIdx1)).norm();
+
+    return 1000.0 * 0.5 * std::min(fErrA, fErrB);
+}
+
+
+//=============================================================================================================
+/**
+* Benchmarks the coarse to fine Powell RAP MUSIC against the exhaustive RAP MUSIC on simulated correlated dipole
+* pairs with random locations and orientations. Reports the time and the localization error of both.
+*
+* @param [in] fwd           The (clustered) forward solution.
+* @param [in] iNumTrials    Number of simulated dipole pairs.
+* @param [in] iDecimation   Decimation factor of the coarse grid.
+* @param [in] dSnr          Amplitude signal to noise ratio of the simulated data.
+* @return 0 when the benchmark ran.
+*/
+int benchmark(MNEForwardSolution& fwd, int iNumTrials, int iDecimation, double dSnr)
+{
+    const MatrixXd& matGain = fwd.sol->data;
+    int iNumSources = matGain.cols()/3;
+    int iNumSamples = 100;
+
+    RapMusic rapMusic(fwd, false, 1);
+    PwlRapMusic pwlRapMusic(fwd, false, 1);
+    pwlRapMusic.setCoarseToFine(iDecimation);
+
+    //qrand picks the sources, the Eigen Random functions draw the orientations and the noise from std::rand
+    qsrand(42);
+    srand(42);
+
+    double dTimeRap = 0, dTimePwl = 0, dErrRap = 0, dErrPwl = 0;
+    int iNumEqual = 0;
+
+    QElapsedTimer timer;
+    QStringList lResults;
+
+    for(int i = 0; i < iNumTrials; ++i) {
+        //Correlated dipole pair with a common time course
+        int iTrue1 = qrand() % iNumSources;
+        int iTrue2 = qrand() % iNumSources;
+
+        Vector3d vecPhi1 = Vector3d::Random().normalized();
+        Vector3d vecPhi2 = Vector3d::Random().normalized();
+        VectorXd vecTopo = matGain.middleCols(iTrue1*3, 3) * vecPhi1 + matGain.middleCols(iTrue2*3, 3) * vecPhi2;
+
+        RowVectorXd vecTimeCourse(iNumSamples);
+        for(int t = 0; t < iNumSamples; ++t) {
+            vecTimeCourse(t) = sin(2.0 * M_PI * t / 25.0);
+        }
+
+        MatrixXd matData = vecTopo * vecTimeCourse;
+        double dNoise = vecTopo.cwiseAbs().maxCoeff() / dSnr;
+        matData += dNoise * MatrixXd::Random(matData.rows(), matData.cols());
+
+        QList< DipolePair<double> > lRapDipoles, lPwlDipoles;
+
+        timer.start();
+        rapMusic.calculateInverse(matData, lRapDipoles);
+        double dTRap = timer.nsecsElapsed() / 1000000.0;
+
+        timer.start();
+        pwlRapMusic.calculateInverse(matData, lPwlDipoles);
+        double dTPwl = timer.nsecsElapsed() / 1000000.0;
+
+        double dERap = localizationError(fwd.source_rr, iTrue1, iTrue2, lRapDipoles);
+        double dEPwl = localizationError(fwd.source_rr, iTrue1, iTrue2, lPwlDipoles);
+
+        if(!lRapDipoles.isEmpty() && !lPwlDipoles.isEmpty()
+                && lRapDipoles[0].m_iIdx1 == lPwlDipoles[0].m_iIdx1 && lRapDipoles[0].m_iIdx2 == lPwlDipoles[0].m_iIdx2) {
+            ++iNumEqual;
+        }
+
+        dTimeRap += dTRap;
+        dTimePwl += dTPwl;
+        dErrRap += dERap;
+        dErrPwl += dEPwl;
+
+        lResults << QString("%1\t%2\t%3\t%4\t%5").arg(i+1).arg(dTRap, 0, 'f', 1).arg(dERap, 0, 'f', 1).arg(dTPwl, 0, 'f', 1).arg(dEPwl, 0, 'f', 1);
+    }
+
+    std::cout << std::endl << "##### Benchmark: exhaustive RAP MUSIC vs. coarse to fine Powell RAP MUSIC ######" << std::endl;
+    std::cout << "Sources: " << iNumSources << "; Channels: " << matGain.rows() << "; Decimation: " << iDecimation << "; SNR: " << dSnr << std::endl << std::endl;
+    std::cout << "Trial\tRAP [ms]\tRAP err [mm]\tPWL [ms]\tPWL err [mm]" << std::endl;
+    for(int i = 0; i < lResults.size(); ++i) {
+        std::cout << lResults[i].toStdString() << std::endl;
+    }
+    std::cout << std::endl << "Mean RAP MUSIC: " << dTimeRap/iNumTrials << " ms, " << dErrRap/iNumTrials << " mm" << std::endl;
+    std::cout << "Mean PWL RAP MUSIC: " << dTimePwl/iNumTrials << " ms, " << dErrPwl/iNumTrials << " mm" << std::endl;
+    std::cout << "Speed-up: " << dTimeRap/dTimePwl << "; same dipole pair found in " << iNumEqual << " of " << iNumTrials << " trials" << std::endl;
+
+    return 0;
+}
+
+
 //=============================================================================================================
 /**
 * The function main marks the entry point of the program.
@@ -115,6 +233,9 @@ int main(int argc, char *argv[])
     QCommandLineOption doMovieOption("doMovie", "Create overlapping movie.", "doMovie", "false");
     QCommandLineOption annotOption("annotType", "Annotation type <type>.", "type", "aparc.a2009s");
     QCommandLineOption surfOption("surfType", "Surface type <type>.", "type", "orig");
+    QCommandLineOption benchmarkOption("benchmark", "Benchmark against the exhaustive RAP MUSIC with <number> simulated dipole pairs (0 = off).", "number", "0");
+    QCommandLineOption decimationOption("decim", "Decimation <factor> of the coarse search grid.", "factor", "5");
+    QCommandLineOption snrOption("snr", "Signal to noise <ratio> of the simulated benchmark data.", "ratio", "10");
 
     parser.addOption(fwdFileOption);
     parser.addOption(evokedFileOption);
@@ -125,6 +246,9 @@ int main(int argc, char *argv[])
     parser.addOption(doMovieOption);
     parser.addOption(annotOption);
     parser.addOption(surfOption);
+    parser.addOption(benchmarkOption);
+    parser.addOption(decimationOption);
+    parser.addOption(snrOption);
     parser.process(app);
 
     // Parse command line parameters
@@ -138,6 +262,8 @@ int main(int argc, char *argv[])
     QString t_sFileNameStc(parser.value(stcFileOption));
 
     qint32 numDipolePairs = parser.value(numDipolePairsOption).toInt();
+    qint32 numBenchmarkTrials = parser.value(benchmarkOption).toInt();
+    qint32 decimation = parser.value(decimationOption).toInt();
 
     bool doMovie = false;
     if(parser.value(doMovieOption) == "false" || parser.value(doMovieOption) == "0") {
@@ -173,7 +299,12 @@ int main(int argc, char *argv[])
 //    std::cout << "Clustered Fwd:\n" << t_clusteredFwd.sol->data.row(0) << std::endl;
 
 
+    if(numBenchmarkTrials > 0) {
+        return benchmark(t_clusteredFwd, numBenchmarkTrials, decimation, parser.value(snrOption).toDouble());
+    }
+
     PwlRapMusic t_pwlRapMusic(t_clusteredFwd, false, numDipolePairs);
+    t_pwlRapMusic.setCoarseToFine(decimation);
 
     int iWinSize = 200;
     if(doMovie) {
@@ -44,6 +44,7 @@ SUBDIRS += \
     ex_evoked_grad_amp \
     ex_fiff_io \
     ex_find_evoked \
+    ex_iir_filter \
     ex_inverse_mne \
     ex_make_inverse_operator \
     ex_make_layout \
@@ -37,6 +37,7 @@ include(../../mne-cpp.pri)
 
 TEMPLATE = lib
 
+QT += concurrent
 QT -= gui
 
 DEFINES += CONNECTIVITY_LIBRARY
@@ -90,6 +91,7 @@ else {
 SOURCES += \
     connectivitymeasures.cpp \
     network/network.cpp \
+    network/networkadjacency.cpp \
     network/networknode.cpp \
     network/networkedge.cpp \
     connectivitysettings.cpp \
@@ -99,6 +101,7 @@ HEADERS += \
     connectivity_global.h \
     connectivitymeasures.h \
     network/network.h \
+    network/networkadjacency.h \
     network/networknode.h \
     network/networkedge.h \
     connectivitysettings.h \
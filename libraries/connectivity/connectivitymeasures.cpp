@@ -43,6 +43,7 @@
 #include "network/networknode.h"
 #include "network/networkedge.h"
 #include "network/network.h"
+#include "network/networkadjacency.h"
 
 #include <iostream>
 
@@ -53,6 +54,8 @@
 //=============================================================================================================
 
 #include <QDebug>
+#include <QVector>
+#include <QtConcurrent>
 
 
 //*************************************************************************************************************
@@ -77,6 +80,49 @@ using namespace Eigen;
 // DEFINE GLOBAL METHODS
 //=============================================================================================================
 
+namespace
+{
+
+//=============================================================================================================
+/**
+* A tile of rows of the cross correlation matrix. Each tile pairs its rows with all following rows.
+*/
+struct CrossCorrTile
+{
+    int                 iFirst;         /**< First row of the tile. */
+    int                 iLast;          /**< One past the last row of the tile. */
+    int                 iFFTSize;       /**< FFT length. */
+    const MatrixXcd*    pSpectra;       /**< Half spectra of all rows, one column per row. */
+    MatrixXd*           pCorr;          /**< The resulting maxima. */
+};
+
+//=============================================================================================================
+/**
+* Computes the cross correlation maxima of one tile. The second row is the outer loop, so its spectrum is read
+* once per tile while the spectra of the tile rows stay in cache.
+*/
+void calcCrossCorrTile(CrossCorrTile& tile)
+{
+    const MatrixXcd& matSpectra = *tile.pSpectra;
+    MatrixXd& matCorr = *tile.pCorr;
+
+    Eigen::FFT<double> fft;
+    fft.SetFlag(fft.HalfSpectrum);
+
+    VectorXcd vecProduct(matSpectra.rows());
+    VectorXd vecResult(tile.iFFTSize);
+
+    for(int j = tile.iFirst; j < matSpectra.cols(); ++j) {
+        for(int i = tile.iFirst; i < tile.iLast && i <= j; ++i) {
+            vecProduct = matSpectra.col(i).cwiseProduct(matSpectra.col(j).conjugate());
+            fft.inv(vecResult, vecProduct);
+            matCorr(i,j) = vecResult.maxCoeff();
+        }
+    }
+}
+
+} // NAMESPACE
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -95,31 +141,12 @@ Network ConnectivityMeasures::pearsonsCorrelationCoeff(const MatrixXd& matData,
     Network finalNetwork("Pearson's Correlation Coefficient");
 
     //Create nodes
-    for(int i = 0; i < matData.rows(); ++i) {
-        RowVectorXf rowVert = RowVectorXf::Zero(3);
-
-        if(matVert.rows() != 0 && i < matVert.rows()) {
-            rowVert(0) = matVert.row(i)(0);
-            rowVert(1) = matVert.row(i)(1);
-            rowVert(2) = matVert.row(i)(2);
-        }
-
-        finalNetwork << NetworkNode::SPtr(new NetworkNode(i, rowVert));
-    }
+    finalNetwork.setNodeVertices(createNodeVertices(matData.rows(), matVert));
 
-    //Create edges
-    double pearsonsCoeff;
-
-    for(int i = 0; i < matData.rows(); ++i) {
-        for(int j = i; j < matData.rows(); ++j) {
-            pearsonsCoeff = calcPearsonsCorrelationCoeff(matData.row(i), matData.row(j));
-
-            QSharedPointer<NetworkEdge> pEdge = QSharedPointer<NetworkEdge>(new NetworkEdge(finalNetwork.getNodes()[i], finalNetwork.getNodes()[j], pearsonsCoeff));
-
-            *finalNetwork.getNodeAt(i) << pEdge;
-            finalNetwork << pEdge;
-        }
-    }
+    //Create edges from the lower triangle
+    NetworkAdjacency adjacency;
+    adjacency.setDenseWeights(calcPearsonsCorrelationMatrix(matData), false);
+    finalNetwork.setAdjacency(adjacency);
 
     return finalNetwork;
 }
@@ -132,31 +159,12 @@ Network ConnectivityMeasures::crossCorrelation(const MatrixXd& matData, const Ma
     Network finalNetwork("Cross Correlation");
 
     //Create nodes
-    for(int i = 0; i < matData.rows(); ++i) {
-        RowVectorXf rowVert = RowVectorXf::Zero(3);
+    finalNetwork.setNodeVertices(createNodeVertices(matData.rows(), matVert));
 
-        if(matVert.rows() != 0 && i < matVert.rows()) {
-            rowVert(0) = matVert.row(i)(0);
-            rowVert(1) = matVert.row(i)(1);
-            rowVert(2) = matVert.row(i)(2);
-        }
-
-        finalNetwork << NetworkNode::SPtr(new NetworkNode(i, rowVert));
-    }
-
-    //Create edges
-    QPair<int,double> crossCorrPair;
-
-    for(int i = 0; i < matData.rows(); ++i) {
-        for(int j = i; j < matData.rows(); ++j) {
-            crossCorrPair = calcCrossCorrelation(matData.row(i), matData.row(j));
-
-            QSharedPointer<NetworkEdge> pEdge = QSharedPointer<NetworkEdge>(new NetworkEdge(finalNetwork.getNodes()[i], finalNetwork.getNodes()[j], crossCorrPair.second));
-
-            *finalNetwork.getNodeAt(i) << pEdge;
-            finalNetwork << pEdge;
-        }
-    }
+    //Create edges from the upper triangle
+    NetworkAdjacency adjacency;
+    adjacency.setDenseWeights(calcCrossCorrelationMatrix(matData), true);
+    finalNetwork.setAdjacency(adjacency);
 
 //    finalNetwork.scale();
 //    matDist /= matDist.maxCoeff();
@@ -205,13 +213,8 @@ QPair<int,double> ConnectivityMeasures::calcCrossCorrelation(const RowVectorXd&
     fft.fwd(freqvec, xCorrInputVecFirst);
     fft.fwd(freqvec2, xCorrInputVecSecond);
 
-    //Create conjugate complex
-    freqvec2.conjugate();
-
-    //Main step of cross corr
-    for (int i = 0; i < fftsize; i++) {
-        freqvec[i] = freqvec[i] * freqvec2[i];
-    }
+    //Main step of cross corr, multiply with the conjugate complex
+    freqvec = freqvec.cwiseProduct(freqvec2.conjugate());
 
     RowVectorXd result;
     fft.inv(result, freqvec);
@@ -239,3 +242,76 @@ QPair<int,double> ConnectivityMeasures::calcCrossCorrelation(const RowVectorXd&
 
     return QPair<int,double>(resultIndex, maxValue);
 }
+
+
+//*************************************************************************************************************
+
+MatrixXd ConnectivityMeasures::calcPearsonsCorrelationMatrix(const MatrixXd& matData)
+{
+    MatrixXd matCoeffs = MatrixXd::Zero(matData.rows(), matData.rows());
+
+    if(matData.cols() == 0) {
+        return matCoeffs;
+    }
+
+    //All dot products at once, one symmetric rank update fills the lower triangle
+    matCoeffs.selfadjointView<Lower>().rankUpdate(matData, 1.0 / matData.cols());
+
+    return matCoeffs;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd ConnectivityMeasures::calcCrossCorrelationMatrix(const MatrixXd& matData)
+{
+    const int iRows = matData.rows();
+    MatrixXd matCorr = MatrixXd::Zero(iRows, iRows);
+
+    if(iRows == 0 || matData.cols() == 0) {
+        return matCorr;
+    }
+
+    //Compute the FFT size as the "next power of 2" of twice the input length
+    int b = ceil(log2(2.0 * matData.cols() - 1));
+    int fftsize = pow(2, qMax(b, 1));
+
+    //Transform every row once, the half spectra are stored column wise
+    Eigen::FFT<double> fft;
+    fft.SetFlag(fft.HalfSpectrum);
+
+    MatrixXcd matSpectra(fftsize/2 + 1, iRows);
+    VectorXd vecZeroPad = VectorXd::Zero(fftsize);
+    VectorXcd vecSpectrum;
+
+    for(int i = 0; i < iRows; ++i) {
+        vecZeroPad.head(matData.cols()) = matData.row(i).transpose();
+        fft.fwd(vecSpectrum, vecZeroPad);
+        matSpectra.col(i) = vecSpectrum;
+    }
+
+    //Split the rows into small tiles, the triangular work load is balanced by the thread pool
+    const int iTileSize = 8;
+    QVector<CrossCorrTile> lTiles;
+    for(int i = 0; i < iRows; i += iTileSize) {
+        CrossCorrTile tile = { i, qMin(i + iTileSize, iRows), fftsize, &matSpectra, &matCorr };
+        lTiles.append(tile);
+    }
+
+    QtConcurrent::blockingMap(lTiles, calcCrossCorrTile);
+
+    return matCorr;
+}
+
+
+//*************************************************************************************************************
+
+MatrixX3f ConnectivityMeasures::createNodeVertices(int iNumberNodes, const MatrixX3f& matVert)
+{
+    MatrixX3f matNodeVert = MatrixX3f::Zero(iNumberNodes, 3);
+
+    int iNumberVert = qMin(iNumberNodes, int(matVert.rows()));
+    matNodeVert.topRows(iNumberVert) = matVert.topRows(iNumberVert);
+
+    return matNodeVert;
+}
@@ -149,6 +149,41 @@ protected:
     */
     static QPair<int,double> calcCrossCorrelation(const Eigen::RowVectorXd &vecFirst, const Eigen::RowVectorXd &vecSecond);
 
+    //=========================================================================================================
+    /**
+    * Calculates the Pearson's correlation coefficient between all rows of the data matrix with one symmetric
+    * rank update.
+    *
+    * @param[in] matData    The input data.
+    *
+    * @return               The coefficients, only the lower triangle (including the diagonal) is set.
+    */
+    static Eigen::MatrixXd calcPearsonsCorrelationMatrix(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Calculates the maximum of the cross correlation between all rows of the data matrix. Every row is
+    * transformed once, the spectral products and inverse transforms are computed in tiles of rows which are
+    * processed concurrently.
+    *
+    * @param[in] matData    The input data.
+    *
+    * @return               The maxima, only the upper triangle (including the diagonal) is set.
+    */
+    static Eigen::MatrixXd calcCrossCorrelationMatrix(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Creates the node positions for a network with iNumberNodes nodes. Nodes without a vertex are placed at the
+    * origin.
+    *
+    * @param[in] iNumberNodes   The number of nodes.
+    * @param[in] matVert        The vertices to use.
+    *
+    * @return                   The node positions.
+    */
+    static Eigen::MatrixX3f createNodeVertices(int iNumberNodes, const Eigen::MatrixX3f& matVert);
+
 };
 
 
@@ -50,6 +50,8 @@
 // QT INCLUDES
 //=============================================================================================================
 
+#include <QDebug>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -79,7 +81,41 @@ using namespace Eigen;
 
 Network::Network(const QString& sConnectivityMethod)
 : m_sConnectivityMethod(sConnectivityMethod)
+, m_pAdjacency(NetworkAdjacency::ConstSPtr(new NetworkAdjacency()))
+, m_bObjectsOutdated(false)
+, m_bAdjacencyOutdated(false)
+{
+}
+
+
+//*************************************************************************************************************
+
+Network::Network(const Network& other)
 {
+    *this = other;
+}
+
+
+//*************************************************************************************************************
+
+Network& Network::operator=(const Network& other)
+{
+    if(this == &other) {
+        return *this;
+    }
+
+    QMutexLocker locker(&other.m_qMutex);
+
+    m_lEdges = other.m_lEdges;
+    m_lNodes = other.m_lNodes;
+    m_matDistMatrix = other.m_matDistMatrix;
+    m_sConnectivityMethod = other.m_sConnectivityMethod;
+    m_matNodeVert = other.m_matNodeVert;
+    m_pAdjacency = other.m_pAdjacency;
+    m_bObjectsOutdated = other.m_bObjectsOutdated;
+    m_bAdjacencyOutdated = other.m_bAdjacencyOutdated;
+
+    return *this;
 }
 
 
@@ -93,16 +129,123 @@ MatrixXd Network::getConnectivityMatrix() const
 
 //*************************************************************************************************************
 
-const QList<NetworkEdge::SPtr>& Network::getEdges() const
+void Network::setNodeVertices(const MatrixX3f& matVert)
 {
+    QMutexLocker locker(&m_qMutex);
+
+    //Keep the edges which were added as objects
+    if(m_bAdjacencyOutdated) {
+        createAdjacency();
+    }
+
+    m_matNodeVert = matVert;
+
+    m_lNodes.clear();
+    m_lEdges.clear();
+
+    if(m_pAdjacency->getNumberNodes() != matVert.rows()) {
+        m_pAdjacency = NetworkAdjacency::ConstSPtr(new NetworkAdjacency(matVert.rows()));
+    }
+
+    m_bAdjacencyOutdated = false;
+    m_bObjectsOutdated = true;
+}
+
+
+//*************************************************************************************************************
+
+const MatrixX3f& Network::getNodeVertices() const
+{
+    return m_matNodeVert;
+}
+
+
+//*************************************************************************************************************
+
+int Network::getNumberNodes() const
+{
+    return m_matNodeVert.rows();
+}
+
+
+//*************************************************************************************************************
+
+void Network::setAdjacency(const NetworkAdjacency& adjacency)
+{
+    if(adjacency.getNumberNodes() != m_matNodeVert.rows()) {
+        qWarning() << "Network::setAdjacency - Number of nodes does not match the node vertices. Returning.";
+        return;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+
+    m_pAdjacency = NetworkAdjacency::ConstSPtr(new NetworkAdjacency(adjacency));
+
+    m_lNodes.clear();
+    m_lEdges.clear();
+
+    m_bAdjacencyOutdated = false;
+    m_bObjectsOutdated = true;
+}
+
+
+//*************************************************************************************************************
+
+const NetworkAdjacency& Network::getAdjacency() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bAdjacencyOutdated) {
+        createAdjacency();
+    }
+
+    return *m_pAdjacency;
+}
+
+
+//*************************************************************************************************************
+
+void Network::sparsify(double dThreshold)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bAdjacencyOutdated) {
+        createAdjacency();
+    }
+
+    m_pAdjacency = NetworkAdjacency::ConstSPtr(new NetworkAdjacency(m_pAdjacency->sparsify(dThreshold)));
+
+    //Already created objects are regenerated from the sparsified adjacency on demand
+    m_lNodes.clear();
+    m_lEdges.clear();
+    m_bObjectsOutdated = true;
+}
+
+
+//*************************************************************************************************************
+
+QList<NetworkEdge::SPtr> Network::getEdges() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bObjectsOutdated) {
+        createObjects();
+    }
+
     return m_lEdges;
 }
 
 
 //*************************************************************************************************************
 
-const QList<NetworkNode::SPtr>& Network::getNodes() const
+QList<NetworkNode::SPtr> Network::getNodes() const
 {
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bObjectsOutdated) {
+        createObjects();
+    }
+
     return m_lNodes;
 }
 
@@ -111,7 +254,7 @@ const QList<NetworkNode::SPtr>& Network::getNodes() const
 
 NetworkEdge::SPtr Network::getEdgeAt(int i)
 {
-    return m_lEdges.at(i);
+    return getEdges().at(i);
 }
 
 
@@ -119,7 +262,7 @@ NetworkEdge::SPtr Network::getEdgeAt(int i)
 
 NetworkNode::SPtr Network::getNodeAt(int i)
 {
-    return m_lNodes.at(i);
+    return getNodes().at(i);
 }
 
 
@@ -127,10 +270,22 @@ NetworkNode::SPtr Network::getNodeAt(int i)
 
 qint16 Network::getDistribution() const
 {
+    QMutexLocker locker(&m_qMutex);
+
     qint16 distribution = 0;
 
-    for(NetworkNode::SPtr node : m_lNodes) {
-        distribution += node->getDegree();
+    if(!m_bObjectsOutdated) {
+        for(const NetworkNode::SPtr& node : m_lNodes) {
+            distribution += node->getDegree();
+        }
+
+        return distribution;
+    }
+
+    //Same as the node objects created from the adjacency: each edge is an out edge of its start node, a self loop
+    //is also an in edge
+    for(NetworkAdjacency::ConstIterator it = m_pAdjacency->begin(); it != m_pAdjacency->end(); ++it) {
+        distribution += it.row() == it.col() ? 2 : 1;
     }
 
     return distribution;
@@ -157,7 +312,14 @@ QString Network::getConnectivityMethod() const
 
 Network& Network::operator<<(NetworkEdge::SPtr newEdge)
 {
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bObjectsOutdated) {
+        createObjects();
+    }
+
     m_lEdges << newEdge;
+    m_bAdjacencyOutdated = true;
 
     return *this;
 }
@@ -167,8 +329,22 @@ Network& Network::operator<<(NetworkEdge::SPtr newEdge)
 
 Network& Network::operator<<(NetworkNode::SPtr newNode)
 {
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bObjectsOutdated) {
+        createObjects();
+    }
+
     m_lNodes << newNode;
 
+    m_matNodeVert.conservativeResize(m_matNodeVert.rows() + 1, 3);
+    m_matNodeVert.row(m_matNodeVert.rows() - 1).setZero();
+    for(int i = 0; i < 3 && i < newNode->getVert().size(); ++i) {
+        m_matNodeVert(m_matNodeVert.rows() - 1, i) = newNode->getVert()(i);
+    }
+
+    m_bAdjacencyOutdated = true;
+
     return *this;
 }
 
@@ -177,21 +353,55 @@ Network& Network::operator<<(NetworkNode::SPtr newNode)
 
 MatrixXd Network::generateConnectMat() const
 {
-    MatrixXd matDist(m_lNodes.size(), m_lNodes.size());
-    matDist.setZero();
+    return getAdjacency().toDense();
+}
+
+
+//*************************************************************************************************************
+
+void Network::createObjects() const
+{
+    m_bObjectsOutdated = false;
+
+    m_lNodes.clear();
+    m_lEdges.clear();
+
+    for(int i = 0; i < m_matNodeVert.rows(); ++i) {
+        m_lNodes << NetworkNode::SPtr(new NetworkNode(i, m_matNodeVert.row(i)));
+    }
+
+    const NetworkAdjacency& adjacency = *m_pAdjacency;
+
+    for(NetworkAdjacency::ConstIterator it = adjacency.begin(); it != adjacency.end(); ++it) {
+        NetworkEdge::SPtr pEdge = NetworkEdge::SPtr(new NetworkEdge(m_lNodes.at(it.row()), m_lNodes.at(it.col()), it.weight()));
+
+        *m_lNodes.at(it.row()) << pEdge;
+        m_lEdges << pEdge;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void Network::createAdjacency() const
+{
+    m_bAdjacencyOutdated = false;
+
+    std::vector<Triplet<double> > lTriplets;
+    lTriplets.reserve(m_lEdges.size());
 
-    for(int i = 0; i < m_lEdges.size(); ++i)
-    {
-        int row = m_lEdges.at(i)->getStartNode()->getId();
-        int col = m_lEdges.at(i)->getEndNode()->getId();
+    for(const NetworkEdge::SPtr& pEdge : m_lEdges) {
+        int iStart = pEdge->getStartNode()->getId();
+        int iEnd = pEdge->getEndNode()->getId();
 
-        if(row < matDist.rows() && col < matDist.cols())
-        {
-            matDist(row,col) = m_lEdges.at(i)->getWeight();
+        if(iStart >= 0 && iEnd >= 0 && iStart < m_lNodes.size() && iEnd < m_lNodes.size()) {
+            lTriplets.push_back(Triplet<double>(iStart, iEnd, pEdge->getWeight()));
         }
     }
 
-    return matDist;
+    NetworkAdjacency::SPtr pAdjacency = NetworkAdjacency::SPtr(new NetworkAdjacency());
+    pAdjacency->setSparseWeights(m_lNodes.size(), lTriplets);
+    m_pAdjacency = pAdjacency;
 }
 
 
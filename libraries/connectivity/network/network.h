@@ -44,6 +44,8 @@
 
 #include "../connectivity_global.h"
 
+#include "networkadjacency.h"
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -51,6 +53,7 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QMutex>
 
 
 //*************************************************************************************************************
@@ -106,6 +109,24 @@ public:
     */
     explicit Network(const QString& sConnectivityMethod = "Unknown");
 
+    //=========================================================================================================
+    /**
+    * Copy constructor. The adjacency is shared, node and edge objects are shared until they are regenerated.
+    *
+    * @param[in] other      The network to copy.
+    */
+    Network(const Network& other);
+
+    //=========================================================================================================
+    /**
+    * Assignment operator.
+    *
+    * @param[in] other      The network to copy.
+    *
+    * @return This network.
+    */
+    Network& operator=(const Network& other);
+
     //=========================================================================================================
     /**
     * Returns the connectivity matrix for this network structure.
@@ -116,19 +137,72 @@ public:
 
     //=========================================================================================================
     /**
-    * Returns the edges.
+    * Sets the node positions. Node i is identified by row i. Any previously added node and edge objects are
+    * dropped and the adjacency is reset if its size does not match.
+    *
+    * @param[in] matVert    The node positions as a number of nodes x 3 matrix.
+    */
+    void setNodeVertices(const Eigen::MatrixX3f& matVert);
+
+    //=========================================================================================================
+    /**
+    * Returns the node positions. Node i is identified by row i.
+    *
+    * @return The node positions as a number of nodes x 3 matrix.
+    */
+    const Eigen::MatrixX3f& getNodeVertices() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of nodes.
+    *
+    * @return The number of nodes.
+    */
+    int getNumberNodes() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the compact adjacency of this network. The number of nodes must match the node vertices. Any previously
+    * added node and edge objects are dropped; they are regenerated from the adjacency on demand.
+    *
+    * @param[in] adjacency  The new adjacency.
+    */
+    void setAdjacency(const NetworkAdjacency& adjacency);
+
+    //=========================================================================================================
+    /**
+    * Returns the compact adjacency of this network. This is the preferred way to access large networks, since it
+    * does not allocate node and edge objects.
+    *
+    * @return The adjacency.
+    */
+    const NetworkAdjacency& getAdjacency() const;
+
+    //=========================================================================================================
+    /**
+    * Drops all edges with |weight| < dThreshold and switches the adjacency to CSR storage.
+    *
+    * @param[in] dThreshold     The absolute weight threshold.
+    */
+    void sparsify(double dThreshold);
+
+    //=========================================================================================================
+    /**
+    * Returns the edges. For networks built from a compact adjacency the edge objects are created on first access.
+    * The list is returned by value, since it may be regenerated by another thread after this call.
     *
     * @return Returns the network edges.
     */
-    const QList<QSharedPointer<NetworkEdge> >& getEdges() const;
+    QList<QSharedPointer<NetworkEdge> > getEdges() const;
 
     //=========================================================================================================
     /**
-    * Returns the nodes.
+    * Returns the nodes. For networks built from a compact adjacency the node objects are created on first access.
+    * The list is returned by value, since it may be regenerated by another thread after this call.
     *
     * @return Returns the network nodes.
     */
-    const QList<QSharedPointer<NetworkNode> >& getNodes() const;
+    QList<QSharedPointer<NetworkNode> > getNodes() const;
 
     //=========================================================================================================
     /**
@@ -152,7 +226,8 @@ public:
 
     //=========================================================================================================
     /**
-    * Returns network distribution, also known as network degree.
+    * Returns network distribution, also known as network degree. Each edge counts once for its start node, a self
+    * loop counts twice.
     *
     * @return   The network distribution calculated as degrees of all nodes together.
     */
@@ -191,12 +266,30 @@ public:
     Network &operator<<(QSharedPointer<NetworkNode> newNode);
 
 protected:
-    QList<QSharedPointer<NetworkEdge> >     m_lEdges;                   /**< List with all edges of the network.*/
-    QList<QSharedPointer<NetworkNode> >     m_lNodes;                   /**< List with all nodes of the network.*/
+    mutable QList<QSharedPointer<NetworkEdge> >     m_lEdges;                   /**< List with all edges of the network.*/
+    mutable QList<QSharedPointer<NetworkNode> >     m_lNodes;                   /**< List with all nodes of the network.*/
+
+    Eigen::MatrixXd                                 m_matDistMatrix;            /**< The distance matrix.*/
+
+    QString                                         m_sConnectivityMethod;      /**< The connectivity measure method used to create the data of this network structure.*/
+
+    Eigen::MatrixX3f                                m_matNodeVert;              /**< The node positions (one row per node).*/
+    mutable NetworkAdjacency::ConstSPtr             m_pAdjacency;               /**< The compact adjacency, shared between copies.*/
+    mutable bool                                    m_bObjectsOutdated;         /**< Whether m_lNodes/m_lEdges need to be regenerated from the adjacency.*/
+    mutable bool                                    m_bAdjacencyOutdated;       /**< Whether the adjacency needs to be regenerated from m_lEdges.*/
+    mutable QMutex                                  m_qMutex;                   /**< Guards the lazy regeneration in the const getters, which are called from worker threads.*/
 
-    Eigen::MatrixXd                         m_matDistMatrix;            /**< The distance matrix.*/
+    //=========================================================================================================
+    /**
+    * Creates the node and edge objects from the node vertices and the adjacency.
+    */
+    void createObjects() const;
 
-    QString                                 m_sConnectivityMethod;      /**< The connectivity measure method used to create the data of this network structure.*/
+    //=========================================================================================================
+    /**
+    * Creates the adjacency from the edge objects.
+    */
+    void createAdjacency() const;
 
     //=========================================================================================================
     /**
@@ -0,0 +1,367 @@
+//=============================================================================================================
+/**
+* @file     networkadjacency.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    NetworkAdjacency class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "networkadjacency.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace CONNECTIVITYLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+template<typename Func>
+void NetworkAdjacency::forEachEntry(Func func) const
+{
+    if(m_storageType == Dense) {
+        const double* pWeight = m_vecDenseWeights.data();
+
+        for(int i = 0; i < m_iNumberNodes; ++i) {
+            for(int j = i; j < m_iNumberNodes; ++j) {
+                func(i, j, *pWeight++);
+            }
+        }
+    } else {
+        for(int i = 0; i < m_matSparseWeights.outerSize(); ++i) {
+            for(SparseWeights::InnerIterator it(m_matSparseWeights, i); it; ++it) {
+                func(i, int(it.col()), it.value());
+            }
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::ConstIterator::ConstIterator(const NetworkAdjacency* pAdjacency, int iRow, qint64 iPos)
+: m_pAdjacency(pAdjacency)
+, m_iRow(iRow)
+, m_iCol(0)
+, m_iPos(iPos)
+{
+    updateColumn();
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::ConstIterator& NetworkAdjacency::ConstIterator::operator++()
+{
+    ++m_iPos;
+
+    if(m_pAdjacency->m_storageType == Dense) {
+        if(++m_iCol >= m_pAdjacency->m_iNumberNodes) {
+            ++m_iRow;
+            m_iCol = m_iRow;
+        }
+    } else {
+        updateColumn();
+    }
+
+    return *this;
+}
+
+
+//*************************************************************************************************************
+
+void NetworkAdjacency::ConstIterator::updateColumn()
+{
+    if(m_pAdjacency->m_storageType == Dense) {
+        m_iCol = m_iRow + int(m_iPos - m_pAdjacency->denseRowOffset(m_iRow));
+        return;
+    }
+
+    const SparseWeights& matWeights = m_pAdjacency->m_matSparseWeights;
+
+    //Skip empty rows
+    while(m_iRow < matWeights.outerSize() && m_iPos >= matWeights.outerIndexPtr()[m_iRow + 1]) {
+        ++m_iRow;
+    }
+
+    m_iCol = m_iRow < matWeights.outerSize() ? matWeights.innerIndexPtr()[m_iPos] : 0;
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::NetworkAdjacency(int iNumberNodes)
+: m_storageType(Dense)
+, m_iNumberNodes(iNumberNodes)
+, m_vecDenseWeights(VectorXd::Zero(qint64(iNumberNodes) * (iNumberNodes + 1) / 2))
+{
+}
+
+
+//*************************************************************************************************************
+
+void NetworkAdjacency::setDenseWeights(const MatrixXd& matWeights, bool bUpper)
+{
+    m_storageType = Dense;
+    m_iNumberNodes = int(matWeights.rows());
+    m_matSparseWeights = SparseWeights();
+    m_vecDenseWeights.resize(qint64(m_iNumberNodes) * (m_iNumberNodes + 1) / 2);
+
+    //Column j of the lower triangle is row j of the upper triangle, which keeps the copy contiguous for both
+    for(int i = 0; i < m_iNumberNodes; ++i) {
+        if(bUpper) {
+            m_vecDenseWeights.segment(denseRowOffset(i), m_iNumberNodes - i) = matWeights.row(i).tail(m_iNumberNodes - i).transpose();
+        } else {
+            m_vecDenseWeights.segment(denseRowOffset(i), m_iNumberNodes - i) = matWeights.col(i).tail(m_iNumberNodes - i);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void NetworkAdjacency::setSparseWeights(int iNumberNodes, const std::vector<Triplet<double> >& lTriplets)
+{
+    //The upper triangle goes first, so it wins over the mirrored lower triangle when duplicates are collapsed
+    std::vector<Triplet<double> > lUpper;
+    lUpper.reserve(lTriplets.size());
+
+    for(const Triplet<double>& triplet : lTriplets) {
+        if(triplet.row() <= triplet.col()) {
+            lUpper.push_back(triplet);
+        }
+    }
+
+    for(const Triplet<double>& triplet : lTriplets) {
+        if(triplet.row() > triplet.col()) {
+            lUpper.push_back(Triplet<double>(triplet.col(), triplet.row(), triplet.value()));
+        }
+    }
+
+    m_storageType = Sparse;
+    m_iNumberNodes = iNumberNodes;
+    m_vecDenseWeights.resize(0);
+    m_matSparseWeights = SparseWeights(iNumberNodes, iNumberNodes);
+    m_matSparseWeights.setFromTriplets(lUpper.begin(), lUpper.end(), [](const double& dFirst, const double&) { return dFirst; });
+    m_matSparseWeights.makeCompressed();
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::StorageType NetworkAdjacency::getStorageType() const
+{
+    return m_storageType;
+}
+
+
+//*************************************************************************************************************
+
+int NetworkAdjacency::getNumberNodes() const
+{
+    return m_iNumberNodes;
+}
+
+
+//*************************************************************************************************************
+
+qint64 NetworkAdjacency::getNumberEntries() const
+{
+    return m_storageType == Dense ? m_vecDenseWeights.size() : m_matSparseWeights.nonZeros();
+}
+
+
+//*************************************************************************************************************
+
+double NetworkAdjacency::getWeight(int i, int j) const
+{
+    if(i > j) {
+        std::swap(i, j);
+    }
+
+    if(i < 0 || j >= m_iNumberNodes) {
+        return 0.0;
+    }
+
+    return m_storageType == Dense ? m_vecDenseWeights[denseRowOffset(i) + j - i] : m_matSparseWeights.coeff(i, j);
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::ConstIterator NetworkAdjacency::begin() const
+{
+    return ConstIterator(this, 0, 0);
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency::ConstIterator NetworkAdjacency::end() const
+{
+    return ConstIterator(this, m_iNumberNodes, getNumberEntries());
+}
+
+
+//*************************************************************************************************************
+
+NetworkAdjacency NetworkAdjacency::sparsify(double dThreshold, bool bKeepSelfLoops) const
+{
+    //Count first so the CSR arrays are allocated exactly once
+    VectorXi vecRowCount = VectorXi::Zero(m_iNumberNodes);
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(std::fabs(dWeight) >= dThreshold && (bKeepSelfLoops || i != j)) {
+            ++vecRowCount[i];
+        }
+    });
+
+    NetworkAdjacency sparseAdjacency;
+    sparseAdjacency.m_storageType = Sparse;
+    sparseAdjacency.m_iNumberNodes = m_iNumberNodes;
+    sparseAdjacency.m_vecDenseWeights.resize(0);
+
+    SparseWeights& matWeights = sparseAdjacency.m_matSparseWeights;
+    matWeights.resize(m_iNumberNodes, m_iNumberNodes);
+    matWeights.reserve(vecRowCount);
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(std::fabs(dWeight) >= dThreshold && (bKeepSelfLoops || i != j)) {
+            matWeights.insert(i, j) = dWeight;
+        }
+    });
+
+    matWeights.makeCompressed();
+
+    return sparseAdjacency;
+}
+
+
+//*************************************************************************************************************
+
+VectorXi NetworkAdjacency::getDegrees(double dThreshold) const
+{
+    VectorXi vecDegrees = VectorXi::Zero(m_iNumberNodes);
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(i != j && std::fabs(dWeight) >= dThreshold) {
+            ++vecDegrees[i];
+            ++vecDegrees[j];
+        }
+    });
+
+    return vecDegrees;
+}
+
+
+//*************************************************************************************************************
+
+VectorXd NetworkAdjacency::getStrengths(double dThreshold) const
+{
+    VectorXd vecStrengths = VectorXd::Zero(m_iNumberNodes);
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(i != j && std::fabs(dWeight) >= dThreshold) {
+            vecStrengths[i] += dWeight;
+            vecStrengths[j] += dWeight;
+        }
+    });
+
+    return vecStrengths;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXi NetworkAdjacency::getEdgeIndices(double dThreshold) const
+{
+    qint64 iNumberEdges = 0;
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(i != j && std::fabs(dWeight) >= dThreshold) {
+            ++iNumberEdges;
+        }
+    });
+
+    MatrixXi matIndices(iNumberEdges, 2);
+    qint64 iEdge = 0;
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        if(i != j && std::fabs(dWeight) >= dThreshold) {
+            matIndices(iEdge, 0) = i;
+            matIndices(iEdge, 1) = j;
+            ++iEdge;
+        }
+    });
+
+    return matIndices;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd NetworkAdjacency::toDense() const
+{
+    MatrixXd matDense = MatrixXd::Zero(m_iNumberNodes, m_iNumberNodes);
+
+    forEachEntry([&](int i, int j, double dWeight) {
+        matDense(i, j) = dWeight;
+    });
+
+    return matDense;
+}
@@ -0,0 +1,339 @@
+//=============================================================================================================
+/**
+* @file     networkadjacency.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    NetworkAdjacency class declaration.
+*
+*/
+
+#ifndef NETWORKADJACENCY_H
+#define NETWORKADJACENCY_H
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../connectivity_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE CONNECTIVITYLIB
+//=============================================================================================================
+
+namespace CONNECTIVITYLIB {
+
+
+//=============================================================================================================
+/**
+* Compact storage of the undirected, weighted adjacency of a network. The weights are kept either as a packed,
+* row-major upper triangle (including the diagonal) or, after sparsification, as a compressed sparse row (CSR)
+* upper triangle. No per edge objects are allocated. All queries treat an edge (i,j) and (j,i) as the same edge.
+*
+* @brief Compact dense/CSR adjacency storage of a network.
+*/
+
+class CONNECTIVITYSHARED_EXPORT NetworkAdjacency
+{
+
+public:
+    typedef QSharedPointer<NetworkAdjacency> SPtr;            /**< Shared pointer type for NetworkAdjacency. */
+    typedef QSharedPointer<const NetworkAdjacency> ConstSPtr; /**< Const shared pointer type for NetworkAdjacency. */
+
+    typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseWeights;     /**< CSR upper triangular weights. */
+
+    enum StorageType {
+        Dense,
+        Sparse
+    };
+
+    //=========================================================================================================
+    /**
+    * Forward iterator over all stored edges (i <= j) in row-major order.
+    */
+    class CONNECTIVITYSHARED_EXPORT ConstIterator
+    {
+    public:
+        //=====================================================================================================
+        /**
+        * Constructs an iterator pointing to the stored entry iPos which lies in row iRow.
+        *
+        * @param[in] pAdjacency     The adjacency to iterate.
+        * @param[in] iRow           The row of the entry.
+        * @param[in] iPos           The position of the entry in the packed weight storage.
+        */
+        ConstIterator(const NetworkAdjacency* pAdjacency, int iRow, qint64 iPos);
+
+        inline int row() const;         /**< Returns the row (start node) of the current entry. */
+        inline int col() const;         /**< Returns the column (end node) of the current entry. */
+        inline double weight() const;   /**< Returns the weight of the current entry. */
+
+        ConstIterator& operator++();
+        inline bool operator==(const ConstIterator& other) const;
+        inline bool operator!=(const ConstIterator& other) const;
+
+    private:
+        void updateColumn();
+
+        const NetworkAdjacency*     m_pAdjacency;   /**< The iterated adjacency. */
+        int                         m_iRow;         /**< The current row. */
+        int                         m_iCol;         /**< The current column. */
+        qint64                      m_iPos;         /**< The current position in the weight storage. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty adjacency with iNumberNodes nodes and dense zero weights.
+    *
+    * @param[in] iNumberNodes   The number of nodes.
+    */
+    explicit NetworkAdjacency(int iNumberNodes = 0);
+
+    //=========================================================================================================
+    /**
+    * Sets the weights from a square matrix. Only one triangle of the matrix is read.
+    *
+    * @param[in] matWeights     The square weight matrix.
+    * @param[in] bUpper         Whether to read the upper (true) or the lower (false) triangle.
+    */
+    void setDenseWeights(const Eigen::MatrixXd& matWeights, bool bUpper = true);
+
+    //=========================================================================================================
+    /**
+    * Sets sparse weights from a triplet list. Each node pair keeps a single weight: an entry i->j is not added to
+    * an entry j->i. Entries below the diagonal are only used if the pair has no entry on or above the diagonal,
+    * of several entries at the same position the first one is kept.
+    *
+    * @param[in] iNumberNodes   The number of nodes.
+    * @param[in] lTriplets      The weight triplets.
+    */
+    void setSparseWeights(int iNumberNodes, const std::vector<Eigen::Triplet<double> >& lTriplets);
+
+    //=========================================================================================================
+    /**
+    * Returns the storage type currently in use.
+    *
+    * @return The storage type.
+    */
+    StorageType getStorageType() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of nodes.
+    *
+    * @return The number of nodes.
+    */
+    int getNumberNodes() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of stored entries, including the diagonal in dense storage.
+    *
+    * @return The number of stored entries.
+    */
+    qint64 getNumberEntries() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the weight between node i and node j.
+    *
+    * @param[in] i      The first node index.
+    * @param[in] j      The second node index.
+    *
+    * @return The edge weight, zero if there is no stored edge.
+    */
+    double getWeight(int i, int j) const;
+
+    //=========================================================================================================
+    /**
+    * Returns an iterator to the first stored entry.
+    *
+    * @return The begin iterator.
+    */
+    ConstIterator begin() const;
+
+    //=========================================================================================================
+    /**
+    * Returns an iterator past the last stored entry.
+    *
+    * @return The end iterator.
+    */
+    ConstIterator end() const;
+
+    //=========================================================================================================
+    /**
+    * Returns a CSR copy of this adjacency which only keeps the entries with |weight| >= dThreshold.
+    *
+    * @param[in] dThreshold         The absolute weight threshold.
+    * @param[in] bKeepSelfLoops     Whether to keep the diagonal entries.
+    *
+    * @return The sparsified adjacency.
+    */
+    NetworkAdjacency sparsify(double dThreshold, bool bKeepSelfLoops = false) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the degree of every node, counting edges with |weight| >= dThreshold. Self loops are ignored.
+    *
+    * @param[in] dThreshold     The absolute weight threshold.
+    *
+    * @return The node degrees.
+    */
+    Eigen::VectorXi getDegrees(double dThreshold = 0.0) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the strength (sum of weights) of every node, counting edges with |weight| >= dThreshold. Self loops
+    * are ignored.
+    *
+    * @param[in] dThreshold     The absolute weight threshold.
+    *
+    * @return The node strengths.
+    */
+    Eigen::VectorXd getStrengths(double dThreshold = 0.0) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the node index pairs (i < j) of all edges with |weight| >= dThreshold. Self loops are ignored.
+    *
+    * @param[in] dThreshold     The absolute weight threshold.
+    *
+    * @return The edge indices as a number of edges x 2 matrix.
+    */
+    Eigen::MatrixXi getEdgeIndices(double dThreshold = 0.0) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the upper triangular connectivity matrix.
+    *
+    * @return The dense upper triangular weight matrix.
+    */
+    Eigen::MatrixXd toDense() const;
+
+protected:
+    //=========================================================================================================
+    /**
+    * Calls func(i, j, weight) for every stored entry with i <= j.
+    *
+    * @param[in] func   The functor to call.
+    */
+    template<typename Func>
+    void forEachEntry(Func func) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the position of row i in the packed dense storage.
+    *
+    * @param[in] i      The row.
+    *
+    * @return The packed position of entry (i,i).
+    */
+    inline qint64 denseRowOffset(int i) const;
+
+    StorageType         m_storageType;      /**< The storage type in use. */
+    int                 m_iNumberNodes;     /**< The number of nodes. */
+    Eigen::VectorXd     m_vecDenseWeights;  /**< Packed row-major upper triangle including the diagonal. */
+    SparseWeights       m_matSparseWeights; /**< CSR upper triangle, used after sparsification. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int NetworkAdjacency::ConstIterator::row() const
+{
+    return m_iRow;
+}
+
+
+//*************************************************************************************************************
+
+inline int NetworkAdjacency::ConstIterator::col() const
+{
+    return m_iCol;
+}
+
+
+//*************************************************************************************************************
+
+inline double NetworkAdjacency::ConstIterator::weight() const
+{
+    return m_pAdjacency->m_storageType == Dense ? m_pAdjacency->m_vecDenseWeights[m_iPos]
+                                                : m_pAdjacency->m_matSparseWeights.valuePtr()[m_iPos];
+}
+
+
+//*************************************************************************************************************
+
+inline bool NetworkAdjacency::ConstIterator::operator==(const ConstIterator& other) const
+{
+    return m_pAdjacency == other.m_pAdjacency && m_iPos == other.m_iPos;
+}
+
+
+//*************************************************************************************************************
+
+inline bool NetworkAdjacency::ConstIterator::operator!=(const ConstIterator& other) const
+{
+    return !(*this == other);
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 NetworkAdjacency::denseRowOffset(int i) const
+{
+    return qint64(i) * m_iNumberNodes - qint64(i) * (i - 1) / 2;
+}
+
+} // namespace CONNECTIVITYLIB
+
+#endif // NETWORKADJACENCY_H
@@ -415,7 +415,7 @@ DigitizerSetTreeItem* MeasurementTreeItem::addData(const FiffDigPointSet& tDigit
 
 NetworkTreeItem* MeasurementTreeItem::addData(const Network& tNetworkData, Qt3DCore::QEntity* p3DEntityParent)
 {
-    if(!tNetworkData.getNodes().isEmpty()) {
+    if(tNetworkData.getNumberNodes() > 0) {
         //Add source estimation data as child
         if(this->findChildren(Data3DTreeModelItemTypes::NetworkItem).size() == 0) {
             //If rt data item does not exists yet, create it here!
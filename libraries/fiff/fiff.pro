@@ -90,6 +90,10 @@ SOURCES += fiff.cpp \
     fiff_id.cpp \
     fiff_info.cpp \
     fiff_raw_dir.cpp \
+    fiff_raw_codec.cpp \
+    fiff_raw_mapped_reader.cpp \
+    fiff_raw_prefetcher.cpp \
+    fiff_raw_writer.cpp \
     fiff_dig_point.cpp \
     fiff_ch_pos.cpp \
     fiff_cov.cpp \
@@ -123,6 +127,10 @@ HEADERS += fiff.h \
     fiff_raw_data.h \
     fiff_dir_entry.h \
     fiff_raw_dir.h \
+    fiff_raw_codec.h \
+    fiff_raw_mapped_reader.h \
+    fiff_raw_prefetcher.h \
+    fiff_raw_writer.h \
     fiff_dig_point.h \
     fiff_ch_pos.h \
     fiff_cov.h \
@@ -116,6 +116,7 @@ namespace FIFFLIB
 *   FIFFT_COMPLEX_FLOAT        20       Complex number encoded with floats
 *   FIFFT_COMPLEX_DOUBLE       21       Complex number encoded with doubles
 *   FIFFT_OLD_PACK             23       Neuromag proprietary 16 bit packing.
+*   FIFFT_COMPRESSED_RAW       24       MNE-CPP block compressed integer raw data (see FiffRawCodec).
 *
 * Following are structure types defined in fiff_types.h
 *
@@ -245,6 +246,7 @@ namespace FIFFLIB
 #define FIFFT_COMPLEX_FLOAT        20
 #define FIFFT_COMPLEX_DOUBLE       21
 #define FIFFT_OLD_PACK             23
+#define FIFFT_COMPRESSED_RAW       24
 #define FIFFT_CH_INFO_STRUCT       30
 #define FIFFT_ID_STRUCT            31
 #define FIFFT_DIR_ENTRY_STRUCT     32
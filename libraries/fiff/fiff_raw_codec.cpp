@@ -0,0 +1,433 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_codec.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffRawCodec Class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_codec.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QtEndian>
+#include <QVarLengthArray>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <limits>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define CODEC_HEADER_INTS   3       /**< nchan, nsamp and samples per block. */
+#define CODEC_MAX_ORDER     2       /**< Highest predictor order. */
+#define CODEC_ESCAPE        24      /**< Rice quotients of this length or more are stored verbatim. */
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL HELPERS
+//=============================================================================================================
+
+namespace
+{
+
+inline quint32 lowMask(int nbits)
+{
+    return nbits >= 32 ? 0xFFFFFFFFu : ((1u << nbits) - 1u);
+}
+
+inline quint32 zigzag(qint32 value)
+{
+    return ((quint32)value << 1) ^ (quint32)(value >> 31);
+}
+
+inline qint32 unzigzag(quint32 value)
+{
+    return (qint32)(value >> 1) ^ -(qint32)(value & 1u);
+}
+
+inline void appendInt(QByteArray& out, qint32 value)
+{
+    uchar bytes[4];
+    qToBigEndian<qint32>(value, bytes);
+    out.append((const char*)bytes, 4);
+}
+
+//=============================================================================================================
+/**
+* MSB first bit writer appending to a byte array.
+*/
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray& out) : m_out(out), m_acc(0), m_nbits(0) {}
+
+    inline void put(quint32 value, int nbits)
+    {
+        if(nbits == 0)
+            return;
+        m_acc = (m_acc << nbits) | (value & lowMask(nbits));
+        m_nbits += nbits;
+        while(m_nbits >= 8) {
+            m_nbits -= 8;
+            m_out.append((char)((m_acc >> m_nbits) & 0xFF));
+        }
+        m_acc &= lowMask(m_nbits);
+    }
+
+    inline void putRice(quint32 value, int k)
+    {
+        quint32 q = value >> k;
+        if(q < CODEC_ESCAPE) {
+            put(lowMask(q) << 1, q + 1);    // q ones and a terminating zero
+            put(value, k);
+        }
+        else {
+            put(lowMask(CODEC_ESCAPE), CODEC_ESCAPE);
+            put(value, 32);
+        }
+    }
+
+    inline void flush()
+    {
+        if(m_nbits > 0)
+            put(0, 8 - m_nbits);
+    }
+
+private:
+    QByteArray& m_out;
+    quint64     m_acc;
+    int         m_nbits;
+};
+
+//=============================================================================================================
+/**
+* MSB first bit reader on a bounded memory range.
+*/
+class BitReader
+{
+public:
+    BitReader(const uchar* begin, const uchar* end) : m_p(begin), m_end(end), m_acc(0), m_nbits(0) {}
+
+    inline bool get(int nbits, quint32& value)
+    {
+        if(nbits == 0) {
+            value = 0;
+            return true;
+        }
+        while(m_nbits < nbits) {
+            if(m_p >= m_end)
+                return false;
+            m_acc = (m_acc << 8) | *m_p++;
+            m_nbits += 8;
+        }
+        m_nbits -= nbits;
+        value = (quint32)(m_acc >> m_nbits) & lowMask(nbits);
+        return true;
+    }
+
+    inline bool getRice(int k, quint32& value)
+    {
+        quint32 q = 0, bit;
+        while(q < CODEC_ESCAPE) {
+            if(!get(1, bit))
+                return false;
+            if(bit == 0)
+                break;
+            ++q;
+        }
+        if(q == CODEC_ESCAPE)
+            return get(32, value);
+
+        quint32 remainder;
+        if(!get(k, remainder))
+            return false;
+        value = (q << k) | remainder;
+        return true;
+    }
+
+private:
+    const uchar*    m_p;
+    const uchar*    m_end;
+    quint64         m_acc;
+    int             m_nbits;
+};
+
+//=============================================================================================================
+/**
+* Computes the prediction residual of sample i (i >= order) of x.
+*/
+inline qint64 residual(const qint32* x, qint32 i, int order)
+{
+    switch(order) {
+        case 0:  return x[i];
+        case 1:  return (qint64)x[i] - x[i-1];
+        default: return (qint64)x[i] - 2 * (qint64)x[i-1] + x[i-2];
+    }
+}
+
+//=============================================================================================================
+/**
+* Encodes one channel block.
+*/
+void encodeChannelBlock(const qint32* x, qint32 n, QByteArray& out)
+{
+    //
+    // Pick the cheapest predictor whose residuals fit into 32 bits
+    //
+    int order = 0;
+    quint64 bestSum = 0;
+    for(int o = 0; o <= CODEC_MAX_ORDER; ++o) {
+        quint64 sum = 0;
+        bool fits = true;
+        for(qint32 i = o; i < n; ++i) {
+            qint64 r = residual(x, i, o);
+            if(r > std::numeric_limits<qint32>::max() || r < std::numeric_limits<qint32>::min()) {
+                fits = false;
+                break;
+            }
+            sum += zigzag((qint32)r);
+        }
+        if(fits && (o == 0 || sum < bestSum)) {
+            order = o;
+            bestSum = sum;
+        }
+    }
+    int warmup = qMin<qint32>(order, n);
+
+    //
+    // Rice parameter from the mean residual, refined on the neighbouring values
+    //
+    qint32 nres = n - warmup;
+    int k = 0;
+    if(nres > 0) {
+        quint64 mean = bestSum / nres;
+        int k0 = 0;
+        while(k0 < 30 && (1ull << (k0 + 1)) <= mean)
+            ++k0;
+        quint64 bestCost = std::numeric_limits<quint64>::max();
+        for(int kc = qMax(k0 - 1, 0); kc <= qMin(k0 + 1, 30); ++kc) {
+            quint64 cost = (quint64)nres * (kc + 1);
+            for(qint32 i = warmup; i < n; ++i) {
+                quint32 q = zigzag((qint32)residual(x, i, order)) >> kc;
+                cost += q < CODEC_ESCAPE ? q : CODEC_ESCAPE + 31 - kc;
+            }
+            if(cost < bestCost) {
+                bestCost = cost;
+                k = kc;
+            }
+        }
+    }
+
+    out.append((char)order);
+    out.append((char)k);
+    for(qint32 i = 0; i < warmup; ++i)
+        appendInt(out, x[i]);
+
+    BitWriter writer(out);
+    for(qint32 i = warmup; i < n; ++i)
+        writer.putRice(zigzag((qint32)residual(x, i, order)), k);
+    writer.flush();
+}
+
+//=============================================================================================================
+/**
+* Decodes one channel block of n samples into x.
+*/
+bool decodeChannelBlock(const uchar* begin, const uchar* end, qint32 n, qint32* x)
+{
+    if(end - begin < 2)
+        return false;
+
+    int order = begin[0];
+    int k = begin[1];
+    if(order > CODEC_MAX_ORDER || k > 31)
+        return false;
+    begin += 2;
+
+    int warmup = qMin<qint32>(order, n);
+    if(end - begin < 4 * warmup)
+        return false;
+    for(qint32 i = 0; i < warmup; ++i, begin += 4)
+        x[i] = qFromBigEndian<qint32>(begin);
+
+    BitReader reader(begin, end);
+    quint32 value;
+    for(qint32 i = warmup; i < n; ++i) {
+        if(!reader.getRice(k, value))
+            return false;
+        qint64 r = unzigzag(value);
+        switch(order) {
+            case 0:  x[i] = (qint32)r; break;
+            case 1:  x[i] = (qint32)(r + x[i-1]); break;
+            default: x[i] = (qint32)(r + 2 * (qint64)x[i-1] - x[i-2]); break;
+        }
+    }
+    return true;
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+void FiffRawCodec::encode(const MatrixXi& p_matData, QByteArray& p_Encoded, qint32 p_iBlockSamples)
+{
+    const qint32 nchan = p_matData.rows();
+    const qint32 nsamp = p_matData.cols();
+    const qint32 nblocksamp = qMax(p_iBlockSamples, 1);
+    const qint32 nblocks = (nsamp + nblocksamp - 1) / nblocksamp;
+
+    QByteArray t_blocks;
+    t_blocks.reserve(nchan * nsamp * 2);
+    QVector<qint32> offsets(nblocks * nchan + 1);
+    QVarLengthArray<qint32, 1024> x(nblocksamp);
+
+    for(qint32 b = 0; b < nblocks; ++b) {
+        qint32 first = b * nblocksamp;
+        qint32 n = qMin(nblocksamp, nsamp - first);
+        for(qint32 c = 0; c < nchan; ++c) {
+            offsets[b * nchan + c] = t_blocks.size();
+            for(qint32 i = 0; i < n; ++i)
+                x[i] = p_matData(c, first + i);
+            encodeChannelBlock(x.constData(), n, t_blocks);
+        }
+    }
+    offsets[nblocks * nchan] = t_blocks.size();
+
+    p_Encoded.clear();
+    p_Encoded.reserve((CODEC_HEADER_INTS + offsets.size()) * 4 + t_blocks.size());
+    appendInt(p_Encoded, nchan);
+    appendInt(p_Encoded, nsamp);
+    appendInt(p_Encoded, nblocksamp);
+    for(qint32 i = 0; i < offsets.size(); ++i)
+        appendInt(p_Encoded, offsets[i]);
+    p_Encoded.append(t_blocks);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawCodec::readHeader(const uchar* p_pData, qint64 p_iSize, qint32& p_iNChan, qint32& p_iNSamp)
+{
+    if(!p_pData || p_iSize < CODEC_HEADER_INTS * 4)
+        return false;
+
+    p_iNChan = qFromBigEndian<qint32>(p_pData);
+    p_iNSamp = qFromBigEndian<qint32>(p_pData + 4);
+    qint32 nblocksamp = qFromBigEndian<qint32>(p_pData + 8);
+
+    if(p_iNChan <= 0 || p_iNSamp < 0 || nblocksamp <= 0)
+        return false;
+
+    qint64 nblocks = (p_iNSamp + nblocksamp - 1) / nblocksamp;
+    return p_iSize >= (CODEC_HEADER_INTS + nblocks * p_iNChan + 1) * 4;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawCodec::decode(const uchar* p_pData, qint64 p_iSize, MatrixXi& p_matData, qint32 p_iFirst, qint32 p_iNSamp)
+{
+    qint32 nchan, nsamp;
+    if(!readHeader(p_pData, p_iSize, nchan, nsamp))
+        return false;
+
+    if(p_iNSamp < 0)
+        p_iNSamp = nsamp - p_iFirst;
+    if(p_iFirst < 0 || p_iNSamp < 0 || p_iFirst + p_iNSamp > nsamp)
+        return false;
+
+    const qint32 nblocksamp = qFromBigEndian<qint32>(p_pData + 8);
+    const qint32 nblocks = (nsamp + nblocksamp - 1) / nblocksamp;
+    const uchar* t_pOffsets = p_pData + CODEC_HEADER_INTS * 4;
+    const uchar* t_pBlocks = t_pOffsets + (nblocks * nchan + 1) * 4;
+    const qint64 t_iBlocksSize = p_iSize - (t_pBlocks - p_pData);
+
+    if(p_matData.rows() != nchan || p_matData.cols() != p_iNSamp)
+        p_matData.resize(nchan, p_iNSamp);
+    if(p_iNSamp == 0)
+        return true;
+
+    QVarLengthArray<qint32, 1024> x(nblocksamp);
+
+    const qint32 bFirst = p_iFirst / nblocksamp;
+    const qint32 bLast = (p_iFirst + p_iNSamp - 1) / nblocksamp;
+    for(qint32 b = bFirst; b <= bLast; ++b) {
+        qint32 first = b * nblocksamp;
+        qint32 n = qMin(nblocksamp, nsamp - first);
+        qint32 from = qMax(p_iFirst, first);
+        qint32 to = qMin(p_iFirst + p_iNSamp, first + n);
+
+        for(qint32 c = 0; c < nchan; ++c) {
+            qint32 start = qFromBigEndian<qint32>(t_pOffsets + (b * nchan + c) * 4);
+            qint32 end = qFromBigEndian<qint32>(t_pOffsets + (b * nchan + c + 1) * 4);
+            if(start < 0 || end < start || end > t_iBlocksSize)
+                return false;
+            if(!decodeChannelBlock(t_pBlocks + start, t_pBlocks + end, n, x.data()))
+                return false;
+            for(qint32 i = from; i < to; ++i)
+                p_matData(c, i - p_iFirst) = x[i - first];
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,142 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_codec.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawCodec class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_CODEC_H
+#define FIFF_RAW_CODEC_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QByteArray>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Lossless block compression of integer raw data buffers, stored as FIFFT_COMPRESSED_RAW data buffers.
+*
+* A buffer is split into blocks of a fixed number of samples. Each channel of each block is coded
+* independently: a fixed polynomial predictor of order 0, 1 or 2 (the cheapest one is chosen per block)
+* removes the correlation between neighbouring samples and the zig-zag mapped residuals are Rice coded.
+* A table with the byte offset of every channel block follows the header, so any sample range of any
+* channel can be decoded without touching the rest of the buffer.
+*
+* Layout (all integers 32 bit big endian):
+*   nchan, nsamp, nblocksamp, offsets[nblocks * nchan + 1], channel blocks
+* with block b of channel c found at offsets[b * nchan + c] relative to the first channel block.
+* A channel block is made of the predictor order (1 byte), the Rice parameter (1 byte), the first
+* order samples as 32 bit integers and the Rice coded residuals of the remaining samples.
+*
+* @brief Block compression codec for raw data buffers.
+*/
+class FIFFSHARED_EXPORT FiffRawCodec
+{
+public:
+    //=========================================================================================================
+    /**
+    * Encodes an integer raw data buffer.
+    *
+    * @param[in] p_matData          The data (channels x samples).
+    * @param[out] p_Encoded         The encoded buffer.
+    * @param[in] p_iBlockSamples    Number of samples per block, the granularity of random access.
+    */
+    static void encode(const MatrixXi& p_matData, QByteArray& p_Encoded, qint32 p_iBlockSamples = 512);
+
+    //=========================================================================================================
+    /**
+    * Reads the dimensions of an encoded buffer.
+    *
+    * @param[in] p_pData        The encoded buffer.
+    * @param[in] p_iSize        Size of the encoded buffer in bytes.
+    * @param[out] p_iNChan      Number of channels.
+    * @param[out] p_iNSamp      Number of samples.
+    *
+    * @return true if the header is valid, false otherwise.
+    */
+    static bool readHeader(const uchar* p_pData, qint64 p_iSize, qint32& p_iNChan, qint32& p_iNSamp);
+
+    //=========================================================================================================
+    /**
+    * Decodes the sample range [p_iFirst, p_iFirst + p_iNSamp) of all channels of an encoded buffer. Only the
+    * blocks overlapping the range are decoded. The output matrix is only resized if its dimensions differ.
+    *
+    * @param[in] p_pData        The encoded buffer.
+    * @param[in] p_iSize        Size of the encoded buffer in bytes.
+    * @param[out] p_matData     The decoded data (channels x p_iNSamp).
+    * @param[in] p_iFirst       First sample to decode (optional).
+    * @param[in] p_iNSamp       Number of samples to decode, -1 decodes up to the end of the buffer (optional).
+    *
+    * @return true if succeeded, false if the buffer is damaged or the range is invalid.
+    */
+    static bool decode(const uchar* p_pData, qint64 p_iSize, MatrixXi& p_matData, qint32 p_iFirst = 0, qint32 p_iNSamp = -1);
+};
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_CODEC_H
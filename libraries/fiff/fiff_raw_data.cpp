@@ -40,6 +40,7 @@
 
 #include "fiff_raw_data.h"
 #include "fiff_tag.h"
+#include "fiff_raw_codec.h"
 #include "fiff_stream.h"
 #include "cstdlib"
 
@@ -282,6 +283,13 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
             {
                 FiffTag::SPtr t_pTag;
                 fid->read_tag(t_pTag, thisRawDir.ent->pos);
+
+                MatrixXi t_matDecoded;
+                if (t_pTag->type == FIFFT_COMPRESSED_RAW && !FiffRawCodec::decode((const uchar*)t_pTag->data(), t_pTag->size(), t_matDecoded))
+                {
+                    printf("Compressed data buffer could not be decoded!!\n");
+                    return false;
+                }
                 //
                 //   Depending on the state of the projection and selection
                 //   we proceed a little bit differently
@@ -296,6 +304,8 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
                             one = cal*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
                         else if(t_pTag->type == FIFFT_FLOAT)
                             one = cal*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
+                        else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                            one = cal*t_matDecoded.cast<double>();
                         else
                             printf("Data Storage Format not known jet [1]!! Type: %d\n", t_pTag->type);
                     }
@@ -326,6 +336,11 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
                             for(r = 0; r < sel.size(); ++r)
                                 newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
                         }
+                        else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                        {
+                            for(r = 0; r < sel.size(); ++r)
+                                newData.block(r,0,1,thisRawDir.nsamp) = t_matDecoded.block(sel[r],0,1,thisRawDir.nsamp).cast<double>();
+                        }
                         else
                         {
                             printf("Data Storage Format not known jet [2]!! Type: %d\n", t_pTag->type);
@@ -342,6 +357,8 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
                         one = mult*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
                     else if(t_pTag->type == FIFFT_FLOAT)
                         one = mult*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
+                    else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                        one = mult*t_matDecoded.cast<double>();
                     else
                         printf("Data Storage Format not known jet [3]!! Type: %d\n", t_pTag->type);
                 }
@@ -599,6 +616,13 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
             {
                 FiffTag::SPtr t_pTag;
                 fid->read_tag(t_pTag, thisRawDir.ent->pos);
+
+                MatrixXi t_matDecoded;
+                if (t_pTag->type == FIFFT_COMPRESSED_RAW && !FiffRawCodec::decode((const uchar*)t_pTag->data(), t_pTag->size(), t_matDecoded))
+                {
+                    printf("Compressed data buffer could not be decoded!!\n");
+                    return false;
+                }
                 //
                 //   Depending on the state of the projection and selection
                 //   we proceed a little bit differently
@@ -613,6 +637,8 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
                             one = cal*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
                         else if(t_pTag->type == FIFFT_FLOAT)
                             one = cal*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
+                        else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                            one = cal*t_matDecoded.cast<double>();
                         else
                             printf("Data Storage Format not known jet [1]!! Type: %d\n", t_pTag->type);
                     }
@@ -643,6 +669,11 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
                             for(r = 0; r < sel.size(); ++r)
                                 newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
                         }
+                        else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                        {
+                            for(r = 0; r < sel.size(); ++r)
+                                newData.block(r,0,1,thisRawDir.nsamp) = t_matDecoded.block(sel[r],0,1,thisRawDir.nsamp).cast<double>();
+                        }
                         else
                         {
                             printf("Data Storage Format not known jet [2]!! Type: %d\n", t_pTag->type);
@@ -659,6 +690,8 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
                         one = mult*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
                     else if(t_pTag->type == FIFFT_FLOAT)
                         one = mult*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
+                    else if(t_pTag->type == FIFFT_COMPRESSED_RAW)
+                        one = mult*t_matDecoded.cast<double>();
                     else
                         printf("Data Storage Format not known jet [3]!! Type: %d\n", t_pTag->type);
                 }
@@ -756,6 +789,139 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
 }
 
 
+//*************************************************************************************************************
+
+bool FiffRawData::read_raw_segment(MatrixXf& data, MatrixXf& times, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    if(from == -1)
+        from = this->first_samp;
+    if(to == -1)
+        to = this->last_samp;
+    //
+    //  Initial checks
+    //
+    if(from < this->first_samp)
+        from = this->first_samp;
+    if(to > this->last_samp)
+        to = this->last_samp;
+    //
+    if(from > to)
+    {
+        printf("No data in this range\n");
+        return false;
+    }
+    printf("Reading %d ... %d  =  %9.3f ... %9.3f secs...", from, to, ((float)from)/this->info.sfreq, ((float)to)/this->info.sfreq);
+    //
+    //  Initialize the row selection and the single precision calibration or multiplication
+    //
+    qint32 nchan = this->info.nchan;
+    qint32 nrows = sel.size() > 0 ? sel.size() : nchan;
+    qint32 i, k;
+
+    VectorXi rows(nrows);
+    for(i = 0; i < nrows; ++i)
+        rows[i] = sel.size() > 0 ? sel[i] : i;
+
+    bool useMult = this->proj.size() > 0 || this->comp.kind != -1;
+    MatrixXf mult;
+    VectorXf scale;
+    if(useMult)
+    {
+        MatrixXd mult_full = MatrixXd::Identity(nchan, nchan);
+        if(this->comp.kind != -1)
+            mult_full = this->comp.data->data;
+        if(this->proj.size() > 0)
+            mult_full = this->proj*mult_full;
+        mult_full = mult_full*this->cals.transpose().asDiagonal();
+
+        mult.resize(nrows, nchan);
+        for(i = 0; i < nrows; ++i)
+            mult.row(i) = mult_full.row(rows[i]).cast<float>();
+    }
+    else
+    {
+        scale.resize(nrows);
+        for(i = 0; i < nrows; ++i)
+            scale[i] = this->cals[rows[i]];
+    }
+
+    FiffStream::SPtr fid = this->file;
+    if (!fid->device()->isOpen() && !fid->device()->open(QIODevice::ReadOnly))
+    {
+        printf("Cannot open file %s",this->info.filename.toUtf8().constData());
+        return false;
+    }
+
+    data.resize(nrows, to-from+1);
+
+    MatrixXf one;
+    MatrixXi t_matDecoded;
+    qint32 dest = 0;
+    for(k = 0; k < this->rawdir.size(); ++k)
+    {
+        const FiffRawDir& thisRawDir = this->rawdir[k];
+        //
+        //  Do we need this buffer
+        //
+        if(thisRawDir.last < from)
+            continue;
+        if(thisRawDir.first > to)
+            break;
+
+        fiff_int_t first_pick = qMax(from, thisRawDir.first) - thisRawDir.first;
+        fiff_int_t picksamp = qMin(to, thisRawDir.last) - thisRawDir.first - first_pick + 1;
+        if(picksamp <= 0)
+            continue;
+
+        if(!thisRawDir.ent || thisRawDir.ent->kind == -1)
+        {
+            //
+            //  Skip is translated to zeros
+            //
+            data.middleCols(dest, picksamp).setZero();
+            dest += picksamp;
+            continue;
+        }
+
+        FiffTag::SPtr t_pTag;
+        fid->read_tag(t_pTag, thisRawDir.ent->pos);
+
+        //
+        //  Convert the picked samples of all channels to float
+        //
+        if(t_pTag->type == FIFFT_DAU_PACK16)
+            one = Map< MatrixDau16 >(t_pTag->toDauPack16(), nchan, thisRawDir.nsamp).middleCols(first_pick, picksamp).cast<float>();
+        else if(t_pTag->type == FIFFT_INT)
+            one = Map< MatrixXi >(t_pTag->toInt(), nchan, thisRawDir.nsamp).middleCols(first_pick, picksamp).cast<float>();
+        else if(t_pTag->type == FIFFT_FLOAT)
+            one = Map< MatrixXf >(t_pTag->toFloat(), nchan, thisRawDir.nsamp).middleCols(first_pick, picksamp);
+        else if(t_pTag->type == FIFFT_COMPRESSED_RAW && FiffRawCodec::decode((const uchar*)t_pTag->data(), t_pTag->size(), t_matDecoded, first_pick, picksamp))
+            one = t_matDecoded.cast<float>();
+        else
+        {
+            printf("Data Storage Format not known jet!! Type: %d\n", t_pTag->type);
+            return false;
+        }
+
+        if(useMult)
+            data.middleCols(dest, picksamp).noalias() = mult*one;
+        else
+            for(i = 0; i < nrows; ++i)
+                data.row(i).segment(dest, picksamp) = scale[i]*one.row(rows[i]);
+
+        dest += picksamp;
+    }
+    printf(" [done]\n");
+
+    times = MatrixXf(1, to-from+1);
+
+    for (i = 0; i < times.cols(); ++i)
+        times(0, i) = ((float)(from+i)) / this->info.sfreq;
+
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 bool FiffRawData::read_raw_segment_times(MatrixXd& data, MatrixXd& times, float from, float to, const RowVectorXi& sel)
@@ -174,6 +174,22 @@ public:
     */
     bool read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix<double>& multSegment, fiff_int_t from = -1, fiff_int_t to = -1, const RowVectorXi& sel = defaultRowVectorXi, bool do_debug = false);
 
+    //=========================================================================================================
+    /**
+    * Read a specific raw data segment in single precision. The stored samples are converted to float directly,
+    * calibration, projection and compensation are applied in single precision. This halves the memory of the
+    * returned segment compared to the double precision version.
+    *
+    * @param[out] data      returns the data matrix (channels x samples)
+    * @param[out] times     returns the time values corresponding to the samples
+    * @param[in] from       first sample to include. If omitted, defaults to the first sample in data (optional)
+    * @param[in] to         last sample to include. If omitted, defaults to the last sample in data (optional)
+    * @param[in] sel        channel selection vector (optional)
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_raw_segment(MatrixXf& data, MatrixXf& times, fiff_int_t from = -1, fiff_int_t to = -1, const RowVectorXi& sel = defaultRowVectorXi);
+
     //=========================================================================================================
     /**
     * ### MNE toolbox root function ###: Implementation of the fiff_read_raw_segment function
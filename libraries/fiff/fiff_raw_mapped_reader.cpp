@@ -0,0 +1,459 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_mapped_reader.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffRawMappedReader Class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_mapped_reader.h"
+#include "fiff_file.h"
+#include "fiff_dir_entry.h"
+#include "fiff_raw_codec.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFile>
+#include <QtEndian>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <cstring>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define TAG_INFO_SIZE 16    /**< kind, type, size and next - four 32 bit integers preceding the tag data. */
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL DECODERS
+//=============================================================================================================
+
+namespace
+{
+
+struct DecodeFloat
+{
+    enum { ElementSize = 4 };
+    static inline float decode(const uchar* src)
+    {
+        quint32 bits = qFromBigEndian<quint32>(src);
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+};
+
+struct DecodeInt
+{
+    enum { ElementSize = 4 };
+    static inline qint32 decode(const uchar* src)
+    {
+        return qFromBigEndian<qint32>(src);
+    }
+};
+
+struct DecodeShort
+{
+    enum { ElementSize = 2 };
+    static inline qint16 decode(const uchar* src)
+    {
+        return qFromBigEndian<qint16>(src);
+    }
+};
+
+//=============================================================================================================
+/**
+* Decodes a block of big endian samples stored sample by sample (all channels of one sample are contiguous).
+* The samples are converted to the scalar type of the destination directly.
+*/
+template<typename Decoder, typename Scalar>
+void decodeSamples(const uchar* src, qint32 nchan, qint32 picksamp, const VectorXi& rows, const Matrix<Scalar, Dynamic, 1>& scale, Matrix<Scalar, Dynamic, Dynamic>& dest, qint32 destCol)
+{
+    const qint32 nrows = rows.size();
+    const qint32 stride = nchan * Decoder::ElementSize;
+
+    for(qint32 s = 0; s < picksamp; ++s) {
+        const uchar* sample = src + s * stride;
+        Scalar* column = dest.data() + (destCol + s) * dest.rows();
+        for(qint32 r = 0; r < nrows; ++r)
+            column[r] = scale[r] * static_cast<Scalar>(Decoder::decode(sample + rows[r] * Decoder::ElementSize));
+    }
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawMappedReader::FiffRawMappedReader(const FiffRawData& p_FiffRawData)
+: m_FiffRawData(p_FiffRawData)
+, m_pFile(Q_NULLPTR)
+, m_pMappedData(Q_NULLPTR)
+, m_iMappedSize(0)
+, m_bUseMult(p_FiffRawData.proj.size() > 0 || p_FiffRawData.comp.kind != -1)
+, m_bSelValid(false)
+{
+    const qint32 nchan = m_FiffRawData.info.nchan;
+
+    m_vecAllRows.resize(nchan);
+    for(qint32 i = 0; i < nchan; ++i)
+        m_vecAllRows[i] = i;
+    m_vecOnes = VectorXd::Ones(nchan);
+    m_vecOnesFloat = VectorXf::Ones(nchan);
+}
+
+
+//*************************************************************************************************************
+
+FiffRawMappedReader::~FiffRawMappedReader()
+{
+    unmap();
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawMappedReader::map()
+{
+    if(isMapped())
+        return true;
+
+    if(!m_FiffRawData.file) {
+        qWarning("FiffRawMappedReader::map - Raw data is not set up.");
+        return false;
+    }
+
+    m_pFile = qobject_cast<QFile*>(m_FiffRawData.file->device());
+    if(!m_pFile) {
+        qWarning("FiffRawMappedReader::map - Raw data device is not a file.");
+        return false;
+    }
+
+    if(!m_pFile->isOpen() && !m_pFile->open(QIODevice::ReadOnly)) {
+        qWarning("FiffRawMappedReader::map - Cannot open file %s.", m_pFile->fileName().toUtf8().constData());
+        return false;
+    }
+
+    m_iMappedSize = m_pFile->size();
+    m_pMappedData = m_pFile->map(0, m_iMappedSize);
+    if(!m_pMappedData) {
+        qWarning("FiffRawMappedReader::map - Cannot map file %s: %s", m_pFile->fileName().toUtf8().constData(), m_pFile->errorString().toUtf8().constData());
+        m_iMappedSize = 0;
+        return false;
+    }
+
+    //
+    // Validate the raw directory against the mapping once, so decoding does not need any checks
+    //
+    const qint32 nchan = m_FiffRawData.info.nchan;
+    for(qint32 k = 0; k < m_FiffRawData.rawdir.size(); ++k) {
+        const FiffRawDir& t_RawDir = m_FiffRawData.rawdir[k];
+        if(!t_RawDir.ent || t_RawDir.ent->kind == -1)
+            continue;
+
+        if(t_RawDir.ent->pos < 0 || t_RawDir.ent->pos + TAG_INFO_SIZE + (qint64)t_RawDir.ent->size > m_iMappedSize) {
+            qWarning("FiffRawMappedReader::map - Raw buffer %d does not fit the mapping (file probably damaged).", k);
+            unmap();
+            return false;
+        }
+
+        qint64 elementSize;
+        switch(t_RawDir.ent->type) {
+            case FIFFT_FLOAT:
+            case FIFFT_INT:
+                elementSize = 4;
+                break;
+            case FIFFT_DAU_PACK16:
+            case FIFFT_SHORT:
+                elementSize = 2;
+                break;
+            case FIFFT_COMPRESSED_RAW:
+                elementSize = 0;
+                break;
+            default:
+                qWarning("FiffRawMappedReader::map - Data storage format %d not supported.", t_RawDir.ent->type);
+                unmap();
+                return false;
+        }
+
+        bool valid;
+        if(elementSize > 0) {
+            valid = (qint64)t_RawDir.ent->size == elementSize * nchan * t_RawDir.nsamp;
+        }
+        else {
+            qint32 nchan_buf, nsamp_buf;
+            valid = FiffRawCodec::readHeader(m_pMappedData + t_RawDir.ent->pos + TAG_INFO_SIZE, t_RawDir.ent->size, nchan_buf, nsamp_buf)
+                    && nchan_buf == nchan
+                    && nsamp_buf == t_RawDir.nsamp;
+        }
+
+        if(!valid) {
+            qWarning("FiffRawMappedReader::map - Raw buffer %d does not match the raw directory (file probably damaged).", k);
+            unmap();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawMappedReader::unmap()
+{
+    if(m_pFile && m_pMappedData)
+        m_pFile->unmap(m_pMappedData);
+
+    m_pMappedData = Q_NULLPTR;
+    m_iMappedSize = 0;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawMappedReader::read_raw_segment(MatrixXd& data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    if(!prepareSegment(from, to, sel))
+        return false;
+
+    return readSegment(data, from, to, m_vecScale, m_vecOnes, m_matMult, m_matScratch);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawMappedReader::read_raw_segment(MatrixXf& data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    if(!prepareSegment(from, to, sel))
+        return false;
+
+    return readSegment(data, from, to, m_vecScaleFloat, m_vecOnesFloat, m_matMultFloat, m_matScratchFloat);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawMappedReader::prepareSegment(fiff_int_t& from, fiff_int_t& to, const RowVectorXi& sel)
+{
+    if(!isMapped() && !map())
+        return false;
+
+    if(from == -1)
+        from = m_FiffRawData.first_samp;
+    if(to == -1)
+        to = m_FiffRawData.last_samp;
+    //
+    //  Initial checks
+    //
+    if(from < m_FiffRawData.first_samp)
+        from = m_FiffRawData.first_samp;
+    if(to > m_FiffRawData.last_samp)
+        to = m_FiffRawData.last_samp;
+    //
+    if(from > to) {
+        qWarning("FiffRawMappedReader::read_raw_segment - No data in this range.");
+        return false;
+    }
+
+    updateSelection(sel);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+template<typename Scalar>
+bool FiffRawMappedReader::readSegment(Matrix<Scalar, Dynamic, Dynamic>& data,
+                                      fiff_int_t from,
+                                      fiff_int_t to,
+                                      const Matrix<Scalar, Dynamic, 1>& p_vecScale,
+                                      const Matrix<Scalar, Dynamic, 1>& p_vecOnes,
+                                      const Matrix<Scalar, Dynamic, Dynamic>& p_matMult,
+                                      Matrix<Scalar, Dynamic, Dynamic>& p_matScratch)
+{
+    const qint32 nrows = m_bUseMult ? p_matMult.rows() : m_vecRows.size();
+    const qint32 ncols = to - from + 1;
+    if(data.rows() != nrows || data.cols() != ncols)
+        data.resize(nrows, ncols);
+
+    //
+    //  With projection or compensation all channels are decoded into the scratch matrix first
+    //
+    Matrix<Scalar, Dynamic, Dynamic>& t_matDest = m_bUseMult ? p_matScratch : data;
+    const VectorXi& t_vecRows = m_bUseMult ? m_vecAllRows : m_vecRows;
+    const Matrix<Scalar, Dynamic, 1>& t_vecScale = m_bUseMult ? p_vecOnes : p_vecScale;
+    if(m_bUseMult && (p_matScratch.rows() != m_FiffRawData.info.nchan || p_matScratch.cols() != ncols))
+        p_matScratch.resize(m_FiffRawData.info.nchan, ncols);
+
+    qint32 dest = 0;
+    for(qint32 k = 0; k < m_FiffRawData.rawdir.size(); ++k) {
+        const FiffRawDir& t_RawDir = m_FiffRawData.rawdir[k];
+        //
+        //  Do we need this buffer
+        //
+        if(t_RawDir.last < from)
+            continue;
+        if(t_RawDir.first > to)
+            break;
+
+        qint32 first_pick = qMax(from, t_RawDir.first) - t_RawDir.first;
+        qint32 last_pick = qMin(to, t_RawDir.last) - t_RawDir.first;
+        qint32 picksamp = last_pick - first_pick + 1;
+
+        if(picksamp > 0) {
+            if(!decodeBuffer(t_RawDir, first_pick, picksamp, t_vecRows, t_vecScale, t_matDest, dest))
+                return false;
+            dest += picksamp;
+        }
+    }
+
+    if(m_bUseMult)
+        data.noalias() = p_matMult * p_matScratch;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawMappedReader::updateSelection(const RowVectorXi& sel)
+{
+    if(m_bSelValid && sel.size() == m_vecSel.size() && (sel.size() == 0 || sel == m_vecSel))
+        return;
+
+    const qint32 nchan = m_FiffRawData.info.nchan;
+    const qint32 nrows = sel.size() > 0 ? sel.size() : nchan;
+
+    m_vecSel = sel;
+    m_vecRows.resize(nrows);
+    m_vecScale.resize(nrows);
+    for(qint32 i = 0; i < nrows; ++i) {
+        m_vecRows[i] = sel.size() > 0 ? sel[i] : i;
+        m_vecScale[i] = m_FiffRawData.cals[m_vecRows[i]];
+    }
+    m_vecScaleFloat = m_vecScale.cast<float>();
+
+    if(m_bUseMult) {
+        //
+        //  mult = sel * proj * comp * cal, the calibration is a column scaling
+        //
+        MatrixXd t_matMult = MatrixXd::Identity(nchan, nchan);
+        if(m_FiffRawData.comp.kind != -1)
+            t_matMult = m_FiffRawData.comp.data->data;
+        if(m_FiffRawData.proj.size() > 0)
+            t_matMult = m_FiffRawData.proj * t_matMult;
+        t_matMult = t_matMult * m_FiffRawData.cals.transpose().asDiagonal();
+
+        m_matMult.resize(nrows, nchan);
+        for(qint32 i = 0; i < nrows; ++i)
+            m_matMult.row(i) = t_matMult.row(m_vecRows[i]);
+        m_matMultFloat = m_matMult.cast<float>();
+    }
+
+    m_bSelValid = true;
+}
+
+
+//*************************************************************************************************************
+
+template<typename Scalar>
+bool FiffRawMappedReader::decodeBuffer(const FiffRawDir& p_RawDir, qint32 first_pick, qint32 picksamp, const VectorXi& p_vecRows, const Matrix<Scalar, Dynamic, 1>& p_vecScale, Matrix<Scalar, Dynamic, Dynamic>& p_matDest, qint32 dest) const
+{
+    //
+    //  Skip is translated to zeros
+    //
+    if(!p_RawDir.ent || p_RawDir.ent->kind == -1) {
+        p_matDest.block(0, dest, p_matDest.rows(), picksamp).setZero();
+        return true;
+    }
+
+    const qint32 nchan = m_FiffRawData.info.nchan;
+    const uchar* t_pData = m_pMappedData + p_RawDir.ent->pos + TAG_INFO_SIZE;
+
+    switch(p_RawDir.ent->type) {
+        case FIFFT_FLOAT:
+            decodeSamples<DecodeFloat>(t_pData + first_pick * nchan * DecodeFloat::ElementSize, nchan, picksamp, p_vecRows, p_vecScale, p_matDest, dest);
+            return true;
+        case FIFFT_INT:
+            decodeSamples<DecodeInt>(t_pData + first_pick * nchan * DecodeInt::ElementSize, nchan, picksamp, p_vecRows, p_vecScale, p_matDest, dest);
+            return true;
+        case FIFFT_DAU_PACK16:
+        case FIFFT_SHORT:
+            decodeSamples<DecodeShort>(t_pData + first_pick * nchan * DecodeShort::ElementSize, nchan, picksamp, p_vecRows, p_vecScale, p_matDest, dest);
+            return true;
+        case FIFFT_COMPRESSED_RAW:
+            //
+            //  Only the blocks overlapping the requested range are decoded
+            //
+            if(!FiffRawCodec::decode(t_pData, p_RawDir.ent->size, m_matIntScratch, first_pick, picksamp))
+                return false;
+            for(qint32 s = 0; s < picksamp; ++s)
+                for(qint32 r = 0; r < p_vecRows.size(); ++r)
+                    p_matDest(r, dest + s) = p_vecScale[r] * static_cast<Scalar>(m_matIntScratch(p_vecRows[r], s));
+            return true;
+        default:
+            qWarning("FiffRawMappedReader::decodeBuffer - Data storage format %d not supported.", p_RawDir.ent->type);
+            return false;
+    }
+}
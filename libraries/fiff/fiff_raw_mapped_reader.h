@@ -0,0 +1,287 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_mapped_reader.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawMappedReader class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_MAPPED_READER_H
+#define FIFF_RAW_MAPPED_READER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_raw_data.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class QFile;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Memory-mapped raw data reader. The file behind a FiffRawData object is mapped once and the buffers listed
+* in its raw directory (FiffRawData::rawdir) are decoded straight from the mapping into a caller-provided
+* matrix. No FiffTag is created and no per-buffer heap allocation takes place, which makes random access
+* reads limited by the decoding cost only.
+*
+* Calibration, SSP projection and compensation are applied as in FiffRawData::read_raw_segment. The
+* projection and compensation state is taken over when the reader is constructed.
+*
+* The reader keeps scratch memory between calls and is therefore not reentrant; use one reader per thread.
+*
+* @brief Memory-mapped zero-copy raw data reader.
+*/
+class FIFFSHARED_EXPORT FiffRawMappedReader
+{
+public:
+    typedef QSharedPointer<FiffRawMappedReader> SPtr;               /**< Shared pointer type for FiffRawMappedReader. */
+    typedef QSharedPointer<const FiffRawMappedReader> ConstSPtr;    /**< Const shared pointer type for FiffRawMappedReader. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a mapped reader for the given raw data. The raw data has to be set up (see
+    * FiffStream::setup_read_raw) and its IO device has to be a QFile which stays alive as long as the reader.
+    *
+    * @param[in] p_FiffRawData  The raw data to read from.
+    */
+    explicit FiffRawMappedReader(const FiffRawData& p_FiffRawData);
+
+    //=========================================================================================================
+    /**
+    * Destroys the mapped reader and releases the mapping.
+    */
+    ~FiffRawMappedReader();
+
+    //=========================================================================================================
+    /**
+    * Maps the raw data file into memory and validates all raw directory entries against the mapping.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool map();
+
+    //=========================================================================================================
+    /**
+    * Releases the mapping.
+    */
+    void unmap();
+
+    //=========================================================================================================
+    /**
+    * Returns whether the file is currently mapped.
+    *
+    * @return true if the file is mapped, false otherwise.
+    */
+    inline bool isMapped() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the raw data the reader operates on.
+    *
+    * @return the raw data.
+    */
+    inline const FiffRawData& raw() const;
+
+    //=========================================================================================================
+    /**
+    * Reads a raw data segment from the mapping. The data matrix is only resized when its dimensions do not
+    * match the requested segment, so passing the same matrix for equally sized segments does not allocate.
+    *
+    * @param[in, out] data  The data matrix (channels x samples) to decode into.
+    * @param[in] from       first sample to include. If -1, defaults to the first sample in data.
+    * @param[in] to         last sample to include. If -1, defaults to the last sample in data.
+    * @param[in] sel        channel selection vector (optional).
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool read_raw_segment(MatrixXd& data, fiff_int_t from = -1, fiff_int_t to = -1, const RowVectorXi& sel = defaultRowVectorXi);
+
+    //=========================================================================================================
+    /**
+    * Reads a raw data segment from the mapping in single precision. The stored samples are converted to float
+    * directly and calibration, projection and compensation are applied in single precision.
+    *
+    * @param[in, out] data  The data matrix (channels x samples) to decode into.
+    * @param[in] from       first sample to include. If -1, defaults to the first sample in data.
+    * @param[in] to         last sample to include. If -1, defaults to the last sample in data.
+    * @param[in] sel        channel selection vector (optional).
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool read_raw_segment(MatrixXf& data, fiff_int_t from = -1, fiff_int_t to = -1, const RowVectorXi& sel = defaultRowVectorXi);
+
+private:
+    //=========================================================================================================
+    /**
+    * Maps the file if necessary, clamps the requested range and updates the selection dependent members.
+    *
+    * @param[in, out] from  first sample to include, -1 is replaced by the first sample in data.
+    * @param[in, out] to    last sample to include, -1 is replaced by the last sample in data.
+    * @param[in] sel        channel selection vector.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool prepareSegment(fiff_int_t& from, fiff_int_t& to, const RowVectorXi& sel);
+
+    //=========================================================================================================
+    /**
+    * Decodes the range [from, to] in the precision of the destination matrix.
+    *
+    * @param[in, out] data      The data matrix (channels x samples) to decode into.
+    * @param[in] from           first sample to include.
+    * @param[in] to             last sample to include.
+    * @param[in] p_vecScale     Calibration for each output row.
+    * @param[in] p_vecOnes      Unit scaling used when decoding into the scratch matrix.
+    * @param[in] p_matMult      Combined selection, projection, compensation and calibration matrix.
+    * @param[in, out] p_matScratch  The scratch matrix used when projection or compensation is applied.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    template<typename Scalar>
+    bool readSegment(Matrix<Scalar, Dynamic, Dynamic>& data,
+                     fiff_int_t from,
+                     fiff_int_t to,
+                     const Matrix<Scalar, Dynamic, 1>& p_vecScale,
+                     const Matrix<Scalar, Dynamic, 1>& p_vecOnes,
+                     const Matrix<Scalar, Dynamic, Dynamic>& p_matMult,
+                     Matrix<Scalar, Dynamic, Dynamic>& p_matScratch);
+
+    //=========================================================================================================
+    /**
+    * Updates the cached row to channel mapping, the per row scaling and the projection/compensation
+    * multiplication matrix if the channel selection changed since the last call.
+    *
+    * @param[in] sel        channel selection vector.
+    */
+    void updateSelection(const RowVectorXi& sel);
+
+    //=========================================================================================================
+    /**
+    * Decodes the samples [first_pick, first_pick + picksamp) of a raw buffer into the columns
+    * [dest, dest + picksamp) of p_matDest.
+    *
+    * @param[in] p_RawDir       The raw directory entry of the buffer.
+    * @param[in] first_pick     First sample within the buffer.
+    * @param[in] picksamp       Number of samples to decode.
+    * @param[in] p_vecRows      Channel index for each destination row.
+    * @param[in] p_vecScale     Scaling for each destination row.
+    * @param[out] p_matDest     The destination matrix.
+    * @param[in] dest           First destination column.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    template<typename Scalar>
+    bool decodeBuffer(const FiffRawDir& p_RawDir, qint32 first_pick, qint32 picksamp, const VectorXi& p_vecRows, const Matrix<Scalar, Dynamic, 1>& p_vecScale, Matrix<Scalar, Dynamic, Dynamic>& p_matDest, qint32 dest) const;
+
+    FiffRawData     m_FiffRawData;      /**< The raw data holding the raw directory, calibration, projection and compensation. */
+    QFile*          m_pFile;            /**< The mapped file, owned by the caller. */
+    uchar*          m_pMappedData;      /**< Start of the mapping. */
+    qint64          m_iMappedSize;      /**< Size of the mapping in bytes. */
+
+    bool            m_bUseMult;         /**< Whether projection and/or compensation have to be applied. */
+    bool            m_bSelValid;        /**< Whether the cached selection dependent members are valid. */
+    RowVectorXi     m_vecSel;           /**< The selection the cached members were computed for. */
+    VectorXi        m_vecRows;          /**< Channel index for each output row (direct decoding). */
+    VectorXd        m_vecScale;         /**< Calibration for each output row (direct decoding). */
+    VectorXi        m_vecAllRows;       /**< Identity channel mapping (decoding into the scratch matrix). */
+    VectorXd        m_vecOnes;          /**< Unit scaling (decoding into the scratch matrix). */
+    MatrixXd        m_matMult;          /**< Combined selection, projection, compensation and calibration matrix. */
+    MatrixXd        m_matScratch;       /**< Uncalibrated all channel scratch data used when m_bUseMult is set. */
+    VectorXf        m_vecScaleFloat;    /**< Single precision m_vecScale. */
+    VectorXf        m_vecOnesFloat;     /**< Single precision m_vecOnes. */
+    MatrixXf        m_matMultFloat;     /**< Single precision m_matMult. */
+    MatrixXf        m_matScratchFloat;  /**< Single precision m_matScratch. */
+    mutable MatrixXi m_matIntScratch;   /**< Decoded samples of a compressed buffer. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool FiffRawMappedReader::isMapped() const
+{
+    return m_pMappedData != Q_NULLPTR;
+}
+
+
+//*************************************************************************************************************
+
+inline const FiffRawData& FiffRawMappedReader::raw() const
+{
+    return m_FiffRawData;
+}
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_MAPPED_READER_H
@@ -0,0 +1,301 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_prefetcher.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffRawPrefetcher Class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_prefetcher.h"
+#include "fiff_raw_data.h"
+#include "fiff_raw_mapped_reader.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE TASK
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//=============================================================================================================
+/**
+* Reads one recording of a FiffRawPrefetcher on a pool thread.
+*/
+class FiffRawPrefetchTask : public QRunnable
+{
+public:
+    FiffRawPrefetchTask(FiffRawPrefetcher* p_pPrefetcher, qint32 p_iRecording)
+    : m_pPrefetcher(p_pPrefetcher)
+    , m_iRecording(p_iRecording)
+    {
+    }
+
+    void run()
+    {
+        m_pPrefetcher->readRecording(m_iRecording);
+    }
+
+private:
+    FiffRawPrefetcher*  m_pPrefetcher;
+    qint32              m_iRecording;
+};
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawPrefetcher::FiffRawPrefetcher(const QStringList& p_listFiles, fiff_int_t p_iSegmentSamples, qint64 p_iMemoryBudget, int p_iThreads)
+: m_iSegmentSamples(qMax(p_iSegmentSamples, 1))
+, m_iMemoryBudget(p_iMemoryBudget)
+, m_nextKey(0, 0)
+, m_iBytesPending(0)
+, m_bStop(false)
+{
+    for(qint32 i = 0; i < p_listFiles.size(); ++i)
+        m_vecRecordings.append(QStringList() << p_listFiles[i] << continuationFiles(p_listFiles[i]));
+
+    m_vecSegmentCount.fill(-1, m_vecRecordings.size());
+
+    if(p_iThreads > 0)
+        m_threadPool.setMaxThreadCount(p_iThreads);
+
+    //
+    // Recordings are queued in order, the pool starts them first in first out. So the recording the consumer
+    // waits for is always being read.
+    //
+    for(qint32 i = 0; i < m_vecRecordings.size(); ++i)
+        m_threadPool.start(new FiffRawPrefetchTask(this, i));
+}
+
+
+//*************************************************************************************************************
+
+FiffRawPrefetcher::~FiffRawPrefetcher()
+{
+    m_mutex.lock();
+    m_bStop = true;
+    m_condConsumed.wakeAll();
+    m_mutex.unlock();
+
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawPrefetcher::next(Segment& p_Segment)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(m_nextKey.first < m_vecRecordings.size()) {
+        QMap<SegmentKey, Segment>::iterator it = m_mapReady.find(m_nextKey);
+        if(it != m_mapReady.end()) {
+            //Swap the data out of the map, the segment is handed over without a copy
+            p_Segment.recording = it.value().recording;
+            p_Segment.fileName = it.value().fileName;
+            p_Segment.from = it.value().from;
+            p_Segment.to = it.value().to;
+            p_Segment.sfreq = it.value().sfreq;
+            p_Segment.data.swap(it.value().data);
+            m_mapReady.erase(it);
+            m_iBytesPending -= p_Segment.data.size() * sizeof(double);
+            ++m_nextKey.second;
+            m_condConsumed.wakeAll();
+            return true;
+        }
+
+        qint32 count = m_vecSegmentCount[m_nextKey.first];
+        if(count >= 0 && m_nextKey.second >= count) {
+            ++m_nextKey.first;
+            m_nextKey.second = 0;
+            m_condConsumed.wakeAll();
+            continue;
+        }
+
+        m_condReady.wait(&m_mutex);
+    }
+
+    return false;
+}
+
+
+//*************************************************************************************************************
+
+QStringList FiffRawPrefetcher::continuationFiles(const QString& p_sFileName)
+{
+    QStringList listFiles;
+
+    QFileInfo t_fileInfo(p_sFileName);
+    QString sSuffix = t_fileInfo.suffix();
+    QString sBase = p_sFileName.left(p_sFileName.size() - sSuffix.size() - (sSuffix.isEmpty() ? 0 : 1));
+
+    for(qint32 k = 1; ; ++k) {
+        QString sName = QString("%1-%2").arg(sBase).arg(k);
+        if(!sSuffix.isEmpty())
+            sName += "." + sSuffix;
+        if(!QFileInfo::exists(sName))
+            break;
+        listFiles.append(sName);
+    }
+
+    return listFiles;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawPrefetcher::readRecording(qint32 p_iRecording)
+{
+    const QStringList& listFiles = m_vecRecordings[p_iRecording];
+    qint32 count = 0;
+
+    for(qint32 f = 0; f < listFiles.size(); ++f) {
+        QFile t_file(listFiles[f]);
+        FiffRawData raw(t_file);
+        if(raw.info.nchan <= 0 || raw.first_samp > raw.last_samp) {
+            qWarning("FiffRawPrefetcher::readRecording - Could not set up raw data of %s.", listFiles[f].toUtf8().constData());
+            break;
+        }
+
+        FiffRawMappedReader reader(raw);
+        bool bMapped = reader.map();
+        MatrixXd times;
+
+        for(fiff_int_t from = raw.first_samp; from <= raw.last_samp; from += m_iSegmentSamples) {
+            fiff_int_t to = qMin(from + m_iSegmentSamples - 1, raw.last_samp);
+            SegmentKey key(p_iRecording, count);
+
+            if(!reserve(key, (qint64)raw.info.nchan * (to - from + 1) * sizeof(double)))
+                return;
+
+            Segment t_Segment;
+            t_Segment.recording = p_iRecording;
+            t_Segment.fileName = listFiles[f];
+            t_Segment.from = from;
+            t_Segment.to = to;
+            t_Segment.sfreq = raw.info.sfreq;
+
+            bool bRead = bMapped ? reader.read_raw_segment(t_Segment.data, from, to)
+                                 : raw.read_raw_segment(t_Segment.data, times, from, to);
+            if(!bRead) {
+                qWarning("FiffRawPrefetcher::readRecording - Could not read samples %d to %d of %s.", from, to, listFiles[f].toUtf8().constData());
+                m_mutex.lock();
+                m_iBytesPending -= (qint64)raw.info.nchan * (to - from + 1) * sizeof(double);
+                m_mutex.unlock();
+                finish(p_iRecording, count);
+                return;
+            }
+
+            publish(key, t_Segment);
+            ++count;
+        }
+    }
+
+    finish(p_iRecording, count);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawPrefetcher::reserve(const SegmentKey& p_Key, qint64 p_iBytes)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(!m_bStop && p_Key != m_nextKey && m_iBytesPending + p_iBytes > m_iMemoryBudget)
+        m_condConsumed.wait(&m_mutex);
+
+    if(m_bStop)
+        return false;
+
+    m_iBytesPending += p_iBytes;
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawPrefetcher::publish(const SegmentKey& p_Key, Segment& p_Segment)
+{
+    QMutexLocker locker(&m_mutex);
+
+    //Insert an empty segment and swap the data in, so the data is not copied into the map
+    Segment& t_Segment = m_mapReady[p_Key];
+    t_Segment.recording = p_Segment.recording;
+    t_Segment.fileName = p_Segment.fileName;
+    t_Segment.from = p_Segment.from;
+    t_Segment.to = p_Segment.to;
+    t_Segment.sfreq = p_Segment.sfreq;
+    t_Segment.data.swap(p_Segment.data);
+
+    m_condReady.wakeAll();
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawPrefetcher::finish(qint32 p_iRecording, qint32 p_iCount)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_vecSegmentCount[p_iRecording] = p_iCount;
+    m_condReady.wakeAll();
+}
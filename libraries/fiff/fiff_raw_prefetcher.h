@@ -0,0 +1,214 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_prefetcher.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawPrefetcher class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_PREFETCHER_H
+#define FIFF_RAW_PREFETCHER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Reads raw data segments of many recordings ahead of time on a thread pool. Each recording is read by one
+* worker, split continuation files (name-1.fif, name-2.fif, ...) are appended to their recording. Segments are
+* handed out in order of the recordings and of the samples by next(), while the workers keep reading the
+* following recordings as long as the decoded segments fit into the memory budget.
+*
+* @brief Parallel multi-file raw data reader with read-ahead.
+*/
+class FIFFSHARED_EXPORT FiffRawPrefetcher
+{
+public:
+    typedef QSharedPointer<FiffRawPrefetcher> SPtr;               /**< Shared pointer type for FiffRawPrefetcher. */
+    typedef QSharedPointer<const FiffRawPrefetcher> ConstSPtr;    /**< Const shared pointer type for FiffRawPrefetcher. */
+
+    //=========================================================================================================
+    /**
+    * A raw data segment handed out by next().
+    */
+    struct Segment {
+        qint32      recording;      /**< Index of the recording in the input list. */
+        QString     fileName;       /**< The file the segment was read from. */
+        fiff_int_t  from;           /**< First sample of the segment. */
+        fiff_int_t  to;             /**< Last sample of the segment. */
+        float       sfreq;          /**< Sampling frequency. */
+        MatrixXd    data;           /**< The calibrated data (channels x samples). */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs the prefetcher and starts reading.
+    *
+    * @param[in] p_listFiles            The recordings to read, continuation files are added automatically.
+    * @param[in] p_iSegmentSamples      Number of samples per segment.
+    * @param[in] p_iMemoryBudget        Maximal number of bytes held by read but not yet consumed segments.
+    * @param[in] p_iThreads             Number of reader threads, defaults to the ideal thread count (optional).
+    */
+    FiffRawPrefetcher(const QStringList& p_listFiles, fiff_int_t p_iSegmentSamples, qint64 p_iMemoryBudget, int p_iThreads = -1);
+
+    //=========================================================================================================
+    /**
+    * Stops reading and waits for the workers to return.
+    */
+    ~FiffRawPrefetcher();
+
+    //=========================================================================================================
+    /**
+    * Returns the next segment in order, waiting for it to be read if necessary.
+    *
+    * @param[out] p_Segment     The segment.
+    *
+    * @return true if a segment was returned, false if all recordings are consumed.
+    */
+    bool next(Segment& p_Segment);
+
+    //=========================================================================================================
+    /**
+    * Returns the list of split continuation files of a recording, e.g. name_raw-1.fif, name_raw-2.fif for
+    * name_raw.fif, which exist on disk.
+    *
+    * @param[in] p_sFileName    The first file of the recording.
+    *
+    * @return the continuation files in order.
+    */
+    static QStringList continuationFiles(const QString& p_sFileName);
+
+private:
+    friend class FiffRawPrefetchTask;
+
+    typedef QPair<qint32, qint32> SegmentKey;     /**< Recording index and segment index within the recording. */
+
+    //=========================================================================================================
+    /**
+    * Reads all segments of one recording, called on a worker thread.
+    *
+    * @param[in] p_iRecording   Index of the recording.
+    */
+    void readRecording(qint32 p_iRecording);
+
+    //=========================================================================================================
+    /**
+    * Reserves memory for a segment before it is read, waits while the memory budget is exhausted. The segment
+    * the consumer waits for is always admitted, so reading can not dead lock.
+    *
+    * @param[in] p_Key          The segment key.
+    * @param[in] p_iBytes       The size of the segment data in bytes.
+    *
+    * @return false if the prefetcher is being destroyed, true otherwise.
+    */
+    bool reserve(const SegmentKey& p_Key, qint64 p_iBytes);
+
+    //=========================================================================================================
+    /**
+    * Hands a read segment over to the consumer. The data is swapped into the pending segments, p_Segment is
+    * left with empty data.
+    *
+    * @param[in] p_Key              The segment key.
+    * @param[in, out] p_Segment     The segment.
+    */
+    void publish(const SegmentKey& p_Key, Segment& p_Segment);
+
+    //=========================================================================================================
+    /**
+    * Marks a recording as completely read.
+    *
+    * @param[in] p_iRecording   Index of the recording.
+    * @param[in] p_iCount       Number of segments published for the recording.
+    */
+    void finish(qint32 p_iRecording, qint32 p_iCount);
+
+    QVector<QStringList>        m_vecRecordings;    /**< The files of each recording. */
+    fiff_int_t                  m_iSegmentSamples;  /**< Number of samples per segment. */
+    qint64                      m_iMemoryBudget;    /**< Maximal number of bytes held by pending segments. */
+
+    QThreadPool                 m_threadPool;       /**< The reader threads. */
+    QMutex                      m_mutex;            /**< Guards all members below. */
+    QWaitCondition              m_condReady;        /**< Signals a published segment or a finished recording. */
+    QWaitCondition              m_condConsumed;     /**< Signals a consumed segment. */
+    QMap<SegmentKey, Segment>   m_mapReady;         /**< Read but not yet consumed segments. */
+    QVector<qint32>             m_vecSegmentCount;  /**< Number of segments of each finished recording, -1 while reading. */
+    SegmentKey                  m_nextKey;          /**< The segment the consumer waits for. */
+    qint64                      m_iBytesPending;    /**< Bytes reserved by read or published segments. */
+    bool                        m_bStop;            /**< Set on destruction. */
+};
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_PREFETCHER_H
@@ -0,0 +1,280 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_writer.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffRawWriter Class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_writer.h"
+#include "fiff_file.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawWriter::FiffRawWriter(QIODevice& p_IODevice, const FiffInfo& p_FiffInfo, qint32 p_iQueueSize, qint32 p_iMaxSamples, const MatrixXi& p_matSel)
+: m_IODevice(p_IODevice)
+, m_FiffInfo(p_FiffInfo)
+, m_matSel(p_matSel)
+, m_iHead(0)
+, m_iTail(0)
+, m_iCount(0)
+, m_bFinish(false)
+, m_iMaxQueueDepth(0)
+, m_iOverruns(0)
+, m_iBytesWritten(0)
+, m_iMaxLatencyNs(0)
+{
+    qint32 nchan = m_matSel.cols() > 0 ? m_matSel.cols() : m_FiffInfo.nchan;
+
+    m_vecSlots.resize(qMax(p_iQueueSize, 1));
+    for(qint32 i = 0; i < m_vecSlots.size(); ++i)
+        m_vecSlots[i].resize(nchan, p_iMaxSamples);
+    m_vecSlotSamples.fill(0, m_vecSlots.size());
+    m_vecSlotQueued.fill(0, m_vecSlots.size());
+    m_matFloat.resize(nchan, p_iMaxSamples);
+}
+
+
+//*************************************************************************************************************
+
+FiffRawWriter::~FiffRawWriter()
+{
+    finish();
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::start(fiff_int_t p_iFirstSample)
+{
+    if(m_pStream)
+        return false;
+
+    m_pStream = FiffStream::start_writing_raw(m_IODevice, m_FiffInfo, m_vecCals, m_matSel);
+    if(!m_pStream)
+        return false;
+
+    if(m_vecCals.cols() != m_vecSlots[0].rows()) {
+        qWarning("FiffRawWriter::start - Calibration and buffer sizes do not match.");
+        m_pStream.clear();
+        return false;
+    }
+    m_vecInvCals = m_vecCals.transpose().cwiseInverse();
+
+    if(p_iFirstSample > 0)
+        m_pStream->write_int(FIFF_FIRST_SAMPLE, &p_iFirstSample);
+
+    m_bFinish = false;
+    m_timer.start();
+    QThread::start();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::write_raw_buffer(const MatrixXd& buf)
+{
+    qint32 slot;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if(!m_pStream || m_bFinish)
+            return false;
+
+        if(buf.rows() != m_vecSlots[0].rows() || buf.cols() > m_vecSlots[0].cols()) {
+            qWarning("FiffRawWriter::write_raw_buffer - Buffer of size %d x %d does not fit the queue slots.", (int)buf.rows(), (int)buf.cols());
+            return false;
+        }
+
+        if(m_iCount == m_vecSlots.size()) {
+            ++m_iOverruns;
+            return false;
+        }
+
+        slot = m_iTail;
+    }
+
+    //
+    // The slot is owned by the producer until it is counted, so the copy does not need the lock
+    //
+    m_vecSlots[slot].leftCols(buf.cols()) = buf;
+    m_vecSlotSamples[slot] = buf.cols();
+    m_vecSlotQueued[slot] = m_timer.nsecsElapsed();
+
+    QMutexLocker locker(&m_mutex);
+    m_iTail = (m_iTail + 1) % m_vecSlots.size();
+    ++m_iCount;
+    if(m_iCount > m_iMaxQueueDepth)
+        m_iMaxQueueDepth = m_iCount;
+    m_condNotEmpty.wakeOne();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::finish()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(!m_pStream)
+            return false;
+        m_bFinish = true;
+        m_condNotEmpty.wakeOne();
+    }
+
+    QThread::wait();
+    m_pStream.clear();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawWriter::queueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iCount;
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawWriter::maxQueueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iMaxQueueDepth;
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawWriter::overruns() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iOverruns;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawWriter::bytesWritten() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iBytesWritten;
+}
+
+
+//*************************************************************************************************************
+
+double FiffRawWriter::bytesPerSecond() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 elapsed = m_timer.isValid() ? m_timer.nsecsElapsed() : 0;
+    return elapsed > 0 ? m_iBytesWritten * 1e9 / elapsed : 0.0;
+}
+
+
+//*************************************************************************************************************
+
+double FiffRawWriter::maxLatencyMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iMaxLatencyNs / 1e6;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::run()
+{
+    while(true) {
+        qint32 slot;
+        {
+            QMutexLocker locker(&m_mutex);
+            while(m_iCount == 0 && !m_bFinish)
+                m_condNotEmpty.wait(&m_mutex);
+
+            if(m_iCount == 0)
+                break;
+
+            slot = m_iHead;
+        }
+
+        //
+        // Calibrate back and convert to float off the acquisition thread
+        //
+        qint32 nsamp = m_vecSlotSamples[slot];
+        m_matFloat.leftCols(nsamp) = (m_vecInvCals.asDiagonal() * m_vecSlots[slot].leftCols(nsamp)).cast<float>();
+        qint32 nel = m_matFloat.rows() * nsamp;
+        m_pStream->write_float(FIFF_DATA_BUFFER, m_matFloat.data(), nel);
+
+        QMutexLocker locker(&m_mutex);
+        m_iBytesWritten += 16 + nel * (qint64)sizeof(float);
+        qint64 latency = m_timer.nsecsElapsed() - m_vecSlotQueued[slot];
+        if(latency > m_iMaxLatencyNs)
+            m_iMaxLatencyNs = latency;
+        m_iHead = (m_iHead + 1) % m_vecSlots.size();
+        --m_iCount;
+    }
+
+    m_pStream->finish_writing_raw();
+}
@@ -0,0 +1,235 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_writer.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawWriter class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_WRITER_H
+#define FIFF_RAW_WRITER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_info.h"
+#include "fiff_stream.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Asynchronous raw data writer. Buffers handed to write_raw_buffer are copied into a bounded queue of
+* pre-allocated slots and written by a dedicated I/O thread, which also applies the inverse calibration and
+* the conversion to float. The producer never waits for the file system: if the queue is full the buffer is
+* rejected and counted as an overrun.
+*
+* The writer supports a single producer thread.
+*
+* @brief Multi-threaded raw data writer with write-behind queue.
+*/
+class FIFFSHARED_EXPORT FiffRawWriter : public QThread
+{
+public:
+    typedef QSharedPointer<FiffRawWriter> SPtr;               /**< Shared pointer type for FiffRawWriter. */
+    typedef QSharedPointer<const FiffRawWriter> ConstSPtr;    /**< Const shared pointer type for FiffRawWriter. */
+
+    //=========================================================================================================
+    /**
+    * Constructs the raw data writer. All queue slots are allocated here.
+    *
+    * @param[in] p_IODevice         The device to write to, has to stay alive until finish() returns.
+    * @param[in] p_FiffInfo         The measurement info, see FiffStream::start_writing_raw.
+    * @param[in] p_iQueueSize       Number of pre-allocated buffers in the queue.
+    * @param[in] p_iMaxSamples      Maximal number of samples per buffer.
+    * @param[in] p_matSel           Channel selection, see FiffStream::start_writing_raw (optional).
+    */
+    FiffRawWriter(QIODevice& p_IODevice, const FiffInfo& p_FiffInfo, qint32 p_iQueueSize, qint32 p_iMaxSamples, const MatrixXi& p_matSel = defaultMatrixXi);
+
+    //=========================================================================================================
+    /**
+    * Destroys the raw data writer. Pending buffers are written and the file is finished.
+    */
+    ~FiffRawWriter();
+
+    //=========================================================================================================
+    /**
+    * Writes the file header (FiffStream::start_writing_raw) and starts the I/O thread.
+    *
+    * @param[in] p_iFirstSample     First sample of the recording, written as FIFF_FIRST_SAMPLE if > 0 (optional).
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool start(fiff_int_t p_iFirstSample = 0);
+
+    //=========================================================================================================
+    /**
+    * Queues a raw data buffer (channels x samples, not calibrated back) for writing. The data are copied into
+    * a free queue slot, the call never waits for disk I/O.
+    *
+    * @param[in] buf    The buffer to write, with at most p_iMaxSamples columns.
+    *
+    * @return true if the buffer was queued, false if the queue is full (overrun) or the buffer does not fit.
+    */
+    bool write_raw_buffer(const MatrixXd& buf);
+
+    //=========================================================================================================
+    /**
+    * Writes all pending buffers, finishes the file (FiffStream::finish_writing_raw) and stops the I/O thread.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool finish();
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers currently waiting in the queue.
+    *
+    * @return the current queue depth.
+    */
+    qint32 queueDepth() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the largest queue depth observed so far.
+    *
+    * @return the maximal queue depth.
+    */
+    qint32 maxQueueDepth() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers rejected because the queue was full.
+    *
+    * @return the number of overruns.
+    */
+    qint32 overruns() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of bytes written since start().
+    *
+    * @return the number of bytes written.
+    */
+    qint64 bytesWritten() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the average write throughput since start().
+    *
+    * @return the throughput in bytes per second.
+    */
+    double bytesPerSecond() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the largest time between queueing a buffer and having it written.
+    *
+    * @return the maximal latency in milliseconds.
+    */
+    double maxLatencyMs() const;
+
+protected:
+    //=========================================================================================================
+    /**
+    * The I/O loop. Takes buffers from the queue, converts and writes them and finishes the file when finish()
+    * was called and the queue is empty.
+    */
+    virtual void run();
+
+private:
+    QIODevice&              m_IODevice;         /**< The device to write to. */
+    FiffInfo                m_FiffInfo;         /**< The measurement info. */
+    MatrixXi                m_matSel;           /**< The channel selection. */
+    FiffStream::SPtr        m_pStream;          /**< The output stream, only used by the I/O thread after start(). */
+    RowVectorXd             m_vecCals;          /**< Calibration factors returned by start_writing_raw. */
+    VectorXd                m_vecInvCals;       /**< Inverse calibration factors. */
+
+    QVector<MatrixXd>       m_vecSlots;         /**< The pre-allocated queue slots. */
+    QVector<qint32>         m_vecSlotSamples;   /**< Number of valid samples in each slot. */
+    QVector<qint64>         m_vecSlotQueued;    /**< Time in ns at which each slot was queued. */
+    MatrixXf                m_matFloat;         /**< Conversion buffer of the I/O thread. */
+    qint32                  m_iHead;            /**< Next slot to write. */
+    qint32                  m_iTail;            /**< Next slot to fill. */
+    qint32                  m_iCount;           /**< Number of queued slots. */
+    bool                    m_bFinish;          /**< Set when finish() was called. */
+
+    mutable QMutex          m_mutex;            /**< Guards the queue indices and the statistics. */
+    QWaitCondition          m_condNotEmpty;     /**< Signals queued buffers to the I/O thread. */
+    QElapsedTimer           m_timer;            /**< Time since start(). */
+    qint32                  m_iMaxQueueDepth;   /**< Largest observed queue depth. */
+    qint32                  m_iOverruns;        /**< Number of rejected buffers. */
+    qint64                  m_iBytesWritten;    /**< Number of bytes written. */
+    qint64                  m_iMaxLatencyNs;    /**< Largest queue to disk latency in ns. */
+};
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_WRITER_H
@@ -45,6 +45,7 @@
 #include "fiff_info.h"
 #include "fiff_info_base.h"
 #include "fiff_raw_data.h"
+#include "fiff_raw_codec.h"
 #include "fiff_cov.h"
 #include "fiff_coord_trans.h"
 #include "fiff_ch_info.h"
@@ -59,6 +60,9 @@
 
 #define MALLOC_54(x,t) (t *)malloc((x)*sizeof(t))
 
+#define FIFF_DIR_INDEX_MAGIC    0x46494458  /**< "FIDX" */
+#define FIFF_DIR_INDEX_VERSION  1
+
 #ifndef TRUE
 #define TRUE 1
 #endif
@@ -75,6 +79,7 @@
 
 #include <iostream>
 #include <time.h>
+#include <limits>
 
 
 //*************************************************************************************************************
@@ -92,6 +97,8 @@
 //=============================================================================================================
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QTcpSocket>
 
 
@@ -111,6 +118,7 @@ using namespace UTILSLIB;
 
 FiffStream::FiffStream(QIODevice *p_pIODevice)
 : QDataStream(p_pIODevice)
+, m_bHasDirPointer(false)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -122,6 +130,7 @@ FiffStream::FiffStream(QIODevice *p_pIODevice)
 
 FiffStream::FiffStream(QByteArray * a, QIODevice::OpenMode mode)
 : QDataStream(a, mode)
+, m_bHasDirPointer(false)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -176,6 +185,14 @@ int FiffStream::nent() const
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::has_dir_pointer() const
+{
+    return m_bHasDirPointer;
+}
+
+
 //*************************************************************************************************************
 
 const FiffDirNode::SPtr& FiffStream::dirtree() const
@@ -317,15 +334,21 @@ bool FiffStream::open(QIODevice::OpenModeFlag mode)
 
     m_dir.clear();
     qint32 dirpos = *t_pTag->toInt();
+    m_bHasDirPointer = dirpos > 0;
     /*
     * Do we have a directory or not?
     */
-    if (dirpos <= 0) {  /* Must do it in the hard way... */
-        bool ok = false;
-        m_dir = this->make_dir(&ok);
-        if (!ok) {
-          qCritical ("Could not create tag directory!");
-          return false;
+    if (dirpos <= 0) {
+        /*
+        * Try the sidecar index first, otherwise do it in the hard way...
+        */
+        if (!this->read_dir_index(m_dir)) {
+            bool ok = false;
+            m_dir = this->make_dir(&ok);
+            if (!ok) {
+              qCritical ("Could not create tag directory!");
+              return false;
+            }
         }
     }
     else {              /* Just read the directory */
@@ -1809,6 +1832,21 @@ bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool a
                 case FIFFT_INT:
                     nsamp = ent->size/(4*nchan);
                     break;
+                case FIFFT_COMPRESSED_RAW:
+                {
+                    //
+                    //   The compressed buffer header holds the dimensions
+                    //
+                    fiff_int_t nchan_buf;
+                    t_pStream->device()->seek(ent->pos + 16);
+                    *t_pStream >> nchan_buf >> nsamp;
+                    if (nchan_buf != nchan)
+                    {
+                        printf("Compressed data buffer does not match the number of channels\n");
+                        return false;
+                    }
+                    break;
+                }
                 default:
                     printf("Cannot handle data buffers of type %d\n",ent->type);
                     return false;
@@ -3158,6 +3196,43 @@ bool FiffStream::write_raw_buffer(const MatrixXd& buf)
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::write_raw_buffer_compressed(const MatrixXd& buf, const RowVectorXd& cals, fiff_int_t blockSamples)
+{
+    if (buf.rows() != cals.cols())
+    {
+        printf("buffer and calibration sizes do not match\n");
+        return false;
+    }
+
+    //
+    //   Only integer valued data are coded losslessly, float data would be quantized to calibration units
+    //
+    ArrayXXd scaled = (cals.transpose().cwiseInverse().asDiagonal()*buf).array();
+    ArrayXXd rounded = scaled.round();
+    if (!scaled.isFinite().all() || rounded.abs().maxCoeff() > (double)std::numeric_limits<int>::max()
+            || (scaled - rounded).abs().maxCoeff() > 1e-3)
+    {
+        printf("buffer is not integer valued in calibration units, it can not be compressed losslessly\n");
+        return false;
+    }
+
+    MatrixXi tmp = rounded.cast<int>();
+
+    QByteArray encoded;
+    FiffRawCodec::encode(tmp, encoded, blockSamples);
+
+    *this << (qint32)FIFF_DATA_BUFFER;
+    *this << (qint32)FIFFT_COMPRESSED_RAW;
+    *this << (qint32)encoded.size();
+    *this << (qint32)FIFFV_NEXT_SEQ;
+
+    this->writeRawData(encoded.constData(),encoded.size());
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 fiff_long_t FiffStream::write_string(fiff_int_t kind, const QString& data)
@@ -3238,6 +3313,105 @@ QList<FiffDirEntry::SPtr> FiffStream::make_dir(bool *ok)
 }
 
 
+//*************************************************************************************************************
+
+QString FiffStream::dir_index_name(const QString& p_sFileName)
+{
+    return p_sFileName + QString(".idx");
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::read_dir_index(QList<FiffDirEntry::SPtr>& p_Dir)
+{
+    QFile* t_pFile = qobject_cast<QFile*>(this->device());
+    if(!t_pFile)
+        return false;
+
+    QFile t_fileIndex(dir_index_name(t_pFile->fileName()));
+    if(!t_fileIndex.exists() || !t_fileIndex.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream t_streamIndex(&t_fileIndex);
+    t_streamIndex.setByteOrder(QDataStream::BigEndian);
+
+    quint32 magic, version;
+    qint64 fileSize, fileModified;
+    FiffId t_id;
+    qint32 nent;
+
+    t_streamIndex >> magic >> version;
+    if(magic != FIFF_DIR_INDEX_MAGIC || version != FIFF_DIR_INDEX_VERSION)
+        return false;
+
+    t_streamIndex >> fileSize >> fileModified;
+    t_streamIndex >> t_id.version >> t_id.machid[0] >> t_id.machid[1] >> t_id.time.secs >> t_id.time.usecs;
+    t_streamIndex >> nent;
+
+    //
+    // Validate the index against the file
+    //
+    QFileInfo t_fileInfo(*t_pFile);
+    if(fileSize != t_fileInfo.size()
+            || fileModified != t_fileInfo.lastModified().toMSecsSinceEpoch()
+            || t_id.version != m_id.version
+            || t_id.machid[0] != m_id.machid[0]
+            || t_id.machid[1] != m_id.machid[1]
+            || t_id.time.secs != m_id.time.secs
+            || t_id.time.usecs != m_id.time.usecs
+            || nent <= 0) {
+        printf("Ignoring outdated directory index %s...", t_fileIndex.fileName().toUtf8().constData());
+        return false;
+    }
+
+    QList<FiffDirEntry::SPtr> dir;
+    dir.reserve(nent);
+    for(qint32 k = 0; k < nent; ++k) {
+        FiffDirEntry::SPtr t_pFiffDirEntry(new FiffDirEntry);
+        t_streamIndex >> t_pFiffDirEntry->kind >> t_pFiffDirEntry->type >> t_pFiffDirEntry->size >> t_pFiffDirEntry->pos;
+        dir.append(t_pFiffDirEntry);
+    }
+
+    if(t_streamIndex.status() != QDataStream::Ok)
+        return false;
+
+    p_Dir = dir;
+    printf("from index...");
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::write_dir_index()
+{
+    QFile* t_pFile = qobject_cast<QFile*>(this->device());
+    if(!t_pFile || m_dir.isEmpty())
+        return false;
+
+    QFile t_fileIndex(dir_index_name(t_pFile->fileName()));
+    if(!t_fileIndex.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Cannot write directory index %s", t_fileIndex.fileName().toUtf8().constData());
+        return false;
+    }
+
+    QDataStream t_streamIndex(&t_fileIndex);
+    t_streamIndex.setByteOrder(QDataStream::BigEndian);
+
+    QFileInfo t_fileInfo(*t_pFile);
+    t_streamIndex << (quint32)FIFF_DIR_INDEX_MAGIC << (quint32)FIFF_DIR_INDEX_VERSION;
+    t_streamIndex << (qint64)t_fileInfo.size() << (qint64)t_fileInfo.lastModified().toMSecsSinceEpoch();
+    t_streamIndex << m_id.version << m_id.machid[0] << m_id.machid[1] << m_id.time.secs << m_id.time.usecs;
+    t_streamIndex << (qint32)m_dir.size();
+
+    for(qint32 k = 0; k < m_dir.size(); ++k)
+        t_streamIndex << m_dir[k]->kind << m_dir[k]->type << m_dir[k]->size << m_dir[k]->pos;
+
+    return t_streamIndex.status() == QDataStream::Ok;
+}
+
+
 //*************************************************************************************************************
 
 bool FiffStream::check_beginning(FiffTag::SPtr &p_pTag)
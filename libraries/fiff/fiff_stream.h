@@ -185,6 +185,15 @@ public:
     */
     int nent() const;
 
+    //=========================================================================================================
+    /**
+    * Whether the file has a directory pointer, i.e. open() read the directory from the file instead of
+    * scanning it or loading it from the sidecar index.
+    *
+    * @return true if the directory was read through the directory pointer.
+    */
+    bool has_dir_pointer() const;
+
     //=========================================================================================================
     /**
     * Returns the directory compiled into a tree
@@ -845,6 +854,21 @@ public:
     */
     bool write_raw_buffer(const MatrixXd& buf);
 
+    //=========================================================================================================
+    /**
+    * Writes a raw buffer block compressed (FIFFT_COMPRESSED_RAW, see FiffRawCodec). The calibrated data are
+    * divided by the calibration factors and have to be integers then, i.e. originate from integer converters, e.g.
+    * when rewriting FIFFT_DAU_PACK16 or FIFFT_INT raw files. Other data (FIFFT_FLOAT sources) are rejected, use
+    * write_raw_buffer for them.
+    *
+    * @param[in] buf            the buffer to write
+    * @param[in] cals           calibration factors
+    * @param[in] blockSamples   number of samples per independently decodable block (optional)
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool write_raw_buffer_compressed(const MatrixXd& buf, const RowVectorXd& cals, fiff_int_t blockSamples = 512);
+
     //=========================================================================================================
     /**
     * Writes a string tag
@@ -866,6 +890,37 @@ public:
     */
     void write_rt_command(fiff_int_t command, const QString& data);
 
+    //=========================================================================================================
+    /**
+    * Returns the name of the sidecar tag directory index belonging to the file of this stream.
+    *
+    * @param[in] p_sFileName    The fiff file name.
+    *
+    * @return The name of the directory index file.
+    */
+    static QString dir_index_name(const QString& p_sFileName);
+
+    //=========================================================================================================
+    /**
+    * Loads the tag directory from the sidecar index (see write_dir_index). The index is only accepted if
+    * file size, modification time and file id match the ones stored in the index. open() uses the index
+    * automatically for files without a directory pointer.
+    *
+    * @param[out] p_Dir     The loaded directory.
+    *
+    * @return true if a valid index was found and loaded, false otherwise.
+    */
+    bool read_dir_index(QList<FiffDirEntry::SPtr>& p_Dir);
+
+    //=========================================================================================================
+    /**
+    * Writes the current tag directory to the sidecar index, so subsequent opens of files without a directory
+    * pointer do not need to scan the whole file. The stream has to be opened before.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool write_dir_index();
+
 private:
     //=========================================================================================================
     /**
@@ -897,6 +952,7 @@ private:
     QList<FiffDirEntry::SPtr>   m_dir;  /**< This is the directory. If no directory exists, open automatically scans the file to create one. */
 //    int         nent;           /**< How many entries? */ -> Use nent() instead
     FiffDirNode::SPtr           m_dirtree; /**< Directory compiled into a tree */
+    bool                        m_bHasDirPointer; /**< Whether the directory was read through the directory pointer */
 //    char        *ext_file_name; /**< Name of the file holding the external data */
 //    FILE        *ext_fd;        /**< The file descriptor of the above file if open  */
 
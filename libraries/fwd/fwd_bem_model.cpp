@@ -52,9 +52,12 @@
 
 #include <fiff/fiff_stream.h>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QList>
+#include <QMutex>
 #include <QThread>
+#include <QVector>
 #include <QtConcurrent>
 
 #define _USE_MATH_DEFINES
@@ -212,15 +215,35 @@ void fromFloatEigenMatrix_40(const Eigen::MatrixXf& from_mat, float **& to_mat)
 
 
 
+//============================= contiguous matrix access =============================
+
+/*
+ * The matrices allocated with mne_cmatrix_40 keep all rows in one contiguous
+ * block (m[0]). This allows us to work on them with Eigen without copying.
+ */
+typedef Eigen::Matrix<float,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowMajor> RowMajorMatrixXf_40;
+typedef Eigen::Map<RowMajorMatrixXf_40> CMatrixMap_40;
+
+CMatrixMap_40 mne_cmatrix_map_40(float **m, int nr, int nc)
+{
+    return CMatrixMap_40(m[0],nr,nc);
+}
+
+
+
 float **mne_lu_invert_40(float **mat,int dim)
 /*
       * Invert a matrix using the LU decomposition from
       * LAPACK
+      *
+      * The blocked partial pivoting LU of Eigen is computed in place,
+      * only the inverse itself needs an additional dim x dim buffer.
       */
 {
-    Eigen::MatrixXf eigen_mat = toFloatEigenMatrix_40(mat, dim, dim);
-    Eigen::MatrixXf eigen_mat_inv = eigen_mat.inverse();
-    fromFloatEigenMatrix_40(eigen_mat_inv, mat);
+    CMatrixMap_40 eigen_mat = mne_cmatrix_map_40(mat,dim,dim);
+    Eigen::PartialPivLU<Eigen::Ref<RowMajorMatrixXf_40> > lu(eigen_mat);
+    RowMajorMatrixXf_40 eigen_mat_inv = lu.inverse();
+    eigen_mat = eigen_mat_inv;
     return mat;
 }
 
@@ -318,22 +341,72 @@ float **mne_mat_mat_mult_40 (float **m1,float **m2,int d1,int d2,int d3)
     return (result);
 #else
     float **result = ALLOC_CMATRIX_40(d1,d3);
-    int j,k,p;
-    float sum;
 
-    for (j = 0; j < d1; j++)
-        for (k = 0; k < d3; k++) {
-            sum = 0.0;
-            for (p = 0; p < d2; p++)
-                sum = sum + m1[j][p]*m2[p][k];
-            result[j][k] = sum;
-        }
+    mne_cmatrix_map_40(result,d1,d3).noalias() = mne_cmatrix_map_40(m1,d1,d2)*mne_cmatrix_map_40(m2,d2,d3);
     return (result);
 #endif
 }
 
 
 
+//============================= compute_forward.c =============================
+
+#define FWD_SOURCE_CHUNK_40 32      /* Source points per work item in the forward computation */
+
+typedef struct {
+    MNELIB::MneSourceSpaceOld* s;   /* The source space */
+    int from;                       /* First vertex of this work item */
+    int to;                         /* One past the last vertex */
+    int off;                        /* Offset of the first in-use vertex within the result */
+} fwdSourceChunk_40;
+
+
+
+//============================= BEM matrix assembly =============================
+
+#define BEM_ROW_CHUNK_40 16         /* Rows per work item in the parallel assembly */
+
+typedef struct {
+    int from;                       /* First row of this work item */
+    int to;                         /* One past the last row */
+} bemRowChunk_40;
+
+
+template<typename RowFunc>
+void bem_parallel_rows_40(int nrow, const RowFunc& rowFunc, bool report)
+/*
+      * Call rowFunc(j) for all rows j in parallel. The rows must be independent.
+      * If requested, the progress is reported in 10 % steps.
+      */
+{
+    QVector<bemRowChunk_40> chunks;
+    QAtomicInt nDone(0);
+    QMutex reportMutex;
+    int lastPct = 0;
+
+    for (int j = 0; j < nrow; j += BEM_ROW_CHUNK_40) {
+        bemRowChunk_40 chunk;
+        chunk.from = j;
+        chunk.to   = qMin(j + BEM_ROW_CHUNK_40,nrow);
+        chunks.append(chunk);
+    }
+    QtConcurrent::blockingMap(chunks, [&](const bemRowChunk_40& chunk) {
+        for (int j = chunk.from; j < chunk.to; j++)
+            rowFunc(j);
+        if (report) {
+            int done = nDone.fetchAndAddOrdered(chunk.to - chunk.from) + chunk.to - chunk.from;
+            int pct  = 10*((10*done)/nrow);
+            QMutexLocker locker(&reportMutex);
+            if (pct > lastPct && pct < 100) {
+                fprintf(stderr,"%d%% ",pct);
+                lastPct = pct;
+            }
+        }
+    });
+}
+
+
+
 
 static struct {
     int  kind;
@@ -1011,16 +1084,15 @@ void FwdBemModel::correct_auto_elements(MneSurfaceOld *surf, float **mat)
           * Improve auto-element approximation...
           */
 {
-    float *row;
-    float sum,miss;
     int   nnode = surf->np;
     int   ntri  = surf->ntri;
-    int   nmemb;
-    int   j,k;
     float pi2 = 2.0*M_PI;
-    MneTriangle*   tri;
 
 #ifdef SIMPLE
+    float *row;
+    float sum;
+    int   j,k;
+
     for (j = 0; j < nnode; j++) {
         row = mat[j];
         sum = 0.0;
@@ -1031,7 +1103,15 @@ void FwdBemModel::correct_auto_elements(MneSurfaceOld *surf, float **mat)
         row[j] = pi2 - sum;
     }
 #else
-    for (j = 0; j < nnode; j++) {
+    /*
+     * Each row is corrected independently
+     */
+    bem_parallel_rows_40(nnode, [&](int j) {
+        float *row;
+        float sum,miss;
+        int   nmemb;
+        int   k;
+        MneTriangle* tri;
         /*
          * How much is missing?
          */
@@ -1070,7 +1150,7 @@ void FwdBemModel::correct_auto_elements(MneSurfaceOld *surf, float **mat)
           sum = sum + row[k];
         fprintf (stderr,"row %d sum = %g\n",j+1,sum/pi2);
         */
-    }
+    }, false);
 #endif
     return;
 }
@@ -1087,13 +1167,11 @@ float **FwdBemModel::fwd_bem_lin_pot_coeff(const QList<MneSurfaceOld*>& surfs)
     float **sub_mat = NULL;
     int   np1,np2,ntri,np_tot,np_max;
     float **nodes;
-    MneTriangle*   tri;
-    double omega[3];
-    double *row = NULL;
-    int    j,k,p,q,c;
+    int    j,p,q;
     int    joff,koff;
     MneSurfaceOld* surf1;
     MneSurfaceOld* surf2;
+    QElapsedTimer timer;
 
     for (p = 0, np_tot = np_max = 0; p < surfs.size(); p++) {
         np_tot += surfs[p]->np;
@@ -1102,10 +1180,7 @@ float **FwdBemModel::fwd_bem_lin_pot_coeff(const QList<MneSurfaceOld*>& surfs)
     }
 
     mat = ALLOC_CMATRIX_40(np_tot,np_tot);
-    for (j = 0; j < np_tot; j++)
-        for (k = 0; k < np_tot; k++)
-            mat[j][k] = 0.0;
-    row        = MALLOC_40(np_max,double);
+    CMatrixMap_40 matMap = mne_cmatrix_map_40(mat,np_tot,np_tot);
     sub_mat = MALLOC_40(np_max,float *);
     for (p = 0, joff = 0; p < surfs.size(); p++, joff = joff + np1) {
         surf1 = surfs[p];
@@ -1119,36 +1194,40 @@ float **FwdBemModel::fwd_bem_lin_pot_coeff(const QList<MneSurfaceOld*>& surfs)
             fprintf(stderr,"\t\t%s (%d) -> %s (%d) ... ",
                     fwd_bem_explain_surface(surf1->id).toUtf8().constData(),np1,
                     fwd_bem_explain_surface(surf2->id).toUtf8().constData(),np2);
+            timer.start();
+            /*
+             * Every row (node) of this block is independent of the others
+             */
+            bem_parallel_rows_40(np1, [&](int j) {
+                Eigen::VectorXd row = Eigen::VectorXd::Zero(np2);
+                MneTriangle* tri;
+                double omega[3];
+                int    k,c;
 
-            for (j = 0; j < np1; j++) {
-                for (k = 0; k < np2; k++)
-                    row[k] = 0.0;
                 for (k = 0, tri = surf2->tris; k < ntri; k++,tri++) {
                     /*
-               * No contribution from a triangle that
-               * this vertex belongs to
-               */
+                     * No contribution from a triangle that
+                     * this vertex belongs to
+                     */
                     if (p == q && (tri->vert[0] == j || tri->vert[1] == j || tri->vert[2] == j))
                         continue;
                     /*
-               * Otherwise do the hard job
-               */
+                     * Otherwise do the hard job
+                     */
                     lin_pot_coeff (nodes[j],tri,omega);
                     for (c = 0; c < 3; c++)
                         row[tri->vert[c]] = row[tri->vert[c]] - omega[c];
                 }
-                for (k = 0; k < np2; k++)
-                    mat[j+joff][k+koff] = row[k];
-            }
+                matMap.block(j+joff,koff,1,np2) = row.transpose().cast<float>();
+            }, true);
             if (p == q) {
                 for (j = 0; j < np1; j++)
                     sub_mat[j] = mat[j+joff]+koff;
                 correct_auto_elements (surf1,sub_mat);
             }
-            fprintf(stderr,"[done]\n");
+            fprintf(stderr,"[done] (%.2f s)\n",timer.elapsed()/1000.0);
         }
     }
-    FREE_40(row);
     FREE_40(sub_mat);
     return(mat);
 }
@@ -1165,6 +1244,9 @@ int FwdBemModel::fwd_bem_linear_collocation_solution(FwdBemModel *m)
     float ip_mult;
     int k;
 
+    QElapsedTimer timer;
+    timer.start();
+
     if(m)
         m->fwd_bem_free_solution();
 
@@ -1206,7 +1288,7 @@ int FwdBemModel::fwd_bem_linear_collocation_solution(FwdBemModel *m)
 
     }
     m->bem_method = FWD_BEM_LINEAR_COLL;
-    fprintf(stderr,"Solution ready.\n");
+    fprintf(stderr,"Solution ready (%.2f s).\n",timer.elapsed()/1000.0);
     return OK;
 
 bad : {
@@ -1228,11 +1310,13 @@ float **FwdBemModel::fwd_bem_multi_solution(float **solids, float **gamma, int n
           * This is the general multilayer case
           */
 {
-    int j,k,p,q;
+    int j,p,q;
     float defl;
     float pi2 = 1.0/(2*M_PI);
     float mult;
-    int   joff,koff,jup,kup,ntot;
+    int   joff,koff,ntot;
+    float **res;
+    QElapsedTimer timer;
 
     for (j = 0,ntot = 0; j < nsurf; j++)
         ntot += ntri[j];
@@ -1240,22 +1324,21 @@ float **FwdBemModel::fwd_bem_multi_solution(float **solids, float **gamma, int n
     /*
        * Modify the matrix
        */
+    CMatrixMap_40 mat = mne_cmatrix_map_40(solids,ntot,ntot);
     for (p = 0, joff = 0; p < nsurf; p++) {
-        jup = ntri[p] + joff;
         for (q = 0, koff = 0; q < nsurf; q++) {
-            kup = ntri[q] + koff;
             mult = (gamma == NULL) ? pi2 : pi2*gamma[p][q];
-            for (j = joff; j < jup; j++)
-                for (k = koff; k < kup; k++)
-                    solids[j][k] = defl - solids[j][k]*mult;
-            koff = kup;
+            mat.block(joff,koff,ntri[p],ntri[q]) = defl - mat.block(joff,koff,ntri[p],ntri[q]).array()*mult;
+            koff += ntri[q];
         }
-        joff = jup;
+        joff += ntri[p];
     }
-    for (k = 0; k < ntot; k++)
-        solids[k][k] = solids[k][k] + 1.0;
+    mat.diagonal().array() += 1.0f;
 
-    return (mne_lu_invert_40(solids,ntot));
+    timer.start();
+    res = mne_lu_invert_40(solids,ntot);
+    fprintf(stderr,"\t\tLU inversion of a %d x %d matrix took %.2f s\n",ntot,ntot,timer.elapsed()/1000.0);
+    return res;
 }
 
 
@@ -1281,71 +1364,35 @@ void FwdBemModel::fwd_bem_ip_modify_solution(float **solution, float **ip_soluti
           */
 {
     int s;
-    int j,k,joff,koff,ntot,nlast;
+    int koff,ntot,nlast;
     float mult;
-    float *row = NULL;
-    float **sub = NULL;
 
     for (s = 0, koff = 0; s < nsurf-1; s++)
         koff = koff + ntri[s];
     nlast = ntri[nsurf-1];
     ntot  = koff + nlast;
 
-    row = MALLOC_40(nlast,float);
-    sub = MALLOC_40(ntot,float *);
     mult = (1.0 + ip_mult)/ip_mult;
 
+    CMatrixMap_40 sol    = mne_cmatrix_map_40(solution,ntot,ntot);
+    CMatrixMap_40 ip_sol = mne_cmatrix_map_40(ip_solution,nlast,nlast);
+
     fprintf(stderr,"\t\tCombining...");
-#ifndef OLD
-    fprintf(stderr,"t ");
-    mne_transpose_square_40(ip_solution,nlast);
-#endif
-    for (s = 0, joff = 0; s < nsurf; s++) {
-        fprintf(stderr,"%d3 ",s+1);
-        /*
-        * Pick the correct submatrix
-        */
-        for (j = 0; j < ntri[s]; j++)
-            sub[j] = solution[j+joff]+koff;
-        /*
-        * Multiply
-        */
-#ifdef OLD
-        for (j = 0; j < ntri[s]; j++) {
-            for (k = 0; k < nlast; k++) {
-                res = mne_dot_vectors_skip_skip(sub[j],1,ip_solution[0]+k,nlast,nlast);
-                row[k] = sub[j][k] - 2.0*res;
-            }
-            for (k = 0; k < nlast; k++)
-                sub[j][k] = row[k];
-        }
-#else
-        for (j = 0; j < ntri[s]; j++) {
-            for (k = 0; k < nlast; k++)
-                row[k] = mne_dot_vectors_40(sub[j],ip_solution[k],nlast);
-            mne_add_scaled_vector_to_40(row,-2.0,sub[j],nlast);
-        }
-#endif
-        joff = joff+ntri[s];
-    }
-#ifndef OLD
-    fprintf(stderr,"t ");
-    mne_transpose_square_40(ip_solution,nlast);
-#endif
-    fprintf(stderr,"33 ");
+    /*
+    * Multiply the last block column of all surfaces at once
+    */
+    RowMajorMatrixXf_40 prod = sol.rightCols(nlast)*ip_sol;
+    sol.rightCols(nlast) -= 2.0f*prod;
     /*
     * The lower right corner is a special case
     */
-    for (j = 0; j < nlast; j++)
-        for (k = 0; k < nlast; k++)
-            sub[j][k] = sub[j][k] + mult*ip_solution[j][k];
+    sol.bottomRightCorner(nlast,nlast) += mult*ip_sol;
     /*
     * Final scaling
     */
     fprintf(stderr,"done.\n\t\tScaling...");
-    mne_scale_vector_40(ip_mult,solution[0],ntot*ntot);
+    sol *= ip_mult;
     fprintf(stderr,"done.\n");
-    FREE_40(row); FREE_40(sub);
     return;
 }
 
@@ -1395,20 +1442,20 @@ float **FwdBemModel::fwd_bem_solid_angles(const QList<MneSurfaceOld*>& surfs)
 {
     MneSurfaceOld* surf1;
     MneSurfaceOld* surf2;
-    MneTriangle* tri;
     int ntri1,ntri2,ntri_tot;
-    int j,k,p,q;
+    int j,p,q;
     int joff,koff;
     float **solids;
-    float result;
     float **sub_solids = NULL;
     float desired;
+    QElapsedTimer timer;
 
     for (p = 0,ntri_tot = 0; p < surfs.size(); p++)
         ntri_tot += surfs[p]->ntri;
 
     sub_solids = MALLOC_40(ntri_tot,float *);
     solids = ALLOC_CMATRIX_40(ntri_tot,ntri_tot);
+    CMatrixMap_40 solidsMap = mne_cmatrix_map_40(solids,ntri_tot,ntri_tot);
     for (p = 0, joff = 0; p < surfs.size(); p++, joff = joff + ntri1) {
         surf1 = surfs[p];
         ntri1 = surf1->ntri;
@@ -1416,17 +1463,22 @@ float **FwdBemModel::fwd_bem_solid_angles(const QList<MneSurfaceOld*>& surfs)
             surf2 = surfs[q];
             ntri2 = surf2->ntri;
             fprintf(stderr,"\t\t%s (%d) -> %s (%d) ... ",fwd_bem_explain_surface(surf1->id).toUtf8().constData(),ntri1,fwd_bem_explain_surface(surf2->id).toUtf8().constData(),ntri2);
-            for (j = 0; j < ntri1; j++)
+            timer.start();
+            bem_parallel_rows_40(ntri1, [&](int j) {
+                float *row = solidsMap.row(j+joff).data()+koff;
+                MneTriangle* tri;
+                int k;
+
                 for (k = 0, tri = surf2->tris; k < ntri2; k++, tri++) {
                     if (p == q && j == k)
-                        result = 0.0;
+                        row[k] = 0.0;
                     else
-                        result = MneSurfaceOrVolume::solid_angle (surf1->tris[j].cent,tri);
-                    solids[j+joff][k+koff] = result;
+                        row[k] = MneSurfaceOrVolume::solid_angle (surf1->tris[j].cent,tri);
                 }
+            }, true);
             for (j = 0; j < ntri1; j++)
                 sub_solids[j] = solids[j+joff]+koff;
-            fprintf(stderr,"[done]\n");
+            fprintf(stderr,"[done] (%.2f s)\n",timer.elapsed()/1000.0);
             if (p == q)
                 desired = 1;
             else if (p < q)
@@ -1456,6 +1508,9 @@ int FwdBemModel::fwd_bem_constant_collocation_solution(FwdBemModel *m)
     int    k;
     float  ip_mult;
 
+    QElapsedTimer timer;
+    timer.start();
+
     if(m)
         m->fwd_bem_free_solution();
 
@@ -1494,7 +1549,7 @@ int FwdBemModel::fwd_bem_constant_collocation_solution(FwdBemModel *m)
         FREE_CMATRIX_40(ip_solution);
     }
     m->bem_method = FWD_BEM_CONSTANT_COLL;
-    fprintf (stderr,"Solution ready.\n");
+    fprintf (stderr,"Solution ready (%.2f s).\n",timer.elapsed()/1000.0);
 
     return OK;
 
@@ -1597,6 +1652,55 @@ float FwdBemModel::fwd_bem_inf_pot(float *rd, float *Q, float *rp)	/* Potential
 }
 
 
+//*************************************************************************************************************
+
+void FwdBemModel::fwd_bem_inf_field_coils(float *rd, float *Q, FwdCoilSet *coils, float *B)
+/*
+     * Infinite-medium magnetic field integrated over each coil
+     * (without \mu_0/4\pi). All integration points are processed in one pass.
+     */
+{
+    const MatrixX3f& rmag = coils->rmag_all;
+    const MatrixX3f& dir  = coils->cosmag_all;
+    ArrayXf dx = rd[X_40] - rmag.col(X_40).array();
+    ArrayXf dy = rd[Y_40] - rmag.col(Y_40).array();
+    ArrayXf dz = rd[Z_40] - rmag.col(Z_40).array();
+    ArrayXf diff2 = dx.square() + dy.square() + dz.square();
+    ArrayXf val = coils->w_all.array()*((Q[Y_40]*dz - Q[Z_40]*dy)*dir.col(X_40).array() +
+                                        (Q[Z_40]*dx - Q[X_40]*dz)*dir.col(Y_40).array() +
+                                        (Q[X_40]*dy - Q[Y_40]*dx)*dir.col(Z_40).array())/(diff2*diff2.sqrt());
+    for (int k = 0; k < coils->ncoil; k++)
+        B[k] = val.segment(coils->coil_first[k],coils->coil_first[k+1]-coils->coil_first[k]).sum();
+}
+
+
+//*************************************************************************************************************
+
+void FwdBemModel::fwd_bem_inf_pots(float *rd, float *Q, FwdBemModel *m, float *v0)
+/*
+     * Infinite-medium potentials at the triangle centers (constant collocation)
+     * or at the vertices (linear collocation) of all surfaces
+     */
+{
+    int   s,k,p;
+    float mult;
+
+    for (s = 0, p = 0; s < m->nsurf; s++) {
+        mult = m->source_mult[s];
+        if (m->bem_method == FWD_BEM_LINEAR_COLL) {
+            float **rr = m->surfs[s]->rr;
+            for (k = 0; k < m->surfs[s]->np; k++)
+                v0[p++] = mult*fwd_bem_inf_pot(rd,Q,rr[k]);
+        }
+        else {
+            MneTriangle* tri = m->surfs[s]->tris;
+            for (k = 0; k < m->surfs[s]->ntri; k++, tri++)
+                v0[p++] = mult*fwd_bem_inf_pot(rd,Q,tri->cent);
+        }
+    }
+}
+
+
 //*************************************************************************************************************
 
 int FwdBemModel::fwd_bem_specify_els(FwdBemModel* m, FwdCoilSet *els)
@@ -2196,15 +2300,8 @@ float **FwdBemModel::fwd_bem_field_coeff(FwdBemModel *m, FwdCoilSet *coils)	/* G
      * Compute the weighting factors to obtain the magnetic field
      */
 {
-    MneSurfaceOld*     surf;
-    MneTriangle*    tri;
-    FwdCoil*        coil;
     FwdCoilSet*     tcoils = NULL;
-    int            ntri;
     float          **coeff = NULL;
-    int            j,k,p,s,off;
-    double         res;
-    double         mult;
 
     if (m->solution == NULL) {
         printf("Solution matrix missing in fwd_bem_field_coeff");
@@ -2238,26 +2335,33 @@ float **FwdBemModel::fwd_bem_field_coeff(FwdBemModel *m, FwdCoilSet *coils)	/* G
             return NULL;
         }
     }
-    ntri  = m->nsol;
-    coeff = ALLOC_CMATRIX_40(coils->ncoil,ntri);
-
-    for (s = 0, off = 0; s < m->nsurf; s++) {
-        surf = m->surfs[s];
-        ntri = surf->ntri;
-        tri  = surf->tris;
-        mult = m->field_mult[s];
-
-        for (k = 0; k < ntri; k++,tri++) {
-            for (j = 0; j < coils->ncoil; j++) {
-                coil = coils->coils[j];
+    coeff = ALLOC_CMATRIX_40(coils->ncoil,m->nsol);
+    /*
+     * Each coil (row of the coefficient matrix) is independent
+     */
+    bem_parallel_rows_40(coils->ncoil, [&](int j) {
+        FwdCoil*       coil = coils->coils[j];
+        MneSurfaceOld* surf;
+        MneTriangle*   tri;
+        int            ntri,k,p,s,off;
+        double         res;
+        double         mult;
+
+        for (s = 0, off = 0; s < m->nsurf; s++) {
+            surf = m->surfs[s];
+            ntri = surf->ntri;
+            tri  = surf->tris;
+            mult = m->field_mult[s];
+
+            for (k = 0; k < ntri; k++,tri++) {
                 res = 0.0;
                 for (p = 0; p < coil->np; p++)
                     res = res + coil->w[p]*one_field_coeff(coil->rmag[p],coil->cosmag[p],tri);
                 coeff[j][k+off] = mult*res;
             }
+            off = off + ntri;
         }
-        off = off + ntri;
-    }
+    }, false);
     delete tcoils;
     return coeff;
 }
@@ -2419,15 +2523,8 @@ float **FwdBemModel::fwd_bem_lin_field_coeff(FwdBemModel *m, FwdCoilSet *coils,
           * in the linear potential approximation
           */
 {
-    MneSurfaceOld*  surf;
-    MneTriangle* tri;
-    FwdCoil*     coil;
     FwdCoilSet*  tcoils = NULL;
-    int         ntri;
     float       **coeff  = NULL;
-    int         j,k,p,pp,off,s;
-    double      res[3],one[3];
-    float       mult;
     linFieldIntFunc func;
 
     if (m->solution == NULL) {
@@ -2470,41 +2567,47 @@ float **FwdBemModel::fwd_bem_lin_field_coeff(FwdBemModel *m, FwdCoilSet *coils,
         func = fwd_bem_one_lin_field_coeff_simple;
 
     coeff = ALLOC_CMATRIX_40(coils->ncoil,m->nsol);
-    for (k = 0; k < m->nsol; k++)
-        for (j = 0; j < coils->ncoil; j++)
-            coeff[j][k] = 0.0;
+    mne_cmatrix_map_40(coeff,coils->ncoil,m->nsol).setZero();
     /*
-       * Process each of the surfaces
+       * Each coil (row of the coefficient matrix) is independent.
+       * Process each of the surfaces for one coil at a time.
        */
-    for (s = 0, off = 0; s < m->nsurf; s++) {
-        surf = m->surfs[s];
-        ntri = surf->ntri;
-        tri  = surf->tris;
-        mult = m->field_mult[s];
-
-        for (k = 0; k < ntri; k++,tri++) {
-            for (j = 0; j < coils->ncoil; j++) {
-                coil = coils->coils[j];
+    bem_parallel_rows_40(coils->ncoil, [&](int j) {
+        FwdCoil*       coil = coils->coils[j];
+        float          *row = coeff[j];
+        MneSurfaceOld* surf;
+        MneTriangle*   tri;
+        int            ntri,k,p,pp,off,s;
+        double         res[3],one[3];
+        float          mult;
+
+        for (s = 0, off = 0; s < m->nsurf; s++) {
+            surf = m->surfs[s];
+            ntri = surf->ntri;
+            tri  = surf->tris;
+            mult = m->field_mult[s];
+
+            for (k = 0; k < ntri; k++,tri++) {
                 for (pp = 0; pp < 3; pp++)
                     res[pp] = 0;
                 /*
-             * Accumulate the coefficients for each triangle node...
-             */
+                 * Accumulate the coefficients for each triangle node...
+                 */
                 for (p = 0; p < coil->np; p++) {
                     func(coil->rmag[p],coil->cosmag[p],tri,one);
                     for (pp = 0; pp < 3; pp++)
                         res[pp] = res[pp] + coil->w[p]*one[pp];
                 }
                 /*
-             * Add these to the corresponding coefficient matrix
-             * elements...
-             */
+                 * Add these to the corresponding coefficient matrix
+                 * elements...
+                 */
                 for (pp = 0; pp < 3; pp++)
-                    coeff[j][tri->vert[pp]+off] = coeff[j][tri->vert[pp]+off] + mult*res[pp];
+                    row[tri->vert[pp]+off] = row[tri->vert[pp]+off] + mult*res[pp];
             }
+            off = off + surf->np;
         }
-        off = off + surf->np;
-    }
+    }, false);
     /*
        * Discard the duplicate
        */
@@ -2548,7 +2651,7 @@ int FwdBemModel::fwd_bem_specify_coils(FwdBemModel *m, FwdCoilSet *coils)
 
     csol->ncoil     = coils->ncoil;
     csol->np        = m->nsol;
-    csol->solution  = mne_mat_mat_mult_40(sol,m->solution,coils->ncoil,m->nsol,m->nsol);//TODO: Suspicion, that this is slow - use Eigen
+    csol->solution  = mne_mat_mat_mult_40(sol,m->solution,coils->ncoil,m->nsol,m->nsol);
 
     FREE_CMATRIX_40(sol);
     return OK;
@@ -2569,10 +2672,7 @@ void FwdBemModel::fwd_bem_lin_field_calc(float *rd, float *Q, FwdCoilSet *coils,
      */
 {
     float *v0;
-    int   s,k,p,np;
-    FwdCoil* coil;
-    float  mult;
-    float  **rr;
+    int   k;
     float  my_rd[3],my_Q[3];
     FwdBemSolution* sol = (FwdBemSolution*)coils->user_data;
     /*
@@ -2593,28 +2693,16 @@ void FwdBemModel::fwd_bem_lin_field_calc(float *rd, float *Q, FwdCoilSet *coils,
     /*
        * Compute the inifinite-medium potentials at the vertices
        */
-    for (s = 0, p = 0; s < m->nsurf; s++) {
-        np     = m->surfs[s]->np;
-        rr     = m->surfs[s]->rr;
-        mult   = m->source_mult[s];
-        for (k = 0; k < np; k++)
-            v0[p++] = mult*fwd_bem_inf_pot(my_rd,my_Q,rr[k]);
-    }
+    fwd_bem_inf_pots(my_rd,my_Q,m,v0);
     /*
        * Primary current contribution
        * (can be calculated in the coil/dipole coordinates)
        */
-    for (k = 0; k < coils->ncoil; k++) {
-        coil = coils->coils[k];
-        B[k] = 0.0;
-        for (p = 0; p < coil->np; p++)
-            B[k] = B[k] + coil->w[p]*fwd_bem_inf_field(rd,Q,coil->rmag[p],coil->cosmag[p]);
-    }
+    fwd_bem_inf_field_coils(rd,Q,coils,B);
     /*
        * Volume current contribution
        */
-    for (k = 0; k < coils->ncoil; k++)
-        B[k] = B[k] + mne_dot_vectors_40(sol->solution[k],v0,m->nsol);
+    Map<VectorXf>(B,coils->ncoil).noalias() += mne_cmatrix_map_40(sol->solution,coils->ncoil,m->nsol)*Map<VectorXf>(v0,m->nsol);
     /*
        * Scale correctly
        */
@@ -2632,10 +2720,7 @@ void FwdBemModel::fwd_bem_field_calc(float *rd, float *Q, FwdCoilSet *coils, Fwd
      */
 {
     float *v0;
-    int   s,k,p,ntri;
-    FwdCoil* coil;
-    MneTriangle* tri;
-    float   mult;
+    int   k;
     float  my_rd[3],my_Q[3];
     FwdBemSolution* sol = (FwdBemSolution*)coils->user_data;
     /*
@@ -2656,28 +2741,16 @@ void FwdBemModel::fwd_bem_field_calc(float *rd, float *Q, FwdCoilSet *coils, Fwd
     /*
        * Compute the inifinite-medium potentials at the centers of the triangles
        */
-    for (s = 0, p = 0; s < m->nsurf; s++) {
-        ntri = m->surfs[s]->ntri;
-        tri  = m->surfs[s]->tris;
-        mult = m->source_mult[s];
-        for (k = 0; k < ntri; k++, tri++)
-            v0[p++] = mult*fwd_bem_inf_pot(my_rd,my_Q,tri->cent);
-    }
+    fwd_bem_inf_pots(my_rd,my_Q,m,v0);
     /*
        * Primary current contribution
        * (can be calculated in the coil/dipole coordinates)
        */
-    for (k = 0; k < coils->ncoil; k++) {
-        coil = coils->coils[k];
-        B[k] = 0.0;
-        for (p = 0; p < coil->np; p++)
-            B[k] = B[k] + coil->w[p]*fwd_bem_inf_field(rd,Q,coil->rmag[p],coil->cosmag[p]);
-    }
+    fwd_bem_inf_field_coils(rd,Q,coils,B);
     /*
        * Volume current contribution
        */
-    for (k = 0; k < coils->ncoil; k++)
-        B[k] = B[k] + mne_dot_vectors_40(sol->solution[k],v0,m->nsol);
+    Map<VectorXf>(B,coils->ncoil).noalias() += mne_cmatrix_map_40(sol->solution,coils->ncoil,m->nsol)*Map<VectorXf>(v0,m->nsol);
     /*
        * Scale correctly
        */
@@ -2963,19 +3036,21 @@ int FwdBemModel::fwd_bem_field_grad(float *rd, float Q[], FwdCoilSet *coils, flo
 void *FwdBemModel::meg_eeg_fwd_one_source_space(void *arg)
 /*
 * Compute the MEG or EEG forward solution for one source space
-* and possibly for only one source component
+* (or a range of its vertices) and possibly for only one source component
 */
 {
     FwdThreadArg* a = (FwdThreadArg*)arg;
     MneSourceSpaceOld* s = a->s;
     int            j,p,q;
+    int            from = a->from;
+    int            to   = a->to < 0 ? s->np : a->to;
     float          *xyz[3];
 
     p = a->off;
     q = 3*a->off;
     if (a->fixed_ori) {					  /* The normal source component only */
         if (a->field_pot_grad && a->res_grad) {                   /* Gradient requested? */
-            for (j = 0; j < s->np; j++)
+            for (j = from; j < to; j++)
                 if (s->inuse[j]) {
                     if (a->field_pot_grad(s->rr[j],s->nn[j],a->coils_els,a->res[p],
                                           a->res_grad[q],a->res_grad[q+1],a->res_grad[q+2],
@@ -2986,7 +3061,7 @@ void *FwdBemModel::meg_eeg_fwd_one_source_space(void *arg)
                 }
         }
         else {
-            for (j = 0; j < s->np; j++)
+            for (j = from; j < to; j++)
                 if (s->inuse[j])
                     if (a->field_pot(s->rr[j],s->nn[j],a->coils_els,a->res[p++],a->client) != OK)
                         goto bad;
@@ -2994,7 +3069,7 @@ void *FwdBemModel::meg_eeg_fwd_one_source_space(void *arg)
     }
     else {						  /* All source components */
         if (a->field_pot_grad && a->res_grad) {               /* Gradient requested? */
-            for (j = 0; j < s->np; j++) {
+            for (j = from; j < to; j++) {
                 if (s->inuse[j]) {
                     if (a->comp < 0) {				  /* Compute all components */
                         if (a->field_pot_grad(s->rr[j],Qx,a->coils_els,a->res[p],
@@ -3044,7 +3119,7 @@ void *FwdBemModel::meg_eeg_fwd_one_source_space(void *arg)
             }
         }
         else {
-            for (j = 0; j < s->np; j++) {
+            for (j = from; j < to; j++) {
                 if (s->inuse[j]) {
                     if (a->vec_field_pot) {
                         xyz[0] = a->res[p++];
@@ -3093,6 +3168,64 @@ bad : {
 }
 
 
+//*************************************************************************************************************
+
+int FwdBemModel::meg_eeg_fwd_parallel(const QList<FwdThreadArg*>& args, MneSourceSpaceOld **spaces, int nspace, int fixed_ori)
+/*
+* Compute the forward solution for all source spaces using the given workers.
+* The source points are split into small chunks which the workers
+* pick up one at a time until all chunks are done. Each worker reuses
+* its own workspace (the FwdThreadArg) for all chunks it processes.
+*/
+{
+    QVector<fwdSourceChunk_40> chunks;
+    QAtomicInt                 next(0);
+    QAtomicInt                 failed(0);
+    fwdSourceChunk_40          chunk;
+    int                        k,j,nuse,off;
+    /*
+    * Split the in-use vertices into chunks of FWD_SOURCE_CHUNK_40 sources
+    */
+    for (k = 0, off = 0; k < nspace; k++) {
+        chunk.s    = spaces[k];
+        chunk.from = 0;
+        chunk.off  = off;
+        for (j = 0, nuse = 0; j < spaces[k]->np; j++) {
+            if (spaces[k]->inuse[j]) {
+                nuse++;
+                off = fixed_ori ? off + 1 : off + 3;
+            }
+            if (nuse == FWD_SOURCE_CHUNK_40 || j == spaces[k]->np-1) {
+                chunk.to = j+1;
+                if (nuse > 0)
+                    chunks.append(chunk);
+                chunk.from = j+1;
+                chunk.off  = off;
+                nuse = 0;
+            }
+        }
+    }
+    /*
+    * Each worker takes the next unprocessed chunk until none is left
+    */
+    QtConcurrent::blockingMap(args, [&](FwdThreadArg* a) {
+        int c;
+
+        a->stat = OK;
+        while (failed.load() == 0 && (c = next.fetchAndAddOrdered(1)) < chunks.size()) {
+            a->s    = chunks[c].s;
+            a->from = chunks[c].from;
+            a->to   = chunks[c].to;
+            a->off  = chunks[c].off;
+            meg_eeg_fwd_one_source_space(a);
+            if (a->stat != OK)
+                failed.store(1);
+        }
+    });
+    return failed.load() == 0 ? OK : FAIL;
+}
+
+
 //*************************************************************************************************************
 
 int FwdBemModel::compute_forward_meg(MneSourceSpaceOld **spaces, int nspace, FwdCoilSet *coils, FwdCoilSet *comp_coils, MneCTFCompDataSet *comp_data, bool fixed_ori, FwdBemModel *bem_model, Vector3f *r0, bool use_threads, MneNamedMatrix **resp, MneNamedMatrix **resp_grad)
@@ -3110,7 +3243,7 @@ int FwdBemModel::compute_forward_meg(MneSourceSpaceOld **spaces, int nspace, Fwd
                                              * for one dipole orientation */
     int                 nmeg = coils->ncoil;/* Number of channels */
     int                 nsource;            /* Total number of sources */
-    int                 k,p,q,off;
+    int                 k,off;
     QStringList         names;              /* Channel names */
     void                *client;
     FwdThreadArg*       one_arg = NULL;
@@ -3215,52 +3348,24 @@ int FwdBemModel::compute_forward_meg(MneSourceSpaceOld **spaces, int nspace, Fwd
         use_threads = false;
 
     if (use_threads) {
-        int            nthread  = (fixed_ori || vec_field || nproc < 6) ? nspace : 3*nspace;
-        QList <FwdThreadArg*> args; //fwdThreadArg   *args    = MALLOC_40(nthread,fwdThreadArg);
+        int            nthread  = qMin(nproc,(nsource + FWD_SOURCE_CHUNK_40 - 1)/FWD_SOURCE_CHUNK_40);
+        QList <FwdThreadArg*> args;
         int            stat;
         /*
-        * We need copies to allocate separate workspace for each thread
+        * We need copies to allocate separate workspace for each thread.
+        * These are created once per thread and reused for all source chunks.
         */
-        if (fixed_ori || vec_field || nproc < 6) {
-            for (k = 0, off = 0; k < nthread; k++) {
-                FwdThreadArg* t_arg = FwdThreadArg::create_meg_multi_thread_duplicate(one_arg,bem_model != NULL);
-                t_arg->s   = spaces[k];
-                t_arg->off = off;
-                off = fixed_ori ? off + spaces[k]->nuse : off + 3*spaces[k]->nuse;
-                args.append(t_arg);
-            }
-            fprintf(stderr,"%d processors. I will use one thread for each of the %d source spaces.\n",
-                    nproc,nspace);
-        }
-        else {
-            for (k = 0, off = 0, q = 0; k < nspace; k++) {
-                for (p = 0; p < 3; p++,q++) {
-                    FwdThreadArg* t_arg = FwdThreadArg::create_meg_multi_thread_duplicate(one_arg,bem_model != NULL);
-                    t_arg->s    = spaces[k];
-                    t_arg->off  = off;
-                    t_arg->comp = p;
-                    args.append(t_arg);
-                }
-                off = fixed_ori ? off + spaces[k]->nuse : off + 3*spaces[k]->nuse;
-            }
-            fprintf(stderr,"%d processors. I will use %d threads : %d source spaces x 3 source components.\n",
-                    nproc,nthread,nspace);
-        }
+        for (k = 0; k < nthread; k++)
+            args.append(FwdThreadArg::create_meg_multi_thread_duplicate(one_arg,bem_model != NULL));
+        fprintf(stderr,"%d processors. I will use %d threads working on chunks of %d source locations.\n",
+                nproc,nthread,FWD_SOURCE_CHUNK_40);
         fprintf(stderr,"Computing MEG at %d source locations (%s orientations)...",
                 nsource,fixed_ori ? "fixed" : "free");
         /*
         * Ready to start the threads & Wait for them to complete
         */
-        QtConcurrent::blockingMap(args, meg_eeg_fwd_one_source_space);
-        /*
-        * Check the results
-        */
-        for (k = 0, stat = OK; k < nthread; k++)
-            if (args[k]->stat != OK) {
-                stat = FAIL;
-                break;
-            }
-        for (k = 0; k < args.size(); k++)//nthread == args.size()
+        stat = meg_eeg_fwd_parallel(args,spaces,nspace,fixed_ori);
+        for (k = 0; k < args.size(); k++)
             FwdThreadArg::free_meg_multi_thread_duplicate(args[k],bem_model != NULL);
         if (stat != OK)
             goto bad;
@@ -3323,7 +3428,7 @@ int FwdBemModel::compute_forward_eeg(MneSourceSpaceOld **spaces, int nspace, Fwd
                                              * for one dipole orientation */
     int             nsource;                /* Total number of sources */
     int             neeg = els->ncoil;      /* Number of channels */
-    int             k,p,q,off;
+    int             k,off;
     QStringList     names;                  /* Channel names */
     void            *client;
     FwdThreadArg*   one_arg = NULL;
@@ -3399,50 +3504,24 @@ int FwdBemModel::compute_forward_eeg(MneSourceSpaceOld **spaces, int nspace, Fwd
         use_threads = false;
 
     if (use_threads) {
-        int            nthread  = (fixed_ori || vec_pot || nproc < 6) ? nspace : 3*nspace;
-        QList <FwdThreadArg*> args; //FwdThreadArg*   *args    = MALLOC_40(nthread,FwdThreadArg*);
+        int            nthread  = qMin(nproc,(nsource + FWD_SOURCE_CHUNK_40 - 1)/FWD_SOURCE_CHUNK_40);
+        QList <FwdThreadArg*> args;
         int            stat;
         /*
-        * We need copies to allocate separate workspace for each thread
+        * We need copies to allocate separate workspace for each thread.
+        * These are created once per thread and reused for all source chunks.
         */
-        if (fixed_ori || vec_pot || nproc < 6) {
-            for (k = 0, off = 0; k < nthread; k++) {
-                FwdThreadArg* t_arg = FwdThreadArg::create_eeg_multi_thread_duplicate(one_arg,bem_model != NULL);
-                t_arg->s   = spaces[k];
-                t_arg->off = off;
-                off = fixed_ori ? off + spaces[k]->nuse : off + 3*spaces[k]->nuse;
-                args.append(t_arg);
-            }
-            printf("%d processors. I will use one thread for each of the %d source spaces.\n",nproc,nspace);
-        }
-        else {
-            for (k = 0, off = 0, q = 0; k < nspace; k++) {
-                for (p = 0; p < 3; p++,q++) {
-                    FwdThreadArg* t_arg = FwdThreadArg::create_eeg_multi_thread_duplicate(one_arg,bem_model != NULL);
-                    t_arg->s    = spaces[k];
-                    t_arg->off  = off;
-                    t_arg->comp = p;
-                    args.append(t_arg);
-                }
-                off = fixed_ori ? off + spaces[k]->nuse : off + 3*spaces[k]->nuse;
-            }
-            printf("%d processors. I will use %d threads : %d source spaces x 3 source components.\n",nproc,nthread,nspace);
-        }
+        for (k = 0; k < nthread; k++)
+            args.append(FwdThreadArg::create_eeg_multi_thread_duplicate(one_arg,bem_model != NULL));
+        printf("%d processors. I will use %d threads working on chunks of %d source locations.\n",
+                nproc,nthread,FWD_SOURCE_CHUNK_40);
         printf("Computing EEG at %d source locations (%s orientations)...",
                 nsource,fixed_ori ? "fixed" : "free");
         /*
         * Ready to start the threads & Wait for them to complete
         */
-        QtConcurrent::blockingMap(args, meg_eeg_fwd_one_source_space);
-        /*
-        * Check the results
-        */
-        for (k = 0, stat = OK; k < nthread; k++)
-            if (args[k]->stat != OK) {
-                stat = FAIL;
-                break;
-            }
-        for (k = 0; k < args.size(); k++)//nthread == args.size()
+        stat = meg_eeg_fwd_parallel(args,spaces,nspace,fixed_ori);
+        for (k = 0; k < args.size(); k++)
             FwdThreadArg::free_eeg_multi_thread_duplicate(args[k],bem_model != NULL);
         if (stat != OK)
             goto bad;
@@ -3491,6 +3570,111 @@ bad : {
                         origin */
 #define CEPS       1e-5
 
+static void sphere_field_points_40(FwdCoilSet* coils, const float *r0, const float *rd, const float *Q, float *Bval)
+/*
+ * The field of one dipole (rd relative to the origin) at all MEG coils.
+ * The integration points are visited one by one.
+ */
+{
+    const float *rmag   = coils->rmag_all.data();
+    const float *cosmag = coils->cosmag_all.data();
+    const float *w      = coils->w_all.data();
+    int   np_all        = coils->rmag_all.rows();
+    float v[3],pos[3],dir[3];
+    float a,a2,r,r2,ar,ar0,ve,vr,re,r0e,F,g0,gr,sum;
+    int   j,k,p;
+
+    if (VEC_LEN_40(rd) <= EPS) {        /* Dipole at the origin */
+        for (k = 0 ; k < coils->ncoil ; k++)
+            if (FWD_IS_MEG_COIL(coils->coils[k]->coil_class))
+                Bval[k] = 0.0;
+        return;
+    }
+    CROSS_PRODUCT_40(Q,rd,v);
+
+    for (k = 0; k < coils->ncoil; k++) {
+        if (!FWD_IS_MEG_COIL(coils->coils[k]->coil_class))
+            continue;
+        for (j = coils->coil_first[k], sum = 0.0; j < coils->coil_first[k+1]; j++) {
+            for (p = 0; p < 3; p++) {           /* The matrices are column major */
+                pos[p] = rmag[j+p*np_all] - r0[p];
+                dir[p] = cosmag[j+p*np_all];
+            }
+            a2  = (rd[X_40]-pos[X_40])*(rd[X_40]-pos[X_40]) + (rd[Y_40]-pos[Y_40])*(rd[Y_40]-pos[Y_40]) + (rd[Z_40]-pos[Z_40])*(rd[Z_40]-pos[Z_40]);
+            a   = sqrt(a2);
+            r2  = VEC_DOT_40(pos,pos);
+            r   = sqrt(r2);
+            ar  = r2 - VEC_DOT_40(pos,rd);
+            if (a > 0.0 && r > 0.0 && std::fabs(ar/(a*r)+1.0) > CEPS) {
+                ar0 = ar/a;
+                ve  = VEC_DOT_40(v,dir);   vr  = VEC_DOT_40(v,pos);
+                re  = VEC_DOT_40(pos,dir); r0e = VEC_DOT_40(rd,dir);
+                F   = a*(r*a + ar);
+                gr  = a2/r + ar0 + 2.0f*(a+r);
+                g0  = a + 2.0f*r + ar0;
+                sum += w[j]*(ve*F + vr*(g0*r0e - gr*re))/(F*F);
+            }
+        }
+        Bval[k] = MAG_FACTOR*sum;
+    }
+}
+
+
+static void sphere_field_vec_points_40(FwdCoilSet* coils, const float *r0, const float *rd, float *Bx, float *By, float *Bz)
+/*
+ * The fields of the x, y, and z dipoles at rd (relative to the origin) at all MEG coils.
+ * The integration points are visited one by one, see sphere_field_points_40.
+ */
+{
+    const float *rmag   = coils->rmag_all.data();
+    const float *cosmag = coils->cosmag_all.data();
+    const float *w      = coils->w_all.data();
+    int   np_all        = coils->rmag_all.rows();
+    float pos[3],dir[3],v1[3],v2[3];
+    float a,a2,r,r2,ar,ar0,re,r0e,F,g0,gr,g,sum[3];
+    int   j,k,p;
+
+    if (VEC_LEN_40(rd) < EPS) {         /* Dipole at the origin */
+        for (k = 0; k < coils->ncoil; k++)
+            if (FWD_IS_MEG_COIL(coils->coils[k]->coil_class))
+                Bx[k] = By[k] = Bz[k] = 0.0;
+        return;
+    }
+
+    for (k = 0; k < coils->ncoil; k++) {
+        if (!FWD_IS_MEG_COIL(coils->coils[k]->coil_class))
+            continue;
+        sum[0] = sum[1] = sum[2] = 0.0;
+        for (j = coils->coil_first[k]; j < coils->coil_first[k+1]; j++) {
+            for (p = 0; p < 3; p++) {           /* The matrices are column major */
+                pos[p] = rmag[j+p*np_all] - r0[p];
+                dir[p] = cosmag[j+p*np_all];
+            }
+            a2  = (rd[X_40]-pos[X_40])*(rd[X_40]-pos[X_40]) + (rd[Y_40]-pos[Y_40])*(rd[Y_40]-pos[Y_40]) + (rd[Z_40]-pos[Z_40])*(rd[Z_40]-pos[Z_40]);
+            a   = sqrt(a2);
+            r2  = VEC_DOT_40(pos,pos);
+            r   = sqrt(r2);
+            ar  = r2 - VEC_DOT_40(pos,rd);
+            if (a > 0.0 && r > 0.0 && std::fabs(ar/(a*r)+1.0) > CEPS) {
+                ar0 = ar/a;
+                F   = a*(r*a + ar);
+                gr  = a2/r + ar0 + 2.0f*(a+r);
+                g0  = a + 2.0f*r + ar0;
+                re  = VEC_DOT_40(pos,dir); r0e = VEC_DOT_40(rd,dir);
+                CROSS_PRODUCT_40(rd,dir,v1);
+                CROSS_PRODUCT_40(rd,pos,v2);
+                g   = (g0*r0e - gr*re)/(F*F);
+                for (p = 0; p < 3; p++)
+                    sum[p] += w[j]*(v1[p]/F + v2[p]*g);
+            }
+        }
+        Bx[k] = MAG_FACTOR*sum[0];
+        By[k] = MAG_FACTOR*sum[1];
+        Bz[k] = MAG_FACTOR*sum[2];
+    }
+}
+
+
 int FwdBemModel::fwd_sphere_field(float *rd, float Q[], FwdCoilSet *coils, float Bval[], void *client)	/* Client data will be the sphere model origin */
 {
     /* This version uses Jukka Sarvas' field computation
@@ -3508,87 +3692,14 @@ int FwdBemModel::fwd_sphere_field(float *rd, float Q[], FwdCoilSet *coils, float
 
       */
     float *r0 = (float *)client;      /* The sphere model origin */
-    float v[3],a_vec[3];
-    float a,a2,r,r2;
-    float ar,ar0,rr0;
-    float vr,ve,re,r0e;
-    float F,g0,gr,result,sum;
-    int   j,k,p;
-    FwdCoil* this_coil;
-    float *this_pos,*this_dir;	/* These point to the coil structure! */
-    int   np;
     float myrd[3];
-    float pos[3];
+    int   p;
     /*
        * Shift to the sphere model coordinates
        */
     for (p = 0; p < 3; p++)
         myrd[p] = rd[p] - r0[p];
-    rd = myrd;
-    /*
-       * Check for a dipole at the origin
-       */
-    for (k = 0 ; k < coils->ncoil ; k++)
-        if (FWD_IS_MEG_COIL(coils->coils[k]->coil_class))
-            Bval[k] = 0.0;
-    r = VEC_LEN_40(rd);
-    if (r > EPS)	{		/* The hard job */
-
-        CROSS_PRODUCT_40(Q,rd,v);
-
-        for (k = 0; k < coils->ncoil; k++) {
-            this_coil = coils->coils[k];
-            if (FWD_IS_MEG_COIL(this_coil->type)) {
-
-                np = this_coil->np;
-
-                for (j = 0, sum = 0.0; j < np; j++) {
-
-                    this_pos = this_coil->rmag[j];
-                    this_dir = this_coil->cosmag[j];
-
-                    for (p = 0; p < 3; p++)
-                        pos[p] = this_pos[p] - r0[p];
-                    this_pos = pos;
-                    result = 0.0;
-
-                    /* Vector from dipole to the field point */
-
-                    VEC_DIFF_40(rd,this_pos,a_vec);
-
-                    /* Compute the dot products needed */
-
-                    a2  = VEC_DOT_40(a_vec,a_vec);       a = sqrt(a2);
-
-                    if (a > 0.0) {
-                        r2  = VEC_DOT_40(this_pos,this_pos); r = sqrt(r2);
-                        if (r > 0.0) {
-                            rr0 = VEC_DOT_40(this_pos,rd);
-                            ar = (r2-rr0);
-                            if (std::fabs(ar/(a*r)+1.0) > CEPS) { /* There is a problem on the negative 'z' axis if the dipole location
-                                                    * and the field point are on the same line */
-                                ar0  = ar/a;
-
-                                ve = VEC_DOT_40(v,this_dir); vr = VEC_DOT_40(v,this_pos);
-                                re = VEC_DOT_40(this_pos,this_dir); r0e = VEC_DOT_40(rd,this_dir);
-
-                                /* The main ingredients */
-
-                                F  = a*(r*a + ar);
-                                gr = a2/r + ar0 + 2.0*(a+r);
-                                g0 = a + 2*r + ar0;
-
-                                /* Mix them together... */
-
-                                sum = sum + this_coil->w[j]*(ve*F + vr*(g0*r0e - gr*re))/(F*F);
-                            }
-                        }
-                    }
-                }				/* All points done */
-                Bval[k] = MAG_FACTOR*sum;
-            }
-        }
-    }
+    sphere_field_points_40(coils,r0,myrd,Q,Bval);
     return OK;          /* Happy conclusion: this works always */
 }
 
@@ -3618,89 +3729,14 @@ int FwdBemModel::fwd_sphere_field_vec(float *rd, FwdCoilSet *coils, float **Bval
 
       */
     float *r0 = (float *)client;      /* The sphere model origin */
-    float a_vec[3],v1[3],v2[3];
-    float a,a2,r,r2;
-    float ar,ar0,rr0;
-    float re,r0e;
-    float F,g0,gr,g,sum[3];
-    int   j,k,p;
-    FwdCoil* this_coil;
-    float *this_pos,*this_dir;	/* These point to the coil structure! */
-    int   np;
     float myrd[3];
-    float pos[3];
+    int   p;
     /*
        * Shift to the sphere model coordinates
        */
     for (p = 0; p < 3; p++)
         myrd[p] = rd[p] - r0[p];
-    rd = myrd;
-    /*
-       * Check for a dipole at the origin
-       */
-    r = VEC_LEN_40(rd);
-    for (k = 0; k < coils->ncoil; k++) {
-        this_coil = coils->coils[k];
-        if (FWD_IS_MEG_COIL(this_coil->coil_class)) {
-            if (r < EPS) {
-                Bval[0][k] = Bval[1][k] = Bval[2][k] = 0.0;
-            }
-            else { 	/* The hard job */
-
-                np = this_coil->np;
-                sum[0] = sum[1] = sum[2] = 0.0;
-
-                for (j = 0; j < np; j++) {
-
-                    this_pos = this_coil->rmag[j];
-                    this_dir = this_coil->cosmag[j];
-
-                    for (p = 0; p < 3; p++)
-                        pos[p] = this_pos[p] - r0[p];
-                    this_pos = pos;
-
-                    /* Vector from dipole to the field point */
-
-                    VEC_DIFF_40(rd,this_pos,a_vec);
-
-                    /* Compute the dot products needed */
-
-                    a2  = VEC_DOT_40(a_vec,a_vec);       a = sqrt(a2);
-
-                    if (a > 0.0) {
-                        r2  = VEC_DOT_40(this_pos,this_pos); r = sqrt(r2);
-                        if (r > 0.0) {
-                            rr0 = VEC_DOT_40(this_pos,rd);
-                            ar = (r2-rr0);
-                            if (std::fabs(ar/(a*r)+1.0) > CEPS) { /* There is a problem on the negative 'z' axis if the dipole location
-                                                    * and the field point are on the same line */
-
-                                /* The main ingredients */
-
-                                ar0  = ar/a;
-                                F  = a*(r*a + ar);
-                                gr = a2/r + ar0 + 2.0*(a+r);
-                                g0 = a + 2*r + ar0;
-
-                                re = VEC_DOT_40(this_pos,this_dir); r0e = VEC_DOT_40(rd,this_dir);
-                                CROSS_PRODUCT_40(rd,this_dir,v1);
-                                CROSS_PRODUCT_40(rd,this_pos,v2);
-
-                                g = (g0*r0e - gr*re)/(F*F);
-                                /*
-                     * Mix them together...
-                     */
-                                for (p = 0; p < 3; p++)
-                                    sum[p] = sum[p] + this_coil->w[j]*(v1[p]/F + v2[p]*g);
-                            }
-                        }
-                    }
-                }				/* All points done */
-                for (p = 0; p < 3; p++)
-                    Bval[p][k] = MAG_FACTOR*sum[p];
-            }
-        }
-    }
+    sphere_field_vec_points_40(coils,r0,myrd,Bval[0],Bval[1],Bval[2]);
     return OK;			/* Happy conclusion: this works always */
 }
 
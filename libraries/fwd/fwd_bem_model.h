@@ -106,6 +106,7 @@ namespace FWDLIB
 //=============================================================================================================
 
 class FwdEegSphereModel;
+class FwdThreadArg;
 
 
 //=============================================================================================================
@@ -272,6 +273,16 @@ public:
                            float *Q,	/* Dipole moment */
                            float *rp);
 
+    static void fwd_bem_inf_field_coils(float       *rd,     /* Dipole position */
+                                        float       *Q,      /* Dipole moment */
+                                        FwdCoilSet*  coils,  /* Integration points of all coils */
+                                        float       *B);     /* Weighted sum for each coil */
+
+    static void fwd_bem_inf_pots(float       *rd,     /* Dipole position (model coordinates) */
+                                 float       *Q,      /* Dipole moment (model coordinates) */
+                                 FwdBemModel* m,      /* The model */
+                                 float       *v0);    /* Potentials at the triangle centers or vertices */
+
     static int fwd_bem_specify_els(FwdBemModel* m,
                             FwdCoilSet*  els);
 
@@ -455,6 +466,11 @@ public:
 
     static void *meg_eeg_fwd_one_source_space(void *arg);
 
+    static int meg_eeg_fwd_parallel(const QList<FwdThreadArg*>& args,   /* One workspace per worker */
+                                    MNELIB::MneSourceSpaceOld* *spaces,  /* Source spaces */
+                                    int                 nspace,      /* How many? */
+                                    int                 fixed_ori);  /* Fixed-orientation dipoles? */
+
     // TODO check if this is the correct class or move
     static int compute_forward_meg( MNELIB::MneSourceSpaceOld*    *spaces,     /* Source spaces */
                                     int                 nspace,      /* How many? */
@@ -409,6 +409,7 @@ FwdCoilSet *FwdCoilSet::create_meg_coils(FIFFLIB::fiffChInfo chs, int nch, int a
     }
     if (t)
         res->coord_frame = t->to;
+    res->update_integration_points();
     return res;
 
 bad : {
@@ -434,6 +435,7 @@ FwdCoilSet *FwdCoilSet::create_eeg_els(fiffChInfo chs, int nch, const FiffCoordT
     }
     if (t)
         res->coord_frame = t->to;
+    res->update_integration_points();
     return res;
 
 bad : {
@@ -521,6 +523,7 @@ FwdCoilSet *FwdCoilSet::read_coil_defs(const QString &name)
         }
     }
     printf("%d coil definitions read\n",res->ncoil);
+    res->update_integration_points();
     return res;
 
 bad : {
@@ -571,6 +574,7 @@ FwdCoilSet* FwdCoilSet::dup_coil_set(const FiffCoordTransOld* t) const
             coil->coord_frame = t->to;
         }
     }
+    res->update_integration_points();
     return res;
 }
 
@@ -623,3 +627,32 @@ bool FwdCoilSet::is_eeg_electrode_type(int type) const
     return type == FIFFV_COIL_EEG;
 }
 
+
+//*************************************************************************************************************
+
+void FwdCoilSet::update_integration_points()
+{
+    int k,p,q,np_all;
+
+    coil_first.resize(ncoil+1);
+    for (k = 0, np_all = 0; k < ncoil; k++) {
+        coil_first[k] = np_all;
+        np_all += coils[k]->np;
+    }
+    coil_first[ncoil] = np_all;
+
+    rmag_all.resize(np_all,3);
+    cosmag_all.resize(np_all,3);
+    w_all.resize(np_all);
+    for (k = 0, q = 0; k < ncoil; k++) {
+        for (p = 0; p < coils[k]->np; p++, q++) {
+            rmag_all(q,X_6)   = coils[k]->rmag[p][X_6];
+            rmag_all(q,Y_6)   = coils[k]->rmag[p][Y_6];
+            rmag_all(q,Z_6)   = coils[k]->rmag[p][Z_6];
+            cosmag_all(q,X_6) = coils[k]->cosmag[p][X_6];
+            cosmag_all(q,Y_6) = coils[k]->cosmag[p][Y_6];
+            cosmag_all(q,Z_6) = coils[k]->cosmag[p][Z_6];
+            w_all[q]          = coils[k]->w[p];
+        }
+    }
+}
@@ -226,6 +226,14 @@ public:
     */
     bool is_eeg_electrode_type(int type) const;
 
+    //=========================================================================================================
+    /**
+    * Collects the integration points of all coils into the structure-of-arrays representation
+    * (rmag_all, cosmag_all, w_all and coil_first). This has to be called whenever coils are
+    * added or their integration points change. The creation and duplication functions do this.
+    */
+    void update_integration_points();
+
 public:
     FwdCoil **coils;                 /* The coil or electrode positions */
     int     ncoil;
@@ -233,6 +241,11 @@ public:
     void    *user_data;             /* We can put whatever in here */
     fwdUserFreeFunc user_data_free;
 
+    Eigen::MatrixX3f rmag_all;      /* The integration point locations of all coils, one row per point */
+    Eigen::MatrixX3f cosmag_all;    /* The corresponding direction cosines */
+    Eigen::VectorXf  w_all;         /* The corresponding weighting coefficients */
+    Eigen::VectorXi  coil_first;    /* Index of the first integration point of each coil (ncoil+1 entries) */
+
 // ### OLD STRUCT ###
 //    typedef struct {
 //      fwdCoil *coils;		/* The coil or electrode positions */
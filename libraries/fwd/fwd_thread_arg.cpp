@@ -103,6 +103,8 @@ FwdThreadArg::FwdThreadArg()
 ,coils_els     (NULL)
 ,client        (NULL)
 ,s             (NULL)
+,from          (0)
+,to            (-1)
 ,fixed_ori     (FALSE)
 ,stat          (FAIL)
 ,comp          (-1)
@@ -136,6 +136,8 @@ public:
     FwdCoilSet          *coils_els;        /* The coil definitions */
     void                *client;           /* Client data for the field computation function */
     MNELIB::MneSourceSpaceOld   *s;                 /* The source space to process */
+    int                 from;              /* First source space vertex to process */
+    int                 to;                /* One past the last vertex to process (-1 = all vertices) */
     int                 fixed_ori;         /* Compute fixed orientation solution? */
     int                 comp;              /* Which component to compute for free orientations */
     int                 stat;
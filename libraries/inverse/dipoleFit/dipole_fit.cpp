@@ -8,6 +8,7 @@
 
 
 
+using namespace Eigen;
 using namespace INVERSELIB;
 using namespace MNELIB;
 using namespace FWDLIB;
@@ -597,6 +598,45 @@ int mne_get_values_from_data_ch (float time,      /* Interesting time point */
 
 
 
+//*************************************************************************************************************
+
+static int fit_dipole_batch(DipoleFitData* fit,    /* Precomputed fitting data */
+                            GuessData*     guess,  /* The initial guesses */
+                            const VectorXf& times, /* Time of each data column */
+                            const MatrixXf& B,     /* The data, one time point per column */
+                            int            n,      /* How many of the columns to fit */
+                            int            verbose,
+                            ECDSet&        set)    /* Add the fitted dipoles here */
+/*
+ * Fit the first n columns of B and add the successful fits to the set in time order
+ */
+{
+    MatrixXf     one_batch = B.leftCols(n);
+    QVector<ECD> dips;
+    int          report_interval = 10;
+    int          k;
+
+    if (n == 0)
+        return OK;
+    if (DipoleFitData::fit_many(fit,guess,times.head(n),one_batch,verbose,dips) == FAIL)
+        return FAIL;
+    for (k = 0; k < n; k++) {
+        if (!dips[k].valid)
+            printf("t = %7.1f ms : %s\n",1000*times[k],"error (tbd: catch)");
+        else {
+            set.addEcd(dips[k]);
+            if (verbose)
+                dips[k].print(stdout);
+            else {
+                if (set.size() % report_interval == 0)
+                    fprintf(stderr,"%d..",set.size());
+            }
+        }
+    }
+    return OK;
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -702,7 +742,8 @@ ECDSet DipoleFit::calculateFit() const
     printf("\n---- Computing the forward solution for the guesses...\n\n");
     if ((guess = new GuessData( settings->guessname,
                                 settings->guess_surfname,
-                                settings->guess_mindist, settings->guess_exclude, settings->guess_grid, fit_data)) == NULL)
+                                settings->guess_mindist, settings->guess_exclude, settings->guess_grid, fit_data,
+                                settings->guess_cache_dir)) == NULL)
         goto out;
 
     fprintf (stderr,"\n---- Fitting : %7.1f ... %7.1f ms (step: %6.1f ms integ: %6.1f ms)\n\n",
@@ -730,41 +771,35 @@ out : {
 
 int DipoleFit::fit_dipoles( const QString& dataname, MneMeasData* data, DipoleFitData* fit, GuessData* guess, float tmin, float tmax, float tstep, float integ, int verbose, ECDSet& p_set)
 {
-    float *one = MALLOC(data->nchan,float);
     float time;
     ECDSet set;
-    ECD   dip;
-    int   s;
-    int   report_interval = 10;
+    int   s,n;
+    /*
+     * Pick all data points first, the fits are then done in one batch
+     */
+    for (s = 0, time = tmin; time < tmax; s++, time = tmin  + s*tstep)
+        ;
+    MatrixXf B(data->nchan,s);
+    VectorXf times(s);
 
     set.dataname = dataname;
 
     fprintf(stderr,"Fitting...%c",verbose ? '\n' : '\0');
-    for (s = 0, time = tmin; time < tmax; s++, time = tmin  + s*tstep) {
+    for (s = 0, n = 0, time = tmin; time < tmax; s++, time = tmin  + s*tstep) {
         /*
      * Pick the data point
      */
         if (mne_get_values_from_data(time,integ,data->current->data,data->current->np,data->nchan,data->current->tmin,
-                                     1.0/data->current->tstep,FALSE,one) == FAIL) {
+                                     1.0/data->current->tstep,FALSE,B.col(n).data()) == FAIL) {
             fprintf(stderr,"Cannot pick time: %7.1f ms\n",1000*time);
             continue;
         }
-
-        if (!DipoleFitData::fit_one(fit,guess,time,one,verbose,dip))
-            printf("t = %7.1f ms : %s\n",1000*time,"error (tbd: catch)");
-        else {
-            set.addEcd(dip);
-            if (verbose)
-                dip.print(stdout);
-            else {
-                if (set.size() % report_interval == 0)
-                    fprintf(stderr,"%d..",set.size());
-            }
-        }
+        times[n++] = time;
     }
+    if (fit_dipole_batch(fit,guess,times,B,n,verbose,set) == FAIL)
+        return FAIL;
     if (!verbose)
         fprintf(stderr,"[done]\n");
-    FREE(one);
     p_set = set;
     return OK;
 }
@@ -774,7 +809,6 @@ int DipoleFit::fit_dipoles( const QString& dataname, MneMeasData* data, DipoleFi
 
 int DipoleFit::fit_dipoles_raw(const QString& dataname, MneRawData* raw, mneChSelection sel, DipoleFitData* fit, GuessData* guess, float tmin, float tmax, float tstep, float integ, int verbose, ECDSet& p_set)
 {
-    float *one    = MALLOC(sel->nchan,float);
     float sfreq   = raw->info->sfreq;
     float myinteg = integ > 0.0 ? 2*integ : 0.1;
     int   overlap = ceil(myinteg*sfreq);
@@ -782,12 +816,12 @@ int DipoleFit::fit_dipoles_raw(const QString& dataname, MneRawData* raw, mneChSe
     int   step    = length - overlap;
     int   stepo   = step + overlap/2;
     int   start   = raw->first_samp;
-    int   s,picks;
+    int   s,picks,n;
     float time,stime;
     float **data  = ALLOC_CMATRIX(sel->nchan,length);
-    ECD    dip;
+    MatrixXf B(sel->nchan,(int)(stepo/(tstep*sfreq))+2);
+    VectorXf times(B.cols());
     ECDSet set;
-    int    report_interval = 10;
 
     set.dataname = dataname;
 
@@ -798,47 +832,44 @@ int DipoleFit::fit_dipoles_raw(const QString& dataname, MneRawData* raw, mneChSe
     if (MneRawData::mne_raw_pick_data_filt(raw,sel,start,length,data) == FAIL)
         goto bad;
     fprintf(stderr,"Fitting...%c",verbose ? '\n' : '\0');
-    for (s = 0, time = tmin; time < tmax; s++, time = tmin  + s*tstep) {
+    for (s = 0, n = 0, time = tmin; time < tmax; s++, time = tmin  + s*tstep) {
         picks = time*sfreq - start;
         if (picks > stepo) {		/* Need a new data segment? */
+            /*
+             * Fit the points picked from the current segment first
+             */
+            if (fit_dipole_batch(fit,guess,times,B,n,verbose,set) == FAIL)
+                goto bad;
+            n = 0;
             start = start + step;
             if (MneRawData::mne_raw_pick_data_filt(raw,sel,start,length,data) == FAIL)
                 goto bad;
             picks = time*sfreq - start;
             stime = start/sfreq;
         }
+        if (n == B.cols()) {
+            B.conservativeResize(Eigen::NoChange,2*n);
+            times.conservativeResize(2*n);
+        }
         /*
      * Get the values
      */
-        if (mne_get_values_from_data_ch (time,integ,data,length,sel->nchan,stime,sfreq,FALSE,one) == FAIL) {
+        if (mne_get_values_from_data_ch (time,integ,data,length,sel->nchan,stime,sfreq,FALSE,B.col(n).data()) == FAIL) {
             fprintf(stderr,"Cannot pick time: %8.3f s\n",time);
             continue;
         }
-        /*
-     * Fit
-     */
-        if (!DipoleFitData::fit_one(fit,guess,time,one,verbose,dip))
-            qWarning() << "Error";
-        else {
-            set.addEcd(dip);
-            if (verbose)
-                dip.print(stdout);
-            else {
-                if (set.size() % report_interval == 0)
-                    fprintf(stderr,"%d..",set.size());
-            }
-        }
+        times[n++] = time;
     }
+    if (fit_dipole_batch(fit,guess,times,B,n,verbose,set) == FAIL)
+        goto bad;
     if (!verbose)
         fprintf(stderr,"[done]\n");
     FREE_CMATRIX(data);
-    FREE(one);
     p_set = set;
     return OK;
 
 bad : {
         FREE_CMATRIX(data);
-        FREE(one);
         return FAIL;
     }
 }
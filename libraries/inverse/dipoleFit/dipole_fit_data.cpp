@@ -14,6 +14,7 @@
 #include <mne/c/mne_surface_old.h>
 
 #include <fwd/fwd_comp_data.h>
+#include <mne/c/mne_ctf_comp_data_set.h>
 
 #include <Eigen/Dense>
 
@@ -21,6 +22,9 @@
 #include <QFile>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QThread>
+#include <QAtomicInt>
+#include <QtConcurrent>
 
 
 
@@ -1607,6 +1611,59 @@ static dipoleFitFuncs new_dipole_fit_funcs()
 
 
 
+//*************************************************************************************************************
+
+static void free_comp_data_duplicate_3(void *d)
+/*
+ * Free a work-area duplicate created by dup_dipole_fit_funcs_3
+ * The coils and the field client belong to the original
+ */
+{
+    FwdCompData* comp = (FwdCompData*)d;
+
+    comp->comp_coils  = NULL;
+    comp->client      = NULL;
+    comp->client_free = NULL;
+    delete comp;
+}
+
+
+//*************************************************************************************************************
+
+static dipoleFitFuncs dup_dipole_fit_funcs_3(dipoleFitFuncs f, FwdBemModel* orig_bem, FwdBemModel* bem)
+/*
+ * Duplicate the forward functions so that they can be used in a separate thread.
+ * Only the parts which hold work areas are copied, everything else is shared.
+ */
+{
+    dipoleFitFuncs res;
+
+    if (!f)
+        return NULL;
+
+    res  = new_dipole_fit_funcs();
+    *res = *f;
+    if (f->meg_client && f->meg_client_free == FwdCompData::fwd_free_comp_data) {
+        FwdCompData* orig = (FwdCompData*)f->meg_client;
+        FwdCompData* comp = new FwdCompData;
+
+        *comp = *orig;
+        comp->work     = NULL;
+        comp->vec_work = NULL;
+        comp->set      = orig->set ? new MneCTFCompDataSet(*(orig->set)) : NULL;
+        if (orig_bem && comp->client == orig_bem)
+            comp->client = bem;
+        res->meg_client      = comp;
+        res->meg_client_free = free_comp_data_duplicate_3;
+    }
+    if (orig_bem && f->eeg_client == orig_bem)
+        res->eeg_client = bem;
+    res->eeg_client_free = NULL;
+    return res;
+}
+
+
+
 
 //============================= mne_simplex_fit.c =============================
 
@@ -3997,6 +4054,86 @@ out :
 }
 
 
+//*************************************************************************************************************
+
+DipoleFitData* DipoleFitData::create_thread_duplicate(DipoleFitData* d)
+/*
+ * Create a duplicate to make the data structure thread safe
+ * Do not duplicate read-only parts of the relevant structures
+ */
+{
+    DipoleFitData* res = new DipoleFitData;
+
+    *res = *d;
+    if (d->bem_model) {
+        res->bem_model     = new FwdBemModel;
+        *(res->bem_model)  = *(d->bem_model);
+        res->bem_model->v0 = NULL;
+    }
+    res->sphere_funcs     = dup_dipole_fit_funcs_3(d->sphere_funcs,d->bem_model,res->bem_model);
+    res->bem_funcs        = dup_dipole_fit_funcs_3(d->bem_funcs,d->bem_model,res->bem_model);
+    res->mag_dipole_funcs = dup_dipole_fit_funcs_3(d->mag_dipole_funcs,d->bem_model,res->bem_model);
+    if (d->funcs == d->bem_funcs)
+        res->funcs = res->bem_funcs;
+    else if (d->funcs == d->mag_dipole_funcs)
+        res->funcs = res->mag_dipole_funcs;
+    else
+        res->funcs = res->sphere_funcs;
+    res->user      = NULL;
+    res->user_free = NULL;
+    return res;
+}
+
+
+//*************************************************************************************************************
+
+void DipoleFitData::free_thread_duplicate(DipoleFitData* d)
+{
+    if (!d)
+        return;
+    free_dipole_fit_funcs(d->sphere_funcs);
+    free_dipole_fit_funcs(d->bem_funcs);
+    free_dipole_fit_funcs(d->mag_dipole_funcs);
+    d->sphere_funcs = d->bem_funcs = d->mag_dipole_funcs = d->funcs = NULL;
+    /*
+     * Only the potential work area of the BEM model is private
+     */
+    if (d->bem_model) {
+        FwdBemModel* bem = d->bem_model;
+
+        FREE_3(bem->v0); bem->v0 = NULL;
+        bem->surfs.clear();
+        bem->nsurf       = 0;
+        bem->ntri        = NULL;
+        bem->np          = NULL;
+        bem->sigma       = NULL;
+        bem->source_mult = NULL;
+        bem->field_mult  = NULL;
+        bem->gamma       = NULL;
+        bem->solution    = NULL;
+        bem->head_mri_t  = NULL;
+        delete bem;
+    }
+    /*
+     * Everything else is shared with the original
+     */
+    d->mri_head_t = NULL;
+    d->meg_head_t = NULL;
+    d->chs        = NULL;
+    d->pick       = NULL;
+    d->meg_coils  = NULL;
+    d->eeg_els    = NULL;
+    d->eeg_model  = NULL;
+    d->bem_model  = NULL;
+    d->noise      = NULL;
+    d->noise_orig = NULL;
+    d->proj       = NULL;
+    d->user       = NULL;
+    d->user_free  = NULL;
+    delete d;
+}
+
+
 //*************************************************************************************************************
 
 MneCovMatrix* DipoleFitData::ad_hoc_noise(FwdCoilSet *meg, FwdCoilSet *eeg, float grad_std, float mag_std, float eeg_std)
@@ -4636,14 +4773,69 @@ out : {
 }
 
 
+//*************************************************************************************************************
+
+static int project_dipole_field_3(DipoleFitData* d, int whiten, float **fwd)
+/*
+ * Apply projection and whitening to the fields of three orthogonal dipoles
+ */
+{
+    int k;
+
+    /*
+   * Apply projection
+   */
+#ifdef DEBUG
+    fprintf(stdout,"orig : ");
+    for (k = 0; k < 3; k++)
+        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
+    fprintf(stdout,"\n");
+#endif
+
+    for (k = 0; k < 3; k++)
+        if (MneProjOp::mne_proj_op_proj_vector(d->proj,fwd[k],d->nmeg+d->neeg,TRUE) == FAIL)
+            goto bad;
+
+#ifdef DEBUG
+    fprintf(stdout,"proj : ");
+    for (k = 0; k < 3; k++)
+        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
+    fprintf(stdout,"\n");
+#endif
+
+    /*
+   * Whiten
+   */
+    if (d->noise && whiten) {
+        if (mne_whiten_data(fwd,fwd,3,d->nmeg+d->neeg,d->noise) == FAIL)
+            goto bad;
+    }
+
+#ifdef DEBUG
+    fprintf(stdout,"white : ");
+    for (k = 0; k < 3; k++)
+        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
+    fprintf(stdout,"\n");
+#endif
+
+    return OK;
+
+bad :
+    return FAIL;
+}
+
+
 //*************************************************************************************************************
 
 DipoleForward* dipole_forward(DipoleFitData* d,
                               float         **rd,
                               int           ndip,
+                              float         **field,
                               DipoleForward* old)
 /*
  * Compute the forward solution and do other nice stuff
+ * If field is given, it holds the unprojected and unwhitened fields of the dipoles
+ * (three rows per dipole) and only the projection, whitening and SVD are done here
  */
 {
     DipoleForward* res;
@@ -4675,7 +4867,13 @@ DipoleForward* dipole_forward(DipoleFitData* d,
         /*
      * Calculate the field of three orthogonal dipoles
      */
-        if ((DipoleFitData::compute_dipole_field(d,rd[k],TRUE,this_fwd)) == FAIL)
+        if (field) {
+            for (p = 0; p < 3; p++)
+                memcpy(this_fwd[p],field[3*k+p],res->nch*sizeof(float));
+            if (project_dipole_field_3(d,TRUE,this_fwd) == FAIL)
+                goto bad;
+        }
+        else if ((DipoleFitData::compute_dipole_field(d,rd[k],TRUE,this_fwd)) == FAIL)
             goto bad;
         /*
      * Choice of column normalization
@@ -4737,7 +4935,23 @@ DipoleForward* DipoleFitData::dipole_forward_one(DipoleFitData* d,
 {
     float *rds[1];
     rds[0] = rd;
-    return dipole_forward(d,rds,1,old);
+    return dipole_forward(d,rds,1,NULL,old);
+}
+
+
+//*************************************************************************************************************
+
+DipoleForward* DipoleFitData::dipole_forward_one_from_field(DipoleFitData* d,
+                                                            float         *rd,
+                                                            float         **field,
+                                                            DipoleForward* old)
+/*
+ * Same as above but start from precomputed unprojected and unwhitened fields
+ */
+{
+    float *rds[1];
+    rds[0] = rd;
+    return dipole_forward(d,rds,1,field,old);
 }
 
 
@@ -4773,45 +4987,69 @@ static float fit_eval(float *rd,int npar,void *user)
 
 
 
-static int find_best_guess(float     *B,         /* The whitened data */
-                           int       nch,
-                           GuessData* guess,	 /* Guesses */
-                           float     limit,	 /* Pseudoradial component omission limit */
-                           int       *bestp,	 /* Which is the best */
-                           float     *goodp)	 /* Best goodness of fit */
+#define PSEUDO_RADIAL_LIMIT_3 0.2f  /* (pseudo) radial component omission limit */
+
+static int find_best_guesses(const MatrixXf& B,      /* The whitened data, one time point per column */
+                             GuessData*     guess,  /* Guesses */
+                             float          limit,  /* Pseudoradial component omission limit */
+                             VectorXi&      best,   /* Which is the best for each column (-1 if none) */
+                             VectorXf&      good)   /* Best goodness of fit for each column */
 /*
- * Thanks to the precomputed SVD everything is really simple
+ * Thanks to the precomputed SVD everything is really simple:
+ * the projections of all data columns onto all guess fields come out of one matrix product
  */
 {
-    int    k,c;
-    double B2,Bm2,this_good,one;
-    int    best = -1;
-    float  good = 0.0;
-    DipoleForward* fwd;
-    int    ncomp;
-
-    B2 = mne_dot_vectors_3(B,B,nch);
-    for (k = 0; k < guess->nguess; k++) {
-        fwd = guess->guess_fwd[k];
-        if (fwd->nch == nch) {
-            ncomp = fwd->sing[2]/fwd->sing[0] > limit ? 3 : 2;
+    MatrixXf BUu;
+    VectorXd B2;
+    double   Bm2,this_good,one;
+    int      j,k,c,ncomp;
+
+    best = VectorXi::Constant(B.cols(),-1);
+    good = VectorXf::Zero(B.cols());
+    if (guess->guess_uu.cols() != B.rows()) {
+        printf("Guess fields do not match the data.");
+        return FAIL;
+    }
+    BUu = guess->guess_uu*B;
+    B2  = B.cast<double>().colwise().squaredNorm().transpose();
+    for (j = 0; j < B.cols(); j++) {
+        for (k = 0; k < guess->nguess; k++) {
+            ncomp = guess->guess_sing[k] > limit ? 3 : 2;
             for (c = 0, Bm2 = 0.0; c < ncomp; c++) {
-                one = mne_dot_vectors_3(fwd->uu[c],B,nch);
+                one = BUu(3*k+c,j);
                 Bm2 = Bm2 + one*one;
             }
-            this_good = 1.0 - (B2 - Bm2)/B2;
-            if (this_good > good) {
-                best = k;
-                good = this_good;
+            this_good = 1.0 - (B2[j] - Bm2)/B2[j];
+            if (this_good > good[j]) {
+                best[j] = k;
+                good[j] = this_good;
             }
         }
     }
-    if (best < 0) {
+    return OK;
+}
+
+
+//*************************************************************************************************************
+
+static int find_best_guess(float     *B,         /* The whitened data */
+                           int       nch,
+                           GuessData* guess,	 /* Guesses */
+                           float     limit,	 /* Pseudoradial component omission limit */
+                           int       *bestp,	 /* Which is the best */
+                           float     *goodp)	 /* Best goodness of fit */
+{
+    VectorXi best;
+    VectorXf good;
+
+    if (find_best_guesses(Map<MatrixXf>(B,nch,1),guess,limit,best,good) == FAIL)
+        return FAIL;
+    if (best[0] < 0) {
         printf("No reasonable initial guess found.");
         return FAIL;
     }
-    *bestp = best;
-    *goodp = good;
+    *bestp = best[0];
+    *goodp = good[0];
     return OK;
 }
 
@@ -5112,17 +5350,34 @@ int simplex_minimize(float **p,		                              /* The initial si
 
 //*************************************************************************************************************
 // fit_dipoles.c
-bool DipoleFitData::fit_one(DipoleFitData* fit,	            /* Precomputed fitting data */
-                    GuessData*     guess,	            /* The initial guesses */
-                    float         time,              /* Which time is it? */
-                    float         *B,	            /* The field to fit */
-                    int           verbose,
-                    ECD&          res               /* The fitted dipole */
-                    )
+static int prepare_fit_data_3(DipoleFitData* fit, float *B)
+/*
+ * Project and whiten the data in place
+ */
+{
+    int nchan = fit->nmeg+fit->neeg;
+
+    if (MneProjOp::mne_proj_op_proj_vector(fit->proj,B,nchan,TRUE) == FAIL)
+        return FAIL;
+    if (mne_whiten_one_data(B,B,nchan,fit->noise) == FAIL)
+        return FAIL;
+    return OK;
+}
+
+
+//*************************************************************************************************************
+// fit_dipoles.c
+static bool fit_one_from_guess_3(DipoleFitData* fit,    /* Precomputed fitting data */
+                                 GuessData*     guess,  /* The initial guesses */
+                                 int            best,   /* Which guess to start from */
+                                 float          time,   /* Which time is it? */
+                                 float          *B,     /* The projected and whitened field to fit */
+                                 int            verbose,
+                                 ECD&           res)    /* The fitted dipole */
 {
     float  **simplex       = NULL;	       /* The simplex */
     float  vals[4];			       /* Values at the vertices */
-    float  limit           = 0.2;	               /* (pseudo) radial component omission limit */
+    float  limit           = PSEUDO_RADIAL_LIMIT_3; /* (pseudo) radial component omission limit */
     float  size            = 1e-2;	       /* Size of the initial simplex */
     float  ftol[]          = { 1e-2, 1e-2 };     /* Tolerances on the the two passes */
     float  atol[]          = { 0.2e-3, 0.2e-3 }; /* If dipole movement between two iterations is less than this,
@@ -5131,8 +5386,7 @@ bool DipoleFitData::fit_one(DipoleFitData* fit,	            /* Precomputed fitti
     int    max_eval        = 1000;	       /* Limit for fit function evaluations */
     int    report_interval = verbose ? 1 : -1;   /* How often to report the intermediate result */
 
-    int        best;
-    float      good,rd_guess[3],rd_final[3],Q[3],final_val;
+    float      rd_guess[3],rd_final[3],Q[3],final_val;
     fitDipUserRec user;
     int        k,p,neval,neval_tot,nchan,ncomp;
     int        fit_fail;
@@ -5140,18 +5394,6 @@ bool DipoleFitData::fit_one(DipoleFitData* fit,	            /* Precomputed fitti
     nchan = fit->nmeg+fit->neeg;
     user.fwd = NULL;
 
-    if (MneProjOp::mne_proj_op_proj_vector(fit->proj,B,nchan,TRUE) == FAIL)
-        goto bad;
-
-    if (mne_whiten_one_data(B,B,nchan,fit->noise) == FAIL)
-        goto bad;
-    /*
-   * Get the initial guess
-   */
-    if (find_best_guess(B,nchan,guess,limit,&best,&good) < 0)
-        goto bad;
-
-
     user.limit = limit;
     user.B     = B;
     user.B2    = mne_dot_vectors_3(B,B,nchan);
@@ -5240,14 +5482,88 @@ bad : {
 }
 
 
+//*************************************************************************************************************
+// fit_dipoles.c
+bool DipoleFitData::fit_one(DipoleFitData* fit,	            /* Precomputed fitting data */
+                    GuessData*     guess,	            /* The initial guesses */
+                    float         time,              /* Which time is it? */
+                    float         *B,	            /* The field to fit */
+                    int           verbose,
+                    ECD&          res               /* The fitted dipole */
+                    )
+{
+    int   best;
+    float good;
 
+    if (prepare_fit_data_3(fit,B) == FAIL)
+        return false;
+    /*
+   * Get the initial guess
+   */
+    if (find_best_guess(B,fit->nmeg+fit->neeg,guess,PSEUDO_RADIAL_LIMIT_3,&best,&good) < 0)
+        return false;
+    return fit_one_from_guess_3(fit,guess,best,time,B,verbose,res);
+}
 
 
+//*************************************************************************************************************
 
+int DipoleFitData::fit_many(DipoleFitData* fit, GuessData* guess, const VectorXf& times, MatrixXf& B, int verbose, QVector<ECD>& res)
+/*
+ * Fit a single dipole to each column of B.
+ * The initial guesses for all columns come from one matrix product and
+ * the simplex fits are then distributed over the available cores.
+ * Each worker has its own duplicate of the fitting data, the results are
+ * stored by column so that their order does not depend on the scheduling.
+ */
+{
+    QList<DipoleFitData*> workers;
+    QAtomicInt     next(0);
+    VectorXi       best;
+    VectorXf       good;
+    ECD            *resp;
+    int            ntime = B.cols();
+    int            nthread,j,k;
+
+    res.fill(ECD(),ntime);
+    resp = res.data();
+    if (ntime == 0)
+        return OK;
+    /*
+     * Project and whiten, columns which fail here are zeroed and will find no guess
+     */
+    for (j = 0; j < ntime; j++)
+        if (prepare_fit_data_3(fit,B.col(j).data()) == FAIL)
+            B.col(j).setZero();
+    if (find_best_guesses(B,guess,PSEUDO_RADIAL_LIMIT_3,best,good) == FAIL)
+        return FAIL;
+    for (j = 0; j < ntime; j++)
+        if (best[j] < 0)
+            printf("No reasonable initial guess found (t = %8.1f ms).\n",1000*times[j]);
+    /*
+     * The intermediate reports of a verbose fit are only readable in sequence
+     */
+    nthread = verbose ? 1 : qBound(1,QThread::idealThreadCount(),ntime);
+    if (nthread == 1)
+        workers.append(fit);
+    else
+        for (k = 0; k < nthread; k++)
+            workers.append(create_thread_duplicate(fit));
 
+    QtConcurrent::blockingMap(workers, [&](DipoleFitData* w) {
+        int c;
 
+        while ((c = next.fetchAndAddOrdered(1)) < ntime) {
+            if (best[c] >= 0)
+                fit_one_from_guess_3(w,guess,best[c],times[c],B.col(c).data(),verbose,resp[c]);
+        }
+    });
 
-
+    if (nthread > 1)
+        for (k = 0; k < nthread; k++)
+            free_thread_duplicate(workers[k]);
+    return OK;
+}
 
 
 //*************************************************************************************************************
@@ -5256,12 +5572,24 @@ int DipoleFitData::compute_dipole_field(DipoleFitData* d, float *rd, int whiten,
 /*
  * Compute the field and take whitening and projection into account
  */
+{
+    if (compute_dipole_field_raw(d,rd,fwd) == FAIL)
+        return FAIL;
+    return project_dipole_field_3(d,whiten,fwd);
+}
+
+
+//*************************************************************************************************************
+
+int DipoleFitData::compute_dipole_field_raw(DipoleFitData* d, float *rd, float **fwd)
+/*
+ * Compute the field of three orthogonal dipoles without projection and whitening
+ */
 {
     float *eeg_fwd[3];
     static float Qx[] = {1.0,0.0,0.0};
     static float Qy[] = {0.0,1.0,0.0};
     static float Qz[] = {0.0,0.0,1.0};
-    int k;
     /*
    * Compute the fields
    */
@@ -5298,42 +5626,6 @@ int DipoleFitData::compute_dipole_field(DipoleFitData* d, float *rd, int whiten,
         }
     }
 
-    /*
-   * Apply projection
-   */
-#ifdef DEBUG
-    fprintf(stdout,"orig : ");
-    for (k = 0; k < 3; k++)
-        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
-    fprintf(stdout,"\n");
-#endif
-
-    for (k = 0; k < 3; k++)
-        if (MneProjOp::mne_proj_op_proj_vector(d->proj,fwd[k],d->nmeg+d->neeg,TRUE) == FAIL)
-            goto bad;
-
-#ifdef DEBUG
-    fprintf(stdout,"proj : ");
-    for (k = 0; k < 3; k++)
-        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
-    fprintf(stdout,"\n");
-#endif
-
-    /*
-   * Whiten
-   */
-    if (d->noise && whiten) {
-        if (mne_whiten_data(fwd,fwd,3,d->nmeg+d->neeg,d->noise) == FAIL)
-            goto bad;
-    }
-
-#ifdef DEBUG
-    fprintf(stdout,"white : ");
-    for (k = 0; k < 3; k++)
-        fprintf(stdout,"%g ",sqrt(mne_dot_vectors_3(fwd[k],fwd[k],d->nmeg+d->neeg)));
-    fprintf(stdout,"\n");
-#endif
-
     return OK;
 
 bad :
@@ -65,6 +65,7 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QVector>
 
 // ToDo move to cpp
 #define COLUMN_NORM_NONE 0	    /* No column normalization requested */
@@ -214,18 +215,83 @@ public:
     */
     static bool fit_one(DipoleFitData* fit, GuessData* guess, float time, float *B, int verbose, ECD& res);
 
+    //=========================================================================================================
+    /**
+    * Fit a single dipole to each column of the given data. The initial guesses of all columns are found
+    * with one matrix product and the fits are distributed over the available cores, each working on its
+    * own duplicate of the fitting data.
+    *
+    * @param[in] fit        Precomputed fitting data
+    * @param[in] guess      The initial guesses
+    * @param[in] times      Time of each column
+    * @param[in, out] B     The fields to fit, one per column (projected and whitened on return)
+    * @param[in] verbose    Verbose output? Fits are done sequentially if set.
+    * @param[out] res       The fitted dipoles in column order, res[j].valid is false if column j could not be fitted
+    *
+    * @return OK when successful
+    */
+    static int fit_many(DipoleFitData* fit, GuessData* guess, const Eigen::VectorXf& times, Eigen::MatrixXf& B, int verbose, QVector<ECD>& res);
+
+    //=========================================================================================================
+    /**
+    * Creates a duplicate which can be used for fitting in a separate thread. Only the forward
+    * calculation work areas are private, all other data are shared with the original.
+    *
+    * @param[in] d      The fitting data to duplicate
+    *
+    * @return the duplicate, to be released with free_thread_duplicate
+    */
+    static DipoleFitData* create_thread_duplicate(DipoleFitData* d);
+
+    //=========================================================================================================
+    /**
+    * Releases a duplicate created with create_thread_duplicate
+    *
+    * @param[in] d      The duplicate to release
+    */
+    static void free_thread_duplicate(DipoleFitData* d);
+
 
 
 //============================= dipole_forward.c
 
     static int compute_dipole_field(DipoleFitData* d, float *rd, int whiten, float **fwd);
 
+    //=========================================================================================================
+    /**
+    * Compute the fields of three orthogonal dipoles at rd without projection and whitening.
+    *
+    * @param[in] d      The fitting data
+    * @param[in] rd     Dipole location
+    * @param[out] fwd   The fields, three rows of nmeg+neeg values
+    *
+    * @return OK when successful
+    */
+    static int compute_dipole_field_raw(DipoleFitData* d, float *rd, float **fwd);
+
     //============================= dipole_forward.c
 
     static DipoleForward* dipole_forward_one(DipoleFitData* d,
                                      float         *rd,
                                      DipoleForward* old);
 
+    //=========================================================================================================
+    /**
+    * Same as dipole_forward_one but starts from fields computed earlier with compute_dipole_field_raw.
+    * Only projection, whitening, column normalization and the SVD are done.
+    *
+    * @param[in] d      The fitting data
+    * @param[in] rd     Dipole location
+    * @param[in] field  The unprojected and unwhitened fields of the three dipole components
+    * @param[in] old    Forward solution to reuse (may be NULL)
+    *
+    * @return the forward solution or NULL on failure
+    */
+    static DipoleForward* dipole_forward_one_from_field(DipoleFitData* d,
+                                                float         *rd,
+                                                float         **field,
+                                                DipoleForward* old);
+
 
 
 
@@ -139,6 +139,8 @@ void DipoleFitSettings::checkIntegrity()
         if (guess_exclude > 0)
             printf("Guess exclude    : %6.1f mm\n",1000*guess_exclude);
     }
+    if (!guess_cache_dir.isEmpty())
+        printf("Guess cache      : %s\n",guess_cache_dir.toUtf8().data());
     printf("Data             : %s\n",measname.toUtf8().data());
     if (projnames.size() > 0) {
         printf("SSP sources      :\n");
@@ -236,6 +238,7 @@ void DipoleFitSettings::usage(char *name)
     printf("\t--exclude dist/mm Exclude points which are closer than this distance from the CM of the inner skull surface (default =  %6.1f mm).\n",1000*guess_exclude);
     printf("\t--mindist dist/mm Exclude points which are closer than this distance from the inner skull surface  (default = %6.1f mm).\n",1000*guess_mindist);
     printf("\t--grid    dist/mm Source space grid size (default = %6.1f mm).\n",1000*guess_grid);
+    printf("\t--guesscache dir  Keep the guess fields in this directory and reuse them when the geometry is unchanged.\n");
     printf("\t--magdip          Fit magnetic dipoles instead of current dipoles.\n");
     printf("\nOutput:\n\n");
     printf("\t--dip     name    xfit dip format output file name\n");
@@ -311,6 +314,14 @@ bool DipoleFitSettings::check_args (int *argc,char **argv)
             }
             guess_surfname = strdup(argv[k+1]);
         }
+        else if (strcmp(argv[k],"--guesscache") == 0) {
+            found = 2;
+            if (k == *argc - 1) {
+                qCritical ("--guesscache: argument required.");
+                return false;
+            }
+            guess_cache_dir = QString(argv[k+1]);
+        }
         else if (strcmp(argv[k],"--guessrad") == 0) {
             found = 2;
             if (k == *argc - 1) {
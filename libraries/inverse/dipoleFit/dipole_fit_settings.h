@@ -148,6 +148,7 @@ public:
     float guess_mindist = 0.010f;       /**< Minimum allowed distance to the surface */
     float guess_exclude = 0.020f;       /**< Exclude points closer than this to the origin */
     float guess_grid    = 0.010f;       /**< Grid spacing */
+    QString guess_cache_dir;            /**< Directory of the guess field cache (no caching if empty) */
 
     QString noisename;                  /**< Noise-covariance matrix */
     float grad_std     = 5e-13f;        /**< Standard deviations to be used if noise covariance is not specified */
@@ -44,10 +44,21 @@
 #include <mne/c/mne_surface_old.h>
 #include <mne/c/mne_source_space_old.h>
 
+#include <mne/c/mne_ctf_comp_data_set.h>
+#include <mne/c/mne_ctf_comp_data.h>
+#include <fwd/fwd_coil_set.h>
+#include <fwd/fwd_comp_data.h>
+
 #include <fiff/fiff_stream.h>
 #include <fiff/fiff_tag.h>
 
 #include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QSysInfo>
 
 
 //*************************************************************************************************************
@@ -88,6 +99,9 @@ using namespace INVERSELIB;
 #define Y_16 1
 #define Z_16 2
 
+#define GUESS_CACHE_MAGIC_16   0x4d4e4547   /* "MNEG" */
+#define GUESS_CACHE_VERSION_16 1
+
 
 #define VEC_COPY_16(to,from) {\
     (to)[X_16] = (from)[X_16];\
@@ -188,6 +202,64 @@ void fromIntEigenMatrix_16(const Eigen::MatrixXi& from_mat, int **&to_mat)
 }
 
 
+//*************************************************************************************************************
+
+static void hash_ints_16(QCryptographicHash& hash, const int *vals, int n)
+{
+    hash.addData((const char *)vals,n*sizeof(int));
+}
+
+
+//*************************************************************************************************************
+
+static void hash_floats_16(QCryptographicHash& hash, const float *vals, int n)
+{
+    hash.addData((const char *)vals,n*sizeof(float));
+}
+
+
+//*************************************************************************************************************
+
+static void hash_coils_16(QCryptographicHash& hash, FwdCoilSet* coils)
+/*
+ * The integration points of the coils are in the fitting coordinate frame
+ * and thus already reflect the device <-> head transformation
+ */
+{
+    int ncoil = coils ? coils->ncoil : 0;
+
+    hash_ints_16(hash,&ncoil,1);
+    for (int k = 0; k < ncoil; k++) {
+        FwdCoil* coil = coils->coils[k];
+
+        hash_ints_16(hash,&coil->type,1);
+        hash_ints_16(hash,&coil->coil_class,1);
+        hash_ints_16(hash,&coil->np,1);
+        for (int p = 0; p < coil->np; p++) {
+            hash_floats_16(hash,coil->rmag[p],3);
+            hash_floats_16(hash,coil->cosmag[p],3);
+        }
+        hash_floats_16(hash,coil->w,coil->np);
+    }
+}
+
+
+//*************************************************************************************************************
+
+static void hash_trans_16(QCryptographicHash& hash, FiffCoordTransOld* t)
+{
+    int present = t != NULL;
+
+    hash_ints_16(hash,&present,1);
+    if (t) {
+        hash_ints_16(hash,&t->from,1);
+        hash_ints_16(hash,&t->to,1);
+        hash_floats_16(hash,t->rot.data(),9);
+        hash_floats_16(hash,t->move.data(),3);
+    }
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -211,7 +283,7 @@ GuessData::GuessData()
 
 //*************************************************************************************************************
 
-GuessData::GuessData(const QString &guessname, const QString &guess_surfname, float mindist, float exclude, float grid, DipoleFitData *f)
+GuessData::GuessData(const QString &guessname, const QString &guess_surfname, float mindist, float exclude, float grid, DipoleFitData *f, const QString &cache_dir)
 {
     MneSourceSpaceOld* *sp = NULL;
     int            nsp = 0;
@@ -219,7 +291,8 @@ GuessData::GuessData(const QString &guessname, const QString &guess_surfname, fl
     int            k,p;
     float          guessrad = 0.080;
     MneSourceSpaceOld* guesses = NULL;
-    dipoleFitFuncs orig;
+    QString        cache_name;
+    bool           from_cache = false;
 
     if (!guessname.isEmpty()) {
         /*
@@ -277,23 +350,21 @@ GuessData::GuessData(const QString &guessname, const QString &guess_surfname, fl
     for (k = 0; k < this->nguess; k++)
         this->guess_fwd[k] = NULL;
     /*
-        * Compute the guesses using the sphere model for speed
+        * The unwhitened guess fields only depend on the geometry and may be in the cache already
         */
-    orig = f->funcs;
-    if (f->fit_mag_dipoles)
-        f->funcs = f->mag_dipole_funcs;
-    else
-        f->funcs = f->sphere_funcs;
-
-    for (k = 0; k < this->nguess; k++) {
-        if ((this->guess_fwd[k] = DipoleFitData::dipole_forward_one(f,this->rr[k],NULL)) == NULL)
-            goto bad;
-#ifdef DEBUG
-        sing = this->guess_fwd[k]->sing;
-        printf("%f %f %f\n",sing[0],sing[1],sing[2]);
-#endif
+    if (!cache_dir.isEmpty()) {
+        cache_name = QDir(cache_dir).filePath(QString("guess-fields-%1.bin").arg(guess_field_key(f,this->rr,this->nguess,
+                                                                                                  guessname,guess_surfname,
+                                                                                                  mindist,exclude,grid)));
+        if ((from_cache = this->read_guess_field_cache(cache_name,f->nmeg+f->neeg)))
+            fprintf(stderr,"[fields read from %s]...",cache_name.toUtf8().constData());
+    }
+    if (!this->make_guess_fields(f))
+        goto bad;
+    if (!cache_name.isEmpty() && !from_cache) {
+        if (this->write_guess_field_cache(cache_name))
+            fprintf(stderr,"[fields saved to %s]...",cache_name.toUtf8().constData());
     }
-    f->funcs = orig;
 
     fprintf(stderr,"[done %d sources]\n",p);
 
@@ -432,8 +503,6 @@ GuessData::~GuessData()
 
 bool GuessData::compute_guess_fields(DipoleFitData* f)
 {
-    dipoleFitFuncs orig = NULL;
-
     if (!f) {
         qCritical("Data missing in compute_guess_fields");
         return false;
@@ -443,24 +512,215 @@ bool GuessData::compute_guess_fields(DipoleFitData* f)
         return false;
     }
     printf("Go through all guess source locations...");
-    orig = f->funcs;
-    if (f->fit_mag_dipoles)
-        f->funcs = f->mag_dipole_funcs;
-    else
-        f->funcs = f->sphere_funcs;
-    for (int k = 0; k < this->nguess; k++) {
-        if ((this->guess_fwd[k] = DipoleFitData::dipole_forward_one(f,this->rr[k],this->guess_fwd[k])) == NULL){
-            if (orig)
+    /*
+     * Fields from an earlier call or from the cache may belong to another geometry
+     */
+    this->guess_field.resize(0,0);
+    if (!this->make_guess_fields(f))
+        return false;
+    printf("[done %d sources]\n",this->nguess);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool GuessData::make_guess_fields(DipoleFitData* f)
+{
+    dipoleFitFuncs orig = f->funcs;
+    int            nch  = f->nmeg+f->neeg;
+    float          *field[3];
+    int            k,p;
+
+    if (this->guess_field.rows() != 3*this->nguess || this->guess_field.cols() != nch) {
+        /*
+         * Compute the guesses using the sphere model for speed
+         */
+        this->guess_field.resize(3*this->nguess,nch);
+        if (f->fit_mag_dipoles)
+            f->funcs = f->mag_dipole_funcs;
+        else
+            f->funcs = f->sphere_funcs;
+        for (k = 0; k < this->nguess; k++) {
+            for (p = 0; p < 3; p++)
+                field[p] = this->guess_field.row(3*k+p).data();
+            if (DipoleFitData::compute_dipole_field_raw(f,this->rr[k],field) == FAIL) {
                 f->funcs = orig;
-            return false;
+                this->guess_field.resize(0,0);
+                return false;
+            }
         }
+        f->funcs = orig;
+    }
+    /*
+     * Projection, whitening and SVD are always redone since they depend on the noise covariance
+     */
+    for (k = 0; k < this->nguess; k++) {
+        for (p = 0; p < 3; p++)
+            field[p] = this->guess_field.row(3*k+p).data();
+        if ((this->guess_fwd[k] = DipoleFitData::dipole_forward_one_from_field(f,this->rr[k],field,this->guess_fwd[k])) == NULL)
+            return false;
 #ifdef DEBUG
         sing = this->guess_fwd[k]->sing;
         printf("%f %f %f\n",sing[0],sing[1],sing[2]);
 #endif
     }
-    f->funcs = orig;
-    printf("[done %d sources]\n",this->nguess);
+    this->make_guess_matrix();
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool GuessData::read_guess_field_cache(const QString& name, int nch)
+{
+    QFile   file(name);
+    quint32 magic;
+    qint32  version,byte_order,nguess_file,nch_file;
+    Eigen::Matrix<float,Dynamic,Dynamic,RowMajor> rr_file(this->nguess,3);
+    Eigen::Matrix<float,Dynamic,Dynamic,RowMajor> field(3*this->nguess,nch);
 
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream in(&file);
+
+    in >> magic >> version >> byte_order >> nguess_file >> nch_file;
+    if (in.status() != QDataStream::Ok || magic != GUESS_CACHE_MAGIC_16 || version != GUESS_CACHE_VERSION_16 ||
+            byte_order != QSysInfo::ByteOrder || nguess_file != this->nguess || nch_file != nch)
+        return false;
+    if (in.readRawData((char *)rr_file.data(),rr_file.size()*sizeof(float)) != (int)(rr_file.size()*sizeof(float)))
+        return false;
+    /*
+     * The guess locations are part of the key but check them anyway
+     */
+    for (int k = 0; k < this->nguess; k++)
+        for (int p = 0; p < 3; p++)
+            if (rr_file(k,p) != this->rr[k][p])
+                return false;
+    if (in.readRawData((char *)field.data(),field.size()*sizeof(float)) != (int)(field.size()*sizeof(float)))
+        return false;
+    this->guess_field = field;
     return true;
 }
+
+
+//*************************************************************************************************************
+
+bool GuessData::write_guess_field_cache(const QString& name) const
+{
+    QSaveFile file(name);
+    int       nch = this->guess_field.cols();
+
+    QDir().mkpath(QFileInfo(name).absolutePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Could not write the guess field cache %s",name.toUtf8().constData());
+        return false;
+    }
+    QDataStream out(&file);
+
+    out << (quint32)GUESS_CACHE_MAGIC_16 << (qint32)GUESS_CACHE_VERSION_16 << (qint32)QSysInfo::ByteOrder
+        << (qint32)this->nguess << (qint32)nch;
+    for (int k = 0; k < this->nguess; k++)
+        out.writeRawData((const char *)this->rr[k],3*sizeof(float));
+    out.writeRawData((const char *)this->guess_field.data(),this->guess_field.size()*sizeof(float));
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        qWarning("Could not write the guess field cache %s",name.toUtf8().constData());
+        return false;
+    }
+    return file.commit();
+}
+
+
+//*************************************************************************************************************
+
+QString GuessData::guess_field_key(DipoleFitData* f, float **rr, int nguess, const QString& guessname, const QString& guess_surfname, float mindist, float exclude, float grid)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    dipoleFitFuncs     funcs = f->fit_mag_dipoles ? f->mag_dipole_funcs : f->sphere_funcs;
+    int                ival[4];
+    float              fval[3];
+    /*
+     * Boundary-element model (defines the guess volume and the sphere origin)
+     */
+    hash.addData(f->bemname.toUtf8());
+    ival[0] = f->bem_model ? f->bem_model->nsurf : 0;
+    hash_ints_16(hash,ival,1);
+    for (int k = 0; k < ival[0]; k++) {
+        MneSurfaceOld* surf = f->bem_model->surfs[k];
+
+        hash_ints_16(hash,&surf->id,1);
+        hash_ints_16(hash,&surf->np,1);
+        for (int p = 0; p < surf->np; p++)
+            hash_floats_16(hash,surf->rr[p],3);
+        hash_floats_16(hash,&f->bem_model->sigma[k],1);
+    }
+    /*
+     * Sphere models
+     */
+    hash_floats_16(hash,f->r0,3);
+    ival[0] = f->eeg_model ? f->eeg_model->nlayer() : 0;
+    hash_ints_16(hash,ival,1);
+    for (int k = 0; k < ival[0]; k++) {
+        fval[0] = f->eeg_model->layers[k].rad;
+        fval[1] = f->eeg_model->layers[k].sigma;
+        hash_floats_16(hash,fval,2);
+    }
+    if (f->eeg_model)
+        hash_floats_16(hash,f->eeg_model->r0.data(),3);
+    /*
+     * Sensors, compensation and coordinate transformations
+     */
+    ival[0] = f->coord_frame;
+    ival[1] = f->nmeg;
+    ival[2] = f->neeg;
+    ival[3] = f->fit_mag_dipoles;
+    hash_ints_16(hash,ival,4);
+    hash_coils_16(hash,f->meg_coils);
+    hash_coils_16(hash,f->eeg_els);
+    if (funcs && funcs->meg_client && funcs->meg_client_free == FwdCompData::fwd_free_comp_data) {
+        FwdCompData* comp = (FwdCompData*)funcs->meg_client;
+
+        ival[0] = comp->set && comp->set->current ? comp->set->current->kind : 0;
+        hash_ints_16(hash,ival,1);
+        hash_coils_16(hash,comp->set && comp->set->current ? comp->comp_coils : NULL);
+    }
+    hash_trans_16(hash,f->meg_head_t);
+    hash_trans_16(hash,f->mri_head_t);
+    /*
+     * The guess grid
+     */
+    hash.addData(guessname.toUtf8());
+    hash.addData(guess_surfname.toUtf8());
+    fval[0] = mindist;
+    fval[1] = exclude;
+    fval[2] = grid;
+    hash_floats_16(hash,fval,3);
+    hash_ints_16(hash,&nguess,1);
+    for (int k = 0; k < nguess; k++)
+        hash_floats_16(hash,rr[k],3);
+
+    return QString(hash.result().toHex());
+}
+
+
+//*************************************************************************************************************
+
+void GuessData::make_guess_matrix()
+{
+    int nch = this->nguess > 0 ? this->guess_fwd[0]->nch : 0;
+
+    this->guess_uu.resize(3*this->nguess,nch);
+    this->guess_sing.resize(this->nguess);
+    for (int k = 0; k < this->nguess; k++) {
+        DipoleForward* fwd = this->guess_fwd[k];
+        /*
+         * All guesses are computed with the same channel set
+         */
+        for (int c = 0; c < 3; c++)
+            this->guess_uu.row(3*k+c) = Map<RowVectorXf>(fwd->uu[c],nch);
+        this->guess_sing[k] = fwd->sing[2]/fwd->sing[0];
+    }
+    return;
+}
@@ -110,9 +110,12 @@ public:
     * Refactored: make_guess_data (setup.c)
     *
     * @param[in] guessname
+    * @param[in] cache_dir  Directory of the guess field cache. If given, the unwhitened guess fields are read from
+    *                       there when the head model, sensors, transformations and guess grid match an earlier run
+    *                       and are saved there otherwise.
     *
     */
-    GuessData( const QString& guessname, const QString& guess_surfname, float mindist, float exclude, float grid, DipoleFitData* f);
+    GuessData( const QString& guessname, const QString& guess_surfname, float mindist, float exclude, float grid, DipoleFitData* f, const QString& cache_dir = QString());
 
     //=========================================================================================================
     /**
@@ -135,7 +138,8 @@ public:
 
     //=========================================================================================================
     /**
-    * Once the guess locations have been set up we can compute the fields
+    * Once the guess locations have been set up we can compute the fields. The unwhitened guess fields are always
+    * recomputed.
     * Refactored: compute_guess_fields (dipole_fit_setup.c)
     *
     * @param[in] f      Dipole Fit Data to the Compute Guess Fields
@@ -144,10 +148,71 @@ public:
     */
     bool compute_guess_fields(DipoleFitData* f);
 
+    //=========================================================================================================
+    /**
+    * Stacks the left singular vectors of all guess fields into guess_uu so that the initial guess scan
+    * reduces to a single matrix product with the whitened data. Has to be called whenever guess_fwd changes.
+    */
+    void make_guess_matrix();
+
+    //=========================================================================================================
+    /**
+    * Computes the unwhitened guess fields unless guess_field already holds them (read from the guess field cache)
+    * and derives guess_fwd from these with the current projection and noise covariance.
+    *
+    * @param[in] f      Dipole Fit Data to compute the fields with
+    *
+    * @return true when successful
+    */
+    bool make_guess_fields(DipoleFitData* f);
+
+    //=========================================================================================================
+    /**
+    * Reads the unwhitened guess fields from a cache file written by write_guess_field_cache.
+    * The file is only accepted if it matches the present guess locations and channel count.
+    *
+    * @param[in] name   The cache file
+    * @param[in] nch    Number of channels
+    *
+    * @return true if guess_field was loaded
+    */
+    bool read_guess_field_cache(const QString& name, int nch);
+
+    //=========================================================================================================
+    /**
+    * Writes the guess locations and the unwhitened guess fields to a cache file.
+    *
+    * @param[in] name   The cache file
+    *
+    * @return true when successful
+    */
+    bool write_guess_field_cache(const QString& name) const;
+
+    //=========================================================================================================
+    /**
+    * Composes the key of the guess field cache from everything the unwhitened guess fields depend on: the head
+    * model, the sensors, the coordinate transformations and the guess grid.
+    *
+    * @param[in] f                  The fitting data
+    * @param[in] rr                 The guess locations
+    * @param[in] nguess             Number of guess locations
+    * @param[in] guessname          The guess source space file
+    * @param[in] guess_surfname     The surface which bounds the guess grid
+    * @param[in] mindist            Minimum distance of the guesses from the surface
+    * @param[in] exclude            Radius of the excluded sphere around the origin
+    * @param[in] grid               Spacing of the guess grid
+    *
+    * @return The key as a hex string
+    */
+    static QString guess_field_key(DipoleFitData* f, float **rr, int nguess, const QString& guessname, const QString& guess_surfname, float mindist, float exclude, float grid);
+
 public:
     float          **rr;            /**< These are the guess dipole locations */
     DipoleForward** guess_fwd;      /**< Forward solutions for the guesses */
     int            nguess;          /**< How many sources */
+    Eigen::MatrixXf guess_uu;       /**< Left singular vectors of guess_fwd, rows 3*k ... 3*k+2 belong to guess k (3*nguess x nch) */
+    Eigen::VectorXf guess_sing;     /**< Ratio of the smallest and largest singular value of each guess field */
+    Eigen::Matrix<float,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowMajor> guess_field;   /**< Unprojected and unwhitened guess fields, rows 3*k ... 3*k+2 belong to guess k (3*nguess x nch) */
 
 // ### OLD STRUCT ###
 //    typedef struct {
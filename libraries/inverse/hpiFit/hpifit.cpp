@@ -90,6 +90,9 @@ using namespace FIFFLIB;
 //=============================================================================================================
 
 HPIFit::HPIFit()
+: m_iNumSamples(0)
+, m_bSessionValid(false)
+, m_iNumCoils(0)
 {
 
 }
@@ -106,6 +109,32 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
                         FiffInfo::SPtr pFiffInfo,
                         bool bDoDebug,
                         const QString& sHPIResourceDir)
+{
+    HPIFit hpiFit;
+
+    hpiFit.fit(t_mat,
+               t_matProjectors,
+               transDevHead,
+               vFreqs,
+               vGof,
+               fittedPointSet,
+               pFiffInfo,
+               bDoDebug,
+               sHPIResourceDir);
+}
+
+
+//*************************************************************************************************************
+
+void HPIFit::fit(const MatrixXd& t_mat,
+                 const Eigen::MatrixXd& t_matProjectors,
+                 FiffCoordTrans& transDevHead,
+                 const QVector<int>& vFreqs,
+                 QVector<double>& vGof,
+                 FiffDigPointSet& fittedPointSet,
+                 FiffInfo::SPtr pFiffInfo,
+                 bool bDoDebug,
+                 const QString& sHPIResourceDir)
 {
     //Check if data was passed
     if(t_mat.rows() == 0 || t_mat.cols() == 0 ) {
@@ -119,198 +148,82 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
 
     vGof.clear();
 
-    struct SensorInfo sensors;
-    struct CoilParam coil;
-    int numCh = pFiffInfo->nchan;
-    int samF = pFiffInfo->sfreq;
-    int samLoc = t_mat.cols(); // minimum samples required to localize numLoc times in a second
-
-    //Get HPI coils from digitizers and set number of coils
-    int numCoils = 0;
-    QList<FiffDigPoint> lHPIPoints;
-
-    for(int i = 0; i < pFiffInfo->dig.size(); ++i) {
-        if(pFiffInfo->dig[i].kind == FIFFV_POINT_HPI) {
-            numCoils++;
-            lHPIPoints.append(pFiffInfo->dig[i]);
-        }
-    }
-
-    //Set coil frequencies
-    Eigen::VectorXd coilfreq(numCoils);
-
-    if(vFreqs.size() >= numCoils) {
-        for(int i = 0; i < numCoils; ++i) {
-            coilfreq[i] = vFreqs.at(i);
-            //std::cout<<std::endl << coilfreq[i] << "Hz";
-        }
-    } else {
-        std::cout<<std::endl<< "HPIFit::fitHPI - Not enough coil frequencies specified. Returning.";
+    if(!updateSession(t_mat.cols(), t_matProjectors, vFreqs, pFiffInfo)) {
         return;
     }
 
-    // Initialize HPI coils location and moment
-    coil.pos = Eigen::MatrixXd::Zero(numCoils,3);
-    coil.mom = Eigen::MatrixXd::Zero(numCoils,3);
-    coil.dpfiterror = Eigen::VectorXd::Zero(numCoils);
-    coil.dpfitnumitr = Eigen::VectorXd::Zero(numCoils);
-
-    // Generate simulated data
-    Eigen::MatrixXd simsig(samLoc,numCoils*2);
-    Eigen::VectorXd time(samLoc);
-
-    for (int i = 0; i < samLoc; ++i) {
-        time[i] = i*1.0/samF;
-    }
-
-    for(int i = 0; i < numCoils; ++i) {
-        for(int j = 0; j < samLoc; ++j) {
-            simsig(j,i) = sin(2*M_PI*coilfreq[i]*time[j]);
-            simsig(j,i+numCoils) = cos(2*M_PI*coilfreq[i]*time[j]);
-        }
-    }
-
-    // Create digitized HPI coil position matrix
-    Eigen::MatrixXd headHPI(numCoils,3);
-
-    // check the pFiffInfo->dig information. If dig is empty, set the headHPI is 0;
-    if (lHPIPoints.size() > 0) {
-        for (int i = 0; i < lHPIPoints.size(); ++i) {
-            headHPI(i,0) = lHPIPoints.at(i).r[0];
-            headHPI(i,1) = lHPIPoints.at(i).r[1];
-            headHPI(i,2) = lHPIPoints.at(i).r[2];
-        }
-    } else {
-        for (int i = 0; i < numCoils; ++i) {
-            headHPI(i,0) = 0;
-            headHPI(i,1) = 0;
-            headHPI(i,2) = 0;
-        }
-    }
-
-    // Get the indices of inner layer channels and exclude bad channels.
-    //TODO: Only supports babymeg and vectorview gradiometeres for hpi fitting.
-    QVector<int> innerind(0);
-
-    for (int i = 0; i < numCh; ++i) {
-        if(pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_BABY_MAG ||
-                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T1 ||
-                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T2 ||
-                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T3) {
-            // Check if the sensor is bad, if not append to innerind
-            if(!(pFiffInfo->bads.contains(pFiffInfo->ch_names.at(i)))) {
-                innerind.append(i);
-            }
-        }
-    }
-
-    //Create new projector based on the excluded channels, first exclude the rows then the columns
-    MatrixXd matProjectorsRows(innerind.size(),t_matProjectors.cols());
-    MatrixXd matProjectorsInnerind(innerind.size(),innerind.size());
-
-    for (int i = 0; i < matProjectorsRows.rows(); ++i) {
-        matProjectorsRows.row(i) = t_matProjectors.row(innerind.at(i));
-    }
-
-    for (int i = 0; i < matProjectorsInnerind.cols(); ++i) {
-        matProjectorsInnerind.col(i) = matProjectorsRows.col(innerind.at(i));
-    }
-
-    //UTILSLIB::IOUtils::write_eigen_matrix(matProjectorsInnerind, "matProjectorsInnerind.txt");
-    //UTILSLIB::IOUtils::write_eigen_matrix(t_matProjectors, "t_matProjectors.txt");
-
-    // Initialize inner layer sensors
-    sensors.coilpos = Eigen::MatrixXd::Zero(innerind.size(),3);
-    sensors.coilori = Eigen::MatrixXd::Zero(innerind.size(),3);
-    sensors.tra = Eigen::MatrixXd::Identity(innerind.size(),innerind.size());
-
-    for(int i = 0; i < innerind.size(); i++) {
-        sensors.coilpos(i,0) = pFiffInfo->chs[innerind.at(i)].chpos.r0[0];
-        sensors.coilpos(i,1) = pFiffInfo->chs[innerind.at(i)].chpos.r0[1];
-        sensors.coilpos(i,2) = pFiffInfo->chs[innerind.at(i)].chpos.r0[2];
-        sensors.coilori(i,0) = pFiffInfo->chs[innerind.at(i)].chpos.ez[0];
-        sensors.coilori(i,1) = pFiffInfo->chs[innerind.at(i)].chpos.ez[1];
-        sensors.coilori(i,2) = pFiffInfo->chs[innerind.at(i)].chpos.ez[2];
-    }
+    struct CoilParam coil;
 
-    Eigen::MatrixXd topo(innerind.size(), numCoils*2);
-    Eigen::MatrixXd amp(innerind.size(), numCoils);
-    Eigen::MatrixXd ampC(innerind.size(), numCoils);
+    // Initialize HPI coils location and moment
+    coil.pos = Eigen::MatrixXd::Zero(m_iNumCoils,3);
+    coil.mom = Eigen::MatrixXd::Zero(m_iNumCoils,3);
+    coil.dpfiterror = Eigen::VectorXd::Zero(m_iNumCoils);
+    coil.dpfitnumitr = Eigen::VectorXd::Zero(m_iNumCoils);
 
     // Get the data from inner layer channels
-    Eigen::MatrixXd innerdata(innerind.size(), t_mat.cols());
+    Eigen::MatrixXd innerdata(m_vInnerInd.size(), t_mat.cols());
 
-    for(int j = 0; j < innerind.size(); ++j) {
-        innerdata.row(j) << t_mat.row(innerind[j]);
+    for(int j = 0; j < m_vInnerInd.size(); ++j) {
+        innerdata.row(j) << t_mat.row(m_vInnerInd[j]);
     }
 
     // Calculate topo
-    topo = innerdata * UTILSLIB::MNEMath::pinv(simsig).transpose(); // topo: # of good inner channel x 8
+    Eigen::MatrixXd topo = innerdata * m_matSimsigPinvT; // topo: # of good inner channel x 8
 
     // Select sine or cosine component depending on the relative size
-    amp  = topo.leftCols(numCoils); // amp: # of good inner channel x 4
-    ampC = topo.rightCols(numCoils);
+    Eigen::MatrixXd amp  = topo.leftCols(m_iNumCoils); // amp: # of good inner channel x 4
+    Eigen::MatrixXd ampC = topo.rightCols(m_iNumCoils);
 
-    for(int j = 0; j < numCoils; ++j) {
+    for(int j = 0; j < m_iNumCoils; ++j) {
        float nS = 0.0;
        float nC = 0.0;
-       for(int i = 0; i < innerind.size(); ++i) {
+       for(int i = 0; i < m_vInnerInd.size(); ++i) {
            nS += amp(i,j)*amp(i,j);
            nC += ampC(i,j)*ampC(i,j);
        }
 
        if(nC > nS) {
-         for(int i = 0; i < innerind.size(); ++i) {
+         for(int i = 0; i < m_vInnerInd.size(); ++i) {
            amp(i,j) = ampC(i,j);
          }
        }
     }
 
-    //Find good seed point/starting point for the coil position in 3D space
-    //Find biggest amplitude per pickup coil (sensor) and store corresponding sensor channel index
-    VectorXi chIdcs(numCoils);
+    //Start from the previous solution if there is one, otherwise find good seed points
+    VectorXi chIdcs = VectorXi::Zero(m_iNumCoils);
+    Eigen::MatrixXd coilPos;
+    bool bWarmStart = m_iNumCoils > 0 && m_matLastCoilPos.rows() == m_iNumCoils;
 
-    for (int j = 0; j < numCoils; j++) {
-        double maxVal = 0;
-        int chIdx = 0;
-
-        for (int i = 0; i < amp.rows(); ++i) {
-            if(std::fabs(amp(i,j)) > maxVal) {
-                maxVal = std::fabs(amp(i,j));
-
-                if(chIdx < innerind.size()) {
-                    chIdx = innerind.at(i);
-                }
-            }
-        }
-
-        chIdcs(j) = chIdx;
+    if(bWarmStart) {
+        coilPos = m_matLastCoilPos;
+    } else {
+        coilPos = computeSeedPoints(amp, chIdcs);
     }
 
-    //Generate seed point by projection the found channel position 3cm inwards
-    Eigen::MatrixXd coilPos = Eigen::MatrixXd::Zero(numCoils,3);
+    coil.pos = coilPos;
 
-    for (int j = 0; j < chIdcs.rows(); ++j) {
-        int chIdx = chIdcs(j);
+    coil = dipfit(coil, m_sensors, amp, m_iNumCoils, m_matProjectorsInnerind);
 
-        if(chIdx < pFiffInfo->chs.size()) {
-            double x = pFiffInfo->chs.at(chIdcs(j)).chpos.r0[0];
-            double y = pFiffInfo->chs.at(chIdcs(j)).chpos.r0[1];
-            double z = pFiffInfo->chs.at(chIdcs(j)).chpos.r0[2];
+    //If a warm-started coil lost track (e.g. after a fast head movement), refit it from the cold seed point
+    const double dMaxWarmStartError = 0.1;
 
-            coilPos(j,0) = -1 * pFiffInfo->chs.at(chIdcs(j)).chpos.ez[0] * 0.03 + x;
-            coilPos(j,1) = -1 * pFiffInfo->chs.at(chIdcs(j)).chpos.ez[1] * 0.03 + y;
-            coilPos(j,2) = -1 * pFiffInfo->chs.at(chIdcs(j)).chpos.ez[2] * 0.03 + z;
-        }
+    if(bWarmStart && coil.dpfiterror.maxCoeff() > dMaxWarmStartError) {
+        struct CoilParam coilCold = coil;
+        coilCold.pos = computeSeedPoints(amp, chIdcs);
+        coilCold = dipfit(coilCold, m_sensors, amp, m_iNumCoils, m_matProjectorsInnerind);
 
-        //std::cout << "HPIFit::fitHPI - Coil " << j << " max value index " << chIdx << std::endl;
+        for(int i = 0; i < m_iNumCoils; ++i) {
+            if(coilCold.dpfiterror(i) < coil.dpfiterror(i)) {
+                coil.pos.row(i) = coilCold.pos.row(i);
+                coil.dpfiterror(i) = coilCold.dpfiterror(i);
+                coil.dpfitnumitr(i) = coilCold.dpfitnumitr(i);
+            }
+        }
     }
 
-    coil.pos = coilPos;
-
-    coil = dipfit(coil, sensors, amp, numCoils, matProjectorsInnerind);
+    m_matLastCoilPos = coil.pos;
 
-    Eigen::Matrix4d trans = computeTransformation(headHPI, coil.pos);
+    Eigen::Matrix4d trans = computeTransformation(m_matHeadHPI, coil.pos);
     //Eigen::Matrix4d trans = computeTransformation(coil.pos, headHPI);
 
     // Store the final result to fiff info
@@ -331,11 +244,11 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
     MatrixXd temp = coil.pos;
     temp.conservativeResize(coil.pos.rows(),coil.pos.cols()+1);
 
-    temp.block(0,3,numCoils,1).setOnes();
+    temp.block(0,3,m_iNumCoils,1).setOnes();
     temp.transposeInPlace();
 
     MatrixXd testPos = trans * temp;
-    MatrixXd diffPos = testPos.block(0,0,3,numCoils) - headHPI.transpose();
+    MatrixXd diffPos = testPos.block(0,0,3,m_iNumCoils) - m_matHeadHPI.transpose();
 
     for(int i = 0; i < diffPos.cols(); ++i) {
         vGof.append(diffPos.col(i).norm());
@@ -372,7 +285,7 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
 
         UTILSLIB::IOUtils::write_eigen_matrix(coil.pos, QString("%1/%2_coilPos_mat").arg(sHPIResourceDir).arg(sTimeStamp));
 
-        UTILSLIB::IOUtils::write_eigen_matrix(headHPI, QString("%1/%2_headHPI_mat").arg(sHPIResourceDir).arg(sTimeStamp));
+        UTILSLIB::IOUtils::write_eigen_matrix(m_matHeadHPI, QString("%1/%2_headHPI_mat").arg(sHPIResourceDir).arg(sTimeStamp));
 
         MatrixXd testPosCut = testPos.transpose();//block(0,0,3,4);
         UTILSLIB::IOUtils::write_eigen_matrix(testPosCut, QString("%1/%2_testPos_mat").arg(sHPIResourceDir).arg(sTimeStamp));
@@ -381,8 +294,8 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
         idx_mat.col(0) = chIdcs;
         UTILSLIB::IOUtils::write_eigen_matrix(idx_mat, QString("%1/%2_idx_mat").arg(sHPIResourceDir).arg(sTimeStamp));
 
-        MatrixXd coilFreq_mat(coilfreq.rows(),1);
-        coilFreq_mat.col(0) = coilfreq;
+        MatrixXd coilFreq_mat(m_vecCoilFreqs.rows(),1);
+        coilFreq_mat.col(0) = m_vecCoilFreqs;
         UTILSLIB::IOUtils::write_eigen_matrix(coilFreq_mat, QString("%1/%2_coilFreq_mat").arg(sHPIResourceDir).arg(sTimeStamp));
 
         UTILSLIB::IOUtils::write_eigen_matrix(diffPos, QString("%1/%2_diffPos_mat").arg(sHPIResourceDir).arg(sTimeStamp));
@@ -392,6 +305,250 @@ void HPIFit::fitHPI(const MatrixXd& t_mat,
 }
 
 
+
+
+//*************************************************************************************************************
+
+void HPIFit::reset()
+{
+    m_pFiffInfo.clear();
+    m_bSessionValid = false;
+    m_matLastCoilPos.resize(0,0);
+    m_matHeadHPI.resize(0,0);
+    m_matChPos.resize(0,0);
+}
+
+
+//*************************************************************************************************************
+
+bool HPIFit::updateSession(int iNumSamples,
+                           const MatrixXd& t_matProjectors,
+                           const QVector<int>& vFreqs,
+                           FiffInfo::SPtr pFiffInfo)
+{
+    if(!pFiffInfo) {
+        std::cout<<std::endl<< "HPIFit::fitHPI - No measurement info passed. Returning.";
+        return false;
+    }
+
+    bool bSameProjectors = t_matProjectors.rows() == m_matProjectors.rows() &&
+                           t_matProjectors.cols() == m_matProjectors.cols() &&
+                           t_matProjectors == m_matProjectors;
+
+    //The digitizer points and the channel positions can be replaced within the same measurement info, e.g. when
+    //new digitizer data are loaded, hence they are compared by value
+    MatrixXd matHeadHPI = getHPIDigPoints(*pFiffInfo);
+    MatrixXd matChPos = getChannelPositions(*pFiffInfo);
+
+    bool bSameHeadHPI = matHeadHPI.rows() == m_matHeadHPI.rows() &&
+                        matHeadHPI.cols() == m_matHeadHPI.cols() &&
+                        matHeadHPI == m_matHeadHPI;
+
+    bool bSameChPos = matChPos.rows() == m_matChPos.rows() &&
+                      matChPos.cols() == m_matChPos.cols() &&
+                      matChPos == m_matChPos;
+
+    if(m_bSessionValid &&
+            pFiffInfo == m_pFiffInfo &&
+            iNumSamples == m_iNumSamples &&
+            vFreqs == m_vFreqs &&
+            pFiffInfo->bads == m_lBads &&
+            bSameProjectors &&
+            bSameHeadHPI &&
+            bSameChPos) {
+        return true;
+    }
+
+    //A different coil setup or sensor geometry invalidates the previous coil positions, bads and projectors do not
+    if(pFiffInfo != m_pFiffInfo || vFreqs != m_vFreqs || !bSameHeadHPI || !bSameChPos) {
+        m_matLastCoilPos.resize(0,0);
+    }
+
+    m_bSessionValid = false;
+    m_pFiffInfo = pFiffInfo;
+    m_lBads = pFiffInfo->bads;
+    m_matProjectors = t_matProjectors;
+    m_vFreqs = vFreqs;
+    m_iNumSamples = iNumSamples;
+    m_matChPos = matChPos;
+
+    int numCh = pFiffInfo->nchan;
+    int samF = pFiffInfo->sfreq;
+    int samLoc = iNumSamples; // minimum samples required to localize numLoc times in a second
+
+    //Set number of coils from the digitized HPI coil positions
+    m_matHeadHPI = matHeadHPI;
+    m_iNumCoils = m_matHeadHPI.rows();
+
+    //Set coil frequencies
+    m_vecCoilFreqs.resize(m_iNumCoils);
+
+    if(vFreqs.size() >= m_iNumCoils) {
+        for(int i = 0; i < m_iNumCoils; ++i) {
+            m_vecCoilFreqs[i] = vFreqs.at(i);
+            //std::cout<<std::endl << m_vecCoilFreqs[i] << "Hz";
+        }
+    } else {
+        std::cout<<std::endl<< "HPIFit::fitHPI - Not enough coil frequencies specified. Returning.";
+        return false;
+    }
+
+    // Generate simulated data
+    Eigen::MatrixXd simsig(samLoc,m_iNumCoils*2);
+    Eigen::VectorXd time(samLoc);
+
+    for (int i = 0; i < samLoc; ++i) {
+        time[i] = i*1.0/samF;
+    }
+
+    for(int i = 0; i < m_iNumCoils; ++i) {
+        for(int j = 0; j < samLoc; ++j) {
+            simsig(j,i) = sin(2*M_PI*m_vecCoilFreqs[i]*time[j]);
+            simsig(j,i+m_iNumCoils) = cos(2*M_PI*m_vecCoilFreqs[i]*time[j]);
+        }
+    }
+
+    m_matSimsigPinvT = UTILSLIB::MNEMath::pinv(simsig).transpose();
+
+    // Get the indices of inner layer channels and exclude bad channels.
+    //TODO: Only supports babymeg and vectorview gradiometeres for hpi fitting.
+    m_vInnerInd.clear();
+
+    for (int i = 0; i < numCh; ++i) {
+        if(pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_BABY_MAG ||
+                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T1 ||
+                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T2 ||
+                pFiffInfo->chs[i].chpos.coil_type == FIFFV_COIL_VV_PLANAR_T3) {
+            // Check if the sensor is bad, if not append to innerind
+            if(!(pFiffInfo->bads.contains(pFiffInfo->ch_names.at(i)))) {
+                m_vInnerInd.append(i);
+            }
+        }
+    }
+
+    //Create new projector based on the excluded channels, first exclude the rows then the columns
+    MatrixXd matProjectorsRows(m_vInnerInd.size(),t_matProjectors.cols());
+    m_matProjectorsInnerind.resize(m_vInnerInd.size(),m_vInnerInd.size());
+
+    for (int i = 0; i < matProjectorsRows.rows(); ++i) {
+        matProjectorsRows.row(i) = t_matProjectors.row(m_vInnerInd.at(i));
+    }
+
+    for (int i = 0; i < m_matProjectorsInnerind.cols(); ++i) {
+        m_matProjectorsInnerind.col(i) = matProjectorsRows.col(m_vInnerInd.at(i));
+    }
+
+    // Initialize inner layer sensors
+    m_sensors.coilpos = Eigen::MatrixXd::Zero(m_vInnerInd.size(),3);
+    m_sensors.coilori = Eigen::MatrixXd::Zero(m_vInnerInd.size(),3);
+    m_sensors.tra = Eigen::MatrixXd::Identity(m_vInnerInd.size(),m_vInnerInd.size());
+
+    for(int i = 0; i < m_vInnerInd.size(); i++) {
+        m_sensors.coilpos(i,0) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.r0[0];
+        m_sensors.coilpos(i,1) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.r0[1];
+        m_sensors.coilpos(i,2) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.r0[2];
+        m_sensors.coilori(i,0) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.ez[0];
+        m_sensors.coilori(i,1) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.ez[1];
+        m_sensors.coilori(i,2) = pFiffInfo->chs[m_vInnerInd.at(i)].chpos.ez[2];
+    }
+
+    m_bSessionValid = true;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd HPIFit::getHPIDigPoints(const FiffInfo& info)
+{
+    int numCoils = 0;
+
+    for(int i = 0; i < info.dig.size(); ++i) {
+        if(info.dig[i].kind == FIFFV_POINT_HPI) {
+            ++numCoils;
+        }
+    }
+
+    MatrixXd matHeadHPI(numCoils,3);
+
+    for(int i = 0, j = 0; i < info.dig.size(); ++i) {
+        if(info.dig[i].kind == FIFFV_POINT_HPI) {
+            matHeadHPI(j,0) = info.dig[i].r[0];
+            matHeadHPI(j,1) = info.dig[i].r[1];
+            matHeadHPI(j,2) = info.dig[i].r[2];
+            ++j;
+        }
+    }
+
+    return matHeadHPI;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd HPIFit::getChannelPositions(const FiffInfo& info)
+{
+    MatrixXd matChPos(info.chs.size(),6);
+
+    for(int i = 0; i < info.chs.size(); ++i) {
+        for(int k = 0; k < 3; ++k) {
+            matChPos(i,k) = info.chs[i].chpos.r0[k];
+            matChPos(i,k+3) = info.chs[i].chpos.ez[k];
+        }
+    }
+
+    return matChPos;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd HPIFit::computeSeedPoints(const MatrixXd& amp, VectorXi& chIdcs) const
+{
+    //Find biggest amplitude per pickup coil (sensor) and store corresponding sensor channel index
+    chIdcs.resize(m_iNumCoils);
+
+    for (int j = 0; j < m_iNumCoils; j++) {
+        double maxVal = 0;
+        int chIdx = 0;
+
+        for (int i = 0; i < amp.rows(); ++i) {
+            if(std::fabs(amp(i,j)) > maxVal) {
+                maxVal = std::fabs(amp(i,j));
+
+                if(chIdx < m_vInnerInd.size()) {
+                    chIdx = m_vInnerInd.at(i);
+                }
+            }
+        }
+
+        chIdcs(j) = chIdx;
+    }
+
+    //Generate seed point by projection the found channel position 3cm inwards
+    Eigen::MatrixXd coilPos = Eigen::MatrixXd::Zero(m_iNumCoils,3);
+
+    for (int j = 0; j < chIdcs.rows(); ++j) {
+        int chIdx = chIdcs(j);
+
+        if(chIdx < m_pFiffInfo->chs.size()) {
+            double x = m_pFiffInfo->chs.at(chIdcs(j)).chpos.r0[0];
+            double y = m_pFiffInfo->chs.at(chIdcs(j)).chpos.r0[1];
+            double z = m_pFiffInfo->chs.at(chIdcs(j)).chpos.r0[2];
+
+            coilPos(j,0) = -1 * m_pFiffInfo->chs.at(chIdcs(j)).chpos.ez[0] * 0.03 + x;
+            coilPos(j,1) = -1 * m_pFiffInfo->chs.at(chIdcs(j)).chpos.ez[1] * 0.03 + y;
+            coilPos(j,2) = -1 * m_pFiffInfo->chs.at(chIdcs(j)).chpos.ez[2] * 0.03 + z;
+        }
+
+        //std::cout << "HPIFit::fitHPI - Coil " << j << " max value index " << chIdx << std::endl;
+    }
+
+    return coilPos;
+}
+
+
 //*************************************************************************************************************
 
 CoilParam HPIFit::dipfit(struct CoilParam coil, struct SensorInfo sensors, const Eigen::MatrixXd& data, int numCoils, const Eigen::MatrixXd& t_matProjectors)
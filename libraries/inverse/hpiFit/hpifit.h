@@ -42,6 +42,7 @@
 //=============================================================================================================
 
 #include "../inverse_global.h"
+#include "hpifitdata.h"
 
 
 //*************************************************************************************************************
@@ -58,6 +59,8 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
 
 
 //*************************************************************************************************************
@@ -104,7 +107,11 @@ struct CoilParam {
 
 //=============================================================================================================
 /**
-* HPI Fit algorithms.
+* HPI Fit algorithms. An HPIFit object can be kept alive between fits of consecutive data blocks (continuous HPI):
+* the good channel selection, the sensor geometry, the projector sub-matrix and the pseudo inverse of the
+* sine/cosine reference signals are cached and only rebuilt when the bad channels, the projectors, the coil
+* frequencies, the block length, the digitized HPI coils or the channel positions change. Each coil's dipole fit is
+* warm-started from the previous solution.
 *
 * @brief HPI Fit algorithms.
 */
@@ -123,7 +130,37 @@ public:
 
     //=========================================================================================================
     /**
-    * Perform one single HPI fit.
+    * Perform one HPI fit. Cached quantities are reused and the coil fits start from the previous coil positions.
+    *
+    * @param[in] t_mat           Data to estimate the HPI positions from
+    * @param[in] t_matProjectors The projectors to apply. Bad channels are still included.
+    * @param[out] transDevHead   The final dev head transformation matrix
+    * @param[in] vFreqs          The frequencies for each coil.
+    * @param[out] vGof           The goodness of fit in mm for each fitted HPI coil.
+    * @param[out] fittedPointSet The final fitted positions in form of a digitizer set.
+    * @param[in] p_pFiffInfo     Associated Fiff Information.
+    * @param[in] bDoDebug        Print debug info to cmd line and write debug info to file.
+    * @param[in] sHPIResourceDir The path to the debug file which is to be written.
+    */
+    void fit(const Eigen::MatrixXd& t_mat,
+             const Eigen::MatrixXd& t_matProjectors,
+             FIFFLIB::FiffCoordTrans &transDevHead,
+             const QVector<int>& vFreqs,
+             QVector<double> &vGof,
+             FIFFLIB::FiffDigPointSet& fittedPointSet,
+             QSharedPointer<FIFFLIB::FiffInfo> pFiffInfo,
+             bool bDoDebug = false,
+             const QString& sHPIResourceDir = QString("./HPIFittingDebug"));
+
+    //=========================================================================================================
+    /**
+    * Drops all cached quantities and the previous coil positions. The next fit starts from scratch.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Perform one single HPI fit without reusing any previous state.
     *
     * @param[in] t_mat           Data to estimate the HPI positions from
     * @param[in] t_matProjectors The projectors to apply. Bad channels are still included.
@@ -146,6 +183,54 @@ public:
                         const QString& sHPIResourceDir = QString("./HPIFittingDebug"));
 
 protected:
+    //=========================================================================================================
+    /**
+    * Rebuilds the cached channel selection, sensor geometry, projector sub-matrix and reference signal pseudo
+    * inverse if any of their inputs changed since the last fit.
+    *
+    * @param[in] iNumSamples     The number of samples of the data block.
+    * @param[in] t_matProjectors The projectors to apply. Bad channels are still included.
+    * @param[in] vFreqs          The frequencies for each coil.
+    * @param[in] pFiffInfo       Associated Fiff Information.
+    *
+    * @return Returns false if the session could not be set up.
+    */
+    bool updateSession(int iNumSamples,
+                       const Eigen::MatrixXd& t_matProjectors,
+                       const QVector<int>& vFreqs,
+                       QSharedPointer<FIFFLIB::FiffInfo> pFiffInfo);
+
+    //=========================================================================================================
+    /**
+    * Collects the digitized HPI coil positions.
+    *
+    * @param[in] info            The measurement info.
+    *
+    * @return Returns the HPI coil positions in head space, one row per coil.
+    */
+    static Eigen::MatrixXd getHPIDigPoints(const FIFFLIB::FiffInfo& info);
+
+    //=========================================================================================================
+    /**
+    * Collects the channel positions and orientations.
+    *
+    * @param[in] info            The measurement info.
+    *
+    * @return Returns the position (first three columns) and orientation (last three columns) of each channel.
+    */
+    static Eigen::MatrixXd getChannelPositions(const FIFFLIB::FiffInfo& info);
+
+    //=========================================================================================================
+    /**
+    * Generates the seed points for a cold start by projecting the channel with the biggest amplitude 3cm inwards.
+    *
+    * @param[in] amp             The coil amplitudes on the good inner layer channels.
+    * @param[out] chIdcs         The channel index used for each coil.
+    *
+    * @return Returns the seed points.
+    */
+    Eigen::MatrixXd computeSeedPoints(const Eigen::MatrixXd& amp, Eigen::VectorXi& chIdcs) const;
+
     //=========================================================================================================
     /**
     * Fits dipoles for the given coils and a given data set.
@@ -172,6 +257,24 @@ protected:
     static Eigen::Matrix4d computeTransformation(Eigen::MatrixXd NH, Eigen::MatrixXd BT);
 
     static QString         m_sHPIResourceDir;      /**< Hold the resource folder to store the debug information in. */
+
+    QSharedPointer<FIFFLIB::FiffInfo>   m_pFiffInfo;                /**< The measurement info the session was set up for. */
+    QStringList                         m_lBads;                    /**< The bad channels the session was set up for. */
+    Eigen::MatrixXd                     m_matProjectors;            /**< The projectors the session was set up for. */
+    QVector<int>                        m_vFreqs;                   /**< The coil frequencies the session was set up for. */
+    int                                 m_iNumSamples;              /**< The block length the session was set up for. */
+    Eigen::MatrixXd                     m_matChPos;                 /**< The channel positions and orientations the session was set up for. */
+    bool                                m_bSessionValid;            /**< Whether the cached quantities below are valid. */
+
+    int                                 m_iNumCoils;                /**< The number of HPI coils. */
+    Eigen::VectorXd                     m_vecCoilFreqs;             /**< The coil frequencies in Hz. */
+    Eigen::MatrixXd                     m_matHeadHPI;               /**< The digitized HPI coil positions in head space. */
+    QVector<int>                        m_vInnerInd;                /**< The good inner layer channels. */
+    SensorInfo                          m_sensors;                  /**< The geometry of the good inner layer channels. */
+    Eigen::MatrixXd                     m_matProjectorsInnerind;    /**< The projectors restricted to the good inner layer channels. */
+    Eigen::MatrixXd                     m_matSimsigPinvT;           /**< Transposed pseudo inverse of the sine/cosine reference signals. */
+
+    Eigen::MatrixXd                     m_matLastCoilPos;           /**< The coil positions of the previous fit, used as warm start. */
 };
 
 //*************************************************************************************************************
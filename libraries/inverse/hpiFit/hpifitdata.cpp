@@ -106,7 +106,8 @@ void HPIFitData::doDipfitConcurrent()
                                        currentSensors,
                                        simplex_numitr);
 
-    this->errorInfo = dipfitError(currentCoil, currentData, currentSensors, this->matProjector);
+    //Evaluate the error at the fitted position, it is used to detect warm starts which lost track
+    this->errorInfo = dipfitError(this->coilPos, currentData, currentSensors, this->matProjector);
     this->errorInfo.numIterations = simplex_numitr;
 }
 
@@ -49,6 +49,7 @@
 // STL INCLUDES
 //=============================================================================================================
 
+#include <cmath>
 #include <iostream>
 
 
@@ -78,6 +79,8 @@ using namespace INVERSELIB;
 MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lambda, const QString method)
 : m_inverseOperator(p_inverseOperator)
 , inverseSetup(false)
+, m_bUseSinglePrecision(false)
+, m_bPoolOrientations(false)
 {
     this->setRegularization(lambda);
     this->setMethod(method);
@@ -88,6 +91,8 @@ MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lamb
 MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lambda, bool dSPM, bool sLORETA)
 : m_inverseOperator(p_inverseOperator)
 , inverseSetup(false)
+, m_bUseSinglePrecision(false)
+, m_bPoolOrientations(false)
 {
     this->setRegularization(lambda);
     this->setMethod(dSPM, sLORETA);
@@ -194,51 +199,106 @@ MNESourceEstimate MinimumNorm::calculateInverse(const FiffEvoked &p_fiffEvoked,
 //*************************************************************************************************************
 
 MNESourceEstimate MinimumNorm::calculateInverse(const MatrixXd &data, float tmin, float tstep) const
+{
+    MNESourceEstimate sourceEstimate;
+
+    calculateInverse(data, tmin, tstep, sourceEstimate);
+
+    return sourceEstimate;
+}
+
+
+//*************************************************************************************************************
+
+bool MinimumNorm::calculateInverse(const MatrixXd &data, float tmin, float tstep, MNESourceEstimate& p_sourceEstimate) const
 {
     if(!inverseSetup)
     {
         qWarning("Inverse not setup -> call doInverseSetup first!");
-        return MNESourceEstimate();
+        return false;
     }
 
-    MatrixXd sol = K * data; //apply imaging kernel
-
-    if (inv.source_ori == FIFFV_MNE_FREE_ORI)
+    if(data.rows() != K.cols())
     {
-        printf("combining the current components...");
-        MatrixXd sol1(sol.rows()/3,sol.cols());
-        for(qint32 i = 0; i < sol.cols(); ++i)
-        {
-            VectorXd* tmp = MNEMath::combine_xyz(sol.block(0,i,sol.rows(),1));
-            sol1.block(0,i,sol.rows()/3,1) = tmp->cwiseSqrt();
-            delete tmp;
-        }
-        sol.resize(sol1.rows(),sol1.cols());
-        sol = sol1;
+        qWarning("Number of data channels does not match the inverse kernel!");
+        return false;
     }
 
-    if (m_bdSPM)
+    qint32 nSources = m_bPoolOrientations ? K.rows()/3 : K.rows();
+
+    //Only (re)allocate the source estimate if its layout changed
+    if(p_sourceEstimate.data.rows() != nSources || p_sourceEstimate.data.cols() != data.cols() ||
+            p_sourceEstimate.vertices.size() != m_vecVertices.size())
     {
-        printf("(dSPM)...");
-        sol = inv.noisenorm*sol;
+        p_sourceEstimate = MNESourceEstimate(MatrixXd(nSources, data.cols()), m_vecVertices, tmin, tstep);
     }
-    else if (m_bsLORETA)
+    else if(p_sourceEstimate.tmin != tmin || p_sourceEstimate.tstep != tstep)
     {
-        printf("(sLORETA)...");
-        sol = inv.noisenorm*sol;
+        //Same layout, only the time axis moved -> update it in place
+        p_sourceEstimate.tmin = tmin;
+        p_sourceEstimate.tstep = tstep;
+        if(p_sourceEstimate.times.size() > 0)
+            p_sourceEstimate.times[0] = tmin;
+        for(qint32 i = 1; i < p_sourceEstimate.times.size(); ++i)
+            p_sourceEstimate.times[i] = p_sourceEstimate.times[i-1] + tstep;
     }
-    printf("[done]\n");
 
-    //Results
-    VectorXi p_vecVertices(inv.src[0].vertno.size() + inv.src[1].vertno.size());
-    p_vecVertices << inv.src[0].vertno, inv.src[1].vertno;
+    if(m_bUseSinglePrecision)
+        applyKernel(m_matKFloat, data, p_sourceEstimate.data);
+    else
+        applyKernel(K, data, p_sourceEstimate.data);
 
-//    VectorXi p_vecVertices();
-//    for(qint32 h = 0; h < inv.src.size(); ++h)
-//        t_qListVertices.push_back(inv.src[h].vertno);
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void MinimumNorm::applyKernel(const Matrix<T,Dynamic,Dynamic>& matKernel, const MatrixXd& data, MatrixXd& matSol) const
+{
+    const qint32 iPool = m_bPoolOrientations ? 3 : 1;
+    const qint32 nSources = matKernel.rows() / iPool;
+    const bool bNoiseNorm = m_vecNoiseNorm.size() == nSources;
+
+    //Blocks of 128 sources x 64 time points keep the unpooled product in the cache
+    const qint32 iSourceBlock = 128;
+    const qint32 iTimeBlock = 64;
 
-    return MNESourceEstimate(sol, p_vecVertices, tmin, tstep);
+    Matrix<T,Dynamic,Dynamic> matDataBlock;
+    Matrix<T,Dynamic,Dynamic> matProduct;
 
+    for(qint32 t = 0; t < data.cols(); t += iTimeBlock)
+    {
+        qint32 nTimes = qMin(iTimeBlock, qint32(data.cols()) - t);
+        matDataBlock = data.middleCols(t, nTimes).template cast<T>();
+
+        for(qint32 s = 0; s < nSources; s += iSourceBlock)
+        {
+            qint32 nBlock = qMin(iSourceBlock, nSources - s);
+            matProduct.noalias() = matKernel.middleRows(s*iPool, nBlock*iPool) * matDataBlock;
+
+            for(qint32 j = 0; j < nTimes; ++j)
+            {
+                const T* pProduct = matProduct.col(j).data();
+                double* pSol = matSol.col(t + j).data() + s;
+
+                if(m_bPoolOrientations)
+                {
+                    for(qint32 k = 0; k < nBlock; ++k, pProduct += 3)
+                        pSol[k] = std::sqrt(double(pProduct[0]*pProduct[0] + pProduct[1]*pProduct[1] + pProduct[2]*pProduct[2]));
+                }
+                else
+                {
+                    for(qint32 k = 0; k < nBlock; ++k)
+                        pSol[k] = pProduct[k];
+                }
+
+                if(bNoiseNorm)
+                    Map<VectorXd>(pSol, nBlock).array() *= m_vecNoiseNorm.segment(s, nBlock).array();
+            }
+        }
+    }
 }
 
 
@@ -256,6 +316,34 @@ void MinimumNorm::doInverseSetup(qint32 nave, bool pick_normal)
 
     std::cout << "K " << K.rows() << " x " << K.cols() << std::endl;
 
+    //Everything calculateInverse needs per data block is prepared once here
+    m_bPoolOrientations = inv.source_ori == FIFFV_MNE_FREE_ORI && !pick_normal;
+
+    if(m_bPoolOrientations && K.rows() % 3 != 0)
+    {
+        qWarning("Free orientation kernel rows are not a multiple of three - orientations are not pooled!");
+        m_bPoolOrientations = false;
+    }
+
+    qint32 nSources = m_bPoolOrientations ? K.rows()/3 : K.rows();
+
+    m_vecNoiseNorm = VectorXd();
+    if((m_bdSPM || m_bsLORETA) && inv.noisenorm.rows() > 0)
+    {
+        if(inv.noisenorm.rows() == nSources)
+            m_vecNoiseNorm = inv.noisenorm.diagonal();
+        else
+            qWarning("Noise normalization does not match the number of sources and is not applied!");
+    }
+
+    m_vecVertices = VectorXi(inv.src[0].vertno.size() + inv.src[1].vertno.size());
+    m_vecVertices << inv.src[0].vertno, inv.src[1].vertno;
+
+    if(m_bUseSinglePrecision)
+        m_matKFloat = K.cast<float>();
+    else
+        m_matKFloat = MatrixXf();
+
     inverseSetup = true;
 }
 
@@ -327,3 +415,14 @@ void MinimumNorm::setRegularization(float lambda)
 {
     m_fLambda = lambda;
 }
+
+
+//*************************************************************************************************************
+
+void MinimumNorm::setUseSinglePrecision(bool bUseSinglePrecision)
+{
+    m_bUseSinglePrecision = bUseSinglePrecision;
+
+    if(inverseSetup)
+        m_matKFloat = m_bUseSinglePrecision ? MatrixXf(K.cast<float>()) : MatrixXf();
+}
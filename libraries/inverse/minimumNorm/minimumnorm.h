@@ -127,6 +127,22 @@ public:
 
     virtual MNESourceEstimate calculateInverse(const MatrixXd &data, float tmin, float tstep) const;
 
+    //=========================================================================================================
+    /**
+    * Applies the inverse to a data block and writes the result into an existing source estimate. The kernel
+    * product, the pooling of the free orientations and the dSPM/sLORETA noise normalization are computed in one
+    * pass over cache-sized blocks of sources and time points. The memory of p_sourceEstimate is reused if its
+    * size already matches.
+    *
+    * @param[in] data               The data matrix (channels x time points).
+    * @param[in] tmin               The time of the first sample.
+    * @param[in] tstep              The time step between two samples.
+    * @param[out] p_sourceEstimate  The source estimate to write to.
+    *
+    * @return true if the inverse was set up and applied, false otherwise.
+    */
+    bool calculateInverse(const MatrixXd &data, float tmin, float tstep, MNESourceEstimate& p_sourceEstimate) const;
+
     virtual void doInverseSetup(qint32 nave, bool pick_normal = false);
 
 
@@ -167,9 +183,30 @@ public:
     */
     void setRegularization(float lambda);
 
+    //=========================================================================================================
+    /**
+    * Set whether the imaging kernel is applied in single precision. This roughly halves the memory traffic of
+    * the kernel product, the result is still returned in double precision.
+    *
+    * @param[in] bUseSinglePrecision   Apply the kernel in single precision.
+    */
+    void setUseSinglePrecision(bool bUseSinglePrecision);
+
     inline MatrixXd& getKernel();
 
 private:
+    //=========================================================================================================
+    /**
+    * Applies the kernel to the data in blocks of sources and time points, pools the orientations and applies the
+    * noise normalization on the fly.
+    *
+    * @param[in] matKernel      The imaging kernel.
+    * @param[in] data           The data matrix (channels x time points).
+    * @param[out] matSol        The source estimate data (sources x time points).
+    */
+    template<typename T>
+    void applyKernel(const Matrix<T,Dynamic,Dynamic>& matKernel, const MatrixXd& data, MatrixXd& matSol) const;
+
     MNEInverseOperator m_inverseOperator;   /**< The inverse operator */
     float m_fLambda;                        /**< Regularization parameter */
     QString m_sMethod;                      /**< Selected method */
@@ -183,6 +220,12 @@ private:
     Label label;                            /**< The corresponding labels */
     MatrixXd K;                             /**< Imaging kernel */
 
+    bool m_bUseSinglePrecision;             /**< Apply the kernel in single precision */
+    MatrixXf m_matKFloat;                   /**< Single precision copy of the imaging kernel */
+    bool m_bPoolOrientations;               /**< Pool the three orientations of each source by their norm */
+    VectorXd m_vecNoiseNorm;                /**< The noise normalization factors, empty for MNE */
+    VectorXi m_vecVertices;                 /**< The vertices of both hemispheres */
+
 };
 
 //*************************************************************************************************************
@@ -39,6 +39,8 @@
 
 #include "pwlrapmusic.h"
 
+#include <limits>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -59,6 +61,9 @@ using namespace INVERSELIB;
 
 PwlRapMusic::PwlRapMusic()
 : RapMusic()
+, m_iCoarseDecimation(5)
+, m_iNumCoarseCandidates(3)
+, m_iCoarseNumGridPoints(0)
 {
 }
 
@@ -67,8 +72,11 @@ PwlRapMusic::PwlRapMusic()
 
 PwlRapMusic::PwlRapMusic(MNEForwardSolution& p_pFwd, bool p_bSparsed, int p_iN, double p_dThr)
 : RapMusic(p_pFwd, p_bSparsed, p_iN, p_dThr)
+, m_iCoarseDecimation(5)
+, m_iNumCoarseCandidates(3)
+, m_iCoarseNumGridPoints(0)
 {
-    //Init
+    //Init -> the base class constructor only ran RapMusic::init, this one also sets up the coarse grid
     init(p_pFwd, p_bSparsed, p_iN, p_dThr);
 }
 
@@ -81,6 +89,20 @@ PwlRapMusic::~PwlRapMusic()
 }
 
 
+//*************************************************************************************************************
+
+bool PwlRapMusic::init(MNEForwardSolution& p_pFwd, bool p_bSparsed, int p_iN, double p_dThr)
+{
+    bool t_bInit = RapMusic::init(p_pFwd, p_bSparsed, p_iN, p_dThr);
+
+    //The new forward solution can have other grid points
+    calcCoarseGrid(m_iCoarseDecimation, m_vecCoarseIdx, m_vecCoarseCells);
+    m_iCoarseNumGridPoints = m_iNumGridPoints;
+
+    return t_bInit;
+}
+
+
 //*************************************************************************************************************
 
 const char* PwlRapMusic::getName() const
@@ -130,12 +152,6 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
     clock_t start, end;
     start = clock();
 
-//    //Map HPCMatrix to Eigen Matrix
-//    Eigen::Map<MatrixXT>
-//        t_MappedMatMeasurement(	p_pMatMeasurement->data(),
-//        p_pMatMeasurement->rows(),
-//        p_pMatMeasurement->cols() );
-
     //Calculate the signal subspace (t_pMatPhi_s)
     MatrixXT* t_pMatPhi_s = NULL;//(m_iNumChannels, m_iN < t_r ? m_iN : t_r);
     int t_r = calcPhi_s(/*(MatrixXT)*/p_matMeasurement, t_pMatPhi_s);
@@ -150,155 +166,140 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
         std::cout << std::endl << std::endl;
     }
 
-    //Create Orthogonal Projector
-    //OrthProj
-    MatrixXT t_matOrthProj(m_iNumChannels,m_iNumChannels);
-    t_matOrthProj.setIdentity();
-
-    //A_k_1
-    MatrixXT t_matA_k_1(m_iNumChannels, t_iMaxSearch);
-    t_matA_k_1.setZero();
-
-//    if (m_pMatGrid != NULL)
-//    {
-//        if(p_pRapDipoles != NULL)
-//            p_pRapDipoles->initRapDipoles(m_pMatGrid);
-//        else
-//            p_pRapDipoles = new RapDipoles<T>(m_pMatGrid);
-//    }
-//    else
-//    {
-//        if(p_pRapDipoles != NULL)
-//            delete p_pRapDipoles;
-
-//        p_pRapDipoles = new RapDipoles<T>();
-//    }
+    //Coarse grid -> rebuilt when it was not set up for the current grid points
+    QVector<int> t_vecCoarseIdx = m_vecCoarseIdx;
+    QVector< QVector<int> > t_vecCoarseCells = m_vecCoarseCells;
+    if(t_vecCoarseIdx.isEmpty() || m_iCoarseNumGridPoints != m_iNumGridPoints)
+        calcCoarseGrid(m_iCoarseDecimation, t_vecCoarseIdx, t_vecCoarseCells);
+
+    int t_iNumCoarse = t_vecCoarseIdx.size();
+
+    //Orthonormal basis of the found source topographies A_k_1 -> the orthogonal projector is I - Q_A*Q_A^T
+    MatrixXT t_matOrthBasis_A(m_iNumChannels, t_iMaxSearch);
+    t_matOrthBasis_A.setZero();
+    int t_iRank_A = 0;
+
     p_RapDipoles.clear();
 
     std::cout << "##### Calculation of PWL RAP MUSIC started ######\n\n";
 
-    MatrixXT t_matProj_Phi_s(t_matOrthProj.rows(), t_pMatPhi_s->cols());
-    //new Version: Calculate projection before
-    MatrixXT t_matProj_LeadField(m_ForwardSolution.sol->data.rows(), m_ForwardSolution.sol->data.cols());
+    //The projections are updated incrementally after each found source, see updateProjection
+    MatrixXT t_matProj_Phi_s = *t_pMatPhi_s;
+    MatrixXT t_matProj_LeadField = m_ForwardSolution.sol->data;
+
+    MatrixXT t_matOrthLeadField;
 
     for(int r = 0; r < t_iMaxSearch ; ++r)
     {
-        t_matProj_Phi_s = t_matOrthProj*(*t_pMatPhi_s);
-
-        //new Version: Calculating Projection before
-        t_matProj_LeadField = t_matOrthProj * m_ForwardSolution.sol->data;//Subtract the found sources from the current found source
-
         //###First Option###
         //Step 1: lt. Mosher 1998 -> Maybe tmp_Proj_Phi_S is already orthogonal -> so no SVD needed -> U_B = tmp_Proj_Phi_S;
         Eigen::JacobiSVD< MatrixXT > t_svdProj_Phi_S(t_matProj_Phi_s, Eigen::ComputeThinU);
         MatrixXT t_matU_B;
         useFullRank(t_svdProj_Phi_S.matrixU(), t_svdProj_Phi_S.singularValues().asDiagonal(), t_matU_B);
 
-        //Inits
-        VectorXT t_vecRoh(m_iNumLeadFieldCombinations,1);
-        t_vecRoh.setZero();
-
         //subcorr benchmark
         //Stop the time
         clock_t start_subcorr, end_subcorr;
         start_subcorr = clock();
 
-        double t_val_roh_k;
+        //Orthonormal bases of all grid points and their projection onto the signal subspace
+        calcOrthLeadField(t_matProj_LeadField, t_matOrthLeadField);
+        MatrixXT t_matW = t_matOrthLeadField.transpose() * t_matU_B;
 
-        //Powell
-        int t_iCurrentRow = 2;
+        //Coarse: all pairs of the decimated grid
+        MatrixXT t_matOrthCoarse(m_iNumChannels, t_iNumCoarse*3);
+        MatrixXT t_matW_Coarse(t_iNumCoarse*3, t_matW.cols());
+        for(int c = 0; c < t_iNumCoarse; ++c)
+        {
+            t_matOrthCoarse.middleCols(c*3, 3) = t_matOrthLeadField.middleCols(t_vecCoarseIdx[c]*3, 3);
+            t_matW_Coarse.middleRows(c*3, 3) = t_matW.middleRows(t_vecCoarseIdx[c]*3, 3);
+        }
 
-        int t_iIdx1 = -1;
-        int t_iIdx2 = -1;
+        VectorXT t_vecRohCoarse;
+        calcPairCorrelations(t_matOrthCoarse, t_matW_Coarse, t_vecRohCoarse);
 
-        int t_iMaxIdx_old = -1;
+        int t_iNumCorrelations = t_vecRohCoarse.size();
 
-        int t_iMaxFound = 0;
+        //Fine: all pairs of the cells of the best coarse pairs
+        double t_val_roh_k = -1;
 
-        Eigen::VectorXi t_pVecIdxElements(m_iNumGridPoints);
+        int t_iIdx1 = -1;
+        int t_iIdx2 = -1;
 
-        PowellIdxVec(t_iCurrentRow, m_iNumGridPoints, t_pVecIdxElements);
+        for(int k = 0; k < m_iNumCoarseCandidates && k < t_vecRohCoarse.size(); ++k)
+        {
+            VectorXT::Index t_iMaxIdx;
+            t_vecRohCoarse.maxCoeff(&t_iMaxIdx);
+            t_vecRohCoarse(t_iMaxIdx) = -1;//exclude the candidate from the next search
 
-        int t_iNumVecElements = m_iNumGridPoints;
+            int c1, c2;
+            RapMusic::getPointPair(t_iNumCoarse, (int)t_iMaxIdx, c1, c2);
 
-        while(t_iMaxFound == 0)
-        {
+            const QVector<int>& t_vecCell1 = t_vecCoarseCells[c1];
+            const QVector<int>& t_vecCell2 = t_vecCoarseCells[c2];
 
-            //Multithreading correlation calculation
-            #ifdef _OPENMP
-            #pragma omp parallel num_threads(m_iMaxNumThreads)
-            #endif
+            for(int i = 0; i < t_vecCell1.size(); ++i)
             {
-            #ifdef _OPENMP
-            #pragma omp for
-            #endif
-                for(int i = 0; i < t_iNumVecElements; i++)
+                //Pairs within one cell only once
+                for(int j = (c1 == c2 ? i : 0); j < t_vecCell2.size(); ++j)
                 {
-                    int k = t_pVecIdxElements(i);
-                    //new Version: calculate matrix multiplication before
-                    //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
-                    MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
+                    int idx1 = t_vecCell1[i];
+                    int idx2 = t_vecCell2[j];
 
-                    int idx1 = m_ppPairIdxCombinations[k]->x1;
-                    int idx2 = m_ppPairIdxCombinations[k]->x2;
+                    Matrix3T t_matQ_12 = t_matOrthLeadField.middleCols(idx1*3, 3).transpose()
+                            * t_matOrthLeadField.middleCols(idx2*3, 3);
 
-                    RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
+                    double t_dCor = RapMusic::subcorrPair(t_matQ_12, t_matW, idx1, idx2);
+                    ++t_iNumCorrelations;
 
-                    t_vecRoh(k) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
+                    if(t_dCor > t_val_roh_k)
+                    {
+                        t_val_roh_k = t_dCor;
+                        t_iIdx1 = idx1;
+                        t_iIdx2 = idx2;
+                    }
                 }
             }
+        }
 
-    //         if(r==0)
-    //         {
-    //             std::fstream filestr;
-    //             std::stringstream filename;
-    //             filename << "Roh_gold.txt";
-    //
-    //             filestr.open ( filename.str().c_str(), std::fstream::out);
-    //             for(int i = 0; i < m_iNumLeadFieldCombinations; ++i)
-    //             {
-    //               filestr << t_vecRoh(i) << "\n";
-    //             }
-    //             filestr.close();
-    //
-    //             //exit(0);
-    //         }
-
-            //Find the maximum of correlation - can't put this in the for loop because it's running in different threads.
+        //Powell: line search through the rows of the full pair grid until neither index improves
+        int t_iCurrentRow = t_iIdx1;
+        int t_iOtherRow = t_iIdx2;
+        int t_iNumUnchanged = 0;
 
-            VectorXT::Index t_iMaxIdx;
-
-            t_val_roh_k = t_vecRoh.maxCoeff(&t_iMaxIdx);//p_vecCor = ^roh_k
+        while(t_iNumUnchanged < 2)
+        {
+            int t_iIdx;
+            double t_dCor = searchRow(t_matOrthLeadField, t_matW, t_iCurrentRow, t_iIdx);
+            t_iNumCorrelations += m_iNumGridPoints;
 
-            if((int)t_iMaxIdx == t_iMaxIdx_old)
+            if(t_dCor > t_val_roh_k)
             {
-                t_iMaxFound = 1;
-                break;
+                t_val_roh_k = t_dCor;
+                t_iIdx1 = t_iCurrentRow;
+                t_iIdx2 = t_iIdx;
+
+                //keep the new partner and search the other index
+                t_iOtherRow = t_iCurrentRow;
+                t_iCurrentRow = t_iIdx;
+                t_iNumUnchanged = 0;
             }
             else
             {
-                t_iMaxIdx_old = t_iMaxIdx;
-                //get positions in sparsed leadfield from index combinations;
-                t_iIdx1 = m_ppPairIdxCombinations[t_iMaxIdx]->x1;
-                t_iIdx2 = m_ppPairIdxCombinations[t_iMaxIdx]->x2;
+                qSwap(t_iCurrentRow, t_iOtherRow);
+                ++t_iNumUnchanged;
             }
-
-
-            //set new index
-            if(t_iIdx1 == t_iCurrentRow)
-                t_iCurrentRow = t_iIdx2;
-            else
-                t_iCurrentRow = t_iIdx1;
-
-            PowellIdxVec(t_iCurrentRow, m_iNumGridPoints, t_pVecIdxElements);
         }
 
+        if(t_iIdx1 > t_iIdx2)
+            qSwap(t_iIdx1, t_iIdx2);
+
         //subcorr benchmark
         end_subcorr = clock();
 
         float t_fSubcorrElapsedTime = ( (float)(end_subcorr-start_subcorr) / (float)CLOCKS_PER_SEC ) * 1000.0f;
         std::cout << "Time Elapsed: " << t_fSubcorrElapsedTime << " ms" << std::endl;
-
+        std::cout << "Correlations evaluated: " << t_iNumCorrelations << " of " << m_iNumLeadFieldCombinations << std::endl;
 
         // (Idx+1) because of MATLAB positions -> starting with 1 not with 0
         std::cout << "Iteration: " << r+1 << " of " << t_iMaxSearch
@@ -308,10 +309,8 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
         MatrixX6T t_matG_k_1(m_ForwardSolution.sol->data.rows(),6);
         RapMusic::getGainMatrixPair(m_ForwardSolution.sol->data, t_matG_k_1, t_iIdx1, t_iIdx2);
 
-        MatrixX6T t_matProj_G_k_1(t_matOrthProj.rows(), t_matG_k_1.cols());
-        t_matProj_G_k_1 = t_matOrthProj * t_matG_k_1;//Subtract the found sources from the current found source
-//         MatrixX6T t_matProj_G_k_1(t_matProj_LeadField.rows(), 6);
-//         getLeadFieldPair(t_matProj_LeadField, t_matProj_G_k_1, t_iIdx1, t_iIdx2);
+        MatrixX6T t_matProj_G_k_1(t_matProj_LeadField.rows(), 6);
+        RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G_k_1, t_iIdx1, t_iIdx2);
 
         //Calculate source direction
         //source direction (p_pMatPhi) for current source r (phi_k_1)
@@ -329,14 +328,9 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
             break;
         }
 
-        //Calculate A_k_1 = [a_theta_1..a_theta_k_1] matrix for subtraction of found source
-        RapMusic::calcA_k_1(t_matG_k_1, t_vec_phi_k_1, r, t_matA_k_1);
-
-        //Calculate new orthogonal Projector (Pi_k_1)
-        calcOrthProj(t_matA_k_1, t_matOrthProj);
-
-        //garbage collecting
-        //ToDo
+        //Subtract the found source a_theta_k_1 = G_k_1*phi_k_1 from the projected Lead Field and signal subspace
+        VectorXT t_vec_a_theta_k_1 = t_matG_k_1*t_vec_phi_k_1;
+        RapMusic::updateProjection(t_vec_a_theta_k_1, t_matOrthBasis_A, t_iRank_A, t_matProj_LeadField, t_matProj_Phi_s);
     }
 
     std::cout << "##### Calculation of PWL RAP MUSIC completed ######"<< std::endl << std::endl << std::endl;
@@ -353,6 +347,105 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
 }
 
 
+//*************************************************************************************************************
+
+void PwlRapMusic::setCoarseToFine(int p_iDecimation, int p_iNumCandidates)
+{
+    m_iCoarseDecimation = p_iDecimation > 1 ? p_iDecimation : 1;
+    m_iNumCoarseCandidates = p_iNumCandidates > 1 ? p_iNumCandidates : 1;
+
+    calcCoarseGrid(m_iCoarseDecimation, m_vecCoarseIdx, m_vecCoarseCells);
+    m_iCoarseNumGridPoints = m_iNumGridPoints;
+}
+
+
+//*************************************************************************************************************
+
+void PwlRapMusic::calcCoarseGrid(int p_iDecimation, QVector<int>& p_vecCoarseIdx, QVector< QVector<int> >& p_vecCoarseCells) const
+{
+    p_vecCoarseIdx.clear();
+    p_vecCoarseCells.clear();
+
+    if(m_iNumGridPoints <= 0)
+        return;
+
+    int t_iNumCoarse = (m_iNumGridPoints + p_iDecimation - 1) / p_iDecimation;
+
+    //Cell (coarse point) of each grid point
+    QVector<int> t_vecCell(m_iNumGridPoints, 0);
+
+    if(m_ForwardSolution.source_rr.rows() == m_iNumGridPoints)
+    {
+        //Farthest point sampling -> the next coarse point is the one farthest away from all chosen ones
+        const MatrixX3f& t_matRR = m_ForwardSolution.source_rr;
+        VectorXf t_vecDist = VectorXf::Constant(m_iNumGridPoints, std::numeric_limits<float>::max());
+
+        VectorXf::Index t_iNext = 0;
+
+        for(int c = 0; c < t_iNumCoarse; ++c)
+        {
+            p_vecCoarseIdx.append((int)t_iNext);
+            RowVector3f t_vecPos = t_matRR.row(t_iNext);
+
+            for(int i = 0; i < m_iNumGridPoints; ++i)
+            {
+                float t_fDist = (t_matRR.row(i) - t_vecPos).squaredNorm();
+                if(t_fDist < t_vecDist(i))
+                {
+                    t_vecDist(i) = t_fDist;
+                    t_vecCell[i] = c;
+                }
+            }
+
+            //all remaining points coincide with coarse points
+            if(t_vecDist.maxCoeff(&t_iNext) <= 0)
+                break;
+        }
+    }
+    else
+    {
+        //No source locations -> group neighbouring indices
+        for(int c = 0; c < t_iNumCoarse; ++c)
+            p_vecCoarseIdx.append(c*p_iDecimation);
+
+        for(int i = 0; i < m_iNumGridPoints; ++i)
+            t_vecCell[i] = i/p_iDecimation;
+    }
+
+    p_vecCoarseCells.resize(p_vecCoarseIdx.size());
+    for(int i = 0; i < m_iNumGridPoints; ++i)
+        p_vecCoarseCells[t_vecCell[i]].append(i);
+}
+
+
+//*************************************************************************************************************
+
+double PwlRapMusic::searchRow(const MatrixXT& p_matOrthLeadField, const MatrixXT& p_matW, int p_iRow, int& p_iIdx) const
+{
+    //Cross products of the row's basis with all bases in one matrix product
+    MatrixXT t_matQ_12 = p_matOrthLeadField.middleCols(p_iRow*3, 3).transpose() * p_matOrthLeadField;
+
+    VectorXT t_vecRoh(m_iNumGridPoints);
+
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(m_iMaxNumThreads)
+    #endif
+    {
+    #ifdef _OPENMP
+    #pragma omp for
+    #endif
+        for(int i = 0; i < m_iNumGridPoints; ++i)
+            t_vecRoh(i) = RapMusic::subcorrPair(t_matQ_12.block(0, i*3, 3, 3), p_matW, p_iRow, i);
+    }
+
+    VectorXT::Index t_iMaxIdx;
+    double t_dCor = t_vecRoh.maxCoeff(&t_iMaxIdx);
+    p_iIdx = (int)t_iMaxIdx;
+
+    return t_dCor;
+}
+
+
 //*************************************************************************************************************
 
 int PwlRapMusic::PowellOffset(int p_iRow, int p_iNumPoints)
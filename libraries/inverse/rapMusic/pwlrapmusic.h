@@ -117,6 +117,19 @@ public:
 
     virtual ~PwlRapMusic();
 
+    //=========================================================================================================
+    /**
+    * Initializes the POWELL RAP MUSIC algorithm with the given model and rebuilds the coarse grid for it.
+    *
+    * @param[in] p_Fwd          The model which contains the gain matrix and its corresponding Grid matrix.
+    * @param[in] p_bSparsed     True when sparse matrices should be used.
+    * @param[in] p_iN           The number (default 2) of uncorrelated sources, which should be found. Starting with
+    *                           the strongest.
+    * @param[in] p_dThr         The correlation threshold (default 0.5) at which the search for sources stops.
+    * @return   true if successful initialized, false otherwise.
+    */
+    virtual bool init(MNEForwardSolution& p_pFwd, bool p_bSparsed = false, int p_iN = 2, double p_dThr = 0.5);
+
     //=========================================================================================================
     /**
     *
@@ -146,12 +159,53 @@ public:
 
     virtual MNESourceEstimate calculateInverse(const MatrixXd& p_matMeasurement, QList< DipolePair<double> > &p_RapDipoles) const;
 
+    //=========================================================================================================
+    /**
+    * Sets up the coarse to fine search. The pair search first scans all pairs of a decimated grid, which keeps
+    * every p_iDecimation-th grid point spread evenly over the source space. Each fine grid point belongs to the
+    * cell of its nearest coarse point. The pairs of the cells of the p_iNumCandidates best coarse pairs are
+    * scanned on the full grid, followed by the Powell line search through the rows of the pair grid.
+    *
+    * @param[in] p_iDecimation      Decimation factor of the coarse grid (default 5, 1 = exhaustive search).
+    * @param[in] p_iNumCandidates   Number of coarse pairs which are refined on the full grid (default 3).
+    */
+    void setCoarseToFine(int p_iDecimation, int p_iNumCandidates = 3);
+
     static int PowellOffset(int p_iRow, int p_iNumPoints);
 
     static void PowellIdxVec(int p_iRow, int p_iNumPoints, Eigen::VectorXi& p_pVecElements);
 
     virtual const char* getName() const;
 
+protected:
+    //=========================================================================================================
+    /**
+    * Selects the coarse grid by farthest point sampling of the source locations and assigns every grid point to
+    * the cell of its nearest coarse point. Without source locations neighbouring indices are grouped.
+    *
+    * @param[in] p_iDecimation          Decimation factor of the coarse grid.
+    * @param[out] p_vecCoarseIdx        Grid indices of the coarse points.
+    * @param[out] p_vecCoarseCells      Grid indices of the cell of each coarse point.
+    */
+    void calcCoarseGrid(int p_iDecimation, QVector<int>& p_vecCoarseIdx, QVector< QVector<int> >& p_vecCoarseCells) const;
+
+    //=========================================================================================================
+    /**
+    * Line search through one row of the pair grid: correlates grid point p_iRow with all grid points.
+    *
+    * @param[in] p_matOrthLeadField The orthonormal bases of all grid points (see calcOrthLeadField).
+    * @param[in] p_matW             The bases projected onto the signal subspace.
+    * @param[in] p_iRow             The grid point which is kept fixed.
+    * @param[out] p_iIdx            The grid point with the maximal correlation to p_iRow.
+    * @return   The maximal correlation of the row.
+    */
+    double searchRow(const MatrixXT& p_matOrthLeadField, const MatrixXT& p_matW, int p_iRow, int& p_iIdx) const;
+
+    int m_iCoarseDecimation;                        /**< Decimation factor of the coarse grid. */
+    int m_iNumCoarseCandidates;                     /**< Number of coarse pairs which are refined. */
+    QVector<int> m_vecCoarseIdx;                    /**< Grid indices of the coarse points. */
+    QVector< QVector<int> > m_vecCoarseCells;       /**< Grid indices belonging to each coarse point. */
+    int m_iCoarseNumGridPoints;                     /**< Number of grid points the coarse grid was built for. */
 };
 
 //*************************************************************************************************************
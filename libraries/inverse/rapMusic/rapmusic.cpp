@@ -157,6 +157,14 @@ bool RapMusic::init(MNEForwardSolution& p_pFwd, bool p_bSparsed, int p_iN, doubl
 
     std::cout << "Calculate gain matrix combinations. \n";
 
+    //A repeated init replaces the combinations of the previous forward solution
+    if(m_ppPairIdxCombinations != NULL)
+    {
+        for(int i = 0; i < m_iNumLeadFieldCombinations; ++i)
+            delete m_ppPairIdxCombinations[i];
+        free(m_ppPairIdxCombinations);
+    }
+
     m_iNumLeadFieldCombinations = MNEMath::nchoose2(m_iNumGridPoints+1);
 
     m_ppPairIdxCombinations = (Pair **)malloc(m_iNumLeadFieldCombinations * sizeof(Pair *));
@@ -425,14 +433,10 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
         std::cout << std::endl << std::endl;
     }
 
-    //Create Orthogonal Projector
-    //OrthProj
-    MatrixXT t_matOrthProj(m_iNumChannels,m_iNumChannels);
-    t_matOrthProj.setIdentity();
-
-    //A_k_1
-    MatrixXT t_matA_k_1(m_iNumChannels, t_iMaxSearch);
-    t_matA_k_1.setZero();
+    //Orthonormal basis of the found source topographies A_k_1 -> the orthogonal projector is I - Q_A*Q_A^T
+    MatrixXT t_matOrthBasis_A(m_iNumChannels, t_iMaxSearch);
+    t_matOrthBasis_A.setZero();
+    int t_iRank_A = 0;
 
 //    if (m_pMatGrid != NULL)
 //    {
@@ -452,17 +456,14 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
 
     std::cout << "##### Calculation of RAP MUSIC started ######\n\n";
 
-    MatrixXT t_matProj_Phi_s(t_matOrthProj.rows(), t_pMatPhi_s->cols());
-    //new Version: Calculate projection before
-    MatrixXT t_matProj_LeadField(m_ForwardSolution.sol->data.rows(), m_ForwardSolution.sol->data.cols());
+    //The projections are updated incrementally after each found source, see updateProjection
+    MatrixXT t_matProj_Phi_s = *t_pMatPhi_s;
+    MatrixXT t_matProj_LeadField = m_ForwardSolution.sol->data;
+
+    MatrixXT t_matOrthLeadField;
 
     for(int r = 0; r < t_iMaxSearch ; ++r)
     {
-        t_matProj_Phi_s = t_matOrthProj*(*t_pMatPhi_s);
-
-        //new Version: Calculating Projection before
-        t_matProj_LeadField = t_matOrthProj * m_ForwardSolution.sol->data;//Subtract the found sources from the current found source
-
         //###First Option###
         //Step 1: lt. Mosher 1998 -> Maybe tmp_Proj_Phi_S is already orthogonal -> so no SVD needed -> U_B = tmp_Proj_Phi_S;
         Eigen::JacobiSVD< MatrixXT > t_svdProj_Phi_S(t_matProj_Phi_s, Eigen::ComputeThinU);
@@ -478,45 +479,12 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
         clock_t start_subcorr, end_subcorr;
         start_subcorr = clock();
 
-        //Multithreading correlation calculation
-        #ifdef _OPENMP
-        #pragma omp parallel num_threads(m_iMaxNumThreads)
-        #endif
-        {
-        #ifdef _OPENMP
-        #pragma omp for
-        #endif
-            for(int i = 0; i < m_iNumLeadFieldCombinations; i++)
-            {
-                //new Version: calculate matrix multiplication before
-                //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
-                MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
-
-                int idx1 = m_ppPairIdxCombinations[i]->x1;
-                int idx2 = m_ppPairIdxCombinations[i]->x2;
-
-                RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
-
-                t_vecRoh(i) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
-            }
-        }
-
+        //Orthonormal bases of all grid points and their projection onto the signal subspace
+        calcOrthLeadField(t_matProj_LeadField, t_matOrthLeadField);
+        MatrixXT t_matW = t_matOrthLeadField.transpose() * t_matU_B;
 
-//         if(r==0)
-//         {
-//             std::fstream filestr;
-//             std::stringstream filename;
-//             filename << "Roh_gold.txt";
-//
-//             filestr.open ( filename.str().c_str(), std::fstream::out);
-//             for(int i = 0; i < m_iNumLeadFieldCombinations; ++i)
-//             {
-//               filestr << t_vecRoh(i) << "\n";
-//             }
-//             filestr.close();
-//
-//             //exit(0);
-//         }
+        //Multithreading correlation calculation
+        calcPairCorrelations(t_matOrthLeadField, t_matW, t_vecRoh);//t_vecRoh holds the correlations roh_k
 
         //subcorr benchmark
         end_subcorr = clock();
@@ -539,14 +507,12 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
         std::cout << "Iteration: " << r+1 << " of " << t_iMaxSearch
             << "; Correlation: " << t_val_roh_k<< "; Position (Idx+1): " << t_iIdx1+1 << " - " << t_iIdx2+1 <<"\n\n";
 
-        //Calculations with the max correlated dipole pair G_k_1 -> ToDo Obsolet when taking direkt Projected Lead Field
+        //Calculations with the max correlated dipole pair G_k_1
         MatrixX6T t_matG_k_1(m_ForwardSolution.sol->data.rows(),6);
         RapMusic::getGainMatrixPair(m_ForwardSolution.sol->data, t_matG_k_1, t_iIdx1, t_iIdx2);
 
-        MatrixX6T t_matProj_G_k_1(t_matOrthProj.rows(), t_matG_k_1.cols());
-        t_matProj_G_k_1 = t_matOrthProj * t_matG_k_1;//Subtract the found sources from the current found source
-//         MatrixX6T t_matProj_G_k_1(t_matProj_LeadField.rows(), 6);
-//         getLeadFieldPair(t_matProj_LeadField, t_matProj_G_k_1, t_iIdx1, t_iIdx2);
+        MatrixX6T t_matProj_G_k_1(t_matProj_LeadField.rows(), 6);
+        RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G_k_1, t_iIdx1, t_iIdx2);
 
         //Calculate source direction
         //source direction (p_pMatPhi) for current source r (phi_k_1)
@@ -564,11 +530,9 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
             break;
         }
 
-        //Calculate A_k_1 = [a_theta_1..a_theta_k_1] matrix for subtraction of found source
-        RapMusic::calcA_k_1(t_matG_k_1, t_vec_phi_k_1, r, t_matA_k_1);
-
-        //Calculate new orthogonal Projector (Pi_k_1)
-        calcOrthProj(t_matA_k_1, t_matOrthProj);
+        //Subtract the found source a_theta_k_1 = G_k_1*phi_k_1 from the projected Lead Field and signal subspace
+        VectorXT t_vec_a_theta_k_1 = t_matG_k_1*t_vec_phi_k_1;
+        RapMusic::updateProjection(t_vec_a_theta_k_1, t_matOrthBasis_A, t_iRank_A, t_matProj_LeadField, t_matProj_Phi_s);
 
         //garbage collecting
         //ToDo
@@ -751,6 +715,150 @@ double RapMusic::subcorr(MatrixX6T& p_matProj_G, const MatrixXT& p_matU_B, Vecto
 }
 
 
+//*************************************************************************************************************
+
+void RapMusic::calcOrthLeadField(const MatrixXT& p_matProj_LeadField, MatrixXT& p_matOrthLeadField) const
+{
+    p_matOrthLeadField.resize(p_matProj_LeadField.rows(), p_matProj_LeadField.cols());
+
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(m_iMaxNumThreads)
+    #endif
+    {
+    #ifdef _OPENMP
+    #pragma omp for
+    #endif
+        for(int i = 0; i < m_iNumGridPoints; ++i)
+        {
+            //Rank revealing QR of the m x 3 block -> Q spans the same space as the singular vectors U_A
+            Eigen::ColPivHouseholderQR<MatrixXT> t_qrProj_G(p_matProj_LeadField.middleCols(i*3, 3));
+            t_qrProj_G.setThreshold(0.00001);
+            int t_iRank = t_qrProj_G.rank();
+
+            MatrixXT t_matQ = MatrixXT::Identity(p_matProj_LeadField.rows(), 3);
+            t_matQ.applyOnTheLeft(t_qrProj_G.householderQ());
+
+            p_matOrthLeadField.middleCols(i*3, 3).setZero();
+            p_matOrthLeadField.middleCols(i*3, t_iRank) = t_matQ.leftCols(t_iRank);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RapMusic::calcPairCorrelations(const MatrixXT& p_matOrthLeadField, const MatrixXT& p_matW, VectorXT& p_vecRoh) const
+{
+    //Grid points of the given bases -> not necessarily all m_iNumGridPoints
+    int t_iNumPoints = p_matOrthLeadField.cols()/3;
+    p_vecRoh.resize(MNEMath::nchoose2(t_iNumPoints+1));
+
+    //Number of grid points (rows of the pair triangle) which share one matrix product
+    const int t_iBlockSize = 8;
+    int t_iNumBlocks = (t_iNumPoints + t_iBlockSize - 1) / t_iBlockSize;
+
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(m_iMaxNumThreads)
+    #endif
+    {
+    #ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+    #endif
+        for(int b = 0; b < t_iNumBlocks; ++b)
+        {
+            int t_iFirst = b * t_iBlockSize;
+            int t_iRows = std::min(t_iBlockSize, t_iNumPoints - t_iFirst);
+            int t_iCols = t_iNumPoints - t_iFirst;
+
+            //Cross products Q_1^T Q_2 of the block's bases with the bases of all following grid points
+            MatrixXT t_matQ_12 = p_matOrthLeadField.middleCols(t_iFirst*3, t_iRows*3).transpose()
+                    * p_matOrthLeadField.middleCols(t_iFirst*3, t_iCols*3);
+
+            for(int k = 0; k < t_iRows; ++k)
+            {
+                int idx1 = t_iFirst + k;
+                //Combination index of the pair (idx1, idx1), see getPointPair
+                int t_iOffset = idx1*t_iNumPoints - idx1*(idx1-1)/2;
+
+                for(int idx2 = idx1; idx2 < t_iNumPoints; ++idx2)
+                    p_vecRoh(t_iOffset + idx2 - idx1) = RapMusic::subcorrPair(t_matQ_12.block(k*3, (idx2-t_iFirst)*3, 3, 3),
+                                                                                p_matW, idx1, idx2);
+            }
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+double RapMusic::subcorrPair(const Matrix3T& p_matQ_12, const MatrixXT& p_matW, int p_iIdx1, int p_iIdx2)
+{
+    //Correlations of both bases with U_B: W_1*W_1^T, W_1*W_2^T and W_2*W_2^T
+    Matrix3T t_matW_11 = p_matW.middleRows(p_iIdx1*3, 3) * p_matW.middleRows(p_iIdx1*3, 3).transpose();
+    Matrix3T t_matW_12 = p_matW.middleRows(p_iIdx1*3, 3) * p_matW.middleRows(p_iIdx2*3, 3).transpose();
+    Matrix3T t_matW_22 = p_matW.middleRows(p_iIdx2*3, 3) * p_matW.middleRows(p_iIdx2*3, 3).transpose();
+
+    //Residual of Q_2 after removing Q_1: R = Q_2 - Q_1*Q_12, R^T*R = I - Q_12^T*Q_12 = V*Lambda*V^T
+    Eigen::SelfAdjointEigenSolver<Matrix3T> t_eigResidual(Matrix3T::Identity() - p_matQ_12.transpose()*p_matQ_12);
+
+    //T = V*Lambda^-1/2 -> orthonormal residual R*T; drop directions which are (almost) shared by both points
+    Matrix3T t_matT = t_eigResidual.eigenvectors();
+    for(int k = 0; k < 3; ++k)
+    {
+        if(t_eigResidual.eigenvalues()(k) > 0.0000000001)
+            t_matT.col(k) /= sqrt(t_eigResidual.eigenvalues()(k));
+        else
+            t_matT.col(k).setZero();
+    }
+
+    //C = [W_1; T^T*(W_2 - Q_12^T*W_1)] -> C*C^T from the 3 x 3 blocks
+    Matrix3T t_matCor_12 = t_matW_12 - t_matW_11*p_matQ_12;
+    Matrix3T t_matCor_22 = t_matW_22 - p_matQ_12.transpose()*t_matW_12 - t_matW_12.transpose()*p_matQ_12
+            + p_matQ_12.transpose()*t_matW_11*p_matQ_12;
+
+    Matrix6T t_matCorCor;
+    t_matCorCor.block<3,3>(0,0) = t_matW_11;
+    t_matCorCor.block<3,3>(0,3) = t_matCor_12*t_matT;
+    t_matCorCor.block<3,3>(3,0) = t_matCorCor.block<3,3>(0,3).transpose();
+    t_matCorCor.block<3,3>(3,3) = t_matT.transpose()*t_matCor_22*t_matT;
+
+    //Step 3: the largest singular value of C -> eigenvalues are sorted ascending
+    Eigen::SelfAdjointEigenSolver<Matrix6T> t_eigCor(t_matCorCor, Eigen::EigenvaluesOnly);
+    double t_dLambda = t_eigCor.eigenvalues()(5);
+
+    return t_dLambda > 0 ? sqrt(t_dLambda) : 0;
+}
+
+
+//*************************************************************************************************************
+
+void RapMusic::updateProjection(    const VectorXT& p_vec_a_theta_k_1,
+                                    MatrixXT& p_matOrthBasis_A,
+                                    int& p_iRank_A,
+                                    MatrixXT& p_matProj_LeadField,
+                                    MatrixXT& p_matProj_Phi_s)
+{
+    //Gram-Schmidt (twice for stability) against the topographies found so far
+    VectorXT t_vec_q = p_vec_a_theta_k_1;
+    for(int i = 0; i < 2; ++i)
+        t_vec_q -= p_matOrthBasis_A.leftCols(p_iRank_A) * (p_matOrthBasis_A.leftCols(p_iRank_A).transpose() * t_vec_q);
+
+    double t_dNorm = t_vec_q.norm();
+
+    //Source lies in the span of the ones already found -> projector doesn't change (cf. calcOrthProj)
+    if(t_dNorm <= 0.00001 * p_vec_a_theta_k_1.norm() || p_iRank_A >= p_matOrthBasis_A.cols())
+        return;
+
+    t_vec_q /= t_dNorm;
+    p_matOrthBasis_A.col(p_iRank_A) = t_vec_q;
+    ++p_iRank_A;
+
+    //(I - q*q^T)*X as rank one update
+    p_matProj_LeadField -= t_vec_q * (t_vec_q.transpose() * p_matProj_LeadField);
+    p_matProj_Phi_s -= t_vec_q * (t_vec_q.transpose() * p_matProj_Phi_s);
+}
+
+
 //*************************************************************************************************************
 
 void RapMusic::calcA_k_1(   const MatrixX6T& p_matG_k_1,
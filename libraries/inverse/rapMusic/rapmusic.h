@@ -61,6 +61,8 @@
 #include <Eigen/Core>
 #include <Eigen/SVD>
 #include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/Eigenvalues>
 
 
 //*************************************************************************************************************
@@ -125,6 +127,8 @@ public:
                                                                              Eigen::Dynamic> as Matrix6XT type. */
     typedef Eigen::Matrix<double, 6, 6> Matrix6T;                            /**< Defines Eigen::Matrix<T, 6, 6>
                                                                              as Matrix6T type. */
+    typedef Eigen::Matrix<double, 3, 3> Matrix3T;                            /**< Defines Eigen::Matrix<T, 3, 3>
+                                                                             as Matrix3T type. */
     typedef Eigen::Matrix<double, Eigen::Dynamic, 1> VectorXT;               /**< Defines Eigen::Matrix<T, Eigen::Dynamic,
                                                                              1> as VectorXT type. */
     typedef Eigen::Matrix<double, 6, 1> Vector6T;                            /**< Defines Eigen::Matrix<T, 6, 1>
@@ -162,7 +166,7 @@ public:
     * @param[in] p_dThr         The correlation threshold (default 0.5) at which the search for sources stops.
     * @return   true if successful initialized, false otherwise.
     */
-    bool init(MNEForwardSolution& p_pFwd, bool p_bSparsed = false, int p_iN = 2, double p_dThr = 0.5);
+    virtual bool init(MNEForwardSolution& p_pFwd, bool p_bSparsed = false, int p_iN = 2, double p_dThr = 0.5);
 
     virtual MNESourceEstimate calculateInverse(const FiffEvoked &p_fiffEvoked, bool pick_normal = false);
 
@@ -228,6 +232,63 @@ protected:
     */
     static double subcorr(MatrixX6T& p_matProj_G, const MatrixXT& p_matU_B, Vector6T& p_vec_phi_k_1);
 
+    //=========================================================================================================
+    /**
+    * Computes an orthonormal basis of each grid point's projected Lead Field block (m x 3) by a rank revealing
+    * QR decomposition. Directions with a singular value below 10^-5 of the strongest one are dropped and their
+    * basis columns are set to zero, so every grid point keeps its 3 columns in p_matOrthLeadField.
+    *
+    * @param[in] p_matProj_LeadField    The projected Lead Field (m x 3*grid points).
+    * @param[out] p_matOrthLeadField    The orthonormal bases of all grid points (m x 3*grid points).
+    */
+    void calcOrthLeadField(const MatrixXT& p_matProj_LeadField, MatrixXT& p_matOrthLeadField) const;
+
+    //=========================================================================================================
+    /**
+    * Computes the subspace correlations of all combinations of the given grid point bases (p_vecRoh is ordered
+    * like m_ppPairIdxCombinations when all grid points are passed). The cross products of the grid point
+    * bases are evaluated in blocks of rows of the pair triangle, one matrix product per block, and the 6 column
+    * subspace correlation of each pair is reduced to the 3 x 3 and 6 x 6 closed form of subcorrPair.
+    *
+    * @param[in] p_matOrthLeadField The orthonormal bases of all grid points (see calcOrthLeadField).
+    * @param[in] p_matW             The bases projected onto the signal subspace: p_matOrthLeadField^T * U_B.
+    * @param[out] p_vecRoh          The correlations of all pairs (number of points + 1 over 2).
+    */
+    void calcPairCorrelations(const MatrixXT& p_matOrthLeadField, const MatrixXT& p_matW, VectorXT& p_vecRoh) const;
+
+    //=========================================================================================================
+    /**
+    * Computes the subspace correlation of a grid point pair from the orthonormal bases Q_1, Q_2 of both points.
+    * The second basis is orthogonalized against the first one (block Gram-Schmidt), which only needs the 3 x 3
+    * cross product Q_1^T Q_2. The correlation is the square root of the largest eigenvalue of C*C^T, with
+    * C = U_A^T * U_B of dimension 6 x rank(U_B). Equal to subcorr for the pair's 6 column Lead Field.
+    *
+    * @param[in] p_matQ_12  The cross product Q_1^T Q_2 of the two orthonormal bases.
+    * @param[in] p_matW     The bases projected onto the signal subspace: Q^T * U_B (3*grid points x rank).
+    * @param[in] p_iIdx1    first Lead Field index point
+    * @param[in] p_iIdx2    second Lead Field index point
+    * @return   The maximal correlation c_1 of the subspace correlation of the pair.
+    */
+    static double subcorrPair(const Matrix3T& p_matQ_12, const MatrixXT& p_matW, int p_iIdx1, int p_iIdx2);
+
+    //=========================================================================================================
+    /**
+    * Removes a found source from the projected Lead Field and the projected signal subspace. Instead of applying
+    * the orthogonal projector of calcOrthProj to the full Lead Field, the source topography is orthogonalized
+    * against the ones already found and subtracted as a rank one update.
+    *
+    * @param[in] p_vec_a_theta_k_1      The topography a_theta_k_1 = G_k_1*phi_k_1 of the found source.
+    * @param[in, out] p_matOrthBasis_A  Orthonormal basis of the found topographies (m x maximal sources).
+    * @param[in, out] p_iRank_A         Number of valid columns in p_matOrthBasis_A.
+    * @param[in, out] p_matProj_LeadField   The projected Lead Field.
+    * @param[in, out] p_matProj_Phi_s   The projected signal subspace.
+    */
+    static void updateProjection(   const VectorXT& p_vec_a_theta_k_1,
+                                    MatrixXT& p_matOrthBasis_A,
+                                    int& p_iRank_A,
+                                    MatrixXT& p_matProj_LeadField,
+                                    MatrixXT& p_matProj_Phi_s);
+
     //=========================================================================================================
     /**
     * Calculates the accumulated manifold vectors A_{k1}
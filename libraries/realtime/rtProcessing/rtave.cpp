@@ -119,6 +119,7 @@ RtAve::RtAve(quint32 numAverages,
 , m_bActivateVariance(false)
 {
     qRegisterMetaType<FIFFLIB::FiffEvokedSet::SPtr>("FIFFLIB::FiffEvokedSet::SPtr");
+    qRegisterMetaType<FIFFLIB::FiffEvoked::SPtr>("FIFFLIB::FiffEvoked::SPtr");
 
     init();
 }
@@ -267,6 +268,10 @@ bool RtAve::start()
     if(this->isRunning())
         QThread::wait();
 
+    //Drop the blocks and releases left over from the last run
+    if(m_pRawMatrixBuffer)
+        m_pRawMatrixBuffer->reset();
+
     m_bIsRunning = true;
 
     QThread::start();
@@ -298,6 +303,8 @@ void RtAve::run()
     //Do initial reset
     reset();
 
+    MatrixXd rawSegment;
+
     //Enter the main loop
     while(m_bIsRunning) {
         //Wait for first data block to arrive
@@ -309,8 +316,8 @@ void RtAve::run()
             //QElapsedTimer time;
             //time.start();
 
-            //Acquire Data m_pRawMatrixBuffer is thread safe
-            MatrixXd rawSegment = m_pRawMatrixBuffer->pop();
+            //Acquire Data m_pRawMatrixBuffer is thread safe, the storage of rawSegment is reused
+            m_pRawMatrixBuffer->pop(rawSegment);
 
             //QMutexLocker locker(&m_qMutex);
             doAveraging(rawSegment);
@@ -518,20 +525,107 @@ void RtAve::mergeData(double dTriggerType)
     if(bArtifactedDetected == false) {
         //Add cut data to average buffer
         m_mapStimAve[dTriggerType].append(mergedData);
+        addToAverage(dTriggerType, mergedData);
 
         //Pop data from buffer
         if(m_mapStimAve[dTriggerType].size() > m_iNumAverages && m_iNumAverages >= 1) {
+            removeFromAverage(dTriggerType, m_mapStimAve[dTriggerType].first());
             m_mapStimAve[dTriggerType].pop_front();
         }
 
         //Proceed a bit different if we use zero number of averages
         if(m_mapStimAve[dTriggerType].size() > 1 && m_iNumAverages == 0) {
+            removeFromAverage(dTriggerType, m_mapStimAve[dTriggerType].first());
             m_mapStimAve[dTriggerType].pop_front();
         }
     }
 }
 
 
+//*************************************************************************************************************
+
+void RtAve::addToAverage(double dTriggerType, const MatrixXd& epoch)
+{
+    qint32& n = m_mapStimAveCount[dTriggerType];
+    MatrixXd& matMean = m_mapStimAveMean[dTriggerType];
+    MatrixXd& matM2 = m_mapStimAveM2[dTriggerType];
+
+    if(n == 0 || matMean.rows() != epoch.rows() || matMean.cols() != epoch.cols()) {
+        n = 0;
+        matMean = MatrixXd::Zero(epoch.rows(), epoch.cols());
+        matM2 = MatrixXd::Zero(epoch.rows(), epoch.cols());
+    }
+
+    ++n;
+
+    MatrixXd matDelta = epoch - matMean;
+    matMean += matDelta / n;
+    matM2.array() += matDelta.array() * (epoch - matMean).array();
+}
+
+
+//*************************************************************************************************************
+
+void RtAve::removeFromAverage(double dTriggerType, const MatrixXd& epoch)
+{
+    //The cumulative average keeps all epochs
+    if(m_iAverageMode != 0) {
+        return;
+    }
+
+    qint32& n = m_mapStimAveCount[dTriggerType];
+    MatrixXd& matMean = m_mapStimAveMean[dTriggerType];
+    MatrixXd& matM2 = m_mapStimAveM2[dTriggerType];
+
+    if(n <= 1) {
+        n = 0;
+        matMean.setZero();
+        matM2.setZero();
+        return;
+    }
+
+    MatrixXd matDelta = epoch - matMean;
+    matMean -= matDelta / (n - 1);
+    matM2.array() -= matDelta.array() * (epoch - matMean).array();
+
+    --n;
+
+    //Recalculate from the stored epochs from time to time, so rounding errors can not pile up
+    if(++m_mapStimAveRemovals[dTriggerType] >= qMax(m_iNumAverages, 1)) {
+        m_mapStimAveRemovals[dTriggerType] = 0;
+        refreshAverage(dTriggerType);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtAve::refreshAverage(double dTriggerType)
+{
+    //Note: Called from mergeData before the evicted epoch was popped, which is therefore skipped here
+    const QList<MatrixXd>& lEpochs = m_mapStimAve[dTriggerType];
+    const int iFirst = lEpochs.size() - m_mapStimAveCount[dTriggerType];
+
+    if(iFirst < 0 || iFirst >= lEpochs.size()) {
+        return;
+    }
+
+    MatrixXd& matMean = m_mapStimAveMean[dTriggerType];
+    MatrixXd& matM2 = m_mapStimAveM2[dTriggerType];
+
+    matMean = MatrixXd::Zero(lEpochs.at(iFirst).rows(), lEpochs.at(iFirst).cols());
+    for(int i = iFirst; i < lEpochs.size(); ++i) {
+        matMean += lEpochs.at(i);
+    }
+    matMean /= lEpochs.size() - iFirst;
+
+    matM2 = MatrixXd::Zero(matMean.rows(), matMean.cols());
+    for(int i = iFirst; i < lEpochs.size(); ++i) {
+        matM2.array() += (lEpochs.at(i) - matMean).array().square();
+    }
+}
+
+
 //*************************************************************************************************************
 
 void checkChVariance(QPair<bool, RowVectorXd>& pairData)
@@ -645,84 +739,86 @@ bool RtAve::checkForArtifact(MatrixXd& data)
 
 void RtAve::generateEvoked(double dTriggerType)
 {
-    QMutexLocker locker(&m_qMutex);
-
-    if(m_mapStimAve[dTriggerType].isEmpty()) {
-        return;
-    }
+    FiffEvoked::SPtr pEvoked;
 
-    //Init evoked
-    FiffEvoked evoked;    
-    int iEvokedIdx = -1;
+    {
+        QMutexLocker locker(&m_qMutex);
 
-    for(int i = 0; i < m_pStimEvokedSet->evoked.size(); ++i) {
-        if(m_pStimEvokedSet->evoked.at(i).comment == QString::number(dTriggerType)) {
-            evoked = m_pStimEvokedSet->evoked.at(i);
-            iEvokedIdx = i;
-            break;
+        if(m_mapStimAve[dTriggerType].isEmpty()) {
+            return;
         }
-    }
-
-    //If the evoked is not yet present add it here
-    if(iEvokedIdx == -1) {
-        float T = 1.0/m_pFiffInfo->sfreq;
-
-        evoked.setInfo(*m_pFiffInfo.data());
-        evoked.baseline = m_pairBaselineSec;
-        evoked.times.resize(m_iPreStimSamples + m_iPostStimSamples);
-        evoked.times[0] = -T*m_iPreStimSamples;
-        for(int i = 1; i < evoked.times.size(); ++i)
-            evoked.times[i] = evoked.times[i-1] + T;
-        evoked.first = evoked.times[0];
-        evoked.last = evoked.times[evoked.times.size()-1];
-        evoked.comment = QString::number(dTriggerType);
-    }
 
-    // Generate final evoked
-    MatrixXd finalAverage = MatrixXd::Zero(m_mapStimAve[dTriggerType].first().rows(), m_iPreStimSamples+m_iPostStimSamples);
+        //Find the evoked, it is updated in place so its measurement info is not copied again
+        int iEvokedIdx = -1;
+        QString sComment = QString::number(dTriggerType);
 
-    if(m_iAverageMode == 0) {
-        for(int i = 0; i < m_mapStimAve[dTriggerType].size(); ++i) {
-            finalAverage += m_mapStimAve[dTriggerType].at(i);
+        for(int i = 0; i < m_pStimEvokedSet->evoked.size(); ++i) {
+            if(m_pStimEvokedSet->evoked.at(i).comment == sComment) {
+                iEvokedIdx = i;
+                break;
+            }
         }
 
-        if(m_mapStimAve[dTriggerType].isEmpty()) {
-            finalAverage = finalAverage/1;
-        } else {
-            finalAverage = finalAverage/m_mapStimAve[dTriggerType].size();
+        //If the evoked is not yet present add it here
+        if(iEvokedIdx == -1) {
+            float T = 1.0/m_pFiffInfo->sfreq;
+
+            FiffEvoked evoked;
+            evoked.setInfo(*m_pFiffInfo.data());
+            evoked.baseline = m_pairBaselineSec;
+            evoked.times.resize(m_iPreStimSamples + m_iPostStimSamples);
+            evoked.times[0] = -T*m_iPreStimSamples;
+            for(int i = 1; i < evoked.times.size(); ++i)
+                evoked.times[i] = evoked.times[i-1] + T;
+            evoked.first = evoked.times[0];
+            evoked.last = evoked.times[evoked.times.size()-1];
+            evoked.comment = sComment;
+
+            m_pStimEvokedSet->evoked.append(evoked);
+            iEvokedIdx = m_pStimEvokedSet->evoked.size() - 1;
         }
 
-        if(m_bDoBaselineCorrection) {
-            finalAverage = MNEMath::rescale(finalAverage, evoked.times, m_pairBaselineSec, QString("mean"));
-        }
+        FiffEvoked& evoked = m_pStimEvokedSet->evoked[iEvokedIdx];
 
-        evoked.data = finalAverage;
+        // Generate final evoked
+        if(m_iAverageMode == 0) {
+            //The running mean is updated by mergeData, so the stored epochs do not need to be summed up again
+            if(m_bDoBaselineCorrection) {
+                evoked.data = MNEMath::rescale(m_mapStimAveMean[dTriggerType], evoked.times, m_pairBaselineSec, QString("mean"));
+            } else {
+                evoked.data = m_mapStimAveMean[dTriggerType];
+            }
 
-        if(m_mapNumberCalcAverages[dTriggerType] < m_iNumAverages) {
-            m_mapNumberCalcAverages[dTriggerType]++;
-        }
+            if(m_mapNumberCalcAverages[dTriggerType] < m_iNumAverages) {
+                m_mapNumberCalcAverages[dTriggerType]++;
+            }
 
-        evoked.nave = m_mapNumberCalcAverages[dTriggerType];
-    } else if(m_iAverageMode == 1) {
-        MatrixXd tempMatrix = m_mapStimAve[dTriggerType].last();
+            evoked.nave = m_mapNumberCalcAverages[dTriggerType];
+        } else if(m_iAverageMode == 1) {
+            MatrixXd tempMatrix = m_mapStimAve[dTriggerType].last();
 
-        if(m_bDoBaselineCorrection) {
-            tempMatrix = MNEMath::rescale(tempMatrix, evoked.times, m_pairBaselineSec, QString("mean"));
-        }
+            if(m_bDoBaselineCorrection) {
+                tempMatrix = MNEMath::rescale(tempMatrix, evoked.times, m_pairBaselineSec, QString("mean"));
+            }
 
-        evoked += tempMatrix;
+            evoked += tempMatrix;
 
-        m_mapNumberCalcAverages[dTriggerType]++;
-    }
+            m_mapNumberCalcAverages[dTriggerType]++;
+        }
 
-    //Add new data to evoked data set
-    if(iEvokedIdx != -1) {
-        //Evoked data is already present
-        m_pStimEvokedSet->evoked[iEvokedIdx] = evoked;
-    } else {
-        //Evoked data is not present yet
-        m_pStimEvokedSet->evoked.append(evoked);
+        //Publish the updated trigger type only, without measurement info
+        pEvoked = FiffEvoked::SPtr(new FiffEvoked);
+        pEvoked->aspect_kind = FIFFV_ASPECT_AVERAGE;
+        pEvoked->nave = evoked.nave;
+        pEvoked->first = evoked.first;
+        pEvoked->last = evoked.last;
+        pEvoked->comment = evoked.comment;
+        pEvoked->times = evoked.times;
+        pEvoked->baseline = evoked.baseline;
+        pEvoked->data = evoked.data;
     }
+
+    emit evokedStimUpdated(pEvoked);
 }
 
 
@@ -763,6 +859,10 @@ void RtAve::reset()
     m_mapMatDataPostIdx.clear();
     m_mapFillingBackBuffer.clear();
     m_mapNumberCalcAverages.clear();
+    m_mapStimAveMean.clear();
+    m_mapStimAveM2.clear();
+    m_mapStimAveCount.clear();
+    m_mapStimAveRemovals.clear();
 
     qDebug()<<"RtAve::reset() - 4";
 
@@ -802,6 +902,24 @@ void RtAve::reset()
 }
 
 
+//*************************************************************************************************************
+
+MatrixXd RtAve::getStdErr(double dTriggerType)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    qint32 n = m_mapStimAveCount.value(dTriggerType, 0);
+    const MatrixXd& matM2 = m_mapStimAveM2[dTriggerType];
+
+    if(n < 2) {
+        return MatrixXd::Zero(matM2.rows(), matM2.cols());
+    }
+
+    //Clamp the rounding noise of the running sum of squared deviations before taking the root
+    return (matM2.array().max(0.0) / (double(n - 1) * n)).sqrt().matrix();
+}
+
+
 //*************************************************************************************************************
 
 void RtAve::init()
@@ -245,6 +245,17 @@ public:
     */
     void reset();
 
+    //=========================================================================================================
+    /**
+    * Returns the standard error of the mean of the epochs which are currently averaged for the given trigger type.
+    * The epochs are not baseline corrected.
+    *
+    * @param[in] dTriggerType   The trigger type.
+    *
+    * @return The standard error of the mean, zero if less than two epochs were averaged.
+    */
+    Eigen::MatrixXd getStdErr(double dTriggerType);
+
 protected:
     //=========================================================================================================
     /**
@@ -254,6 +265,39 @@ protected:
     */
     virtual void run();
 
+    //=========================================================================================================
+    /**
+    * Adds an epoch to the running mean and sum of squared deviations of the given trigger type (Welford update).
+    *
+    * @param[in] dTriggerType   The trigger type.
+    * @param[in] epoch          The epoch which was appended to the average buffer.
+    */
+    void addToAverage(double dTriggerType, const Eigen::MatrixXd& epoch);
+
+    //=========================================================================================================
+    /**
+    * Removes an epoch from the running mean and sum of squared deviations of the given trigger type. Every
+    * m_iNumAverages removals the accumulators are recalculated from the stored epochs to bound the rounding drift.
+    *
+    * @param[in] dTriggerType   The trigger type.
+    * @param[in] epoch          The epoch which is popped from the average buffer.
+    */
+    void removeFromAverage(double dTriggerType, const Eigen::MatrixXd& epoch);
+
+    //=========================================================================================================
+    /**
+    * Recalculates the running mean and sum of squared deviations of the given trigger type from the stored epochs.
+    *
+    * @param[in] dTriggerType   The trigger type.
+    */
+    void refreshAverage(double dTriggerType);
+
+    QMap<double,QList<Eigen::MatrixXd> >            m_mapStimAve;               /**< the current stimulus average buffer. Holds m_iNumAverages vectors */
+    QMap<double,Eigen::MatrixXd>                    m_mapStimAveMean;           /**< The running mean of the averaged epochs for each trigger type. */
+    QMap<double,Eigen::MatrixXd>                    m_mapStimAveM2;             /**< The running sum of squared deviations from the mean for each trigger type. */
+    QMap<double,qint32>                             m_mapStimAveCount;          /**< The number of epochs in the running accumulators for each trigger type. */
+    QMap<double,qint32>                             m_mapStimAveRemovals;       /**< The number of removals since the last recalculation of the accumulators. */
+
 private:
     //=========================================================================================================
     /**
@@ -345,7 +389,6 @@ private:
     FIFFLIB::FiffEvokedSet::SPtr                    m_pStimEvokedSet;           /**< Holds the evoked information. */
 
     QMap<int,QList<int> >                           m_qMapDetectedTrigger;      /**< Detected trigger for each trigger channel. */
-    QMap<double,QList<Eigen::MatrixXd> >            m_mapStimAve;               /**< the current stimulus average buffer. Holds m_iNumAverages vectors */
     QMap<double,Eigen::MatrixXd>                    m_mapDataPre;               /**< The matrix holding the pre stim data. */
     QMap<double,Eigen::MatrixXd>                    m_mapDataPost;              /**< The matrix holding the post stim data. */
     QMap<double,qint32>                             m_mapMatDataPostIdx;        /**< Current index inside of the matrix m_matDataPost */
@@ -362,6 +405,16 @@ signals:
     * @param[out] p_pEvokedStimSet     The evoked stimulus data set
     */
     void evokedStim(FIFFLIB::FiffEvokedSet::SPtr p_pEvokedStimSet);
+
+    //=========================================================================================================
+    /**
+    * Signal which is emitted together with evokedStim. It only carries the evoked of the trigger type which was
+    * updated. The evoked holds no measurement info, which does not change while averaging, so receivers can update
+    * their copy without touching the other trigger types.
+    *
+    * @param[out] p_pEvoked     The updated average (FIFFV_ASPECT_AVERAGE) of one trigger type.
+    */
+    void evokedStimUpdated(FIFFLIB::FiffEvoked::SPtr p_pEvoked);
 };
 
 //*************************************************************************************************************
@@ -44,6 +44,9 @@
 
 #include <iostream>
 #include <fiff/fiff_cov.h>
+#include <fiff/fiff_proj.h>
+
+#include <math.h>
 
 
 //*************************************************************************************************************
@@ -63,6 +66,63 @@ using namespace REALTIMELIB;
 using namespace FIFFLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC FUNCTIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Adds (p_dSign = 1) or removes (p_dSign = -1) the samples p_matBlock to or from the accumulated mean and scatter
+* matrix. The block is centered on its own mean and merged by the pairwise update of Chan et al., which stays
+* stable for large offsets. Only the lower triangle of p_matScatter is updated.
+*
+* @param[in] p_matBlock         the samples (channels x samples)
+* @param[in] p_dSign            1 to add, -1 to remove the samples
+* @param[in, out] p_dN          the (weighted) number of accumulated samples
+* @param[in, out] p_vecMean     the mean
+* @param[in, out] p_matScatter  the scatter matrix sum (x - mean)*(x - mean)^T (lower triangle)
+*/
+static void updateScatter(const Ref<const MatrixXd>& p_matBlock, double p_dSign, double& p_dN, VectorXd& p_vecMean, MatrixXd& p_matScatter)
+{
+    double t_dNBlock = p_matBlock.cols();
+    if(t_dNBlock == 0)
+        return;
+
+    VectorXd t_vecMeanBlock = p_matBlock.rowwise().mean();
+    MatrixXd t_matCentered = p_matBlock.colwise() - t_vecMeanBlock;
+
+    double t_dNNew = p_dN + p_dSign * t_dNBlock;
+
+    if(t_dNNew <= 0.5) {
+        //window is empty -> start from zero to not accumulate rounding errors
+        p_dN = 0;
+        p_vecMean.setZero();
+        p_matScatter.setZero();
+        return;
+    }
+
+    if(p_dSign > 0) {
+        VectorXd t_vecDelta = t_vecMeanBlock - p_vecMean;
+        double t_dWeight = p_dN * t_dNBlock / t_dNNew;
+
+        p_vecMean += t_vecDelta * (t_dNBlock / t_dNNew);
+        p_matScatter.selfadjointView<Lower>().rankUpdate(t_matCentered, 1.0);
+        p_matScatter.selfadjointView<Lower>().rankUpdate(t_vecDelta, t_dWeight);
+    } else {
+        p_vecMean -= (t_vecMeanBlock - p_vecMean) * (t_dNBlock / t_dNNew);
+
+        VectorXd t_vecDelta = t_vecMeanBlock - p_vecMean;
+        double t_dWeight = t_dNNew * t_dNBlock / p_dN;
+
+        p_matScatter.selfadjointView<Lower>().rankUpdate(t_matCentered, -1.0);
+        p_matScatter.selfadjointView<Lower>().rankUpdate(t_vecDelta, -t_dWeight);
+    }
+
+    p_dN = t_dNNew;
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -72,6 +132,8 @@ RtCov::RtCov(qint32 p_iMaxSamples, FiffInfo::SPtr p_pFiffInfo, QObject *parent)
 : QThread(parent)
 , m_iMaxSamples(p_iMaxSamples)
 , m_iNewMaxSamples(0)
+, m_iEmitSamples(0)
+, m_estimationMode(SlidingWindow)
 , m_pFiffInfo(p_pFiffInfo)
 , m_bIsRunning(false)
 {
@@ -105,10 +167,29 @@ void RtCov::append(const MatrixXd &p_DataSegment)
 
 void RtCov::setSamples(qint32 samples)
 {
+    QMutexLocker locker(&mutex);
     m_iNewMaxSamples = samples;
 }
 
 
+//*************************************************************************************************************
+
+void RtCov::setEstimationMode(EstimationMode mode)
+{
+    QMutexLocker locker(&mutex);
+    m_estimationMode = mode;
+}
+
+
+//*************************************************************************************************************
+
+void RtCov::setEmitInterval(qint32 samples)
+{
+    QMutexLocker locker(&mutex);
+    m_iEmitSamples = samples > 0 ? samples : 0;
+}
+
+
 //*************************************************************************************************************
 
 bool RtCov::start()
@@ -117,6 +198,10 @@ bool RtCov::start()
     if(this->isRunning())
         QThread::wait();
 
+    //Drop the blocks and releases left over from the last run
+    if(m_pRawMatrixBuffer)
+        m_pRawMatrixBuffer->reset();
+
     m_bIsRunning = true;
     QThread::start();
 
@@ -143,42 +228,89 @@ bool RtCov::stop()
 void RtCov::run()
 {
     //SETUP
-    QStringList exclude;
-    for(int i = 0; i<m_pFiffInfo->chs.size(); i++) {
-        if(m_pFiffInfo->chs.at(i).kind == FIFFV_STIM_CH) {
-            exclude << m_pFiffInfo->chs.at(i).ch_name;
-        }
-    }
-    bool doProj = true;
+    initRegularization();
 
-    quint32 n_samples = 0;
+    EstimationMode t_mode = SlidingWindow;
+    quint32 t_iWindow = 0;
+    quint32 t_iEmit = 0;
 
-    FiffCov::SPtr cov(new FiffCov());
-    VectorXd mu;
+    //Accumulated (weighted) number of samples, mean and scatter matrix (lower triangle)
+    double t_dN = 0;
+    VectorXd t_vecMean;
+    MatrixXd t_matScatter;
+
+    //Samples of the sliding window and the number of already removed samples of the first block
+    QList<MatrixXd> t_qListWindow;
+    qint32 t_iFirstRemoved = 0;
+
+    quint32 t_iSamplesSeen = 0;
+    quint32 t_iSamplesSinceEmit = 0;
 
     while(m_bIsRunning)
     {
         if(m_pRawMatrixBuffer)
         {
-            MatrixXd rawSegment = m_pRawMatrixBuffer->pop();
+            //Borrow the block in place, it is handed back after it was accumulated
+            CircularMatrixBuffer<double>::ReadView rawSegment = m_pRawMatrixBuffer->beginRead();
 
-            if(n_samples == 0)
-            {
-                mu = rawSegment.rowwise().sum();
-                cov->data = rawSegment * rawSegment.transpose();
+            mutex.lock();
+            if(m_iNewMaxSamples > 0) {
+                m_iMaxSamples = m_iNewMaxSamples;
+                m_iNewMaxSamples = 0;
             }
-            else
-            {
-                mu.array() += rawSegment.rowwise().sum().array();
-                cov->data += rawSegment * rawSegment.transpose();
+            bool t_bReset = t_mode != m_estimationMode || t_vecMean.size() != rawSegment.rows();
+            t_mode = m_estimationMode;
+            t_iWindow = m_iMaxSamples > 1 ? m_iMaxSamples : 2;
+            t_iEmit = m_iEmitSamples > 0 ? m_iEmitSamples : t_iWindow;
+            mutex.unlock();
+
+            if(t_bReset) {
+                t_dN = 0;
+                t_vecMean = VectorXd::Zero(rawSegment.rows());
+                t_matScatter = MatrixXd::Zero(rawSegment.rows(), rawSegment.rows());
+                t_qListWindow.clear();
+                t_iFirstRemoved = 0;
+                t_iSamplesSeen = 0;
+                t_iSamplesSinceEmit = 0;
             }
-            n_samples += rawSegment.cols();
 
-            if(n_samples > m_iMaxSamples)
+            if(t_mode == SlidingWindow) {
+                updateScatter(rawSegment, 1.0, t_dN, t_vecMean, t_matScatter);
+                t_qListWindow.append(rawSegment);
+
+                //Remove the oldest samples which dropped out of the window, partial blocks included
+                while(t_dN > t_iWindow && !t_qListWindow.isEmpty()) {
+                    qint32 t_iAvailable = t_qListWindow.first().cols() - t_iFirstRemoved;
+                    qint32 t_iRemove = qMin(t_iAvailable, (qint32)(t_dN - t_iWindow));
+
+                    updateScatter(t_qListWindow.first().middleCols(t_iFirstRemoved, t_iRemove), -1.0, t_dN, t_vecMean, t_matScatter);
+
+                    t_iFirstRemoved += t_iRemove;
+                    if(t_iFirstRemoved == t_qListWindow.first().cols()) {
+                        t_qListWindow.removeFirst();
+                        t_iFirstRemoved = 0;
+                    }
+                }
+            } else {
+                //Forget with exp(-1/window) per sample before adding the new samples
+                double t_dForget = exp(-(double)rawSegment.cols() / (double)t_iWindow);
+                t_dN *= t_dForget;
+                t_matScatter.triangularView<Lower>() *= t_dForget;
+
+                updateScatter(rawSegment, 1.0, t_dN, t_vecMean, t_matScatter);
+            }
+
+            t_iSamplesSeen += rawSegment.cols();
+            t_iSamplesSinceEmit += rawSegment.cols();
+
+            m_pRawMatrixBuffer->endRead();
+
+            if(t_iSamplesSeen >= t_iWindow && t_iSamplesSinceEmit >= t_iEmit && t_dN > 1)
             {
-                mu /= (float)n_samples;
-                cov->data.array() -= n_samples * (mu * mu.transpose()).array();
-                cov->data.array() /= (n_samples - 1);
+                FiffCov::SPtr cov(new FiffCov());
+
+                cov->data = t_matScatter.selfadjointView<Lower>();
+                cov->data /= (t_dN - 1);
 
                 cov->kind = FIFFV_MNE_NOISE_COV;
                 cov->diag = false;
@@ -188,29 +320,126 @@ void RtCov::run()
                 cov->names = m_pFiffInfo->ch_names;
                 cov->projs = m_pFiffInfo->projs;
                 cov->bads = m_pFiffInfo->bads;
-                cov->nfree = n_samples;
+                cov->nfree = (fiff_int_t)(t_dN + 0.5);
+
+                // regularize noise covariance, the projectors may have been changed since the last estimate
+                if(projsChanged())
+                    initRegularization();
 
-                // regularize noise covariance
-                *cov.data() = cov->regularize(*m_pFiffInfo, 0.05, 0.05, 0.1, doProj, exclude);
+                regularize(cov->data);
 
                 emit covCalculated(cov);
 
-                cov = FiffCov::SPtr(new FiffCov());
-                n_samples = 0;
+                t_iSamplesSinceEmit = 0;
             }
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtCov::initRegularization()
+{
+    m_qListRegGroups.clear();
+    m_qListRegProjs = m_pFiffInfo->projs;
+
+    QStringList exclude;
+    for(int i = 0; i<m_pFiffInfo->chs.size(); i++) {
+        if(m_pFiffInfo->chs.at(i).kind == FIFFV_STIM_CH) {
+            exclude << m_pFiffInfo->chs.at(i).ch_name;
+        }
+    }
+
+    QList<FiffProj> t_listProjs = m_qListRegProjs;
+    FiffProj::activate_projs(t_listProjs);
+
+    QList<RowVectorXi> t_qListSel;
+    QList<double> t_qListReg;
+    t_qListSel << m_pFiffInfo->pick_types(false, true, false, defaultQStringList, exclude);
+    t_qListReg << 0.1;
+    t_qListSel << m_pFiffInfo->pick_types(QString("mag"), false, false, defaultQStringList, exclude);
+    t_qListReg << 0.05;
+    t_qListSel << m_pFiffInfo->pick_types(QString("grad"), false, false, defaultQStringList, exclude);
+    t_qListReg << 0.05;
+
+    for(int i = 0; i < t_qListSel.size(); ++i) {
+        if(t_qListSel[i].size() == 0) {
+            continue;
+        }
+
+        RegGroup t_group;
+        t_group.sel = t_qListSel[i];
+        t_group.reg = t_qListReg[i];
+
+        QStringList t_qListNames;
+        for(int k = 0; k < t_group.sel.size(); ++k) {
+            t_qListNames << m_pFiffInfo->ch_names[t_group.sel(k)];
+        }
+
+        t_group.ncomp = FiffProj::make_projector(t_listProjs, t_qListNames, t_group.proj);
+
+        m_qListRegGroups.append(t_group);
+    }
+}
 
 
-//            qint32 samples = rawSegment.cols();
-//            VectorXf mu = rawSegment.rowwise().sum().array() / (float)samples;
+//*************************************************************************************************************
+
+bool RtCov::projsChanged() const
+{
+    const QList<FiffProj>& t_listProjs = m_pFiffInfo->projs;
 
-//            MatrixXf noise_covariance = rawSegment * rawSegment.transpose();// noise_covariance == raw_covariance
-//            noise_covariance.array() -= samples * (mu * mu.transpose()).array();
-//            noise_covariance.array() /= (samples - 1);
+    if(t_listProjs.size() != m_qListRegProjs.size())
+        return true;
 
-//            std::cout << "Noise Covariance:\n" << noise_covariance.block(0,0,10,10) << std::endl;
+    for(int i = 0; i < t_listProjs.size(); ++i) {
+        const FiffProj& t_proj = t_listProjs[i];
+        const FiffProj& t_projReg = m_qListRegProjs[i];
 
-//            printf("%d raw buffer (%d x %d) generated\r\n", count, tmp.rows(), tmp.cols());
+        if(t_proj.kind != t_projReg.kind || t_proj.active != t_projReg.active || t_proj.desc != t_projReg.desc)
+            return true;
 
+        if(t_proj.data->col_names != t_projReg.data->col_names
+                || t_proj.data->data.rows() != t_projReg.data->data.rows()
+                || t_proj.data->data.cols() != t_projReg.data->data.cols()
+                || t_proj.data->data != t_projReg.data->data)
+            return true;
+    }
+
+    return false;
+}
+
+
+//*************************************************************************************************************
+
+void RtCov::regularize(MatrixXd& p_matCov) const
+{
+    for(int g = 0; g < m_qListRegGroups.size(); ++g) {
+        const RegGroup& t_group = m_qListRegGroups[g];
+        qint32 n = t_group.sel.size();
+
+        MatrixXd t_matC(n, n);
+        for(qint32 i = 0; i < n; ++i) {
+            for(qint32 j = 0; j < n; ++j) {
+                t_matC(i,j) = p_matCov(t_group.sel(i), t_group.sel(j));
+            }
+        }
+
+        if(t_group.ncomp > 0 && t_group.ncomp < n) {
+            //U*(U^T*C*U + reg*sigma*I)*U^T with U*U^T = P
+            t_matC = t_group.proj * (t_matC * t_group.proj);
+            double sigma = t_matC.trace() / (n - t_group.ncomp);
+            t_matC += (t_group.reg * sigma) * t_group.proj;
+        } else {
+            double sigma = t_matC.diagonal().mean();
+            t_matC.diagonal().array() += t_group.reg * sigma;
+        }
+
+        for(qint32 i = 0; i < n; ++i) {
+            for(qint32 j = 0; j < n; ++j) {
+                p_matCov(t_group.sel(i), t_group.sel(j)) = t_matC(i,j);
+            }
         }
     }
 }
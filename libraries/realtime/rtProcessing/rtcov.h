@@ -69,6 +69,7 @@
 #include <QThread>
 #include <QMutex>
 #include <QSharedPointer>
+#include <QList>
 
 
 //*************************************************************************************************************
@@ -111,11 +112,21 @@ public:
     typedef QSharedPointer<RtCov> SPtr;             /**< Shared pointer type for RtCov. */
     typedef QSharedPointer<const RtCov> ConstSPtr;  /**< Const shared pointer type for RtCov. */
 
+    //=========================================================================================================
+    /**
+    * Covariance estimation modes.
+    */
+    enum EstimationMode {
+        SlidingWindow,          /**< Exact covariance of the latest samples (the window). */
+        ExponentialForgetting   /**< Exponentially weighted covariance, the window is the time constant in samples. */
+    };
+
     //=========================================================================================================
     /**
     * Creates the real-time covariance estimation object.
     *
-    * @param[in] p_iMaxSamples      Number of samples to use for each data chunk
+    * @param[in] p_iMaxSamples      Number of samples to use for each estimate (window length). By default a
+    *                               covariance is emitted every p_iMaxSamples samples (non overlapping windows).
     * @param[in] p_pFiffInfo        Associated Fiff Information
     * @param[in] parent     Parent QObject (optional)
     */
@@ -145,12 +156,28 @@ public:
 
     //=========================================================================================================
     /**
-    * Set number of estimation samples
+    * Set number of estimation samples (window length or time constant of the exponential forgetting).
     *
     * @param[in] samples    estimation samples to set
     */
     void setSamples(qint32 samples);
 
+    //=========================================================================================================
+    /**
+    * Sets the estimation mode. Switching the mode restarts the estimation.
+    *
+    * @param[in] mode       the estimation mode to set
+    */
+    void setEstimationMode(EstimationMode mode);
+
+    //=========================================================================================================
+    /**
+    * Sets the number of samples between two emitted covariances, independently of the window length.
+    *
+    * @param[in] samples    emit interval in samples (0 = window length)
+    */
+    void setEmitInterval(qint32 samples);
+
     //=========================================================================================================
     /**
     * Starts the RtCov by starting the producer's thread.
@@ -186,17 +213,58 @@ protected:
     virtual void run();
 
 private:
+    //=========================================================================================================
+    /**
+    * Channel group which is regularized together (see FiffCov::regularize).
+    */
+    struct RegGroup {
+        RowVectorXi sel;        /**< Channel indices of the group. */
+        MatrixXd proj;          /**< SSP projector of the group channels. */
+        qint32 ncomp;           /**< Number of projection components. */
+        double reg;             /**< Regularization factor. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Prepares the regularization of the emitted covariances. The channel selections and SSP projectors are
+    * computed once and only rebuilt when the projectors of the measurement info change.
+    */
+    void initRegularization();
+
+    //=========================================================================================================
+    /**
+    * Checks whether the projectors of the measurement info differ from the ones the regularization was
+    * prepared with.
+    *
+    * @return true if the projectors changed, false otherwise
+    */
+    bool projsChanged() const;
+
+    //=========================================================================================================
+    /**
+    * Regularizes a covariance matrix like FiffCov::regularize(info, 0.05, 0.05, 0.1, true, stim channels).
+    * With the projector P the group covariance C becomes P*C*P + reg*sigma*P.
+    *
+    * @param[in, out] p_matCov  the covariance matrix to regularize
+    */
+    void regularize(MatrixXd& p_matCov) const;
+
     QMutex      mutex;                  /**< Provides access serialization between threads*/
 
     quint32      m_iMaxSamples;         /**< Maximal amount of samples received, before covariance is estimated.*/
 
     quint32      m_iNewMaxSamples;      /**< New maximal amount of samples received, before covariance is estimated.*/
+    quint32      m_iEmitSamples;        /**< Samples between two emitted covariances (0 = m_iMaxSamples).*/
+    EstimationMode m_estimationMode;    /**< The estimation mode.*/
 
     FiffInfo::SPtr  m_pFiffInfo;        /**< Holds the fiff measurement information. */
 
     bool        m_bIsRunning;           /**< Holds if real-time Covariance estimation is running.*/
 
     CircularMatrixBuffer<double>::SPtr m_pRawMatrixBuffer;   /**< The Circular Raw Matrix Buffer. */
+
+    QList<RegGroup> m_qListRegGroups;   /**< The channel groups to regularize. */
+    QList<FiffProj> m_qListRegProjs;    /**< The projectors of the measurement info m_qListRegGroups was prepared with. */
 };
 
 //*************************************************************************************************************
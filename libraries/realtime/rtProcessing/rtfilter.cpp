@@ -41,6 +41,14 @@
 #include "rtfilter.h"
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QThread>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -54,101 +62,252 @@ using namespace FIFFLIB;
 
 //*************************************************************************************************************
 //=============================================================================================================
-// DEFINE GLOBAL METHODS
+// DEFINE MEMBER METHODS
 //=============================================================================================================
 
-void doFilterPerChannelRTMSA(QPair<QList<FilterData>,QPair<int,RowVectorXd> > &channelDataTime)
+RtFilter::RtFilter()
 {
-    for(int i = 0; i < channelDataTime.first.size(); ++i) {
-        //channelDataTime.second.second = channelDataTime.first.at(i).applyConvFilter(channelDataTime.second.second, true, FilterData::ZeroPad);
-        channelDataTime.second.second = channelDataTime.first.at(i).applyFFTFilter(channelDataTime.second.second, true, FilterData::ZeroPad); //FFT Convolution for rt is not suitable. FFT make the signal filtering non causal.
-    }
 }
 
 
 //*************************************************************************************************************
-//=============================================================================================================
-// DEFINE MEMBER METHODS
-//=============================================================================================================
 
-RtFilter::RtFilter()
+RtFilter::~RtFilter()
 {
 }
 
 
 //*************************************************************************************************************
 
-RtFilter::~RtFilter()
+MatrixXd RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
 {
+    MatrixXd matDataOut;
+    filterBlock(m_engine, matDataIn, matDataOut, iMaxFilterLength, lFilterChannelList, lFilterData);
+    return matDataOut;
 }
 
 
 //*************************************************************************************************************
 
-MatrixXd RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
+void RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, MatrixXd& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
 {
-    //Initialise the overlay matrix
-    if(m_matOverlap.cols() != iMaxFilterLength || m_matOverlap.rows() < matDataIn.rows()) {
-        m_matOverlap.resize(matDataIn.rows(), iMaxFilterLength);
-        m_matOverlap.setZero();
-    }
+    filterBlock(m_engine, matDataIn, matDataOut, iMaxFilterLength, lFilterChannelList, lFilterData);
+}
 
-    if(m_matDelay.cols() != iMaxFilterLength/2 || m_matOverlap.rows() < matDataIn.rows()) {
-        m_matDelay.resize(matDataIn.rows(), iMaxFilterLength/2);
-        m_matDelay.setZero();
-    }
 
-    //Resize output matrix to match input matrix
-    MatrixXd matDataOut(matDataIn.rows(), matDataIn.cols());
+//*************************************************************************************************************
+
+MatrixXf RtFilter::filterChannelsConcurrently(const MatrixXf& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
+{
+    MatrixXf matDataOut;
+    filterBlock(m_engineFloat, matDataIn, matDataOut, iMaxFilterLength, lFilterChannelList, lFilterData);
+    return matDataOut;
+}
+
+
+//*************************************************************************************************************
+
+void RtFilter::filterChannelsConcurrently(const MatrixXf& matDataIn, MatrixXf& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
+{
+    filterBlock(m_engineFloat, matDataIn, matDataOut, iMaxFilterLength, lFilterChannelList, lFilterData);
+}
+
+
+//*************************************************************************************************************
+
+void RtFilter::reset()
+{
+    m_engine.matHistory.setZero();
+    m_engine.matDelay.setZero();
+    m_engineFloat.matHistory.setZero();
+    m_engineFloat.matDelay.setZero();
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void RtFilter::filterBlock(FilterEngine<T>& engine,
+                           const Matrix<T, Dynamic, Dynamic>& matDataIn,
+                           Matrix<T, Dynamic, Dynamic>& matDataOut,
+                           int iMaxFilterLength,
+                           const QVector<int>& lFilterChannelList,
+                           const QList<FilterData>& lFilterData)
+{
+    const int iRows = matDataIn.rows();
+    const int iCols = matDataIn.cols();
+
+    if(matDataOut.rows() != iRows || matDataOut.cols() != iCols)
+        matDataOut.resize(iRows, iCols);
 
-    //Generate QList structure which can be handled by the QConcurrent framework
-    QList<QPair<QList<FilterData>,QPair<int,RowVectorXd> > > timeData;
-    QList<int> notFilterChannelIndex;
+    if(iCols == 0)
+        return;
 
-    //Only select channels specified in lFilterChannelList
-    for(qint32 i = 0; i < matDataIn.rows(); ++i) {
-        int pos = lFilterChannelList.indexOf(i);
-        if(pos != -1 && pos < matDataIn.rows()) {
-            timeData.append(QPair<QList<FilterData>,QPair<int,RowVectorXd> >(lFilterData,QPair<int,RowVectorXd>(pos,matDataIn.row(pos))));
+    setupEngine(engine, iRows, iCols, iMaxFilterLength, lFilterChannelList, lFilterData);
+
+    //Filter the channels concurrently, each worker owns a contiguous range of the filtered channels
+    for(int i = 0; i < engine.workers.size(); ++i) {
+        engine.workers[i].pDataIn = &matDataIn;
+        engine.workers[i].pDataOut = &matDataOut;
+        engine.workers[i].pEngine = &engine;
+    }
+
+    if(engine.workers.size() == 1)
+        filterWorker(engine.workers[0]);
+    else if(engine.workers.size() > 1)
+        QtConcurrent::blockingMap(engine.workers, &RtFilter::filterWorker<T>);
+
+    //Delay the channels which are not filtered by half of the maximal filter length to keep them aligned
+    const int iDelay = engine.matDelay.rows();
+    for(int i = 0; i < engine.vecPassRows.size(); ++i) {
+        const int iRow = engine.vecPassRows[i];
+
+        if(iDelay == 0) {
+            matDataOut.row(iRow) = matDataIn.row(iRow);
+        } else if(iCols >= iDelay) {
+            matDataOut.row(iRow).head(iDelay) = engine.matDelay.col(i).transpose();
+            matDataOut.row(iRow).tail(iCols - iDelay) = matDataIn.row(iRow).head(iCols - iDelay);
+            engine.matDelay.col(i) = matDataIn.row(iRow).tail(iDelay).transpose();
         } else {
-            notFilterChannelIndex.append(i);
+            matDataOut.row(iRow) = engine.matDelay.col(i).head(iCols).transpose();
+            engine.matDelay.col(i).head(iDelay - iCols) = engine.matDelay.col(i).tail(iDelay - iCols).eval();
+            engine.matDelay.col(i).tail(iCols) = matDataIn.row(iRow).transpose();
         }
     }
+}
 
-    //Do the concurrent filtering
-    if(!timeData.isEmpty()) {
-        QFuture<void> future = QtConcurrent::map(timeData,
-                                             doFilterPerChannelRTMSA);
 
-        future.waitForFinished();
+//*************************************************************************************************************
 
-        //Do the overlap add method and store in matDataOut
-        int iFilteredNumberCols = timeData.at(0).second.second.cols();
+template<typename T>
+void RtFilter::setupEngine(FilterEngine<T>& engine,
+                           int iRows,
+                           int iBlockSize,
+                           int iMaxFilterLength,
+                           const QVector<int>& lFilterChannelList,
+                           const QList<FilterData>& lFilterData)
+{
+    //Compare against the current configuration, this costs O(channels + taps) and does not allocate
+    bool bFiltersChanged = engine.lCoeffs.size() != lFilterData.size();
+    for(int i = 0; !bFiltersChanged && i < lFilterData.size(); ++i)
+        bFiltersChanged = engine.lCoeffs[i].cols() != lFilterData[i].m_dCoeffA.cols()
+                          || engine.lCoeffs[i] != lFilterData[i].m_dCoeffA;
+
+    bool bChannelsChanged = bFiltersChanged
+                            || engine.iRows != iRows
+                            || engine.iMaxFilterLength != iMaxFilterLength
+                            || engine.lFilterChannelList != lFilterChannelList;
+
+    if(!bChannelsChanged && engine.iBlockSize == iBlockSize)
+        return;
+
+    if(bChannelsChanged) {
+        engine.lCoeffs.clear();
+        for(int i = 0; i < lFilterData.size(); ++i)
+            engine.lCoeffs.append(lFilterData[i].m_dCoeffA);
+        engine.lFilterChannelList = lFilterChannelList;
+        engine.iRows = iRows;
+        engine.iMaxFilterLength = iMaxFilterLength;
+
+        //The filters are applied in series, hence the combined kernel is their convolution
+        engine.vecKernel = RowVectorXd::Ones(1);
+        for(int i = 0; i < engine.lCoeffs.size(); ++i) {
+            const RowVectorXd& vecCoeffs = engine.lCoeffs[i];
+            if(vecCoeffs.cols() == 0)
+                continue;
+            RowVectorXd vecConv = RowVectorXd::Zero(engine.vecKernel.cols() + vecCoeffs.cols() - 1);
+            for(int k = 0; k < vecCoeffs.cols(); ++k)
+                vecConv.segment(k, engine.vecKernel.cols()) += vecCoeffs[k] * engine.vecKernel;
+            engine.vecKernel = vecConv;
+        }
 
-        for(int r = 0; r < timeData.size(); r++) {
-            //Get the currently filtered data. This data has a delay of filterLength/2 in front and back.
-            RowVectorXd tempData = timeData.at(r).second.second;
+        //Split the channels into filtered and delayed ones, a lookup table keeps this linear
+        QVector<bool> vecFilter(iRows, false);
+        if(!engine.lCoeffs.isEmpty())
+            for(int i = 0; i < lFilterChannelList.size(); ++i)
+                if(lFilterChannelList[i] >= 0 && lFilterChannelList[i] < iRows)
+                    vecFilter[lFilterChannelList[i]] = true;
+
+        int iNumFilter = vecFilter.count(true);
+        engine.vecFilterRows.resize(iNumFilter);
+        engine.vecPassRows.resize(iRows - iNumFilter);
+        for(int i = 0, f = 0, p = 0; i < iRows; ++i) {
+            if(vecFilter[i])
+                engine.vecFilterRows[f++] = i;
+            else
+                engine.vecPassRows[p++] = i;
+        }
 
-            //Perform the actual overlap add by adding the last filterlength data to the newly filtered one
-            tempData.head(iMaxFilterLength) += m_matOverlap.row(timeData.at(r).second.first);
+        engine.matHistory = Matrix<T, Dynamic, Dynamic>::Zero(engine.vecKernel.cols() - 1, iNumFilter);
+        engine.matDelay = Matrix<T, Dynamic, Dynamic>::Zero(qMax(iMaxFilterLength/2, 0), iRows - iNumFilter);
+        engine.iFFTLength = 0;
+    }
 
-            //Write the newly calulated filtered data to the filter data matrix. Keep in mind that the current block also effect last part of the last block (begin at dataIndex-iFilterDelay).
-            int start = 0;
-            matDataOut.row(timeData.at(r).second.first).segment(start,iFilteredNumberCols-iMaxFilterLength) = tempData.head(iFilteredNumberCols-iMaxFilterLength);
+    engine.iBlockSize = iBlockSize;
 
-            //Refresh the m_matOverlap with the new calculated filtered data.
-            m_matOverlap.row(timeData.at(r).second.first) = timeData.at(r).second.second.tail(iMaxFilterLength);
-        }
-    }
+    //The FFT has to hold the history plus one block, so the circular wrap around only hits the discarded part
+    const int iKernelLength = engine.vecKernel.cols();
+    int iFFTLength = 2;
+    while(iFFTLength < iBlockSize + iKernelLength - 1)
+        iFFTLength *= 2;
+
+    if(iFFTLength != engine.iFFTLength) {
+        engine.iFFTLength = iFFTLength;
 
-    //Fill filtered data with raw data if the channel was not filtered
-    for(int i = 0; i < notFilterChannelIndex.size(); ++i) {
-        matDataOut.row(notFilterChannelIndex.at(i)) << m_matDelay.row(notFilterChannelIndex.at(i)), matDataIn.row(notFilterChannelIndex.at(i)).head(matDataIn.cols() - iMaxFilterLength/2);
+        RowVectorXd vecKernelZeroPad = RowVectorXd::Zero(iFFTLength);
+        vecKernelZeroPad.head(iKernelLength) = engine.vecKernel;
 
-        //matDataOut.row(notFilterChannelIndex.at(i)).segment(0, matDataIn.row(notFilterChannelIndex.at(i)).cols()) = matDataIn.row(notFilterChannelIndex.at(i));
+        Eigen::FFT<double> fft;
+        fft.SetFlag(fft.HalfSpectrum);
+        RowVectorXcd vecSpectrum;
+        fft.fwd(vecSpectrum, vecKernelZeroPad);
+        engine.vecSpectrum = vecSpectrum.cast<std::complex<T> >();
     }
 
-    m_matDelay = matDataIn.block(0, matDataIn.cols()-iMaxFilterLength/2, matDataIn.rows(), iMaxFilterLength/2);
+    //One worker per thread, each with its own FFT object and buffers
+    const int iNumFilter = engine.vecFilterRows.size();
+    const int iNumWorkers = qMin(qMax(QThread::idealThreadCount(), 1), iNumFilter);
+
+    engine.workers.resize(iNumWorkers);
+    for(int i = 0; i < iNumWorkers; ++i) {
+        FilterWorker<T>& worker = engine.workers[i];
+        worker.fft.SetFlag(worker.fft.HalfSpectrum);
+        worker.vecTime.resize(iFFTLength);
+        worker.vecFreq.resize(iFFTLength/2 + 1);
+        worker.iFirst = (i * iNumFilter) / iNumWorkers;
+        worker.iLast = ((i + 1) * iNumFilter) / iNumWorkers;
+    }
+}
 
-    return matDataOut;
+
+//*************************************************************************************************************
+
+template<typename T>
+void RtFilter::filterWorker(FilterWorker<T>& worker)
+{
+    FilterEngine<T>& engine = *worker.pEngine;
+    const Matrix<T, Dynamic, Dynamic>& matDataIn = *worker.pDataIn;
+    Matrix<T, Dynamic, Dynamic>& matDataOut = *worker.pDataOut;
+
+    const int iCols = matDataIn.cols();
+    const int iHistory = engine.matHistory.rows();
+
+    for(int i = worker.iFirst; i < worker.iLast; ++i) {
+        const int iRow = engine.vecFilterRows[i];
+
+        //Assemble history and new block, the remainder is padded with zeros
+        worker.vecTime.head(iHistory) = engine.matHistory.col(i).transpose();
+        worker.vecTime.segment(iHistory, iCols) = matDataIn.row(iRow);
+        worker.vecTime.tail(engine.iFFTLength - iHistory - iCols).setZero();
+
+        //Keep the last samples as history for the next block
+        engine.matHistory.col(i) = worker.vecTime.segment(iCols, iHistory).transpose();
+
+        //Overlap-save: multiply with the kernel spectrum and keep the samples not affected by the wrap around
+        worker.fft.fwd(worker.vecFreq, worker.vecTime);
+        worker.vecFreq.array() *= engine.vecSpectrum.array();
+        worker.fft.inv(worker.vecTime, worker.vecFreq);
+
+        matDataOut.row(iRow) = worker.vecTime.segment(iHistory, iCols);
+    }
 }
@@ -82,9 +82,16 @@ namespace REALTIMELIB
 
 //=============================================================================================================
 /**
-* Real-time noise Spectrum estimation
+* Real-time multichannel FIR filtering. The filters of the filter list are combined into one kernel whose
+* spectrum is computed once, the data blocks are filtered with the overlap-save method. All state (spectrum,
+* FFT plans, channel histories and per worker scratch) persists between blocks and is only rebuilt when the
+* filters, the filtered channels or the block dimensions change, so filtering a block does not allocate.
+* The filtered channels are split into one contiguous range per worker and processed concurrently.
 *
-* @brief Real-time Noise estimation
+* The output is causal; channels which are not filtered are delayed by iMaxFilterLength/2 samples to stay
+* aligned with the filtered ones.
+*
+* @brief Real-time overlap-save FIR filtering
 */
 class REALTIMESHARED_EXPORT RtFilter
 {
@@ -95,13 +102,13 @@ public:
 
     //=========================================================================================================
     /**
-    * Creates the real-time covariance estimation object.
+    * Creates the real-time filter object.
     */
     explicit RtFilter();
 
     //=========================================================================================================
     /**
-    * Destroys the Real-time noise estimation object.
+    * Destroys the real-time filter object.
     */
     ~RtFilter();
 
@@ -109,18 +116,136 @@ public:
     /**
     * Calculates the filtered version of the raw input data
     *
-    * @param [in] matDataIn     data which is to be filtered
-    * @param [out] matDataOut    data which is to be filtered
-    * @param [in] iDataIndex    current position in the global data matrix
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [in] iMaxFilterLength      length of the longest filter, defines the delay of the unfiltered channels
+    * @param [in] lFilterChannelList    indices of the channels to filter
+    * @param [in] lFilterData           the filters to apply, they are applied in series
+    *
+    * @return the filtered data
     */
     Eigen::MatrixXd filterChannelsConcurrently(const Eigen::MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
 
-protected:
-    Eigen::MatrixXd                 m_matOverlap;                   /**< Last overlap block */
-    Eigen::MatrixXd                 m_matDelay;                     /**< Last delay block */
+    //=========================================================================================================
+    /**
+    * Calculates the filtered version of the raw input data into a caller provided matrix, which is only
+    * resized when its dimensions do not match the input.
+    *
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [out] matDataOut           the filtered data
+    * @param [in] iMaxFilterLength      length of the longest filter, defines the delay of the unfiltered channels
+    * @param [in] lFilterChannelList    indices of the channels to filter
+    * @param [in] lFilterData           the filters to apply, they are applied in series
+    */
+    void filterChannelsConcurrently(const Eigen::MatrixXd& matDataIn, Eigen::MatrixXd& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
+
+    //=========================================================================================================
+    /**
+    * Single precision version of filterChannelsConcurrently. Keeps its own state, so a float pipeline never
+    * converts to double.
+    *
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [in] iMaxFilterLength      length of the longest filter, defines the delay of the unfiltered channels
+    * @param [in] lFilterChannelList    indices of the channels to filter
+    * @param [in] lFilterData           the filters to apply, they are applied in series
+    *
+    * @return the filtered data
+    */
+    Eigen::MatrixXf filterChannelsConcurrently(const Eigen::MatrixXf& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
+
+    //=========================================================================================================
+    /**
+    * Single precision version of filterChannelsConcurrently writing into a caller provided matrix.
+    *
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [out] matDataOut           the filtered data
+    * @param [in] iMaxFilterLength      length of the longest filter, defines the delay of the unfiltered channels
+    * @param [in] lFilterChannelList    indices of the channels to filter
+    * @param [in] lFilterData           the filters to apply, they are applied in series
+    */
+    void filterChannelsConcurrently(const Eigen::MatrixXf& matDataIn, Eigen::MatrixXf& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
+
+    //=========================================================================================================
+    /**
+    * Resets the channel histories, e.g. after a discontinuity in the data stream.
+    */
+    void reset();
 
 private:
+    template<typename T> struct FilterEngine;
+
+    //=========================================================================================================
+    /**
+    * Scratch memory and channel range of one worker.
+    */
+    template<typename T>
+    struct FilterWorker {
+        Eigen::FFT<T>                                           fft;        /**< FFT object, keeps the plans between blocks. */
+        Eigen::Matrix<T, 1, Eigen::Dynamic>                     vecTime;    /**< Time domain work buffer of FFT length. */
+        Eigen::Matrix<std::complex<T>, 1, Eigen::Dynamic>       vecFreq;    /**< Half spectrum work buffer. */
+        int                                                     iFirst;     /**< First index into the filtered rows. */
+        int                                                     iLast;      /**< One past the last index into the filtered rows. */
+        const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>* pDataIn;    /**< The block being filtered. */
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>*       pDataOut;   /**< The filtered block. */
+        FilterEngine<T>*                                        pEngine;    /**< The engine the worker belongs to. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Overlap-save state for one precision.
+    */
+    template<typename T>
+    struct FilterEngine {
+        FilterEngine() : iRows(-1), iBlockSize(-1), iMaxFilterLength(-1), iFFTLength(0) {}
+
+        QList<Eigen::RowVectorXd>                           lCoeffs;            /**< Coefficients of the filters the engine was set up for. */
+        QVector<int>                                        lFilterChannelList; /**< The filter channel list the engine was set up for. */
+        int                                                 iRows;              /**< Number of channels. */
+        int                                                 iBlockSize;         /**< Number of samples per block. */
+        int                                                 iMaxFilterLength;   /**< The maximal filter length. */
+        Eigen::RowVectorXd                                  vecKernel;          /**< The combined kernel of all filters. */
+        int                                                 iFFTLength;         /**< FFT length. */
+        Eigen::VectorXi                                     vecFilterRows;      /**< Channels which are filtered. */
+        Eigen::VectorXi                                     vecPassRows;        /**< Channels which are only delayed. */
+        Eigen::Matrix<std::complex<T>, 1, Eigen::Dynamic>   vecSpectrum;        /**< Half spectrum of the combined kernel. */
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>    matHistory;         /**< Last kernel length - 1 input samples, one column per filtered channel. */
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>    matDelay;           /**< Last iMaxFilterLength/2 input samples, one column per delayed channel. */
+        QVector<FilterWorker<T> >                           workers;            /**< The workers. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Filters a block with the given engine, sets the engine up first if necessary.
+    */
+    template<typename T>
+    static void filterBlock(FilterEngine<T>& engine,
+                            const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matDataIn,
+                            Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matDataOut,
+                            int iMaxFilterLength,
+                            const QVector<int>& lFilterChannelList,
+                            const QList<UTILSLIB::FilterData>& lFilterData);
+
+    //=========================================================================================================
+    /**
+    * (Re)builds the engine state for the given configuration. The channel histories are kept if only the
+    * block size changed.
+    */
+    template<typename T>
+    static void setupEngine(FilterEngine<T>& engine,
+                            int iRows,
+                            int iBlockSize,
+                            int iMaxFilterLength,
+                            const QVector<int>& lFilterChannelList,
+                            const QList<UTILSLIB::FilterData>& lFilterData);
+
+    //=========================================================================================================
+    /**
+    * Filters the channel range of one worker, called concurrently.
+    */
+    template<typename T>
+    static void filterWorker(FilterWorker<T>& worker);
 
+    FilterEngine<double>            m_engine;           /**< Double precision filter state. */
+    FilterEngine<float>             m_engineFloat;      /**< Single precision filter state. */
 };
 
 //*************************************************************************************************************
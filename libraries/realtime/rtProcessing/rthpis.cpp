@@ -44,7 +44,6 @@
 
 #include "rthpis.h"
 
-#include <inverse/hpiFit/hpifit.h>
 #include <fiff/fiff_info.h>
 
 
@@ -89,13 +88,13 @@ void RtHPISWorker::doWork(const Eigen::MatrixXd& matData,
     fitResult.devHeadTrans.from = 1;
     fitResult.devHeadTrans.to = 4;
 
-    HPIFit::fitHPI(matData,
-                    m_matProjectors,
-                    fitResult.devHeadTrans,
-                    vFreqs,
-                    fitResult.errorDistances,
-                    fitResult.fittedCoils,
-                    pFiffInfo);
+    m_hpiFit.fit(matData,
+                 m_matProjectors,
+                 fitResult.devHeadTrans,
+                 vFreqs,
+                 fitResult.errorDistances,
+                 fitResult.fittedCoils,
+                 pFiffInfo);
 
     emit resultReady(fitResult);
 }
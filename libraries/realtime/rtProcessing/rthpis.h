@@ -51,6 +51,8 @@
 #include <fiff/fiff_dig_point.h>
 #include <fiff/fiff_coord_trans.h>
 
+#include <inverse/hpiFit/hpifit.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -129,6 +131,9 @@ public:
                 const QVector<int>& vFreqs,
                 QSharedPointer<FIFFLIB::FiffInfo> pFiffInfo);
 
+protected:
+    INVERSELIB::HPIFit      m_hpiFit;       /**< The fitting session, kept alive to reuse cached quantities and previous coil positions. */
+
 signals:
     void resultReady(const REALTIMELIB::FittingResult &fitResult);
 };
@@ -48,6 +48,24 @@
 //=============================================================================================================
 
 #include <QDebug>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+#include <cmath>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Eigenvalues>
 
 
 //*************************************************************************************************************
@@ -68,6 +86,7 @@ RtInvOp::RtInvOp(FiffInfo::SPtr &p_pFiffInfo, MNEForwardSolution::SPtr &p_pFwd,
 , m_bIsRunning(false)
 , m_pFiffInfo(p_pFiffInfo)
 , m_pFwd(p_pFwd)
+, m_iLastUpdateLatency(-1)
 {
     qRegisterMetaType<MNEInverseOperator::SPtr>("MNEInverseOperator::SPtr");
 }
@@ -112,19 +131,117 @@ void RtInvOp::run()
 {
     m_bIsRunning = true;
 
+    // Restrict forward solution as necessary for MEG
+    MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
+
+    QElapsedTimer timer;
+
     while(m_bIsRunning)
     {
         if(m_vecNoiseCov.size() > 0)
         {
-            // Restrict forward solution as necessary for MEG
-            MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
-
             mutex.lock();
-            MNEInverseOperator::SPtr t_invOpMeg(new MNEInverseOperator(*m_pFiffInfo.data(), t_forwardMeg, m_vecNoiseCov[0], 0.2f, 0.8f));
+            FiffCov t_noiseCov = m_vecNoiseCov[0];
             m_vecNoiseCov.pop_front();
             mutex.unlock();
 
+            timer.start();
+            MNEInverseOperator::SPtr t_invOpMeg = updateInvOp(t_forwardMeg, t_noiseCov);
+            m_iLastUpdateLatency.store(int(timer.elapsed()));
+
             emit invOperatorCalculated(t_invOpMeg);
         }
+        else
+        {
+            msleep(10);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperator::SPtr RtInvOp::updateInvOp(const MNEForwardSolution& p_forward, const FiffCov& p_noiseCov)
+{
+    FiffInfo t_gainInfo;
+    MatrixXd t_gain;
+    MatrixXd t_whitener;
+    qint32 t_iNumNonZero;
+    FiffCov t_outNoiseCov;
+    p_forward.prepare_forward(*m_pFiffInfo.data(), p_noiseCov, false, t_gainInfo, t_gain, t_outNoiseCov, t_whitener, t_iNumNonZero);
+
+    //
+    // Full computation, the depth and orientation priors only depend on the forward solution and are kept
+    //
+    if(!m_pInvOpFull || t_gainInfo.ch_names != m_lChNamesFull || t_iNumNonZero == 0)
+    {
+        m_pInvOpFull = MNEInverseOperator::SPtr(new MNEInverseOperator(*m_pFiffInfo.data(), p_forward, p_noiseCov, 0.2f, 0.8f));
+        m_lChNamesFull = t_gainInfo.ch_names;
+
+        VectorXd t_vecSourceStd = m_pInvOpFull->source_cov->data.col(0).array().sqrt();
+        m_matGainWeighted = t_gain * t_vecSourceStd.asDiagonal();
+
+        m_matGainWeightedGram = MatrixXd::Zero(m_matGainWeighted.rows(), m_matGainWeighted.rows());
+        m_matGainWeightedGram.selfadjointView<Lower>().rankUpdate(m_matGainWeighted);
+        m_matGainWeightedGram.triangularView<StrictlyUpper>() = m_matGainWeightedGram.transpose();
+
+        return m_pInvOpFull;
+    }
+
+    //
+    // Incremental update, rescale the source covariance so that trace(G*R*G') equals the rank again
+    //
+    MatrixXd t_matGram = t_whitener * m_matGainWeightedGram * t_whitener.transpose();
+    double t_dScaling = (double)t_iNumNonZero / t_matGram.trace();
+    t_matGram *= t_dScaling;
+
+    //
+    // SVD of the whitened and weighted gain G = U*S*V' from the eigen decomposition of G*G' = U*S^2*U'
+    //
+    SelfAdjointEigenSolver<MatrixXd> t_eig(t_matGram);
+
+    qint32 t_iNumSing = t_eig.eigenvalues().size();
+    VectorXd t_vecSing(t_iNumSing);
+    MatrixXd t_matU(t_matGram.rows(), t_iNumSing);
+
+    for(qint32 i = 0; i < t_iNumSing; ++i)
+    {
+        // Sort descending, as the SVD does
+        t_vecSing[i] = std::sqrt(std::max(t_eig.eigenvalues()[t_iNumSing-1-i], 0.0));
+        t_matU.col(i) = t_eig.eigenvectors().col(t_iNumSing-1-i);
     }
+
+    // V = G'*U*S^-1, components in the null space of the whitener do not contribute to the inverse
+    double t_dTol = t_iNumSing > 0 ? t_vecSing[0] * 1e-10 : 0.0;
+    MatrixXd t_matB = std::sqrt(t_dScaling) * t_whitener.transpose() * t_matU;
+
+    for(qint32 i = 0; i < t_iNumSing; ++i)
+    {
+        if(t_vecSing[i] > t_dTol)
+            t_matB.col(i) /= t_vecSing[i];
+        else
+            t_matB.col(i).setZero();
+    }
+
+    MatrixXd t_matV = m_matGainWeighted.transpose() * t_matB;
+
+    MNEInverseOperator::SPtr t_pInvOp(new MNEInverseOperator(*m_pInvOpFull));
+
+    t_pInvOp->eigen_fields = FiffNamedMatrix::SDPtr(new FiffNamedMatrix(t_matU.cols(),
+                                                                        t_matU.rows(),
+                                                                        defaultQStringList,
+                                                                        t_gainInfo.ch_names,
+                                                                        t_matU.transpose()));
+    t_pInvOp->eigen_leads = FiffNamedMatrix::SDPtr(new FiffNamedMatrix(t_matV.rows(),
+                                                                       t_matV.cols(),
+                                                                       defaultQStringList,
+                                                                       defaultQStringList,
+                                                                       t_matV));
+    t_pInvOp->sing = t_vecSing;
+    t_pInvOp->noise_cov = FiffCov::SDPtr(new FiffCov(t_outNoiseCov));
+    t_pInvOp->source_cov->data *= t_dScaling;
+    t_pInvOp->projs = m_pFiffInfo->projs;
+    t_pInvOp->info.bads = m_pFiffInfo->bads;
+
+    return t_pInvOp;
 }
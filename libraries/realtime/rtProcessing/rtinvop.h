@@ -67,6 +67,7 @@
 
 #include <QThread>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QSharedPointer>
 
 
@@ -150,6 +151,14 @@ public:
     */
     inline bool isRunning();
 
+    //=========================================================================================================
+    /**
+    * Returns the time it took to calculate the last inverse operator.
+    *
+    * @return the latency of the last inverse operator update in milliseconds, -1 if none was calculated yet
+    */
+    inline qint64 getLastUpdateLatency() const;
+
 signals:
     //=========================================================================================================
     /**
@@ -168,6 +177,20 @@ protected:
     */
     virtual void run();
 
+    //=========================================================================================================
+    /**
+    * Calculates the inverse operator for a new noise covariance. The first call and calls with a changed
+    * channel selection run the full make_inverse_operator and cache the source weighted gain matrix. All other
+    * calls only recompute the whitener and obtain the SVD of the whitened gain from the eigen decomposition of
+    * its (channels x channels) Gram matrix, which is formed from the cached Gram matrix of the weighted gain.
+    *
+    * @param[in] p_forward      The forward solution.
+    * @param[in] p_noiseCov     The new noise covariance.
+    *
+    * @return the inverse operator
+    */
+    MNEInverseOperator::SPtr updateInvOp(const MNEForwardSolution& p_forward, const FiffCov& p_noiseCov);
+
 private:
     QMutex      mutex;                  /**< Provides access serialization between threads. */
     bool        m_bIsRunning;           /**< Whether RtInv is running. */
@@ -176,6 +199,12 @@ private:
 
     FiffInfo::SPtr m_pFiffInfo;         /**< The fiff measurement information. */
     MNEForwardSolution::SPtr m_pFwd;    /**< The forward solution. */
+
+    MNEInverseOperator::SPtr m_pInvOpFull;  /**< The last fully computed inverse operator. Its forward dependent parts are reused. */
+    QStringList m_lChNamesFull;             /**< The channels used by m_pInvOpFull. */
+    MatrixXd m_matGainWeighted;             /**< The gain matrix weighted with the source standard deviations of m_pInvOpFull. */
+    MatrixXd m_matGainWeightedGram;         /**< m_matGainWeighted * m_matGainWeighted^T. */
+    QAtomicInt m_iLastUpdateLatency;        /**< The latency of the last inverse operator update in milliseconds, written by run(). */
 };
 
 //*************************************************************************************************************
@@ -188,6 +217,14 @@ inline bool RtInvOp::isRunning()
     return m_bIsRunning;
 }
 
+
+//*************************************************************************************************************
+
+inline qint64 RtInvOp::getLastUpdateLatency() const
+{
+    return m_iLastUpdateLatency.load();
+}
+
 } // NAMESPACE
 
 #ifndef metatype_mneinverseoperatorsptr
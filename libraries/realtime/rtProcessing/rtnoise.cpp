@@ -205,7 +205,7 @@ void RtNoise::run()
     {
         if(m_pRawMatrixBuffer)
         {
-            MatrixXd block = m_pRawMatrixBuffer->pop();
+            CircularMatrixBuffer<double>::ReadView block = m_pRawMatrixBuffer->beginRead();
 
             if(FirstStart){
                 //init the circ buffer and parameters
@@ -220,10 +220,9 @@ void RtNoise::run()
                 FirstStart = false;
             }
             //concate blocks
-            for (int i=0; i< m_iSensors; i++)
-                for (int j=0; j< m_iBlockSize; j++)
-                    m_matCircBuf(i,j+m_iBlockIndex*m_iBlockSize) = block(i,j);
+            m_matCircBuf.block(0, m_iBlockIndex*m_iBlockSize, m_iSensors, m_iBlockSize) = block.topLeftCorner(m_iSensors, m_iBlockSize);
 
+            m_pRawMatrixBuffer->endRead();
 
             m_iBlockIndex ++;
             if (m_iBlockIndex >= m_iNumOfBlocks){
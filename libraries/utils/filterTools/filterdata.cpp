@@ -227,68 +227,108 @@ void FilterData::fftTransformCoeffs()
 
 RowVectorXd FilterData::applyConvFilter(const RowVectorXd& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
 {
-    if(data.cols()<m_dCoeffA.cols() && compensateEdgeEffects==MirrorData){
-        qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(m_dCoeffA.cols()).arg(data.cols());
+    return convFilter(data, m_dCoeffA, keepOverhead, compensateEdgeEffects);
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXf FilterData::applyConvFilter(const RowVectorXf& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
+{
+    //The coefficients are public and may be reassigned, so the single precision copy is made per call
+    return convFilter(data, RowVectorXf(m_dCoeffA.cast<float>()), keepOverhead, compensateEdgeEffects);
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
+{
+    return fftFilter(data, m_dFFTCoeffA, keepOverhead, compensateEdgeEffects);
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXf FilterData::applyFFTFilter(const RowVectorXf& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
+{
+    //The coefficients are public and may be reassigned, so the single precision copy is made per call
+    return fftFilter(data, RowVectorXcf(m_dFFTCoeffA.cast<std::complex<float> >()), keepOverhead, compensateEdgeEffects);
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+Matrix<T, 1, Dynamic> FilterData::convFilter(const Matrix<T, 1, Dynamic>& data, const Matrix<T, 1, Dynamic>& coeffA, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
+{
+    typedef Matrix<T, 1, Dynamic> RowVectorXt;
+
+    if(data.cols()<coeffA.cols() && compensateEdgeEffects==MirrorData){
+        qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(coeffA.cols()).arg(data.cols());
         return data;
     }
 
     //Do zero padding or mirroring depending on user input
-    RowVectorXd t_dataZeroPad = RowVectorXd::Zero(2*m_dCoeffA.cols() + data.cols());
-    RowVectorXd t_filteredTime = RowVectorXd::Zero(2*m_dCoeffA.cols() + data.cols());
+    RowVectorXt t_dataZeroPad = RowVectorXt::Zero(2*coeffA.cols() + data.cols());
+    RowVectorXt t_filteredTime = RowVectorXt::Zero(2*coeffA.cols() + data.cols());
 
     switch(compensateEdgeEffects) {
         case MirrorData:
-            t_dataZeroPad.head(m_dCoeffA.cols()) = data.head(m_dCoeffA.cols()).reverse();   //front
-            t_dataZeroPad.segment(m_dCoeffA.cols(), data.cols()) = data;                    //middle
-            t_dataZeroPad.tail(m_dCoeffA.cols()) = data.tail(m_dCoeffA.cols()).reverse();   //back
+            t_dataZeroPad.head(coeffA.cols()) = data.head(coeffA.cols()).reverse();   //front
+            t_dataZeroPad.segment(coeffA.cols(), data.cols()) = data;                 //middle
+            t_dataZeroPad.tail(coeffA.cols()) = data.tail(coeffA.cols()).reverse();   //back
             break;
 
         case ZeroPad:
-            t_dataZeroPad.segment(m_dCoeffA.cols(), data.cols()) = data;
+            t_dataZeroPad.segment(coeffA.cols(), data.cols()) = data;
             break;
 
         default:
-            t_dataZeroPad.segment(m_dCoeffA.cols(), data.cols()) = data;
+            t_dataZeroPad.segment(coeffA.cols(), data.cols()) = data;
             break;
     }
 
     //Do the convolution
-    for(int i=m_dCoeffA.cols(); i<t_filteredTime.cols(); i++)
-        t_filteredTime(i-m_dCoeffA.cols()) = t_dataZeroPad.segment(i-m_dCoeffA.cols(),m_dCoeffA.cols()) * m_dCoeffA.transpose();
+    for(int i=coeffA.cols(); i<t_filteredTime.cols(); i++)
+        t_filteredTime(i-coeffA.cols()) = t_dataZeroPad.segment(i-coeffA.cols(),coeffA.cols()) * coeffA.transpose();
 
     //Return filtered data
     if(!keepOverhead)
-        return t_filteredTime.segment(m_dCoeffA.cols()/2, data.cols());
+        return t_filteredTime.segment(coeffA.cols()/2, data.cols());
 
-    return t_filteredTime.head(data.cols()+m_dCoeffA.cols());
+    return t_filteredTime.head(data.cols()+coeffA.cols());
 }
 
 
 //*************************************************************************************************************
 
-RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
+template<typename T>
+Matrix<T, 1, Dynamic> FilterData::fftFilter(const Matrix<T, 1, Dynamic>& data, const Matrix<std::complex<T>, 1, Dynamic>& fftCoeffA, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
 {
-    if(data.cols()<m_dCoeffA.cols() && compensateEdgeEffects==MirrorData) {
-        qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(m_dCoeffA.cols()).arg(data.cols());
+    typedef Matrix<T, 1, Dynamic> RowVectorXt;
+    typedef Matrix<std::complex<T>, 1, Dynamic> RowVectorXct;
+
+    const int iTaps = m_dCoeffA.cols();
+
+    if(data.cols()<iTaps && compensateEdgeEffects==MirrorData) {
+        qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(iTaps).arg(data.cols());
         return data;
     }
 
-//    std::cout<<"m_iFFTlength: "<<m_iFFTlength<<std::endl;
-//    std::cout<<"2*m_dCoeffA.cols() + data.cols(): "<<2*m_dCoeffA.cols() + data.cols()<<std::endl;
-
-    if(2*m_dCoeffA.cols() + data.cols()>m_iFFTlength) {
+    if(2*iTaps + data.cols()>m_iFFTlength) {
         qDebug()<<"Error in FilterData: Number of mirroring/zeropadding size plus data size is bigger then fft length!";
         return data;
     }
 
     //Do zero padding or mirroring depending on user input
-    RowVectorXd t_dataZeroPad = RowVectorXd::Zero(m_iFFTlength);
+    RowVectorXt t_dataZeroPad = RowVectorXt::Zero(m_iFFTlength);
 
     switch(compensateEdgeEffects) {
         case MirrorData:
-            t_dataZeroPad.head(m_dCoeffA.cols()) = data.head(m_dCoeffA.cols()).reverse();   //front
-            t_dataZeroPad.segment(m_dCoeffA.cols(), data.cols()) = data;                    //middle
-            t_dataZeroPad.tail(m_dCoeffA.cols()) = data.tail(m_dCoeffA.cols()).reverse();   //back
+            t_dataZeroPad.head(iTaps) = data.head(iTaps).reverse();   //front
+            t_dataZeroPad.segment(iTaps, data.cols()) = data;         //middle
+            t_dataZeroPad.tail(iTaps) = data.tail(iTaps).reverse();   //back
             break;
 
         case ZeroPad:
@@ -301,25 +341,25 @@ RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhea
     }
 
     //generate fft object
-    Eigen::FFT<double> fft;
+    Eigen::FFT<T> fft;
     fft.SetFlag(fft.HalfSpectrum);
 
     //fft-transform data sequence
-    RowVectorXcd t_freqData;
+    RowVectorXct t_freqData;
     fft.fwd(t_freqData,t_dataZeroPad);
 
     //perform frequency-domain filtering
-    RowVectorXcd t_filteredFreq = m_dFFTCoeffA.array()*t_freqData.array();
+    RowVectorXct t_filteredFreq = fftCoeffA.array()*t_freqData.array();
 
     //inverse-FFT
-    RowVectorXd t_filteredTime;
+    RowVectorXt t_filteredTime;
     fft.inv(t_filteredTime,t_filteredFreq);
 
     //Return filtered data
     if(!keepOverhead)
-        return t_filteredTime.segment(m_dCoeffA.cols()/2, data.cols());
+        return t_filteredTime.segment(iTaps/2, data.cols());
 
-    return t_filteredTime.head(data.cols()+m_dCoeffA.cols());
+    return t_filteredTime.head(data.cols()+iTaps);
 }
 
 
@@ -169,6 +169,29 @@ public:
     */
     RowVectorXd applyFFTFilter(const RowVectorXd& data, bool keepOverhead = false, CompensateEdgeEffects compensateEdgeEffects = MirrorData) const;
 
+    /**
+    * Single precision version of applyConvFilter. The current m_dCoeffA is converted to single precision per call.
+    *
+    * @param [in] data holds the data to be filtered
+    * @param [in] keepOverhead whether the result should still include the overhead information in front and back of the data
+    * @param [in] compensateEdgeEffects defines how the edge effects should be handlted. Choose between ZeroPad and Mirroring
+    *
+    * @return the filtered data in form of a RowVectorXf
+    */
+    RowVectorXf applyConvFilter(const RowVectorXf& data, bool keepOverhead = false, CompensateEdgeEffects compensateEdgeEffects = MirrorData) const;
+
+    /**
+    * Single precision version of applyFFTFilter. The FFT is computed in single precision, the current
+    * m_dFFTCoeffA is converted to single precision per call.
+    *
+    * @param [in] data holds the data to be filtered
+    * @param [in] keepOverhead whether the result should still include the overhead information in front and back of the data
+    * @param [in] compensateEdgeEffects defines how the edge effects should be handlted. Choose between ZeroPad and Mirroring
+    *
+    * @return the filtered data in form of a RowVectorXf
+    */
+    RowVectorXf applyFFTFilter(const RowVectorXf& data, bool keepOverhead = false, CompensateEdgeEffects compensateEdgeEffects = MirrorData) const;
+
     /**
      * @brief getStringForDesignMethod returns the current design method as a string
      */
@@ -206,6 +229,19 @@ public:
 
     RowVectorXcd    m_dFFTCoeffA;       /**< the FFT-transformed forward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
     RowVectorXcd    m_dFFTCoeffB;       /**< the FFT-transformed backward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
+
+private:
+    /**
+    * Time domain convolution shared by the double and single precision versions of applyConvFilter.
+    */
+    template<typename T>
+    Matrix<T, 1, Dynamic> convFilter(const Matrix<T, 1, Dynamic>& data, const Matrix<T, 1, Dynamic>& coeffA, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const;
+
+    /**
+    * Frequency domain filtering shared by the double and single precision versions of applyFFTFilter.
+    */
+    template<typename T>
+    Matrix<T, 1, Dynamic> fftFilter(const Matrix<T, 1, Dynamic>& data, const Matrix<std::complex<T>, 1, Dynamic>& fftCoeffA, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const;
 };
 
 //*************************************************************************************************************
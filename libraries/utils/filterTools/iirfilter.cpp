@@ -0,0 +1,639 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Christoph Dinh <chdinh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Christoph Dinh. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the IirFilter class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "iirfilter.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL DESIGN FUNCTIONS
+//=============================================================================================================
+
+namespace
+{
+
+typedef std::complex<double> Complex;
+
+const double PI = 3.14159265358979323846;
+const Complex J(0.0, 1.0);
+
+//=============================================================================================================
+/**
+* Zeros, poles and gain of a transfer function.
+*/
+struct Zpk
+{
+    QVector<Complex>    z;
+    QVector<Complex>    p;
+    double              k;
+};
+
+//=============================================================================================================
+/**
+* Descending Landen sequence of the elliptic modulus k, see S. J. Orfanidis, "Lecture Notes on Elliptic
+* Filter Design", 2006.
+*/
+QVector<double> landen(double k)
+{
+    QVector<double> v;
+    while(k > 1e-15 && v.size() < 16) {
+        double kp = std::sqrt(1.0 - k*k);
+        k = std::pow(k / (1.0 + kp), 2);
+        v.append(k);
+    }
+    return v;
+}
+
+//=============================================================================================================
+/**
+* Jacobi elliptic function cd(u*K, k) for complex u, evaluated via the Landen sequence.
+*/
+Complex cde(const Complex& u, const QVector<double>& v)
+{
+    Complex w = std::cos(u * PI / 2.0);
+    for(int n = v.size() - 1; n >= 0; --n)
+        w = (1.0 + v[n]) * w / (1.0 + v[n] * w * w);
+    return w;
+}
+
+//=============================================================================================================
+/**
+* Jacobi elliptic function sn(u*K, k) for complex u, evaluated via the Landen sequence.
+*/
+Complex sne(const Complex& u, const QVector<double>& v)
+{
+    Complex w = std::sin(u * PI / 2.0);
+    for(int n = v.size() - 1; n >= 0; --n)
+        w = (1.0 + v[n]) * w / (1.0 + v[n] * w * w);
+    return w;
+}
+
+//=============================================================================================================
+/**
+* Inverse of sn(u*K, k), returns u.
+*/
+Complex asne(Complex w, double k)
+{
+    QVector<double> v = landen(k);
+    for(int n = 0; n < v.size(); ++n) {
+        double v1 = n == 0 ? k : v[n-1];
+        w = w / (1.0 + std::sqrt(1.0 - w * w * v1 * v1)) * 2.0 / (1.0 + v[n]);
+    }
+    return 1.0 - 2.0 * std::acos(w) / PI;
+}
+
+//=============================================================================================================
+/**
+* Solves the degree equation for the selectivity modulus k given the order and the discrimination modulus k1.
+*/
+double ellipdeg(int N, double k1)
+{
+    double k1p = std::sqrt(1.0 - k1*k1);
+    QVector<double> v = landen(k1p);
+    double prod = 1.0;
+    for(int i = 1; i <= N/2; ++i)
+        prod *= std::real(sne(Complex((2.0*i - 1.0) / N, 0.0), v));
+    double kp = std::pow(k1p, N) * std::pow(prod, 4);
+    return std::sqrt(1.0 - kp*kp);
+}
+
+//=============================================================================================================
+/**
+* Analog low-pass prototypes with the pass band edge at 1 rad/s.
+*/
+Zpk butterworthPrototype(int N)
+{
+    Zpk zpk;
+    for(int i = 1; i <= N; ++i)
+        zpk.p.append(std::exp(J * PI * double(2*i + N - 1) / double(2*N)));
+    zpk.k = 1.0;
+    return zpk;
+}
+
+Zpk chebyshevPrototype(int N, double dPassRipple)
+{
+    Zpk zpk;
+    double ep = std::sqrt(std::pow(10.0, dPassRipple / 10.0) - 1.0);
+    double v0 = std::asinh(1.0 / ep) / N;
+    Complex prod = 1.0;
+    for(int i = 1; i <= N; ++i) {
+        double theta = PI * (2.0*i - 1.0) / (2.0*N);
+        zpk.p.append(Complex(-std::sinh(v0) * std::sin(theta), std::cosh(v0) * std::cos(theta)));
+        prod *= -zpk.p.last();
+    }
+    zpk.k = std::real(prod) * (N % 2 == 0 ? 1.0 / std::sqrt(1.0 + ep*ep) : 1.0);
+    return zpk;
+}
+
+Zpk ellipticPrototype(int N, double dPassRipple, double dStopAtten)
+{
+    Zpk zpk;
+    double ep = std::sqrt(std::pow(10.0, dPassRipple / 10.0) - 1.0);
+    double es = std::sqrt(std::pow(10.0, dStopAtten / 10.0) - 1.0);
+    double k1 = ep / es;
+    double k = ellipdeg(N, k1);
+    QVector<double> v = landen(k);
+
+    double v0 = std::real(-J * asne(J / ep, k1) / double(N));
+
+    for(int i = 1; i <= N/2; ++i) {
+        double ui = (2.0*i - 1.0) / N;
+        Complex zeta = cde(Complex(ui, 0.0), v);
+        Complex z = J / (k * zeta);
+        zpk.z.append(z);
+        zpk.z.append(std::conj(z));
+
+        Complex p = J * cde(Complex(ui, -v0), v);
+        zpk.p.append(p);
+        zpk.p.append(std::conj(p));
+    }
+    if(N % 2 == 1)
+        zpk.p.append(Complex(std::real(J * sne(Complex(0.0, v0), v)), 0.0));
+
+    //Normalize to unit gain (odd order) or 1/sqrt(1+ep^2) (even order) at DC
+    Complex prod = 1.0;
+    for(int i = 0; i < zpk.p.size(); ++i)
+        prod *= -zpk.p[i];
+    for(int i = 0; i < zpk.z.size(); ++i)
+        prod /= -zpk.z[i];
+    zpk.k = std::real(prod) * (N % 2 == 0 ? 1.0 / std::sqrt(1.0 + ep*ep) : 1.0);
+    return zpk;
+}
+
+//=============================================================================================================
+/**
+* Product of (c - x) over all roots.
+*/
+Complex prodDiff(const QVector<Complex>& roots, const Complex& c)
+{
+    Complex prod = 1.0;
+    for(int i = 0; i < roots.size(); ++i)
+        prod *= c - roots[i];
+    return prod;
+}
+
+//=============================================================================================================
+/**
+* Analog frequency transformations of a low-pass prototype.
+*/
+void lp2lp(Zpk& zpk, double wo)
+{
+    for(int i = 0; i < zpk.z.size(); ++i)
+        zpk.z[i] *= wo;
+    for(int i = 0; i < zpk.p.size(); ++i)
+        zpk.p[i] *= wo;
+    zpk.k *= std::pow(wo, zpk.p.size() - zpk.z.size());
+}
+
+void lp2hp(Zpk& zpk, double wo)
+{
+    int degree = zpk.p.size() - zpk.z.size();
+    zpk.k *= std::real(prodDiff(zpk.z, 0.0) / prodDiff(zpk.p, 0.0));
+    for(int i = 0; i < zpk.z.size(); ++i)
+        zpk.z[i] = wo / zpk.z[i];
+    for(int i = 0; i < zpk.p.size(); ++i)
+        zpk.p[i] = wo / zpk.p[i];
+    for(int i = 0; i < degree; ++i)
+        zpk.z.append(0.0);
+}
+
+void lp2bp(Zpk& zpk, double wo, double bw)
+{
+    int degree = zpk.p.size() - zpk.z.size();
+    QVector<Complex> z, p;
+    for(int i = 0; i < zpk.z.size(); ++i) {
+        Complex zl = zpk.z[i] * bw / 2.0;
+        Complex d = std::sqrt(zl*zl - wo*wo);
+        z << zl + d << zl - d;
+    }
+    for(int i = 0; i < zpk.p.size(); ++i) {
+        Complex pl = zpk.p[i] * bw / 2.0;
+        Complex d = std::sqrt(pl*pl - wo*wo);
+        p << pl + d << pl - d;
+    }
+    for(int i = 0; i < degree; ++i)
+        z.append(0.0);
+    zpk.z = z;
+    zpk.p = p;
+    zpk.k *= std::pow(bw, degree);
+}
+
+void lp2bs(Zpk& zpk, double wo, double bw)
+{
+    int degree = zpk.p.size() - zpk.z.size();
+    zpk.k *= std::real(prodDiff(zpk.z, 0.0) / prodDiff(zpk.p, 0.0));
+    QVector<Complex> z, p;
+    for(int i = 0; i < zpk.z.size(); ++i) {
+        Complex zh = (bw / 2.0) / zpk.z[i];
+        Complex d = std::sqrt(zh*zh - wo*wo);
+        z << zh + d << zh - d;
+    }
+    for(int i = 0; i < zpk.p.size(); ++i) {
+        Complex ph = (bw / 2.0) / zpk.p[i];
+        Complex d = std::sqrt(ph*ph - wo*wo);
+        p << ph + d << ph - d;
+    }
+    for(int i = 0; i < degree; ++i)
+        z << J * wo << -J * wo;
+    zpk.z = z;
+    zpk.p = p;
+}
+
+//=============================================================================================================
+/**
+* Bilinear transform, fs2 is twice the sampling frequency.
+*/
+void bilinear(Zpk& zpk, double fs2)
+{
+    int degree = zpk.p.size() - zpk.z.size();
+    zpk.k *= std::real(prodDiff(zpk.z, fs2) / prodDiff(zpk.p, fs2));
+    for(int i = 0; i < zpk.z.size(); ++i)
+        zpk.z[i] = (fs2 + zpk.z[i]) / (fs2 - zpk.z[i]);
+    for(int i = 0; i < zpk.p.size(); ++i)
+        zpk.p[i] = (fs2 + zpk.p[i]) / (fs2 - zpk.p[i]);
+    for(int i = 0; i < degree; ++i)
+        zpk.z.append(-1.0);
+}
+
+//=============================================================================================================
+/**
+* A quadratic (or linear) factor 1 + c1 x^-1 + c2 x^-2 built from a conjugate pair or two real roots.
+*/
+struct Quadratic
+{
+    Complex root;   /**< Representative root, used for pairing. */
+    double  c1;
+    double  c2;
+};
+
+QVector<Quadratic> quadratics(const QVector<Complex>& roots)
+{
+    QVector<Quadratic> result;
+    QVector<double> reals;
+
+    for(int i = 0; i < roots.size(); ++i) {
+        const Complex& r = roots[i];
+        if(std::abs(r.imag()) <= 1e-10 * qMax(1.0, std::abs(r))) {
+            reals.append(r.real());
+        } else if(r.imag() > 0) {
+            Quadratic q = { r, -2.0 * r.real(), std::norm(r) };
+            result.append(q);
+        }
+    }
+
+    std::sort(reals.begin(), reals.end());
+    for(int i = 0; i < reals.size(); i += 2) {
+        if(i + 1 < reals.size()) {
+            Quadratic q = { reals[i+1], -(reals[i] + reals[i+1]), reals[i] * reals[i+1] };
+            result.append(q);
+        } else {
+            Quadratic q = { reals[i], -reals[i], 0.0 };
+            result.append(q);
+        }
+    }
+
+    return result;
+}
+
+bool lessMagnitude(const Quadratic& a, const Quadratic& b)
+{
+    return std::abs(a.root) < std::abs(b.root);
+}
+
+//=============================================================================================================
+/**
+* Groups zeros and poles into second order sections. Each pole pair is matched with the closest remaining
+* zero pair; the sections with poles closest to the unit circle come last in the cascade.
+*/
+MatrixXd zpk2sos(const Zpk& zpk)
+{
+    QVector<Quadratic> poles = quadratics(zpk.p);
+    QVector<Quadratic> zeros = quadratics(zpk.z);
+
+    int nSections = qMax(poles.size(), zeros.size());
+    Quadratic unit = { 0.0, 0.0, 0.0 };
+    while(poles.size() < nSections)
+        poles.append(unit);
+    while(zeros.size() < nSections)
+        zeros.append(unit);
+
+    std::sort(poles.begin(), poles.end(), lessMagnitude);
+
+    MatrixXd matSos(nSections, 6);
+    for(int s = 0; s < nSections; ++s) {
+        int iBest = 0;
+        for(int i = 1; i < zeros.size(); ++i)
+            if(std::abs(zeros[i].root - poles[s].root) < std::abs(zeros[iBest].root - poles[s].root))
+                iBest = i;
+
+        matSos.row(s) << 1.0, zeros[iBest].c1, zeros[iBest].c2, 1.0, poles[s].c1, poles[s].c2;
+        zeros.remove(iBest);
+    }
+
+    if(nSections > 0)
+        matSos.row(0).head(3) *= zpk.k;
+
+    return matSos;
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+IirFilter::IirFilter()
+: m_sName("Unknown")
+, m_Type(LPF)
+, m_designMethod(Butterworth)
+, m_iOrder(0)
+, m_dFreq1(0.0)
+, m_dFreq2(0.0)
+, m_sFreq(1000.0)
+, m_dPassRipple(1.0)
+, m_dStopAtten(60.0)
+{
+}
+
+
+//*************************************************************************************************************
+
+IirFilter::IirFilter(const QString& sName,
+                     FilterType type,
+                     DesignMethod designMethod,
+                     int iOrder,
+                     double dFreq1,
+                     double dFreq2,
+                     double sFreq,
+                     double dPassRipple,
+                     double dStopAtten)
+: m_sName(sName)
+, m_Type(type)
+, m_designMethod(designMethod)
+, m_iOrder(iOrder)
+, m_dFreq1(dFreq1)
+, m_dFreq2(dFreq2)
+, m_sFreq(sFreq)
+, m_dPassRipple(dPassRipple)
+, m_dStopAtten(dStopAtten)
+{
+    designFilter();
+}
+
+
+//*************************************************************************************************************
+
+bool IirFilter::designFilter()
+{
+    m_matSos.resize(0, 6);
+    m_matState.resize(0, 0);
+
+    const double dNyquist = m_sFreq / 2.0;
+    bool bBand = m_Type == BPF || m_Type == NOTCH;
+
+    if(m_iOrder < 1 || m_sFreq <= 0.0
+       || m_dFreq1 <= 0.0 || m_dFreq1 >= dNyquist
+       || (bBand && (m_dFreq2 <= m_dFreq1 || m_dFreq2 >= dNyquist))) {
+        qWarning() << "IirFilter::designFilter - Invalid filter parameters for" << m_sName;
+        return false;
+    }
+
+    if(m_designMethod != Butterworth && m_dPassRipple <= 0.0) {
+        qWarning() << "IirFilter::designFilter - The pass band ripple has to be positive.";
+        return false;
+    }
+
+    if(m_designMethod == Elliptic && m_dStopAtten <= m_dPassRipple) {
+        qWarning() << "IirFilter::designFilter - The stop band attenuation has to exceed the pass band ripple.";
+        return false;
+    }
+
+    Zpk zpk;
+    switch(m_designMethod) {
+        case Butterworth:
+            zpk = butterworthPrototype(m_iOrder);
+            break;
+        case Chebyshev:
+            zpk = chebyshevPrototype(m_iOrder, m_dPassRipple);
+            break;
+        case Elliptic:
+            zpk = ellipticPrototype(m_iOrder, m_dPassRipple, m_dStopAtten);
+            break;
+    }
+
+    //Pre-warp the edge frequencies for the bilinear transform
+    const double fs2 = 2.0 * m_sFreq;
+    const double w1 = fs2 * std::tan(PI * m_dFreq1 / m_sFreq);
+    const double w2 = bBand ? fs2 * std::tan(PI * m_dFreq2 / m_sFreq) : 0.0;
+
+    switch(m_Type) {
+        case LPF:
+            lp2lp(zpk, w1);
+            break;
+        case HPF:
+            lp2hp(zpk, w1);
+            break;
+        case BPF:
+            lp2bp(zpk, std::sqrt(w1 * w2), w2 - w1);
+            break;
+        case NOTCH:
+            lp2bs(zpk, std::sqrt(w1 * w2), w2 - w1);
+            break;
+    }
+
+    bilinear(zpk, fs2);
+
+    m_matSos = zpk2sos(zpk);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::filterData(const MatrixXd& matData, MatrixXd& matDataOut)
+{
+    if(m_matState.rows() != matData.rows() || m_matState.cols() != 2 * numSections())
+        m_matState = ArrayXXd::Zero(matData.rows(), 2 * numSections());
+
+    if(&matDataOut != &matData)
+        matDataOut = matData;
+
+    runSections(matDataOut, m_matState, false);
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd IirFilter::filterDataZeroPhase(const MatrixXd& matData) const
+{
+    const int iCols = matData.cols();
+    if(numSections() == 0 || iCols < 2)
+        return matData;
+
+    //Extend the data by odd reflection at both ends
+    const int iPad = qMin(3 * (2 * numSections() + 1), iCols - 1);
+    MatrixXd matExt(matData.rows(), iCols + 2 * iPad);
+    for(int i = 0; i < iPad; ++i) {
+        matExt.col(iPad - 1 - i) = 2.0 * matData.col(0) - matData.col(i + 1);
+        matExt.col(iPad + iCols + i) = 2.0 * matData.col(iCols - 1) - matData.col(iCols - 2 - i);
+    }
+    matExt.middleCols(iPad, iCols) = matData;
+
+    //Start forward and backward pass in the steady state of the respective first sample
+    RowVectorXd vecStepState = stepState();
+
+    ArrayXXd matState = (matExt.col(0) * vecStepState).array();
+    runSections(matExt, matState, false);
+
+    matState = (matExt.col(matExt.cols() - 1) * vecStepState).array();
+    runSections(matExt, matState, true);
+
+    return matExt.middleCols(iPad, iCols);
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::resetState()
+{
+    m_matState.setZero();
+}
+
+
+//*************************************************************************************************************
+
+std::complex<double> IirFilter::frequencyResponse(double dFreq) const
+{
+    const Complex zi = std::exp(-J * 2.0 * PI * dFreq / m_sFreq);
+
+    Complex h = 1.0;
+    for(int s = 0; s < numSections(); ++s)
+        h *= (m_matSos(s,0) + zi * (m_matSos(s,1) + zi * m_matSos(s,2)))
+             / (m_matSos(s,3) + zi * (m_matSos(s,4) + zi * m_matSos(s,5)));
+
+    return h;
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::runSections(MatrixXd& matData, ArrayXXd& matState, bool bReverse) const
+{
+    const int iRows = matData.rows();
+    const int iCols = matData.cols();
+    const int iSections = numSections();
+
+    ArrayXd x(iRows);
+    ArrayXd y(iRows);
+
+    //Transposed direct form II, all channels of one sample are processed at once
+    for(int i = 0; i < iCols; ++i) {
+        const int t = bReverse ? iCols - 1 - i : i;
+        x = matData.col(t).array();
+
+        for(int s = 0; s < iSections; ++s) {
+            const double b0 = m_matSos(s,0), b1 = m_matSos(s,1), b2 = m_matSos(s,2);
+            const double a1 = m_matSos(s,4), a2 = m_matSos(s,5);
+
+            y = b0 * x + matState.col(2*s);
+            matState.col(2*s) = b1 * x - a1 * y + matState.col(2*s + 1);
+            matState.col(2*s + 1) = b2 * x - a2 * y;
+            x.swap(y);
+        }
+
+        matData.col(t) = x.matrix();
+    }
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd IirFilter::stepState() const
+{
+    RowVectorXd vecState(2 * numSections());
+    double dScale = 1.0;
+
+    for(int s = 0; s < numSections(); ++s) {
+        const double b0 = m_matSos(s,0), b1 = m_matSos(s,1), b2 = m_matSos(s,2);
+        const double a1 = m_matSos(s,4), a2 = m_matSos(s,5);
+
+        //Steady state output of the section for a unit step and the resulting state
+        const double g = (b0 + b1 + b2) / (1.0 + a1 + a2);
+        const double s2 = b2 - a2 * g;
+        const double s1 = b1 - a1 * g + s2;
+
+        vecState[2*s] = dScale * s1;
+        vecState[2*s + 1] = dScale * s2;
+        dScale *= g;
+    }
+
+    return vecState;
+}
@@ -0,0 +1,240 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.h
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Christoph Dinh <chdinh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     October, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Christoph Dinh. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    IirFilter class declaration.
+*
+*/
+
+#ifndef IIRFILTER_H
+#define IIRFILTER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../utils_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QString>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE UTILSLIB
+//=============================================================================================================
+
+namespace UTILSLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* IIR filter designed as a cascade of second order sections (biquads). Butterworth, Chebyshev (type I) and
+* elliptic low-, high-, band-pass and band-stop filters are designed from the analog prototype via frequency
+* transformation and the pre-warped bilinear transform.
+*
+* The filter runs causally with persistent per channel state (filterData) for real-time processing, or
+* forward-backward (filterDataZeroPhase) for offline zero-phase filtering. Data is processed sample by sample
+* with all channels of a sample at once, so the inner loop over the channels is vectorized.
+*
+* @brief IIR second order section filter.
+*/
+class UTILSSHARED_EXPORT IirFilter
+{
+
+public:
+    enum DesignMethod {
+        Butterworth,
+        Chebyshev,
+        Elliptic
+    };
+
+    enum FilterType {
+        LPF,
+        HPF,
+        BPF,
+        NOTCH
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty IirFilter object which passes data unchanged.
+    */
+    IirFilter();
+
+    //=========================================================================================================
+    /**
+    * Constructs and designs an IirFilter object.
+    *
+    * @param [in] sName         name of the filter.
+    * @param [in] type          filter type.
+    * @param [in] designMethod  design method.
+    * @param [in] iOrder        order of the analog low-pass prototype; band-pass and band-stop filters have twice the order.
+    * @param [in] dFreq1        cutoff frequency in Hz of low- and high-pass filters, lower band edge otherwise.
+    * @param [in] dFreq2        upper band edge in Hz of band-pass and band-stop filters, ignored otherwise.
+    * @param [in] sFreq         sampling frequency in Hz.
+    * @param [in] dPassRipple   pass band ripple in dB (Chebyshev and elliptic).
+    * @param [in] dStopAtten    stop band attenuation in dB (elliptic).
+    */
+    IirFilter(const QString& sName,
+              FilterType type,
+              DesignMethod designMethod,
+              int iOrder,
+              double dFreq1,
+              double dFreq2,
+              double sFreq,
+              double dPassRipple = 1.0,
+              double dStopAtten = 60.0);
+
+    //=========================================================================================================
+    /**
+    * Designs the second order sections from the current parameters and resets the filter state.
+    *
+    * @return true if the parameters are valid, false otherwise.
+    */
+    bool designFilter();
+
+    //=========================================================================================================
+    /**
+    * Filters the data causally. The state of each channel is kept between calls, so consecutive blocks are
+    * filtered as one continuous signal. The state is reset when the number of channels changes.
+    *
+    * @param [in] matData       data to filter (channels x samples).
+    * @param [out] matDataOut   filtered data, may be the same matrix as matData.
+    */
+    void filterData(const MatrixXd& matData, MatrixXd& matDataOut);
+
+    //=========================================================================================================
+    /**
+    * Filters the data forward and backward, which results in zero phase and squared magnitude response. The
+    * data is extended by odd reflection at both ends and the filter is started in its steady state to reduce
+    * edge effects. The causal state is not touched.
+    *
+    * @param [in] matData   data to filter (channels x samples).
+    *
+    * @return the filtered data.
+    */
+    MatrixXd filterDataZeroPhase(const MatrixXd& matData) const;
+
+    //=========================================================================================================
+    /**
+    * Resets the causal filter state of all channels to zero.
+    */
+    void resetState();
+
+    //=========================================================================================================
+    /**
+    * Evaluates the complex frequency response of the cascade.
+    *
+    * @param [in] dFreq     frequency in Hz.
+    *
+    * @return the frequency response.
+    */
+    std::complex<double> frequencyResponse(double dFreq) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of second order sections.
+    *
+    * @return the number of sections.
+    */
+    inline int numSections() const;
+
+    QString         m_sName;            /**< name of the filter. */
+    FilterType      m_Type;             /**< filter type. */
+    DesignMethod    m_designMethod;     /**< design method. */
+    int             m_iOrder;           /**< order of the analog low-pass prototype. */
+    double          m_dFreq1;           /**< cutoff frequency or lower band edge in Hz. */
+    double          m_dFreq2;           /**< upper band edge in Hz. */
+    double          m_sFreq;            /**< sampling frequency in Hz. */
+    double          m_dPassRipple;      /**< pass band ripple in dB. */
+    double          m_dStopAtten;       /**< stop band attenuation in dB. */
+
+    MatrixXd        m_matSos;           /**< second order sections, one row per section: b0 b1 b2 a0 a1 a2 with a0 = 1. */
+
+private:
+    //=========================================================================================================
+    /**
+    * Runs the cascade over the samples of matData in the given direction with the given state.
+    *
+    * @param [in, out] matData  data to filter in place (channels x samples).
+    * @param [in, out] matState filter state (channels x 2*sections).
+    * @param [in] bReverse      whether to run from the last to the first sample.
+    */
+    void runSections(MatrixXd& matData, ArrayXXd& matState, bool bReverse) const;
+
+    //=========================================================================================================
+    /**
+    * Computes the steady state of each section for a unit step input.
+    *
+    * @return the steady state (1 x 2*sections).
+    */
+    RowVectorXd stepState() const;
+
+    ArrayXXd        m_matState;         /**< causal filter state (channels x 2*sections). */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int IirFilter::numSections() const
+{
+    return m_matSos.rows();
+}
+
+} // NAMESPACE UTILSLIB
+
+#endif // IIRFILTER_H
@@ -52,6 +52,7 @@
 //=============================================================================================================
 
 #include <typeinfo>
+#include <cstdio>
 
 
 //*************************************************************************************************************
@@ -68,7 +69,10 @@
 //=============================================================================================================
 
 #include <QPair>
-#include <QSemaphore>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
 #include <QSharedPointer>
 
 
@@ -89,9 +93,24 @@ namespace IOBUFFER
 using namespace Eigen;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// SOME DEFINES
+//=============================================================================================================
+
+#define IOBUFFER_CACHE_LINE_SIZE 64     /**< Assumed cache line size in bytes. */
+
+
 //=============================================================================================================
 /**
-* Circular Matrix buffer provides a template for thread safe circular matrix buffers.
+* Circular Matrix buffer provides a template for lock-free single producer single consumer circular matrix buffers.
+* All matrices are stored in pre-allocated, cache line aligned blocks. The read and write positions live on
+* separate cache lines and are synchronized with acquire/release atomics only; a mutex is touched only when a
+* blocking consumer or producer has to sleep.
+*
+* Besides the copying push() and pop() the blocks can be written and read in place: beginWrite()/endWrite() and
+* beginRead()/endRead() hand out Eigen::Map views of the next block, which avoids the allocation and the copy.
+* Exactly one thread may push and exactly one other thread may pop.
 *
 * @brief The circular matrix buffer
 */
@@ -102,6 +121,19 @@ public:
     typedef QSharedPointer<CircularMatrixBuffer> SPtr;              /**< Shared pointer type for CircularMatrixBuffer. */
     typedef QSharedPointer<const CircularMatrixBuffer> ConstSPtr;   /**< Const shared pointer type for CircularMatrixBuffer. */
 
+    typedef Matrix<_Tp, Dynamic, Dynamic> MatrixType;               /**< Matrix type of the stored blocks. */
+    typedef Map<MatrixType> WriteView;                              /**< View of a block which is written in place. */
+    typedef Map<const MatrixType> ReadView;                         /**< View of a block which is read in place. */
+
+    //=========================================================================================================
+    /**
+    * The wait policy which is used when the buffer is empty (pop) or full (push).
+    */
+    enum WaitPolicy {
+        Blocking,       /**< Spin shortly, then sleep until the other side signals. */
+        Spinning        /**< Keep spinning and yielding, for low latency at the cost of a busy core. */
+    };
+
     //=========================================================================================================
     /**
     * Constructs a CircularMatrixBuffer.
@@ -110,8 +142,9 @@ public:
     * @param [in] uiMaxNumMatrices  length of buffer.
     * @param [in] uiRows            Number of rows.
     * @param [in] uiCols            Number of columns.
+    * @param [in] policy            The wait policy (default Blocking).
     */
-    explicit CircularMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols);
+    explicit CircularMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols, WaitPolicy policy = Blocking);
 
     //=========================================================================================================
     /**
@@ -137,10 +170,57 @@ public:
 
     //=========================================================================================================
     /**
-    * Clears the buffer.
+    * Copies the first matrix (first in first out) to the given matrix. The storage of the matrix is reused when it
+    * already has the right dimensions.
+    *
+    * @param [out] matrix   the first matrix.
+    */
+    inline void pop(Matrix<_Tp, Dynamic, Dynamic>& matrix);
+
+    //=========================================================================================================
+    /**
+    * Waits for a free block and returns a view of it. The block is published to the consumer by endWrite().
+    * While paused or after releaseFromPush() the view points to a scratch block which is never published.
+    *
+    * @return view of the next block to be written.
+    */
+    inline WriteView beginWrite();
+
+    //=========================================================================================================
+    /**
+    * Publishes the block which was acquired by beginWrite().
+    */
+    inline void endWrite();
+
+    //=========================================================================================================
+    /**
+    * Waits for the first block and returns a view of it. The view stays valid until endRead() is called.
+    * While paused or after releaseFromPop() the view points to a zero block.
+    *
+    * @return view of the first block.
+    */
+    inline ReadView beginRead();
+
+    //=========================================================================================================
+    /**
+    * Hands the block which was borrowed by beginRead() back to the producer.
+    */
+    inline void endRead();
+
+    //=========================================================================================================
+    /**
+    * Clears the buffer. The published blocks are dropped by the consumer at its next beginRead(), so clear() may
+    * be called from any thread, also while the consumer reads a block. A pending release is kept.
     */
     void clear();
 
+    //=========================================================================================================
+    /**
+    * Clears the buffer and drops pending releases, which were not picked up by a waiting pop() or push(). Must only
+    * be called while the consumer does not run, e.g. before its thread is (re-)started.
+    */
+    void reset();
+
     //=========================================================================================================
     /**
     * Size of the buffer.
@@ -159,6 +239,26 @@ public:
     */
     inline quint32 cols() const;
 
+    //=========================================================================================================
+    /**
+    * Number of blocks which are currently stored in the buffer.
+    */
+    inline quint32 fill() const;
+
+    //=========================================================================================================
+    /**
+    * Number of pushes which found the buffer full and had to wait for the consumer.
+    */
+    inline quint32 overruns() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the wait policy.
+    *
+    * @param [in] policy    the new wait policy.
+    */
+    inline void setWaitPolicy(WaitPolicy policy);
+
     //=========================================================================================================
     /**
     * Pauses the buffer. Skpis any incoming matrices and only pops zero matrices.
@@ -182,23 +282,81 @@ public:
 private:
     //=========================================================================================================
     /**
-    * Returns the current circular index to the corresponding given index.
+    * Returns the pointer to the given block.
     *
-    * @param [in] index which should be mapped.
-    * @return the mapped index.
+    * @param [in] uiIndex   position of the block, is mapped into the circular buffer.
+    * @return pointer to the first element of the block.
     */
-    inline unsigned int mapIndex(int& index);
+    inline _Tp* block(quint32 uiIndex) const;
+
+    //=========================================================================================================
+    /**
+    * Waits until the consumer published a free block or the producer was released.
+    *
+    * @return true if a block is free, false if released or paused.
+    */
+    inline bool waitForFreeBlock();
+
+    //=========================================================================================================
+    /**
+    * Waits until the producer published a block or the consumer was released.
+    *
+    * @return true if a block is available, false if released or paused.
+    */
+    inline bool waitForUsedBlock();
+
+    //=========================================================================================================
+    /**
+    * Drops the blocks which were published before the last clear(). Called by the consumer only.
+    */
+    inline void applyClear();
+
+    //=========================================================================================================
+    /**
+    * Sleeps on the wait condition until the other side changed its index or released this side, used by the
+    * blocking wait policy.
+    *
+    * @param [in] index     the index of the other side.
+    * @param [in] uiSeen    the value of the index which made this side wait.
+    * @param [in] release   the release flag of this side.
+    */
+    inline void sleep(QAtomicInt& index, quint32 uiSeen, QAtomicInt& release);
+
+    //=========================================================================================================
+    /**
+    * Wakes the other side in case it sleeps.
+    */
+    inline void wake();
 
     unsigned int    m_uiMaxNumMatrices;         /**< Holds the maximal number of matrices.*/
     unsigned int    m_uiRows;                   /**< Holds the number rows.*/
     unsigned int    m_uiCols;                   /**< Holds the number cols.*/
-    unsigned int    m_uiMaxNumElements;         /**< Holds the maximal number of buffer elements.*/
-    _Tp*            m_pBuffer;                  /**< Holds the circular buffer.*/
-    int             m_iCurrentReadIndex;        /**< Holds the current read index.*/
-    int             m_iCurrentWriteIndex;       /**< Holds the current write index.*/
-    QSemaphore*     m_pFreeElements;            /**< Holds a semaphore which acquires free elements for thread safe writing. A semaphore is a generalization of a mutex.*/
-    QSemaphore*     m_pUsedElements;            /**< Holds a semaphore which acquires written semaphore for thread safe reading.*/
+    unsigned int    m_uiBlockStride;            /**< Holds the number of elements between two blocks, padded to full cache lines.*/
+    char*           m_pStorage;                 /**< Holds the allocated memory.*/
+    _Tp*            m_pBuffer;                  /**< Holds the circular buffer, followed by a zero and a scratch block.*/
+    WaitPolicy      m_waitPolicy;               /**< Holds the wait policy.*/
     bool            m_bPause;
+
+    QMutex          m_qMutex;                   /**< Only used to sleep with the blocking wait policy.*/
+    QWaitCondition  m_qWaitCondition;           /**< Wakes a sleeping producer or consumer.*/
+    QAtomicInt      m_iSleeping;                /**< Holds the number of sleeping threads.*/
+    QAtomicInt      m_iReleasePop;              /**< Set by releaseFromPop().*/
+    QAtomicInt      m_iReleasePush;             /**< Set by releaseFromPush().*/
+    QAtomicInt      m_iOverruns;                /**< Holds the number of pushes which found the buffer full.*/
+    QAtomicInt      m_iClear;                   /**< Set by clear(), handled by the consumer.*/
+    QAtomicInt      m_iClearIndex;              /**< Holds the write index at the time of the last clear().*/
+
+    char            m_cPad0[IOBUFFER_CACHE_LINE_SIZE];
+    QAtomicInt      m_iWriteIndex;              /**< Holds the number of published blocks, written by the producer only.*/
+    quint32         m_uiCachedReadIndex;        /**< Holds the producer's copy of the read index.*/
+    bool            m_bWriteScratch;            /**< Whether the producer currently writes to the scratch block.*/
+
+    char            m_cPad1[IOBUFFER_CACHE_LINE_SIZE];
+    QAtomicInt      m_iReadIndex;               /**< Holds the number of consumed blocks, written by the consumer only.*/
+    quint32         m_uiCachedWriteIndex;       /**< Holds the consumer's copy of the write index.*/
+    bool            m_bReadZero;                /**< Whether the consumer currently reads the zero block.*/
+
+    char            m_cPad2[IOBUFFER_CACHE_LINE_SIZE];
 };
 
 
@@ -208,20 +366,37 @@ private:
 //=============================================================================================================
 
 template<typename _Tp>
-CircularMatrixBuffer<_Tp>::CircularMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols)
+CircularMatrixBuffer<_Tp>::CircularMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols, WaitPolicy policy)
 : Buffer(typeid(_Tp).name())
-, m_uiMaxNumMatrices(uiMaxNumMatrices)
+, m_uiMaxNumMatrices(uiMaxNumMatrices > 0 ? uiMaxNumMatrices : 1)
 , m_uiRows(uiRows)
 , m_uiCols(uiCols)
-, m_uiMaxNumElements(m_uiMaxNumMatrices*m_uiRows*m_uiCols)
-, m_pBuffer(new _Tp[m_uiMaxNumElements])
-, m_iCurrentReadIndex(-1)
-, m_iCurrentWriteIndex(-1)
-, m_pFreeElements(new QSemaphore(m_uiMaxNumElements))
-, m_pUsedElements(new QSemaphore(0))
+, m_uiBlockStride(((m_uiRows*m_uiCols*sizeof(_Tp) + IOBUFFER_CACHE_LINE_SIZE - 1) / IOBUFFER_CACHE_LINE_SIZE) * IOBUFFER_CACHE_LINE_SIZE / sizeof(_Tp))
+, m_pStorage(new char[(m_uiMaxNumMatrices + 2) * m_uiBlockStride * sizeof(_Tp) + IOBUFFER_CACHE_LINE_SIZE])
+, m_pBuffer(0)
+, m_waitPolicy(policy)
 , m_bPause(false)
+, m_iSleeping(0)
+, m_iReleasePop(0)
+, m_iReleasePush(0)
+, m_iOverruns(0)
+, m_iClear(0)
+, m_iClearIndex(0)
+, m_iWriteIndex(0)
+, m_uiCachedReadIndex(0)
+, m_bWriteScratch(false)
+, m_iReadIndex(0)
+, m_uiCachedWriteIndex(0)
+, m_bReadZero(false)
 {
-
+    //Align the first block to a cache line, the stride keeps all following blocks aligned
+    quintptr t_uiAddress = reinterpret_cast<quintptr>(m_pStorage);
+    t_uiAddress = (t_uiAddress + IOBUFFER_CACHE_LINE_SIZE - 1) & ~quintptr(IOBUFFER_CACHE_LINE_SIZE - 1);
+    m_pBuffer = reinterpret_cast<_Tp*>(t_uiAddress);
+
+    //Block m_uiMaxNumMatrices is the zero block, block m_uiMaxNumMatrices+1 the scratch block
+    for(unsigned int i = 0; i < (m_uiMaxNumMatrices + 2) * m_uiBlockStride; ++i)
+        m_pBuffer[i] = 0;
 }
 
 
@@ -230,9 +405,7 @@ CircularMatrixBuffer<_Tp>::CircularMatrixBuffer(unsigned int uiMaxNumMatrices, u
 template<typename _Tp>
 CircularMatrixBuffer<_Tp>::~CircularMatrixBuffer()
 {
-    delete m_pFreeElements;
-    delete m_pUsedElements;
-    delete [] m_pBuffer;
+    delete [] m_pStorage;
 }
 
 
@@ -243,13 +416,11 @@ inline void CircularMatrixBuffer<_Tp>::push(const Matrix<_Tp, Dynamic, Dynamic>*
 {
     if(!m_bPause)
     {
-        unsigned int t_size = pMatrix->size();
-        if(t_size == m_uiRows*m_uiCols)
+        if((unsigned int)pMatrix->size() == m_uiRows*m_uiCols)
         {
-            m_pFreeElements->acquire(t_size);
-            for(unsigned int i = 0; i < t_size; ++i)
-                m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = pMatrix->data()[i];
-            m_pUsedElements->release(t_size);
+            WriteView t_view = beginWrite();
+            t_view = Map<const MatrixType>(pMatrix->data(), m_uiRows, m_uiCols);
+            endWrite();
         }
 
         else {
@@ -264,17 +435,9 @@ inline void CircularMatrixBuffer<_Tp>::push(const Matrix<_Tp, Dynamic, Dynamic>*
 template<typename _Tp>
 inline Matrix<_Tp, Dynamic, Dynamic> CircularMatrixBuffer<_Tp>::pop()
 {
-    Matrix<_Tp, Dynamic, Dynamic> matrix(m_uiRows, m_uiCols);
+    Matrix<_Tp, Dynamic, Dynamic> matrix;
 
-    if(!m_bPause)
-    {
-        m_pUsedElements->acquire(m_uiRows*m_uiCols);
-        for(quint32 i = 0; i < m_uiRows*m_uiCols; ++i)
-            matrix.data()[i] = m_pBuffer[mapIndex(m_iCurrentReadIndex)];
-        m_pFreeElements->release(m_uiRows*m_uiCols);
-    }
-    else
-        matrix.setZero();
+    pop(matrix);
 
     return matrix;
 }
@@ -283,12 +446,190 @@ inline Matrix<_Tp, Dynamic, Dynamic> CircularMatrixBuffer<_Tp>::pop()
 //*************************************************************************************************************
 
 template<typename _Tp>
-inline unsigned int CircularMatrixBuffer<_Tp>::mapIndex(int& index)
+inline void CircularMatrixBuffer<_Tp>::pop(Matrix<_Tp, Dynamic, Dynamic>& matrix)
+{
+    matrix = beginRead();
+    endRead();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline typename CircularMatrixBuffer<_Tp>::WriteView CircularMatrixBuffer<_Tp>::beginWrite()
+{
+    m_bWriteScratch = m_bPause || !waitForFreeBlock();
+
+    if(m_bWriteScratch)
+        return WriteView(block(m_uiMaxNumMatrices + 1), m_uiRows, m_uiCols);
+
+    return WriteView(block((quint32)m_iWriteIndex.loadAcquire() % m_uiMaxNumMatrices), m_uiRows, m_uiCols);
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::endWrite()
+{
+    if(m_bWriteScratch) {
+        m_bWriteScratch = false;
+        return;
+    }
+
+    //Ordered store followed by the ordered load in wake(), pairs with the announcement in sleep()
+    m_iWriteIndex.fetchAndStoreOrdered((int)((quint32)m_iWriteIndex.loadAcquire() + 1));
+    wake();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline typename CircularMatrixBuffer<_Tp>::ReadView CircularMatrixBuffer<_Tp>::beginRead()
+{
+    m_bReadZero = m_bPause || !waitForUsedBlock();
+
+    if(m_bReadZero)
+        return ReadView(block(m_uiMaxNumMatrices), m_uiRows, m_uiCols);
+
+    return ReadView(block((quint32)m_iReadIndex.loadAcquire() % m_uiMaxNumMatrices), m_uiRows, m_uiCols);
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::endRead()
+{
+    if(m_bReadZero) {
+        m_bReadZero = false;
+        return;
+    }
+
+    m_iReadIndex.fetchAndStoreOrdered((int)((quint32)m_iReadIndex.loadAcquire() + 1));
+    wake();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline _Tp* CircularMatrixBuffer<_Tp>::block(quint32 uiIndex) const
+{
+    return m_pBuffer + uiIndex * m_uiBlockStride;
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::waitForFreeBlock()
+{
+    quint32 t_uiWrite = (quint32)m_iWriteIndex.loadAcquire();
+
+    //Only reload the consumer's index when the cached one says the buffer is full
+    if(t_uiWrite - m_uiCachedReadIndex < m_uiMaxNumMatrices)
+        return true;
+
+    m_uiCachedReadIndex = (quint32)m_iReadIndex.loadAcquire();
+    if(t_uiWrite - m_uiCachedReadIndex < m_uiMaxNumMatrices)
+        return true;
+
+    m_iOverruns.ref();
+
+    for(int t_iSpins = 0; ; ++t_iSpins) {
+        if(m_iReleasePush.fetchAndStoreOrdered(0) || m_bPause)
+            return false;
+
+        m_uiCachedReadIndex = (quint32)m_iReadIndex.loadAcquire();
+        if(t_uiWrite - m_uiCachedReadIndex < m_uiMaxNumMatrices)
+            return true;
+
+        if(m_waitPolicy == Blocking && t_iSpins > 64)
+            sleep(m_iReadIndex, m_uiCachedReadIndex, m_iReleasePush);
+        else
+            QThread::yieldCurrentThread();
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::waitForUsedBlock()
 {
-    int AuxIndex;
-    AuxIndex = ++index;
-    return index = AuxIndex % m_uiMaxNumElements;
+    applyClear();
+
+    quint32 t_uiRead = (quint32)m_iReadIndex.loadAcquire();
 
+    //Only reload the producer's index when the cached one says the buffer is empty (or is outdated by clear())
+    if(m_uiCachedWriteIndex - t_uiRead - 1 < m_uiMaxNumMatrices)
+        return true;
+
+    for(int t_iSpins = 0; ; ++t_iSpins) {
+        m_uiCachedWriteIndex = (quint32)m_iWriteIndex.loadAcquire();
+        if(m_uiCachedWriteIndex - t_uiRead - 1 < m_uiMaxNumMatrices)
+            return true;
+
+        if(m_iReleasePop.fetchAndStoreOrdered(0) || m_bPause)
+            return false;
+
+        if(m_waitPolicy == Blocking && t_iSpins > 64)
+            sleep(m_iWriteIndex, m_uiCachedWriteIndex, m_iReleasePop);
+        else
+            QThread::yieldCurrentThread();
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::applyClear()
+{
+    if(m_iClear.loadAcquire() == 0 || m_iClear.fetchAndStoreOrdered(0) == 0)
+        return;
+
+    //Skip up to the write index seen by clear(), unless the consumer already passed it
+    quint32 t_uiClear = (quint32)m_iClearIndex.loadAcquire();
+    quint32 t_uiRead = (quint32)m_iReadIndex.loadAcquire();
+
+    if(t_uiClear - t_uiRead <= m_uiMaxNumMatrices) {
+        m_iReadIndex.fetchAndStoreOrdered((int)t_uiClear);
+        wake();
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::sleep(QAtomicInt& index, quint32 uiSeen, QAtomicInt& release)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    m_iSleeping.ref();
+
+    //Check again after announcing the sleep: a side which published before it could see the announcement did
+    //not wake us. One which publishes afterwards has to take the mutex for its wake-up, which wait() releases.
+    //The timeout only covers pause(), which is not announced through an atomic.
+    if((quint32)index.fetchAndAddOrdered(0) == uiSeen && release.fetchAndAddOrdered(0) == 0)
+        m_qWaitCondition.wait(&m_qMutex, 10);
+
+    m_iSleeping.deref();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::wake()
+{
+    if(m_iSleeping.fetchAndAddOrdered(0) > 0) {
+        QMutexLocker locker(&m_qMutex);
+        m_qWaitCondition.wakeAll();
+    }
 }
 
 
@@ -297,13 +638,25 @@ inline unsigned int CircularMatrixBuffer<_Tp>::mapIndex(int& index)
 template<typename _Tp>
 void CircularMatrixBuffer<_Tp>::clear()
 {
-    delete m_pFreeElements;
-    m_pFreeElements = new QSemaphore(m_uiMaxNumElements);
-    delete m_pUsedElements;
-    m_pUsedElements = new QSemaphore(0);
+    //Only the consumer moves the read index, it drops the blocks at its next beginRead(). The producer keeps its
+    //position.
+    m_iClearIndex.fetchAndStoreOrdered(m_iWriteIndex.loadAcquire());
+    m_iClear.fetchAndStoreOrdered(1);
+
+    wake();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+void CircularMatrixBuffer<_Tp>::reset()
+{
+    //A release which was never picked up would make the first pop of the next run return the zero block
+    m_iReleasePop.fetchAndStoreOrdered(0);
+    m_iReleasePush.fetchAndStoreOrdered(0);
 
-    m_iCurrentReadIndex = -1;
-    m_iCurrentWriteIndex = -1;
+    clear();
 }
 
 
@@ -334,12 +687,51 @@ inline quint32 CircularMatrixBuffer<_Tp>::cols() const
 }
 
 
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline quint32 CircularMatrixBuffer<_Tp>::fill() const
+{
+    //Load the read index first, so the write index which is loaded afterwards is never behind it
+    quint32 t_uiRead = (quint32)m_iReadIndex.loadAcquire();
+
+    //Blocks dropped by a pending clear() do not count
+    if(m_iClear.loadAcquire()) {
+        quint32 t_uiClear = (quint32)m_iClearIndex.loadAcquire();
+        if(t_uiClear - t_uiRead <= m_uiMaxNumMatrices)
+            t_uiRead = t_uiClear;
+    }
+
+    return (quint32)m_iWriteIndex.loadAcquire() - t_uiRead;
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline quint32 CircularMatrixBuffer<_Tp>::overruns() const
+{
+    return (quint32)m_iOverruns.loadAcquire();
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline void CircularMatrixBuffer<_Tp>::setWaitPolicy(WaitPolicy policy)
+{
+    m_waitPolicy = policy;
+}
+
+
 //*************************************************************************************************************
 
 template<typename _Tp>
 inline void CircularMatrixBuffer<_Tp>::pause(bool bPause)
 {
     m_bPause = bPause;
+
+    wake();
 }
 
 
@@ -348,15 +740,11 @@ inline void CircularMatrixBuffer<_Tp>::pause(bool bPause)
 template<typename _Tp>
 inline bool CircularMatrixBuffer<_Tp>::releaseFromPop()
 {
-   if((uint)m_pUsedElements->available() < m_uiRows*m_uiCols)
+    if(fill() == 0)
     {
-        //The last matrix which is to be popped from the buffer is supposed to be a zero matrix
-        unsigned int t_size = m_uiRows*m_uiCols;
-        for(unsigned int i = 0; i < t_size; ++i)
-            m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = 0;
-
-        //Release (create) values from m_pUsedElements so that the pop function can leave the acquire statement in the pop function
-        m_pUsedElements->release(m_uiRows*m_uiCols);
+        //The waiting pop returns a zero matrix
+        m_iReleasePop.fetchAndStoreOrdered(1);
+        wake();
 
         return true;
     }
@@ -370,15 +758,11 @@ inline bool CircularMatrixBuffer<_Tp>::releaseFromPop()
 template<typename _Tp>
 inline bool CircularMatrixBuffer<_Tp>::releaseFromPush()
 {
-    if((uint)m_pFreeElements->available() < m_uiRows*m_uiCols)
+    if(fill() == m_uiMaxNumMatrices)
     {
-        //The last matrix which is to be pushed to the buffer is supposed to be a zero matrix
-        unsigned int t_size = m_uiRows*m_uiCols;
-        for(unsigned int i = 0; i < t_size; ++i)
-            m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = 0;
-
-        //Release (create) values from m_pFreeElements so that the push function can leave the acquire statement in the push function
-        m_pFreeElements->release(m_uiRows*m_uiCols);
+        //The waiting push drops its matrix
+        m_iReleasePush.fetchAndStoreOrdered(1);
+        wake();
 
         return true;
     }
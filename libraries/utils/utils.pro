@@ -85,6 +85,7 @@ SOURCES += \
     filterTools/cosinefilter.cpp \
     filterTools/parksmcclellan.cpp \
     filterTools/filterdata.cpp \
+    filterTools/iirfilter.cpp \
     filterTools/filterio.cpp \
     detecttrigger.cpp \
     spectrogram.cpp \
@@ -112,6 +113,7 @@ HEADERS += \
     filterTools/cosinefilter.h \
     filterTools/parksmcclellan.h \
     filterTools/filterdata.h \
+    filterTools/iirfilter.h \
     filterTools/filterio.h \
     detecttrigger.h \
     spectrogram.h \
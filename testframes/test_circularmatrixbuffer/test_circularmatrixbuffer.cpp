@@ -0,0 +1,389 @@
+//=============================================================================================================
+/**
+* @file     test_circularmatrixbuffer.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the producer/consumer hand-over of the CircularMatrixBuffer
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/generics/circularmatrixbuffer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QThread>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace IOBUFFER;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Pushes blocks which are filled with their running number.
+*/
+class BufferProducer : public QThread
+{
+public:
+    BufferProducer(CircularMatrixBuffer<double>* pBuffer, int iNumBlocks, int iFirst = 0)
+    : m_pBuffer(pBuffer)
+    , m_iNumBlocks(iNumBlocks)
+    , m_iFirst(iFirst)
+    {
+    }
+
+protected:
+    void run()
+    {
+        MatrixXd t_mat(m_pBuffer->rows(), m_pBuffer->cols());
+        for(int i = 0; i < m_iNumBlocks; ++i) {
+            t_mat.setConstant(m_iFirst + i);
+            m_pBuffer->push(&t_mat);
+        }
+    }
+
+private:
+    CircularMatrixBuffer<double>* m_pBuffer;
+    int m_iNumBlocks;
+    int m_iFirst;
+};
+
+
+//=============================================================================================================
+/**
+* Pops blocks and counts the ones which do not carry the expected running number.
+*/
+class BufferConsumer : public QThread
+{
+public:
+    BufferConsumer(CircularMatrixBuffer<double>* pBuffer, int iNumBlocks, int iFirst = 0)
+    : m_pBuffer(pBuffer)
+    , m_iNumBlocks(iNumBlocks)
+    , m_iFirst(iFirst)
+    , m_iErrors(0)
+    {
+    }
+
+    int errors() const
+    {
+        return m_iErrors;
+    }
+
+    MatrixXd last() const
+    {
+        return m_matLast;
+    }
+
+protected:
+    void run()
+    {
+        for(int i = 0; i < m_iNumBlocks; ++i) {
+            m_pBuffer->pop(m_matLast);
+            if(m_matLast.minCoeff() != m_iFirst + i || m_matLast.maxCoeff() != m_iFirst + i)
+                ++m_iErrors;
+        }
+    }
+
+private:
+    CircularMatrixBuffer<double>* m_pBuffer;
+    int m_iNumBlocks;
+    int m_iFirst;
+    int m_iErrors;
+    MatrixXd m_matLast;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestCircularMatrixBuffer
+*
+* @brief The TestCircularMatrixBuffer class tests the hand-over between one producer and one consumer thread
+*
+*/
+class TestCircularMatrixBuffer: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestCircularMatrixBuffer();
+
+private slots:
+    void initTestCase();
+    void pushPop_data();
+    void pushPop();
+    void clearWhileReading_data();
+    void clearWhileReading();
+    void releaseFromPop_data();
+    void releaseFromPop();
+    void releaseFromPush_data();
+    void releaseFromPush();
+    void resetDropsStaleRelease_data();
+    void resetDropsStaleRelease();
+    void cleanupTestCase();
+
+private:
+    void addPolicies();
+
+    int m_iNumBlocks;
+    int m_iTimeout;
+};
+
+
+//*************************************************************************************************************
+
+TestCircularMatrixBuffer::TestCircularMatrixBuffer()
+: m_iNumBlocks(20000)
+, m_iTimeout(10000)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::initTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::addPolicies()
+{
+    QTest::addColumn<int>("policy");
+
+    QTest::newRow("Blocking") << (int)CircularMatrixBuffer<double>::Blocking;
+    QTest::newRow("Spinning") << (int)CircularMatrixBuffer<double>::Spinning;
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::pushPop_data()
+{
+    addPolicies();
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::pushPop()
+{
+    QFETCH(int, policy);
+
+    CircularMatrixBuffer<double> t_buffer(8, 3, 4, (CircularMatrixBuffer<double>::WaitPolicy)policy);
+
+    BufferProducer t_producer(&t_buffer, m_iNumBlocks);
+    BufferConsumer t_consumer(&t_buffer, m_iNumBlocks);
+    t_consumer.start();
+    t_producer.start();
+
+    QVERIFY( t_producer.wait(m_iTimeout) );
+    QVERIFY( t_consumer.wait(m_iTimeout) );
+
+    QCOMPARE( t_consumer.errors(), 0 );
+    QCOMPARE( t_buffer.fill(), (quint32)0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::clearWhileReading_data()
+{
+    addPolicies();
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::clearWhileReading()
+{
+    QFETCH(int, policy);
+
+    CircularMatrixBuffer<double> t_buffer(4, 2, 2, (CircularMatrixBuffer<double>::WaitPolicy)policy);
+
+    MatrixXd t_mat = MatrixXd::Constant(2, 2, 1.0);
+    for(int i = 0; i < 3; ++i)
+        t_buffer.push(&t_mat);
+
+    //Clear while the consumer holds the first block, the block has to stay valid until endRead()
+    CircularMatrixBuffer<double>::ReadView t_view = t_buffer.beginRead();
+    t_buffer.clear();
+    QCOMPARE( t_buffer.fill(), (quint32)0 );
+    QCOMPARE( t_view(0,0), 1.0 );
+    t_buffer.endRead();
+    QCOMPARE( t_buffer.fill(), (quint32)0 );
+
+    //The producer keeps its position, the next block is the only one left
+    t_mat.setConstant(2.0);
+    t_buffer.push(&t_mat);
+    QCOMPARE( t_buffer.fill(), (quint32)1 );
+
+    BufferConsumer t_consumer(&t_buffer, 1, 2);
+    t_consumer.start();
+    QVERIFY( t_consumer.wait(m_iTimeout) );
+    QCOMPARE( t_consumer.errors(), 0 );
+
+    //Fill the whole buffer again after the clear, the producer must not block
+    BufferProducer t_producer(&t_buffer, 4, 3);
+    t_producer.start();
+    QVERIFY( t_producer.wait(m_iTimeout) );
+    QCOMPARE( t_buffer.fill(), (quint32)4 );
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPop_data()
+{
+    addPolicies();
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPop()
+{
+    QFETCH(int, policy);
+
+    CircularMatrixBuffer<double> t_buffer(4, 2, 2, (CircularMatrixBuffer<double>::WaitPolicy)policy);
+
+    //A consumer waiting on the empty buffer is released with the zero block
+    BufferConsumer t_consumer(&t_buffer, 1, 0);
+    t_consumer.start();
+    QTest::qWait(20);
+    QVERIFY( t_consumer.isRunning() );
+
+    t_buffer.releaseFromPop();
+    t_buffer.clear();
+    QVERIFY( t_consumer.wait(m_iTimeout) );
+    QCOMPARE( t_consumer.errors(), 0 );
+    QCOMPARE( t_consumer.last().cwiseAbs().maxCoeff(), 0.0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPush_data()
+{
+    addPolicies();
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPush()
+{
+    QFETCH(int, policy);
+
+    CircularMatrixBuffer<double> t_buffer(2, 2, 2, (CircularMatrixBuffer<double>::WaitPolicy)policy);
+
+    //The third block does not fit, the producer waits until it is released and then drops the block
+    BufferProducer t_producer(&t_buffer, 3);
+    t_producer.start();
+    QTest::qWait(20);
+    QVERIFY( t_producer.isRunning() );
+
+    t_buffer.releaseFromPush();
+    QVERIFY( t_producer.wait(m_iTimeout) );
+    QCOMPARE( t_buffer.fill(), (quint32)2 );
+    QVERIFY( t_buffer.overruns() > 0 );
+
+    BufferConsumer t_consumer(&t_buffer, 2);
+    t_consumer.start();
+    QVERIFY( t_consumer.wait(m_iTimeout) );
+    QCOMPARE( t_consumer.errors(), 0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::resetDropsStaleRelease_data()
+{
+    addPolicies();
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::resetDropsStaleRelease()
+{
+    QFETCH(int, policy);
+
+    CircularMatrixBuffer<double> t_buffer(4, 2, 2, (CircularMatrixBuffer<double>::WaitPolicy)policy);
+
+    //Stop sequence of a run whose consumer did not wait at that moment, then a restart
+    MatrixXd t_mat = MatrixXd::Constant(2, 2, -1.0);
+    t_buffer.push(&t_mat);
+    t_buffer.releaseFromPop();
+    t_buffer.clear();
+    t_buffer.reset();
+
+    //The next run has to see its own blocks only, not the zero block of the stale release or the old block
+    BufferConsumer t_consumer(&t_buffer, 16);
+    BufferProducer t_producer(&t_buffer, 16);
+    t_consumer.start();
+    t_producer.start();
+
+    QVERIFY( t_producer.wait(m_iTimeout) );
+    QVERIFY( t_consumer.wait(m_iTimeout) );
+    QCOMPARE( t_consumer.errors(), 0 );
+    QCOMPARE( t_buffer.fill(), (quint32)0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_MAIN(TestCircularMatrixBuffer)
+#include "test_circularmatrixbuffer.moc"
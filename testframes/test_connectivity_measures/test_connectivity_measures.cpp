@@ -0,0 +1,219 @@
+//=============================================================================================================
+/**
+* @file     test_connectivity_measures.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the correlation matrices of ConnectivityMeasures
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <connectivity/connectivitymeasures.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace CONNECTIVITYLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Exposes the protected correlation computations of ConnectivityMeasures to the test.
+*/
+class ConnectivityMeasuresMatrices : public ConnectivityMeasures
+{
+public:
+    using ConnectivityMeasures::calcPearsonsCorrelationCoeff;
+    using ConnectivityMeasures::calcCrossCorrelation;
+    using ConnectivityMeasures::calcPearsonsCorrelationMatrix;
+    using ConnectivityMeasures::calcCrossCorrelationMatrix;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestConnectivityMeasures
+*
+* @brief The TestConnectivityMeasures class compares every entry of the Pearson's and cross correlation matrices
+* with the correlation of the corresponding pair of rows
+*
+*/
+class TestConnectivityMeasures: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestConnectivityMeasures();
+
+private slots:
+    void initTestCase();
+    void comparePearsonsCorrelationMatrix_data();
+    void comparePearsonsCorrelationMatrix();
+    void compareCrossCorrelationMatrix_data();
+    void compareCrossCorrelationMatrix();
+    void cleanupTestCase();
+
+private:
+    double epsilon;
+};
+
+
+//*************************************************************************************************************
+
+TestConnectivityMeasures::TestConnectivityMeasures()
+: epsilon(0.0000000001)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::initTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::comparePearsonsCorrelationMatrix_data()
+{
+    QTest::addColumn<int>("iRows");
+    QTest::addColumn<int>("iCols");
+
+    QTest::newRow("single row") << 1 << 7;
+    QTest::newRow("two samples") << 5 << 2;
+    QTest::newRow("one full tile") << 8 << 64;
+    QTest::newRow("partial tile") << 21 << 100;
+    QTest::newRow("odd length") << 9 << 257;
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::comparePearsonsCorrelationMatrix()
+{
+    QFETCH(int, iRows);
+    QFETCH(int, iCols);
+
+    MatrixXd matData = MatrixXd::Random(iRows, iCols);
+    MatrixXd matCoeffs = ConnectivityMeasuresMatrices::calcPearsonsCorrelationMatrix(matData);
+
+    QVERIFY( matCoeffs.rows() == iRows && matCoeffs.cols() == iRows );
+
+    double dMax = matCoeffs.cwiseAbs().maxCoeff();
+    QVERIFY( dMax > 0.0 );
+
+    //Only the lower triangle is set
+    for(int i = 0; i < iRows; ++i) {
+        for(int j = 0; j <= i; ++j) {
+            double dRef = ConnectivityMeasuresMatrices::calcPearsonsCorrelationCoeff(matData.row(i), matData.row(j));
+            QVERIFY( qAbs(matCoeffs(i,j) - dRef) <= epsilon * dMax );
+        }
+        for(int j = i + 1; j < iRows; ++j) {
+            QVERIFY( matCoeffs(i,j) == 0.0 );
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::compareCrossCorrelationMatrix_data()
+{
+    QTest::addColumn<int>("iRows");
+    QTest::addColumn<int>("iCols");
+
+    QTest::newRow("single row") << 1 << 7;
+    QTest::newRow("two samples") << 5 << 2;
+    QTest::newRow("one full tile") << 8 << 64;
+    QTest::newRow("partial tile") << 21 << 100;
+    QTest::newRow("odd length") << 9 << 257;
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::compareCrossCorrelationMatrix()
+{
+    QFETCH(int, iRows);
+    QFETCH(int, iCols);
+
+    MatrixXd matData = MatrixXd::Random(iRows, iCols);
+    MatrixXd matCorr = ConnectivityMeasuresMatrices::calcCrossCorrelationMatrix(matData);
+
+    QVERIFY( matCorr.rows() == iRows && matCorr.cols() == iRows );
+
+    double dMax = matCorr.cwiseAbs().maxCoeff();
+    QVERIFY( dMax > 0.0 );
+
+    //Only the upper triangle is set
+    for(int i = 0; i < iRows; ++i) {
+        for(int j = 0; j < i; ++j) {
+            QVERIFY( matCorr(i,j) == 0.0 );
+        }
+        for(int j = i; j < iRows; ++j) {
+            double dRef = ConnectivityMeasuresMatrices::calcCrossCorrelation(matData.row(i), matData.row(j)).second;
+            QVERIFY( qAbs(matCorr(i,j) - dRef) <= epsilon * dMax );
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestConnectivityMeasures::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestConnectivityMeasures)
+#include "test_connectivity_measures.moc"
@@ -77,6 +77,7 @@ private slots:
     void initTestCase();
     void dipoleFitSimple();
     void dipoleFitAdvanced();
+    void dipoleFitParallel();
     void cleanupTestCase();
 
 private:
@@ -273,6 +274,62 @@ void TestDipoleFit::dipoleFitAdvanced()
 }
 
 
+//*************************************************************************************************************
+
+void TestDipoleFit::dipoleFitParallel()
+{
+    QFile testFile;
+
+    //*********************************************************************************************************
+    // Dipole Fit Settings
+    //*********************************************************************************************************
+
+    printf(">>>>>>>>>>>>>>>>>>>>>>>>> Dipole Fit Settings >>>>>>>>>>>>>>>>>>>>>>>>>\n");
+
+    //Same as dipoleFitSimple, the MEG and EEG sphere models are evaluated concurrently by the fitting threads
+    DipoleFitSettings settings;
+    testFile.setFileName(QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis-ave.fif"); QVERIFY( testFile.exists() );
+    settings.measname = testFile.fileName();
+    settings.is_raw = false;
+    settings.setno = 1;
+    settings.include_meg = true;
+    settings.include_eeg = true;
+    settings.tmin = 32.0f/1000.0f;
+    settings.tmax = 148.0f/1000.0f;
+    settings.bmin = -100.0f/1000.0f;
+    settings.bmax = 0.0f/1000.0f;
+
+    settings.checkIntegrity();
+
+    printf("<<<<<<<<<<<<<<<<<<<<<<<<< Dipole Fit Settings Finished <<<<<<<<<<<<<<<<<<<<<<<<<\n");
+
+
+    //*********************************************************************************************************
+    // Compute Dipole Fit in parallel and sequentially
+    //*********************************************************************************************************
+
+    printf(">>>>>>>>>>>>>>>>>>>>>>>>> Compute Dipole Fit >>>>>>>>>>>>>>>>>>>>>>>>>\n");
+
+    settings.verbose = false;
+    DipoleFit dipFitParallel(&settings);
+    m_ECDSet = dipFitParallel.calculateFit();
+
+    //Verbose fits run in a single thread
+    settings.verbose = true;
+    DipoleFit dipFitSequential(&settings);
+    m_refECDSet = dipFitSequential.calculateFit();
+
+    printf("<<<<<<<<<<<<<<<<<<<<<<<<< Compute Dipole Fit Finished <<<<<<<<<<<<<<<<<<<<<<<<<\n");
+
+
+    //*********************************************************************************************************
+    // Compare Fit
+    //*********************************************************************************************************
+
+    compareFit();
+}
+
+
 //*************************************************************************************************************
 
 void TestDipoleFit::compareFit()
@@ -78,6 +78,12 @@ private slots:
     void compareData();
     void compareTimes();
     void compareInfo();
+    void compareMappedData();
+    void compareFloatData();
+    void compareDirIndex();
+    void compareAsyncWrite();
+    void compareCompressed();
+    void comparePrefetch();
     void cleanupTestCase();
 
 private:
@@ -319,6 +325,264 @@ void TestFiffRWR::compareInfo()
     }
 }
 
+//*************************************************************************************************************
+
+void TestFiffRWR::compareMappedData()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    FiffRawData raw(t_fileIn);
+
+    //
+    //   Read the same segment through the stream and through the mapping
+    //
+    fiff_int_t from = raw.first_samp + 1000;
+    fiff_int_t to = from + 2*ceil(raw.info.sfreq);
+
+    MatrixXd stream_data, stream_times;
+    QVERIFY( raw.read_raw_segment(stream_data, stream_times, from, to) );
+
+    FiffRawMappedReader mappedReader(raw);
+    QVERIFY( mappedReader.map() );
+
+    MatrixXd mapped_data;
+    QVERIFY( mappedReader.read_raw_segment(mapped_data, from, to) );
+
+    QVERIFY( stream_data.rows() == mapped_data.rows() );
+    QVERIFY( stream_data.cols() == mapped_data.cols() );
+    QVERIFY( (stream_data - mapped_data).array().abs().maxCoeff() < epsilon );
+
+    //
+    //   Selection
+    //
+    RowVectorXi sel(3);
+    sel << 0, 5, 10;
+    QVERIFY( mappedReader.read_raw_segment(mapped_data, from, to, sel) );
+    for(qint32 i = 0; i < sel.size(); ++i)
+        QVERIFY( (stream_data.row(sel[i]) - mapped_data.row(i)).array().abs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareFloatData()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    FiffRawData raw(t_fileIn);
+
+    fiff_int_t from = raw.first_samp + 1000;
+    fiff_int_t to = from + 2*ceil(raw.info.sfreq);
+
+    MatrixXd data, times;
+    QVERIFY( raw.read_raw_segment(data, times, from, to) );
+
+    //
+    //   Single precision through the stream and through the mapping, compared relative to the channel range
+    //
+    VectorXd range = data.array().abs().rowwise().maxCoeff().max(1e-30);
+
+    MatrixXf data_float, times_float;
+    QVERIFY( raw.read_raw_segment(data_float, times_float, from, to) );
+    QVERIFY( data_float.rows() == data.rows() && data_float.cols() == data.cols() );
+    QVERIFY( ((data_float.cast<double>() - data).array().abs().colwise() / range.array()).maxCoeff() < 1e-5 );
+
+    FiffRawMappedReader mappedReader(raw);
+    MatrixXf mapped_float;
+    QVERIFY( mappedReader.read_raw_segment(mapped_float, from, to) );
+    QVERIFY( ((mapped_float.cast<double>() - data).array().abs().colwise() / range.array()).maxCoeff() < 1e-5 );
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareDirIndex()
+{
+    QFile t_fileOut("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_out.fif");
+    QFile::remove(FiffStream::dir_index_name(t_fileOut.fileName()));
+
+    //
+    //   The written file has no directory pointer, the first open scans the tags
+    //
+    FiffStream::SPtr t_pStream(new FiffStream(&t_fileOut));
+    QVERIFY( t_pStream->open() );
+    QVERIFY( !t_pStream->has_dir_pointer() );
+    QList<FiffDirEntry::SPtr> scanned_dir = t_pStream->dir();
+    QVERIFY( t_pStream->write_dir_index() );
+    t_pStream->close();
+
+    //
+    //   The second open has to load the same directory from the index
+    //
+    t_pStream = FiffStream::SPtr(new FiffStream(&t_fileOut));
+    QVERIFY( t_pStream->open() );
+    QList<FiffDirEntry::SPtr> indexed_dir;
+    QVERIFY( t_pStream->read_dir_index(indexed_dir) );
+    t_pStream->close();
+
+    QVERIFY( scanned_dir.size() == indexed_dir.size() );
+    for( qint32 i = 0; i < scanned_dir.size(); ++i )
+    {
+        QVERIFY( scanned_dir[i]->kind == indexed_dir[i]->kind );
+        QVERIFY( scanned_dir[i]->type == indexed_dir[i]->type );
+        QVERIFY( scanned_dir[i]->size == indexed_dir[i]->size );
+        QVERIFY( scanned_dir[i]->pos == indexed_dir[i]->pos );
+    }
+
+    QFile::remove(FiffStream::dir_index_name(t_fileOut.fileName()));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareAsyncWrite()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    QFile t_fileOut("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_async_out.fif");
+
+    FiffRawData raw(t_fileIn);
+    fiff_int_t quantum = ceil(raw.info.sfreq);
+    fiff_int_t from = raw.first_samp;
+    fiff_int_t to = from + 3*quantum - 1;
+
+    //
+    //   Write through the asynchronous writer
+    //
+    FiffRawWriter writer(t_fileOut, raw.info, 4, quantum);
+    QVERIFY( writer.start(from) );
+
+    MatrixXd data, times;
+    for(fiff_int_t first = from; first < to; first += quantum)
+    {
+        QVERIFY( raw.read_raw_segment(data, times, first, first + quantum - 1) );
+        while(!writer.write_raw_buffer(data))
+            QThread::msleep(1);
+    }
+    QVERIFY( writer.finish() );
+    QVERIFY( writer.queueDepth() == 0 );
+    QVERIFY( writer.bytesWritten() > 0 );
+
+    //
+    //   Read back and compare the last buffer
+    //
+    FiffRawData raw_async(t_fileOut);
+    MatrixXd data_async, times_async;
+    QVERIFY( raw_async.read_raw_segment(data_async, times_async, to - quantum + 1, to) );
+
+    QVERIFY( data.rows() == data_async.rows() && data.cols() == data_async.cols() );
+    QVERIFY( (data - data_async).array().abs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareCompressed()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    QFile t_fileOut("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_compressed_out.fif");
+    QFile t_fileRef("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_uncompressed_out.fif");
+
+    FiffRawData raw(t_fileIn);
+    fiff_int_t quantum = ceil(raw.info.sfreq);
+    fiff_int_t from = raw.first_samp;
+    fiff_int_t to = from + 3*quantum - 1;
+
+    //
+    //   Write the same samples compressed and uncompressed
+    //
+    RowVectorXd cals, cals_ref;
+    FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileOut, raw.info, cals);
+    FiffStream::SPtr reffid = FiffStream::start_writing_raw(t_fileRef, raw.info, cals_ref);
+    outfid->write_int(FIFF_FIRST_SAMPLE, &from);
+    reffid->write_int(FIFF_FIRST_SAMPLE, &from);
+
+    MatrixXd data, times;
+    QVERIFY( raw.read_raw_segment(data, times, from, to) );
+
+    //The samples have to lie on the integer grid of the written calibration, otherwise they are rejected
+    MatrixXd data_float = data.middleCols(0, quantum);
+    data_float(0,0) += 0.25*cals[0];
+    QVERIFY( !outfid->write_raw_buffer_compressed(data_float, cals) );
+
+    data = cals.transpose().asDiagonal() * (cals.transpose().cwiseInverse().asDiagonal() * data).array().round().matrix();
+
+    for(fiff_int_t first = 0; first < data.cols(); first += quantum) {
+        QVERIFY( outfid->write_raw_buffer_compressed(data.middleCols(first, quantum), cals) );
+        QVERIFY( reffid->write_raw_buffer(data.middleCols(first, quantum), cals_ref) );
+    }
+    outfid->finish_writing_raw();
+    reffid->finish_writing_raw();
+
+    QVERIFY( t_fileOut.size() < t_fileRef.size() );
+
+    //
+    //   Read back through the stream and through the mapping, across buffer boundaries. The round-trip has to be
+    //   bit-exact with respect to the uncompressed file.
+    //
+    FiffRawData raw_compressed(t_fileOut);
+    FiffRawData raw_ref(t_fileRef);
+    fiff_int_t seg_from = from + quantum/2;
+    fiff_int_t seg_to = to - quantum/2;
+
+    MatrixXd data_compressed, times_compressed, data_ref, times_ref;
+    QVERIFY( raw_compressed.read_raw_segment(data_compressed, times_compressed, seg_from, seg_to) );
+    QVERIFY( raw_ref.read_raw_segment(data_ref, times_ref, seg_from, seg_to) );
+    QVERIFY( data_compressed == data_ref );
+
+    FiffRawMappedReader mappedReader(raw_compressed);
+    FiffRawMappedReader mappedReaderRef(raw_ref);
+    QVERIFY( mappedReader.map() );
+    QVERIFY( mappedReaderRef.map() );
+    QVERIFY( mappedReader.read_raw_segment(data_compressed, seg_from, seg_to) );
+    QVERIFY( mappedReaderRef.read_raw_segment(data_ref, seg_from, seg_to) );
+    QVERIFY( data_compressed == data_ref );
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::comparePrefetch()
+{
+    QString sFileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    QString sFileSplit("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_split.fif");
+    QString sFileSplitCont("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_split-1.fif");
+
+    //
+    //   Fake a split recording from two copies of the input file
+    //
+    QFile::remove(sFileSplit);
+    QFile::remove(sFileSplitCont);
+    QVERIFY( QFile::copy(sFileIn, sFileSplit) );
+    QVERIFY( QFile::copy(sFileIn, sFileSplitCont) );
+    QVERIFY( FiffRawPrefetcher::continuationFiles(sFileSplit) == QStringList() << sFileSplitCont );
+
+    QFile t_fileIn(sFileIn);
+    FiffRawData raw(t_fileIn);
+    MatrixXd data, times;
+    QVERIFY( raw.read_raw_segment(data, times) );
+
+    //
+    //   Budget for about two segments, so the readers have to wait for the consumer
+    //
+    fiff_int_t segmentSamples = ceil(raw.info.sfreq);
+    qint64 budget = 2 * (qint64)raw.info.nchan * segmentSamples * sizeof(double);
+    FiffRawPrefetcher prefetcher(QStringList() << sFileIn << sFileSplit, segmentSamples, budget, 2);
+
+    QVector<qint32> vecSamples(2, 0);
+    FiffRawPrefetcher::Segment segment;
+    qint32 lastRecording = 0;
+    while(prefetcher.next(segment)) {
+        QVERIFY( segment.recording >= lastRecording );
+        lastRecording = segment.recording;
+
+        QVERIFY( segment.data.cols() == segment.to - segment.from + 1 );
+        QVERIFY( (data.middleCols(segment.from - raw.first_samp, segment.data.cols()) - segment.data).array().abs().maxCoeff() < epsilon );
+        vecSamples[segment.recording] += segment.data.cols();
+    }
+
+    QVERIFY( vecSamples[0] == data.cols() );
+    QVERIFY( vecSamples[1] == 2 * data.cols() );
+}
+
+
 //*************************************************************************************************************
 
 void TestFiffRWR::cleanupTestCase()
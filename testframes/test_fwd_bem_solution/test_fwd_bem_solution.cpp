@@ -0,0 +1,454 @@
+//=============================================================================================================
+/**
+* @file     test_fwd_bem_solution.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the BEM solution
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fwd/fwd_bem_model.h>
+
+#include <mne/c/mne_surface_old.h>
+#include <mne/c/mne_source_space_old.h>
+#include <mne/c/mne_triangle.h>
+
+#include <fiff/fiff_file.h>
+
+#include <stdlib.h>
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Dense>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FWDLIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFwdBemSolution
+*
+* @brief The TestFwdBemSolution class compares the BEM solutions of a small three layer sphere model with a serial
+* double precision computation
+*
+*/
+class TestFwdBemSolution : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFwdBemSolution();
+
+private slots:
+    void initTestCase();
+    void compareLinearCollocation();
+    void compareConstantCollocation();
+    void cleanupTestCase();
+
+private:
+    FwdBemModel* createModel() const;
+    MneSurfaceOld* createSphere(int iId, float fRadius) const;
+    MatrixXd multiSolution(const MatrixXd& matCoeff, const MatrixXd& matGamma, const VectorXi& vecNum) const;
+    MatrixXd ipSolution(const MatrixXd& matCoeff, const MatrixXd& matGamma, const VectorXi& vecNum, double dIpMult) const;
+    bool compareSolution(const FwdBemModel* m, const MatrixXd& matRef) const;
+
+    double epsilon;
+
+    int m_iNumSubdivisions;
+    float m_sigma[3];
+    float m_radius[3];
+};
+
+
+//*************************************************************************************************************
+
+TestFwdBemSolution::TestFwdBemSolution()
+: epsilon(0.001)
+, m_iNumSubdivisions(2)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdBemSolution::initTestCase()
+{
+    //
+    //   Scalp, skull and brain from the outside to the inside, the skull conductivity requires the IP approach
+    //
+    m_sigma[0] = 0.33f;
+    m_sigma[1] = 0.0132f;
+    m_sigma[2] = 0.33f;
+
+    m_radius[0] = 0.09f;
+    m_radius[1] = 0.085f;
+    m_radius[2] = 0.08f;
+
+    QVERIFY( m_sigma[1]/m_sigma[2] <= FWD_BEM_IP_APPROACH_LIMIT );
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdBemSolution::compareLinearCollocation()
+{
+    FwdBemModel* m = createModel();
+    QVERIFY( FwdBemModel::fwd_bem_linear_collocation_solution(m) == 0 );
+    QVERIFY( m->bem_method == FWD_BEM_LINEAR_COLL );
+
+    //
+    //   Serial assembly of the linear potential coefficients
+    //
+    VectorXi vecNum(m->nsurf);
+    for(int p = 0; p < m->nsurf; ++p) {
+        vecNum[p] = m->surfs[p]->np;
+    }
+    int nTot = vecNum.sum();
+
+    MatrixXd matCoeff = MatrixXd::Zero(nTot, nTot);
+    double omega[3];
+
+    for(int p = 0, joff = 0; p < m->nsurf; joff += vecNum[p], ++p) {
+        MneSurfaceOld* surf1 = m->surfs[p];
+        for(int q = 0, koff = 0; q < m->nsurf; koff += vecNum[q], ++q) {
+            MneSurfaceOld* surf2 = m->surfs[q];
+            for(int j = 0; j < surf1->np; ++j) {
+                for(int k = 0; k < surf2->ntri; ++k) {
+                    MneTriangle* tri = surf2->tris + k;
+                    if(p == q && (tri->vert[0] == j || tri->vert[1] == j || tri->vert[2] == j)) {
+                        continue;
+                    }
+                    FwdBemModel::lin_pot_coeff(surf1->rr[j], tri, omega);
+                    for(int c = 0; c < 3; ++c) {
+                        matCoeff(joff + j, koff + tri->vert[c]) -= omega[c];
+                    }
+                }
+            }
+
+            if(p != q) {
+                continue;
+            }
+
+            //The auto elements receive the missing solid angle, one half to the node and the rest to its neighbors
+            for(int j = 0; j < surf1->np; ++j) {
+                double dMiss = 2.0*M_PI - matCoeff.block(joff + j, koff, 1, vecNum[q]).sum();
+                matCoeff(joff + j, koff + j) = dMiss/2.0;
+                dMiss = dMiss/(4.0*surf1->nneighbor_tri[j]);
+                for(int k = 0; k < surf1->ntri; ++k) {
+                    int* vert = surf1->tris[k].vert;
+                    for(int c = 0; c < 3; ++c) {
+                        if(vert[c] == j) {
+                            matCoeff(joff + j, koff + vert[(c+1)%3]) += dMiss;
+                            matCoeff(joff + j, koff + vert[(c+2)%3]) += dMiss;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    MatrixXd matGamma(m->nsurf, m->nsurf);
+    for(int p = 0; p < m->nsurf; ++p) {
+        for(int q = 0; q < m->nsurf; ++q) {
+            matGamma(p, q) = m->gamma[p][q];
+        }
+    }
+
+    QVERIFY( compareSolution(m, ipSolution(matCoeff, matGamma, vecNum, m_sigma[1]/m_sigma[2])) );
+
+    delete m;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdBemSolution::compareConstantCollocation()
+{
+    FwdBemModel* m = createModel();
+    QVERIFY( FwdBemModel::fwd_bem_constant_collocation_solution(m) == 0 );
+    QVERIFY( m->bem_method == FWD_BEM_CONSTANT_COLL );
+
+    //
+    //   Serial assembly of the solid angle matrix
+    //
+    VectorXi vecNum(m->nsurf);
+    for(int p = 0; p < m->nsurf; ++p) {
+        vecNum[p] = m->surfs[p]->ntri;
+    }
+    int nTot = vecNum.sum();
+
+    MatrixXd matSolids = MatrixXd::Zero(nTot, nTot);
+
+    for(int p = 0, joff = 0; p < m->nsurf; joff += vecNum[p], ++p) {
+        MneSurfaceOld* surf1 = m->surfs[p];
+        for(int q = 0, koff = 0; q < m->nsurf; koff += vecNum[q], ++q) {
+            MneSurfaceOld* surf2 = m->surfs[q];
+            for(int j = 0; j < surf1->ntri; ++j) {
+                for(int k = 0; k < surf2->ntri; ++k) {
+                    if(p != q || j != k) {
+                        matSolids(joff + j, koff + k) = MneSurfaceOrVolume::solid_angle(surf1->tris[j].cent, surf2->tris + k);
+                    }
+                }
+            }
+        }
+    }
+
+    MatrixXd matGamma(m->nsurf, m->nsurf);
+    for(int p = 0; p < m->nsurf; ++p) {
+        for(int q = 0; q < m->nsurf; ++q) {
+            matGamma(p, q) = m->gamma[p][q];
+        }
+    }
+
+    QVERIFY( compareSolution(m, ipSolution(matSolids, matGamma, vecNum, m_sigma[1]/m_sigma[2])) );
+
+    delete m;
+}
+
+
+//*************************************************************************************************************
+
+FwdBemModel* TestFwdBemSolution::createModel() const
+{
+    //
+    //   The same set up as in FwdBemModel::fwd_bem_load_surfaces, the arrays are released by the model
+    //
+    int nsurf = 3;
+    int ids[3] = { FIFFV_BEM_SURF_ID_HEAD, FIFFV_BEM_SURF_ID_SKULL, FIFFV_BEM_SURF_ID_BRAIN };
+
+    FwdBemModel* m = new FwdBemModel;
+    m->nsurf = nsurf;
+    m->sigma = (float*)malloc(nsurf*sizeof(float));
+    m->ntri = (int*)malloc(nsurf*sizeof(int));
+    m->np = (int*)malloc(nsurf*sizeof(int));
+    m->source_mult = (float*)malloc(nsurf*sizeof(float));
+    m->field_mult = (float*)malloc(nsurf*sizeof(float));
+    m->gamma = (float**)malloc(nsurf*sizeof(float*));
+    m->gamma[0] = (float*)malloc(nsurf*nsurf*sizeof(float));
+
+    for(int j = 0; j < nsurf; ++j) {
+        m->surfs.append(createSphere(ids[j], m_radius[j]));
+        m->sigma[j] = m_sigma[j];
+        m->ntri[j] = m->surfs[j]->ntri;
+        m->np[j] = m->surfs[j]->np;
+        m->gamma[j] = m->gamma[0] + j*nsurf;
+    }
+
+    //Zero conductivity outside
+    for(int j = 0; j < nsurf; ++j) {
+        float sigmaOut = (j == 0) ? 0.0f : m_sigma[j-1];
+        m->source_mult[j] = 2.0f/(m_sigma[j] + sigmaOut);
+        m->field_mult[j] = m_sigma[j] - sigmaOut;
+        for(int k = 0; k < nsurf; ++k) {
+            m->gamma[j][k] = (m_sigma[k] - ((k == 0) ? 0.0f : m_sigma[k-1]))/(m_sigma[j] + sigmaOut);
+        }
+    }
+
+    return m;
+}
+
+
+//*************************************************************************************************************
+
+MneSurfaceOld* TestFwdBemSolution::createSphere(int iId, float fRadius) const
+{
+    //
+    //   Subdivided icosahedron
+    //
+    double t = (1.0 + sqrt(5.0))/2.0;
+    QList<Vector3d> lNodes;
+    lNodes << Vector3d(-1,t,0) << Vector3d(1,t,0) << Vector3d(-1,-t,0) << Vector3d(1,-t,0)
+           << Vector3d(0,-1,t) << Vector3d(0,1,t) << Vector3d(0,-1,-t) << Vector3d(0,1,-t)
+           << Vector3d(t,0,-1) << Vector3d(t,0,1) << Vector3d(-t,0,-1) << Vector3d(-t,0,1);
+
+    int ico[20][3] = { {0,11,5}, {0,5,1}, {0,1,7}, {0,7,10}, {0,10,11}, {1,5,9}, {5,11,4}, {11,10,2}, {10,7,6}, {7,1,8},
+                       {3,9,4}, {3,4,2}, {3,2,6}, {3,6,8}, {3,8,9}, {4,9,5}, {2,4,11}, {6,2,10}, {8,6,7}, {9,8,1} };
+    QList<Vector3i> lTris;
+    for(int k = 0; k < 20; ++k) {
+        lTris << Vector3i(ico[k][0], ico[k][1], ico[k][2]);
+    }
+
+    for(int s = 0; s < m_iNumSubdivisions; ++s) {
+        QMap<QPair<int,int>, int> mapMidpoints;
+        QList<Vector3i> lNewTris;
+        for(int k = 0; k < lTris.size(); ++k) {
+            int mid[3];
+            for(int c = 0; c < 3; ++c) {
+                QPair<int,int> edge(qMin(lTris[k][c], lTris[k][(c+1)%3]), qMax(lTris[k][c], lTris[k][(c+1)%3]));
+                if(!mapMidpoints.contains(edge)) {
+                    mapMidpoints.insert(edge, lNodes.size());
+                    lNodes << (lNodes[edge.first] + lNodes[edge.second])/2.0;
+                }
+                mid[c] = mapMidpoints.value(edge);
+            }
+            lNewTris << Vector3i(lTris[k][0], mid[0], mid[2]) << Vector3i(lTris[k][1], mid[1], mid[0])
+                     << Vector3i(lTris[k][2], mid[2], mid[1]) << Vector3i(mid[0], mid[1], mid[2]);
+        }
+        lTris = lNewTris;
+    }
+
+    MneSurfaceOld* s = (MneSurfaceOld*)MneSurfaceOrVolume::mne_new_source_space(lNodes.size());
+    s->id = iId;
+    s->ntri = lTris.size();
+    s->itris = (int**)malloc(s->ntri*sizeof(int*));
+    s->itris[0] = (int*)malloc(3*s->ntri*sizeof(int));
+
+    for(int j = 0; j < s->np; ++j) {
+        Vector3d r = fRadius*lNodes[j].normalized();
+        for(int c = 0; c < 3; ++c) {
+            s->rr[j][c] = r[c];
+        }
+    }
+
+    for(int k = 0; k < s->ntri; ++k) {
+        s->itris[k] = s->itris[0] + 3*k;
+        Vector3d r1(s->rr[lTris[k][0]][0], s->rr[lTris[k][0]][1], s->rr[lTris[k][0]][2]);
+        Vector3d r2(s->rr[lTris[k][1]][0], s->rr[lTris[k][1]][1], s->rr[lTris[k][1]][2]);
+        Vector3d r3(s->rr[lTris[k][2]][0], s->rr[lTris[k][2]][1], s->rr[lTris[k][2]][2]);
+
+        //Outward normals
+        bool bFlip = (r2 - r1).cross(r3 - r1).dot(r1 + r2 + r3) < 0;
+        s->itris[k][0] = lTris[k][0];
+        s->itris[k][1] = bFlip ? lTris[k][2] : lTris[k][1];
+        s->itris[k][2] = bFlip ? lTris[k][1] : lTris[k][2];
+    }
+
+    MneSurfaceOrVolume::mne_source_space_add_geometry_info((MneSourceSpaceOld*)s, true);
+
+    return s;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestFwdBemSolution::multiSolution(const MatrixXd& matCoeff, const MatrixXd& matGamma, const VectorXi& vecNum) const
+{
+    //
+    //   Inverse of I - gamma*coeff/(2*pi) with deflation, as in FwdBemModel::fwd_bem_multi_solution
+    //
+    int nTot = vecNum.sum();
+    double defl = 1.0/nTot;
+    MatrixXd matSys(nTot, nTot);
+
+    for(int p = 0, joff = 0; p < vecNum.size(); joff += vecNum[p], ++p) {
+        for(int q = 0, koff = 0; q < vecNum.size(); koff += vecNum[q], ++q) {
+            double mult = matGamma(p, q)/(2.0*M_PI);
+            matSys.block(joff, koff, vecNum[p], vecNum[q]) = (defl - mult*matCoeff.block(joff, koff, vecNum[p], vecNum[q]).array()).matrix();
+        }
+    }
+    matSys.diagonal().array() += 1.0;
+
+    return matSys.fullPivLu().inverse();
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestFwdBemSolution::ipSolution(const MatrixXd& matCoeff, const MatrixXd& matGamma, const VectorXi& vecNum, double dIpMult) const
+{
+    MatrixXd matSol = multiSolution(matCoeff, matGamma, vecNum);
+
+    //
+    //   The isolated problem of the innermost surface, as in FwdBemModel::fwd_bem_ip_modify_solution
+    //
+    int nLast = vecNum[vecNum.size()-1];
+    int nTot = vecNum.sum();
+    MatrixXd matIpSol = multiSolution(matCoeff.bottomRightCorner(nLast, nLast), MatrixXd::Ones(1, 1), VectorXi::Constant(1, nLast));
+
+    for(int j = 0; j < nTot; ++j) {
+        RowVectorXd row = matSol.block(j, nTot - nLast, 1, nLast) * matIpSol;
+        matSol.block(j, nTot - nLast, 1, nLast) -= 2.0*row;
+    }
+    matSol.bottomRightCorner(nLast, nLast) += (1.0 + dIpMult)/dIpMult*matIpSol;
+
+    return dIpMult*matSol;
+}
+
+
+//*************************************************************************************************************
+
+bool TestFwdBemSolution::compareSolution(const FwdBemModel* m, const MatrixXd& matRef) const
+{
+    if(m->nsol != matRef.rows() || !m->solution) {
+        return false;
+    }
+
+    double dMaxError = 0.0;
+    for(int j = 0; j < m->nsol; ++j) {
+        for(int k = 0; k < m->nsol; ++k) {
+            dMaxError = qMax(dMaxError, fabs(m->solution[j][k] - matRef(j, k)));
+        }
+    }
+
+    return dMaxError <= epsilon * matRef.cwiseAbs().maxCoeff();
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdBemSolution::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFwdBemSolution)
+#include "test_fwd_bem_solution.moc"
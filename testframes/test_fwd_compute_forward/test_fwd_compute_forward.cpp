@@ -0,0 +1,334 @@
+//=============================================================================================================
+/**
+* @file     test_fwd_compute_forward.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the threaded MEG and EEG forward computations
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fwd/fwd_bem_model.h>
+#include <fwd/fwd_coil_set.h>
+#include <fwd/fwd_coil.h>
+#include <fwd/fwd_eeg_sphere_model.h>
+
+#include <mne/c/mne_surface_or_volume.h>
+#include <mne/c/mne_source_space_old.h>
+#include <mne/c/mne_named_matrix.h>
+
+#include <stdlib.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QThread>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FWDLIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFwdComputeForward
+*
+* @brief The TestFwdComputeForward class checks that the threaded MEG and EEG forward computations give the same
+* matrices as the computation without threads
+*
+*/
+class TestFwdComputeForward : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFwdComputeForward();
+
+private slots:
+    void initTestCase();
+    void compareMeg_data();
+    void compareMeg();
+    void compareEeg_data();
+    void compareEeg();
+    void cleanupTestCase();
+
+private:
+    FwdCoilSet* createCoils(int iNumCoils, int iCoilClass, float fRadius) const;
+    MneSourceSpaceOld* createSourceSpace(int iNumPoints) const;
+    bool compareMatrices(MneNamedMatrix* pMatOne, MneNamedMatrix* pMatTwo) const;
+
+    double epsilon;
+
+    MneSourceSpaceOld* m_pSpaces[2];
+    FwdCoilSet* m_pCoils;
+    FwdCoilSet* m_pEls;
+    FwdEegSphereModel* m_pEegModel;
+    Vector3f m_r0;
+};
+
+
+//*************************************************************************************************************
+
+TestFwdComputeForward::TestFwdComputeForward()
+: epsilon(0.0)
+, m_pCoils(NULL)
+, m_pEls(NULL)
+, m_pEegModel(NULL)
+{
+    m_pSpaces[0] = m_pSpaces[1] = NULL;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::initTestCase()
+{
+    if(QThread::idealThreadCount() < 2)
+        QSKIP("The forward computations are not threaded on a single processor");
+
+    srand(42);
+
+    //
+    //   Two source spaces with some vertices not in use, which gives many chunks of sources for the threads
+    //
+    m_pSpaces[0] = createSourceSpace(300);
+    m_pSpaces[1] = createSourceSpace(250);
+
+    //
+    //   Magnetometers on a helmet-like sphere and electrodes on the scalp
+    //
+    m_pCoils = createCoils(60, FWD_COILC_MAG, 0.12f);
+    m_pEls = createCoils(40, FWD_COILC_EEG, 0.09f);
+
+    m_r0 = Vector3f(0.001f, -0.002f, 0.04f);
+
+    m_pEegModel = FwdEegSphereModel::setup_eeg_sphere_model(QString(), QString(), 0.09f);
+    QVERIFY( m_pEegModel != NULL );
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::compareMeg_data()
+{
+    QTest::addColumn<bool>("bFixedOri");
+
+    QTest::newRow("fixed orientation") << true;
+    QTest::newRow("free orientation") << false;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::compareMeg()
+{
+    QFETCH(bool, bFixedOri);
+
+    MneNamedMatrix* pMeg = NULL;
+    MneNamedMatrix* pMegGrad = NULL;
+    MneNamedMatrix* pMegThreads = NULL;
+    MneNamedMatrix* pMegGradThreads = NULL;
+
+    QVERIFY( FwdBemModel::compute_forward_meg(m_pSpaces, 2, m_pCoils, NULL, NULL, bFixedOri, NULL, &m_r0, false, &pMeg, &pMegGrad) == 0 );
+    QVERIFY( FwdBemModel::compute_forward_meg(m_pSpaces, 2, m_pCoils, NULL, NULL, bFixedOri, NULL, &m_r0, true, &pMegThreads, &pMegGradThreads) == 0 );
+
+    int nSource = m_pSpaces[0]->nuse + m_pSpaces[1]->nuse;
+    QVERIFY( pMeg->nrow == (bFixedOri ? nSource : 3*nSource) && pMeg->ncol == m_pCoils->ncoil );
+    QVERIFY( pMegGrad->nrow == 3*pMeg->nrow );
+
+    QVERIFY( compareMatrices(pMeg, pMegThreads) );
+    QVERIFY( compareMatrices(pMegGrad, pMegGradThreads) );
+
+    delete pMeg;
+    delete pMegGrad;
+    delete pMegThreads;
+    delete pMegGradThreads;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::compareEeg_data()
+{
+    QTest::addColumn<bool>("bFixedOri");
+
+    QTest::newRow("fixed orientation") << true;
+    QTest::newRow("free orientation") << false;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::compareEeg()
+{
+    QFETCH(bool, bFixedOri);
+
+    MneNamedMatrix* pEeg = NULL;
+    MneNamedMatrix* pEegGrad = NULL;
+    MneNamedMatrix* pEegThreads = NULL;
+    MneNamedMatrix* pEegGradThreads = NULL;
+
+    QVERIFY( FwdBemModel::compute_forward_eeg(m_pSpaces, 2, m_pEls, bFixedOri, NULL, m_pEegModel, false, &pEeg, &pEegGrad) == 0 );
+    QVERIFY( FwdBemModel::compute_forward_eeg(m_pSpaces, 2, m_pEls, bFixedOri, NULL, m_pEegModel, true, &pEegThreads, &pEegGradThreads) == 0 );
+
+    int nSource = m_pSpaces[0]->nuse + m_pSpaces[1]->nuse;
+    QVERIFY( pEeg->nrow == (bFixedOri ? nSource : 3*nSource) && pEeg->ncol == m_pEls->ncoil );
+    QVERIFY( pEegGrad->nrow == 3*pEeg->nrow );
+
+    QVERIFY( compareMatrices(pEeg, pEegThreads) );
+    QVERIFY( compareMatrices(pEegGrad, pEegGradThreads) );
+
+    delete pEeg;
+    delete pEegGrad;
+    delete pEegThreads;
+    delete pEegGradThreads;
+}
+
+
+//*************************************************************************************************************
+
+FwdCoilSet* TestFwdComputeForward::createCoils(int iNumCoils, int iCoilClass, float fRadius) const
+{
+    //
+    //   One integration point per electrode, four per magnetometer
+    //
+    int nPoints = iCoilClass == FWD_COILC_EEG ? 1 : 4;
+
+    FwdCoilSet* pCoils = new FwdCoilSet();
+    pCoils->coils = (FwdCoil**)malloc(iNumCoils*sizeof(FwdCoil*));
+    pCoils->ncoil = iNumCoils;
+
+    for(int k = 0; k < iNumCoils; ++k) {
+        FwdCoil* coil = new FwdCoil(nPoints);
+        coil->coil_class = iCoilClass;
+        coil->chname = QString("%1 %2").arg(iCoilClass == FWD_COILC_EEG ? "EEG" : "MEG").arg(k+1, 3, 10, QChar('0'));
+
+        Vector3f dir = Vector3f::Random().normalized();
+        dir[2] = qAbs(dir[2]);
+        Vector3f center = fRadius * dir;
+
+        for(int p = 0; p < nPoints; ++p) {
+            Vector3f point = nPoints > 1 ? Vector3f(center + 0.005f * Vector3f::Random()) : center;
+            for(int c = 0; c < 3; ++c) {
+                coil->rmag[p][c] = point[c];
+                coil->cosmag[p][c] = dir[c];
+            }
+            coil->w[p] = 1.0f/nPoints;
+        }
+
+        pCoils->coils[k] = coil;
+    }
+    pCoils->update_integration_points();
+
+    return pCoils;
+}
+
+
+//*************************************************************************************************************
+
+MneSourceSpaceOld* TestFwdComputeForward::createSourceSpace(int iNumPoints) const
+{
+    MneSourceSpaceOld* pSpace = MneSurfaceOrVolume::mne_new_source_space(iNumPoints);
+
+    for(int k = 0; k < iNumPoints; ++k) {
+        Vector3f rr = 0.07f * Vector3f::Random();
+        Vector3f nn = Vector3f::Random().normalized();
+        for(int c = 0; c < 3; ++c) {
+            pSpace->rr[k][c] = rr[c];
+            pSpace->nn[k][c] = nn[c];
+        }
+        pSpace->vertno[k] = k;
+        pSpace->inuse[k] = rand() % 4 != 0;
+        if(pSpace->inuse[k])
+            pSpace->nuse++;
+    }
+
+    return pSpace;
+}
+
+
+//*************************************************************************************************************
+
+bool TestFwdComputeForward::compareMatrices(MneNamedMatrix* pMatOne, MneNamedMatrix* pMatTwo) const
+{
+    if(!pMatOne || !pMatTwo || pMatOne->nrow != pMatTwo->nrow || pMatOne->ncol != pMatTwo->ncol)
+        return false;
+
+    //
+    //   Every source is computed by the same code with or without threads, so the matrices have to be identical
+    //
+    double dMax = 0.0;
+    for(int j = 0; j < pMatOne->nrow; ++j)
+        for(int k = 0; k < pMatOne->ncol; ++k)
+            dMax = qMax(dMax, (double)qAbs(pMatOne->data[j][k]));
+
+    for(int j = 0; j < pMatOne->nrow; ++j)
+        for(int k = 0; k < pMatOne->ncol; ++k)
+            if(qAbs(pMatOne->data[j][k] - pMatTwo->data[j][k]) > epsilon * dMax)
+                return false;
+
+    return dMax > 0.0;
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdComputeForward::cleanupTestCase()
+{
+    delete m_pSpaces[0];
+    delete m_pSpaces[1];
+    delete m_pCoils;
+    delete m_pEls;
+    delete m_pEegModel;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFwdComputeForward)
+#include "test_fwd_compute_forward.moc"
@@ -0,0 +1,266 @@
+//=============================================================================================================
+/**
+* @file     test_fwd_sphere_field.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the sphere model field computations
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fwd/fwd_bem_model.h>
+#include <fwd/fwd_coil_set.h>
+#include <fwd/fwd_coil.h>
+
+#include <stdlib.h>
+#include <limits>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FWDLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFwdSphereField
+*
+* @brief The TestFwdSphereField class compares the sphere model field kernels with a double precision evaluation of
+* the Sarvas formula
+*
+*/
+class TestFwdSphereField : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFwdSphereField();
+
+private slots:
+    void initTestCase();
+    void compareField();
+    void compareVecField();
+    void cleanupTestCase();
+
+private:
+    void sarvasField(const MatrixX3f& p_matRd, const MatrixX3f& p_matQ, MatrixXf& p_matB) const;
+
+    double epsilon;
+
+    FwdCoilSet* m_pCoils;
+    float m_r0[3];
+    MatrixX3f m_matRd;
+    MatrixX3f m_matQ;
+};
+
+
+//*************************************************************************************************************
+
+TestFwdSphereField::TestFwdSphereField()
+: epsilon(0.0001)
+, m_pCoils(NULL)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdSphereField::initTestCase()
+{
+    //
+    //   Magnetometers with four integration points each on a helmet-like sphere
+    //
+    int nCoils = 60;
+    int nPoints = 4;
+
+    srand(42);
+
+    m_pCoils = new FwdCoilSet();
+    m_pCoils->coils = (FwdCoil**)malloc(nCoils*sizeof(FwdCoil*));
+    m_pCoils->ncoil = nCoils;
+
+    for(int k = 0; k < nCoils; ++k) {
+        FwdCoil* coil = new FwdCoil(nPoints);
+        coil->coil_class = FWD_COILC_MAG;
+
+        Vector3f dir = Vector3f::Random().normalized();
+        Vector3f center = 0.12f * dir;
+
+        for(int p = 0; p < nPoints; ++p) {
+            Vector3f point = center + 0.005f * Vector3f::Random();
+            for(int c = 0; c < 3; ++c) {
+                coil->rmag[p][c] = point[c];
+                coil->cosmag[p][c] = dir[c];
+            }
+            coil->w[p] = 1.0f/nPoints;
+        }
+
+        m_pCoils->coils[k] = coil;
+    }
+    m_pCoils->update_integration_points();
+
+    m_r0[0] = 0.001f;
+    m_r0[1] = -0.002f;
+    m_r0[2] = 0.04f;
+
+    //
+    //   Dipoles inside the sphere, the first one at the origin of the sphere model
+    //
+    int nDipoles = 50;
+    m_matRd.resize(nDipoles, 3);
+    m_matQ.resize(nDipoles, 3);
+
+    for(int j = 0; j < nDipoles; ++j) {
+        m_matRd.row(j) = 0.06f * RowVector3f::Random() + RowVector3f(m_r0[0], m_r0[1], m_r0[2]);
+        m_matQ.row(j) = 1e-8f * RowVector3f::Random();
+    }
+    m_matRd.row(0) = RowVector3f(m_r0[0], m_r0[1], m_r0[2]);
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdSphereField::compareField()
+{
+    MatrixXf matRef;
+    sarvasField(m_matRd, m_matQ, matRef);
+
+    VectorXf vecOne(m_pCoils->ncoil);
+    float dMax = matRef.cwiseAbs().maxCoeff();
+    QVERIFY( dMax > 0.0f );
+
+    for(int j = 0; j < m_matRd.rows(); ++j) {
+        RowVector3f rd = m_matRd.row(j);
+        RowVector3f Q = m_matQ.row(j);
+        QVERIFY( FwdBemModel::fwd_sphere_field(rd.data(), Q.data(), m_pCoils, vecOne.data(), m_r0) == 0 );
+        QVERIFY( (vecOne - matRef.col(j)).cwiseAbs().maxCoeff() < epsilon * dMax );
+    }
+
+    //No field from a dipole at the origin of the sphere model
+    RowVector3f rd = m_matRd.row(0);
+    RowVector3f Q = m_matQ.row(0);
+    QVERIFY( FwdBemModel::fwd_sphere_field(rd.data(), Q.data(), m_pCoils, vecOne.data(), m_r0) == 0 );
+    QVERIFY( vecOne.cwiseAbs().maxCoeff() == 0.0f );
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdSphereField::compareVecField()
+{
+    MatrixXf matOne(m_pCoils->ncoil, 3);
+    float* Bval[3] = { matOne.col(0).data(), matOne.col(1).data(), matOne.col(2).data() };
+    VectorXf vecField(m_pCoils->ncoil);
+
+    for(int j = 0; j < m_matRd.rows(); ++j) {
+        RowVector3f rd = m_matRd.row(j);
+        RowVector3f Q = m_matQ.row(j);
+        QVERIFY( FwdBemModel::fwd_sphere_field_vec(rd.data(), m_pCoils, Bval, m_r0) == 0 );
+
+        //The x, y, and z dipoles of unit strength
+        MatrixXf matRef;
+        sarvasField(m_matRd.row(j).replicate(3, 1), Matrix3f::Identity(), matRef);
+        float dMax = qMax(matRef.cwiseAbs().maxCoeff(), std::numeric_limits<float>::min());
+        QVERIFY( (matOne - matRef).cwiseAbs().maxCoeff() <= epsilon * dMax );
+
+        //The fields of the three orthogonal dipoles combine to the field of the dipole Q
+        QVERIFY( FwdBemModel::fwd_sphere_field(rd.data(), Q.data(), m_pCoils, vecField.data(), m_r0) == 0 );
+        QVERIFY( (matOne * Q.transpose() - vecField).cwiseAbs().maxCoeff() <= epsilon * (matOne * Q.transpose()).cwiseAbs().maxCoeff() );
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdSphereField::sarvasField(const MatrixX3f& p_matRd, const MatrixX3f& p_matQ, MatrixXf& p_matB) const
+{
+    //
+    //   Sarvas (1987) in double precision, coil by coil from the integration points of each FwdCoil
+    //
+    Vector3d r0(m_r0[0], m_r0[1], m_r0[2]);
+    p_matB.setZero(m_pCoils->ncoil, p_matRd.rows());
+
+    for(int j = 0; j < p_matRd.rows(); ++j) {
+        Vector3d rd = p_matRd.row(j).transpose().cast<double>() - r0;
+        Vector3d Q = p_matQ.row(j).transpose().cast<double>();
+        if(rd.norm() <= 1e-5)
+            continue;
+        Vector3d v = Q.cross(rd);
+
+        for(int k = 0; k < m_pCoils->ncoil; ++k) {
+            FwdCoil* coil = m_pCoils->coils[k];
+            double dSum = 0.0;
+            for(int p = 0; p < coil->np; ++p) {
+                Vector3d r = Vector3d(coil->rmag[p][0], coil->rmag[p][1], coil->rmag[p][2]) - r0;
+                Vector3d e(coil->cosmag[p][0], coil->cosmag[p][1], coil->cosmag[p][2]);
+                Vector3d a = r - rd;
+                double dA = a.norm();
+                double dR = r.norm();
+                double dF = dA*(dR*dA + dR*dR - r.dot(rd));
+                Vector3d gradF = (dA*dA/dR + a.dot(r)/dA + 2.0*dA + 2.0*dR)*r - (dA + 2.0*dR + a.dot(r)/dA)*rd;
+                dSum += coil->w[p]*(dF*v.dot(e) - v.dot(r)*gradF.dot(e))/(dF*dF);
+            }
+            p_matB(k, j) = 1e-7*dSum;
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFwdSphereField::cleanupTestCase()
+{
+    delete m_pCoils;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFwdSphereField)
+#include "test_fwd_sphere_field.moc"
@@ -0,0 +1,279 @@
+//=============================================================================================================
+/**
+* @file     test_guess_data.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the guess field cache of the dipole fit
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <inverse/dipoleFit/guess_data.h>
+#include <inverse/dipoleFit/dipole_fit_data.h>
+
+#include <fwd/fwd_coil_set.h>
+#include <fwd/fwd_coil.h>
+
+#include <fiff/c/fiff_coord_trans_old.h>
+#include <fiff/fiff_constants.h>
+
+#include <stdlib.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace FWDLIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestGuessData
+*
+* @brief The TestGuessData class writes and reads back the guess field cache and checks that the cache key changes
+* with the geometry the guess fields depend on
+*
+*/
+class TestGuessData: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestGuessData();
+
+private slots:
+    void initTestCase();
+    void compareCacheRoundTrip();
+    void compareCacheKey();
+    void cleanupTestCase();
+
+private:
+    float **guessLocations(const MatrixX3f& matRR) const;
+
+    int m_iNumGuesses;
+    int m_iNumChannels;
+
+    MatrixX3f m_matRR;
+    QTemporaryDir m_tempDir;
+};
+
+
+//*************************************************************************************************************
+
+TestGuessData::TestGuessData()
+: m_iNumGuesses(20)
+, m_iNumChannels(30)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestGuessData::initTestCase()
+{
+    QVERIFY( m_tempDir.isValid() );
+
+    m_matRR = 0.06f * MatrixX3f::Random(m_iNumGuesses, 3);
+}
+
+
+//*************************************************************************************************************
+
+void TestGuessData::compareCacheRoundTrip()
+{
+    QString sName = QDir(m_tempDir.path()).filePath("cache/guess-fields.bin");
+
+    GuessData guessWrite;
+    guessWrite.nguess = m_iNumGuesses;
+    guessWrite.rr = guessLocations(m_matRR);
+    guessWrite.guess_field = MatrixXf::Random(3*m_iNumGuesses, m_iNumChannels);
+
+    //The directory is created on demand
+    QVERIFY( guessWrite.write_guess_field_cache(sName) );
+
+    GuessData guessRead;
+    guessRead.nguess = m_iNumGuesses;
+    guessRead.rr = guessLocations(m_matRR);
+    QVERIFY( guessRead.read_guess_field_cache(sName, m_iNumChannels) );
+    QVERIFY( guessRead.guess_field == guessWrite.guess_field );
+
+    //Another channel count, other guess locations and a missing file are rejected
+    GuessData guessOther;
+    guessOther.nguess = m_iNumGuesses;
+    guessOther.rr = guessLocations(m_matRR);
+    QVERIFY( !guessOther.read_guess_field_cache(sName, m_iNumChannels+1) );
+
+    guessOther.rr[m_iNumGuesses-1][2] += 0.001f;
+    QVERIFY( !guessOther.read_guess_field_cache(sName, m_iNumChannels) );
+    QVERIFY( guessOther.guess_field.size() == 0 );
+
+    QVERIFY( !guessRead.read_guess_field_cache(QDir(m_tempDir.path()).filePath("missing.bin"), m_iNumChannels) );
+
+    //A truncated file is rejected
+    QFile file(sName);
+    QVERIFY( file.resize(file.size() - sizeof(float)) );
+
+    GuessData guessTruncated;
+    guessTruncated.nguess = m_iNumGuesses;
+    guessTruncated.rr = guessLocations(m_matRR);
+    QVERIFY( !guessTruncated.read_guess_field_cache(sName, m_iNumChannels) );
+    QVERIFY( guessTruncated.guess_field.size() == 0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestGuessData::compareCacheKey()
+{
+    //
+    //   Magnetometers in head coordinates and a device to head transformation
+    //
+    int nCoils = 10;
+
+    DipoleFitData f;
+    f.coord_frame = FIFFV_COORD_HEAD;
+    f.nmeg = nCoils;
+    f.r0[2] = 0.04f;
+
+    f.meg_coils = new FwdCoilSet();
+    f.meg_coils->coils = (FwdCoil**)malloc(nCoils*sizeof(FwdCoil*));
+    f.meg_coils->ncoil = nCoils;
+
+    for(int k = 0; k < nCoils; ++k) {
+        FwdCoil* coil = new FwdCoil(1);
+        coil->coil_class = FWD_COILC_MAG;
+
+        Vector3f dir = Vector3f::Random().normalized();
+        for(int c = 0; c < 3; ++c) {
+            coil->rmag[0][c] = 0.12f * dir[c];
+            coil->cosmag[0][c] = dir[c];
+        }
+        coil->w[0] = 1.0f;
+
+        f.meg_coils->coils[k] = coil;
+    }
+    f.meg_coils->update_integration_points();
+
+    float rot[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    float move[3] = { 0.0f, 0.0f, 0.04f };
+    f.meg_head_t = new FiffCoordTransOld(FIFFV_COORD_DEVICE, FIFFV_COORD_HEAD, rot, move);
+
+    float **rr = guessLocations(m_matRR);
+    QString sGuessSurf("inner_skull.surf");
+    float fMinDist = 0.01f;
+    float fExclude = 0.02f;
+    float fGrid = 0.01f;
+
+    QString sKey = GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid);
+    QVERIFY( sKey.size() == 40 );
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) == sKey );
+
+    //Transformation
+    f.meg_head_t->move[1] += 0.001f;
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+    f.meg_head_t->move[1] -= 0.001f;
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) == sKey );
+
+    //Coil set
+    f.meg_coils->coils[3]->rmag[0][0] += 0.001f;
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+    f.meg_coils->coils[3]->rmag[0][0] -= 0.001f;
+
+    f.meg_coils->coils[5]->cosmag[0][1] = -f.meg_coils->coils[5]->cosmag[0][1];
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+    f.meg_coils->coils[5]->cosmag[0][1] = -f.meg_coils->coils[5]->cosmag[0][1];
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) == sKey );
+
+    //Guess grid
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, 0.005f) != sKey );
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, 0.005f, fExclude, fGrid) != sKey );
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, 0.0f, fGrid) != sKey );
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString("guesses-src.fif"), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses-1, QString(), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+
+    rr[0][0] += 0.001f;
+    QVERIFY( GuessData::guess_field_key(&f, rr, m_iNumGuesses, QString(), sGuessSurf, fMinDist, fExclude, fGrid) != sKey );
+
+    free(rr[0]);
+    free(rr);
+}
+
+
+//*************************************************************************************************************
+
+void TestGuessData::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+float **TestGuessData::guessLocations(const MatrixX3f& matRR) const
+{
+    //Same layout as the guess locations allocated by GuessData, which frees them
+    float **rr = (float **)malloc(matRR.rows()*sizeof(float *));
+    rr[0] = (float *)malloc(matRR.rows()*3*sizeof(float));
+
+    for(int k = 0; k < matRR.rows(); ++k) {
+        rr[k] = rr[0] + 3*k;
+        for(int p = 0; p < 3; ++p) {
+            rr[k][p] = matRR(k, p);
+        }
+    }
+
+    return rr;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestGuessData)
+#include "test_guess_data.moc"
@@ -0,0 +1,213 @@
+//=============================================================================================================
+/**
+* @file     test_hpi_fit.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the session handling of the HPIFit
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <inverse/hpiFit/hpifit.h>
+
+#include <fiff/fiff_raw_data.h>
+#include <fiff/fiff_info.h>
+#include <fiff/fiff_dig_point_set.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <qmath.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestHpiFit
+*
+* @brief The TestHpiFit class checks that a kept HPIFit session follows changes of the measurement info
+*
+*/
+class TestHpiFit: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestHpiFit();
+
+private slots:
+    void initTestCase();
+    void compareChangedDig();
+    void cleanupTestCase();
+
+private:
+    MatrixXd simulateData(const MatrixXd& matCoilPos, int iNumSamples) const;
+
+    double epsilon;
+
+    FiffInfo::SPtr m_pFiffInfo;
+    QVector<int> m_vFreqs;
+};
+
+
+//*************************************************************************************************************
+
+TestHpiFit::TestHpiFit()
+: epsilon(0.00001)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestHpiFit::initTestCase()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+
+    FiffRawData raw(t_fileIn);
+    m_pFiffInfo = FiffInfo::SPtr(new FiffInfo(raw.info));
+    m_pFiffInfo->bads.clear();
+
+    m_vFreqs << 154 << 158 << 161 << 165;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestHpiFit::simulateData(const MatrixXd& matCoilPos, int iNumSamples) const
+{
+    //Magnetic dipoles along z in device space, each one driven with its coil frequency
+    MatrixXd data = MatrixXd::Zero(m_pFiffInfo->nchan, iNumSamples);
+
+    for(int c = 0; c < matCoilPos.rows(); ++c) {
+        for(int i = 0; i < m_pFiffInfo->nchan; ++i) {
+            Vector3d r, ez;
+            for(int k = 0; k < 3; ++k) {
+                r[k] = m_pFiffInfo->chs[i].chpos.r0[k] - matCoilPos(c,k);
+                ez[k] = m_pFiffInfo->chs[i].chpos.ez[k];
+            }
+
+            double dNorm = r.norm();
+            Vector3d field = 1e-7 * (3.0 * r * r[2] / pow(dNorm, 5) - Vector3d::UnitZ() / pow(dNorm, 3));
+
+            for(int s = 0; s < iNumSamples; ++s) {
+                data(i,s) += field.dot(ez) * sin(2 * M_PI * m_vFreqs[c] * s / m_pFiffInfo->sfreq);
+            }
+        }
+    }
+
+    return data;
+}
+
+
+//*************************************************************************************************************
+
+void TestHpiFit::compareChangedDig()
+{
+    //The coils sit at the digitized positions transformed to device space
+    MatrixXd matCoilPos(0,3);
+    for(int i = 0; i < m_pFiffInfo->dig.size(); ++i) {
+        if(m_pFiffInfo->dig[i].kind == FIFFV_POINT_HPI) {
+            Vector4f r(m_pFiffInfo->dig[i].r[0], m_pFiffInfo->dig[i].r[1], m_pFiffInfo->dig[i].r[2], 1.0f);
+            Vector4f rDev = m_pFiffInfo->dev_head_t.invtrans * r;
+            matCoilPos.conservativeResize(matCoilPos.rows() + 1, 3);
+            matCoilPos.row(matCoilPos.rows() - 1) = rDev.head(3).cast<double>().transpose();
+        }
+    }
+    QVERIFY( matCoilPos.rows() > 0 && matCoilPos.rows() <= m_vFreqs.size() );
+
+    MatrixXd data = simulateData(matCoilPos, 600);
+    MatrixXd matProjectors = MatrixXd::Identity(m_pFiffInfo->nchan, m_pFiffInfo->nchan);
+
+    HPIFit hpiFit;
+    FiffCoordTrans transFirst, transSecond;
+    QVector<double> vGof;
+    FiffDigPointSet fittedPointSet;
+
+    hpiFit.fit(data, matProjectors, transFirst, m_vFreqs, vGof, fittedPointSet, m_pFiffInfo);
+    QVERIFY( vGof.size() == matCoilPos.rows() );
+
+    //
+    //   Replace the digitizer points under the same measurement info, as done when new digitizer data are loaded.
+    //   The head moves by the shift, hence the second transformation has to follow it.
+    //
+    Vector3f shift(0.01f, -0.005f, 0.002f);
+
+    QList<FiffDigPoint> lDigPoints = m_pFiffInfo->dig;
+    for(int i = 0; i < lDigPoints.size(); ++i) {
+        for(int k = 0; k < 3; ++k) {
+            lDigPoints[i].r[k] += shift[k];
+        }
+    }
+    m_pFiffInfo->dig = lDigPoints;
+
+    fittedPointSet = FiffDigPointSet();
+    hpiFit.fit(data, matProjectors, transSecond, m_vFreqs, vGof, fittedPointSet, m_pFiffInfo);
+    QVERIFY( vGof.size() == matCoilPos.rows() );
+
+    Matrix3f rotDiff = transSecond.trans.block(0,0,3,3) - transFirst.trans.block(0,0,3,3);
+    Vector3f transDiff = transSecond.trans.block(0,3,3,1) - transFirst.trans.block(0,3,3,1) - shift;
+
+    QVERIFY( rotDiff.cwiseAbs().maxCoeff() < epsilon );
+    QVERIFY( transDiff.cwiseAbs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestHpiFit::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestHpiFit)
+#include "test_hpi_fit.moc"
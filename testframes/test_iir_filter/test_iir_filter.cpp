@@ -0,0 +1,255 @@
+//=============================================================================================================
+/**
+* @file     test_iir_filter.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the IIR second order section filters
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/filterTools/iirfilter.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <qmath.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestIirFilter
+*
+* @brief The TestIirFilter class compares the second order section cascade against the direct form filter
+*
+*/
+class TestIirFilter: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestIirFilter();
+
+private slots:
+    void initTestCase();
+    void compareDirectForm_data();
+    void compareDirectForm();
+    void compareZeroPhase_data();
+    void compareZeroPhase();
+    void cleanupTestCase();
+
+private:
+    void addDesigns();
+    MatrixXd filterDirectForm(const MatrixXd& matSos, const MatrixXd& matData) const;
+
+    double epsilon;
+    double epsilonZeroPhase;
+    double m_dSFreq;
+
+    MatrixXd m_matData;
+};
+
+
+//*************************************************************************************************************
+
+TestIirFilter::TestIirFilter()
+: epsilon(0.000000001)
+, epsilonZeroPhase(0.001)
+, m_dSFreq(1000.0)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::initTestCase()
+{
+    m_matData = MatrixXd::Random(8, 2000);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::addDesigns()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("designMethod");
+    QTest::addColumn<int>("iOrder");
+    QTest::addColumn<double>("dFreq1");
+    QTest::addColumn<double>("dFreq2");
+
+    QTest::newRow("Butterworth LPF") << (int)IirFilter::LPF << (int)IirFilter::Butterworth << 4 << 40.0 << 0.0;
+    QTest::newRow("Butterworth NOTCH") << (int)IirFilter::NOTCH << (int)IirFilter::Butterworth << 2 << 45.0 << 55.0;
+    QTest::newRow("Chebyshev BPF") << (int)IirFilter::BPF << (int)IirFilter::Chebyshev << 2 << 8.0 << 30.0;
+    QTest::newRow("Elliptic HPF") << (int)IirFilter::HPF << (int)IirFilter::Elliptic << 3 << 5.0 << 0.0;
+    QTest::newRow("Elliptic LPF") << (int)IirFilter::LPF << (int)IirFilter::Elliptic << 4 << 100.0 << 0.0;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestIirFilter::filterDirectForm(const MatrixXd& matSos, const MatrixXd& matData) const
+{
+    //Expand the cascade into one numerator and one denominator polynomial
+    RowVectorXd b = RowVectorXd::Ones(1);
+    RowVectorXd a = RowVectorXd::Ones(1);
+
+    for(int s = 0; s < matSos.rows(); ++s) {
+        RowVectorXd bNew = RowVectorXd::Zero(b.cols() + 2);
+        RowVectorXd aNew = RowVectorXd::Zero(a.cols() + 2);
+        for(int k = 0; k < 3; ++k) {
+            bNew.segment(k, b.cols()) += matSos(s,k) * b;
+            aNew.segment(k, a.cols()) += matSos(s,3+k) * a;
+        }
+        b = bNew;
+        a = aNew;
+    }
+
+    //Direct form I difference equation
+    MatrixXd matOut = MatrixXd::Zero(matData.rows(), matData.cols());
+
+    for(int n = 0; n < matData.cols(); ++n) {
+        VectorXd vecAcc = VectorXd::Zero(matData.rows());
+        for(int k = 0; k < b.cols() && k <= n; ++k) {
+            vecAcc += b[k] * matData.col(n-k);
+        }
+        for(int k = 1; k < a.cols() && k <= n; ++k) {
+            vecAcc -= a[k] * matOut.col(n-k);
+        }
+        matOut.col(n) = vecAcc / a[0];
+    }
+
+    return matOut;
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareDirectForm_data()
+{
+    addDesigns();
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareDirectForm()
+{
+    QFETCH(int, type);
+    QFETCH(int, designMethod);
+    QFETCH(int, iOrder);
+    QFETCH(double, dFreq1);
+    QFETCH(double, dFreq2);
+
+    IirFilter filter("Test", (IirFilter::FilterType)type, (IirFilter::DesignMethod)designMethod, iOrder, dFreq1, dFreq2, m_dSFreq);
+    QVERIFY( filter.numSections() > 0 );
+
+    //Filter in blocks, the state carries over from one block to the next
+    int iBlockSize = 100;
+    MatrixXd matOut(m_matData.rows(), m_matData.cols());
+    MatrixXd matBlock;
+
+    for(int i = 0; i < m_matData.cols(); i += iBlockSize) {
+        filter.filterData(m_matData.middleCols(i, iBlockSize), matBlock);
+        matOut.middleCols(i, iBlockSize) = matBlock;
+    }
+
+    MatrixXd matRef = filterDirectForm(filter.m_matSos, m_matData);
+
+    QVERIFY( (matOut - matRef).cwiseAbs().maxCoeff() / matRef.cwiseAbs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareZeroPhase_data()
+{
+    addDesigns();
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareZeroPhase()
+{
+    QFETCH(int, type);
+    QFETCH(int, designMethod);
+    QFETCH(int, iOrder);
+    QFETCH(double, dFreq1);
+    QFETCH(double, dFreq2);
+
+    IirFilter filter("Test", (IirFilter::FilterType)type, (IirFilter::DesignMethod)designMethod, iOrder, dFreq1, dFreq2, m_dSFreq);
+
+    //Away from the edges a sinusoid is only scaled by the squared magnitude response, its phase is kept
+    double dFreq = 10.0;
+    RowVectorXd vecSine(4000);
+    for(int i = 0; i < vecSine.cols(); ++i) {
+        vecSine[i] = sin(2 * M_PI * dFreq * i / m_dSFreq);
+    }
+
+    MatrixXd matOut = filter.filterDataZeroPhase(vecSine);
+    double dGain = std::norm(filter.frequencyResponse(dFreq));
+
+    QVERIFY( matOut.cols() == vecSine.cols() );
+    QVERIFY( (matOut.middleCols(1000, 2000) - dGain * vecSine.segment(1000, 2000)).cwiseAbs().maxCoeff() < epsilonZeroPhase );
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestIirFilter)
+#include "test_iir_filter.moc"
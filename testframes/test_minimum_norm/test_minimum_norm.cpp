@@ -0,0 +1,231 @@
+//=============================================================================================================
+/**
+* @file     test_minimum_norm.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the kernel application of the MinimumNorm
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <inverse/minimumNorm/minimumnorm.h>
+
+#include <mne/mne_inverse_operator.h>
+#include <mne/mne_sourceestimate.h>
+
+#include <fiff/fiff_constants.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestMinimumNorm
+*
+* @brief The TestMinimumNorm class compares the blocked kernel application against the plain matrix computation
+*
+*/
+class TestMinimumNorm: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestMinimumNorm();
+
+private slots:
+    void initTestCase();
+    void compareInverse_data();
+    void compareInverse();
+    void compareTimeUpdate();
+    void cleanupTestCase();
+
+private:
+    MatrixXd computeReference(MinimumNorm& minimumNorm, const QString& method, bool pick_normal) const;
+
+    double epsilon;
+    double epsilonFloat;
+
+    MNEInverseOperator m_inverseOperator;
+    MatrixXd m_matData;
+};
+
+
+//*************************************************************************************************************
+
+TestMinimumNorm::TestMinimumNorm()
+: epsilon(0.0000000001)
+, epsilonFloat(0.0001)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestMinimumNorm::initTestCase()
+{
+    QFile t_fileInv("./MNE-sample-data/MEG/sample/sample_audvis-meg-eeg-oct-6-meg-eeg-inv.fif");
+    m_inverseOperator = MNEInverseOperator(t_fileInv);
+
+    QVERIFY( m_inverseOperator.nchan > 0 );
+
+    //More than one block of time points, the last one only partially filled
+    m_matData = 1e-12 * MatrixXd::Random(m_inverseOperator.nchan, 150);
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestMinimumNorm::computeReference(MinimumNorm& minimumNorm, const QString& method, bool pick_normal) const
+{
+    //The computation as done before the kernel was applied blockwise
+    MNEInverseOperator& inv = minimumNorm.getPreparedInverseOperator();
+    MatrixXd sol = minimumNorm.getKernel() * m_matData;
+
+    if(inv.source_ori == FIFFV_MNE_FREE_ORI && !pick_normal) {
+        MatrixXd sol1(sol.rows()/3, sol.cols());
+        for(qint32 i = 0; i < sol.rows()/3; ++i) {
+            sol1.row(i) = (sol.row(3*i).array().square() + sol.row(3*i+1).array().square() + sol.row(3*i+2).array().square()).sqrt().matrix();
+        }
+        sol = sol1;
+    }
+
+    if(method != "MNE") {
+        sol = inv.noisenorm * sol;
+    }
+
+    return sol;
+}
+
+
+//*************************************************************************************************************
+
+void TestMinimumNorm::compareInverse_data()
+{
+    QTest::addColumn<QString>("method");
+    QTest::addColumn<bool>("pick_normal");
+
+    QTest::newRow("MNE") << QString("MNE") << false;
+    QTest::newRow("MNE normal") << QString("MNE") << true;
+    QTest::newRow("dSPM") << QString("dSPM") << false;
+    QTest::newRow("dSPM normal") << QString("dSPM") << true;
+    QTest::newRow("sLORETA") << QString("sLORETA") << false;
+}
+
+
+//*************************************************************************************************************
+
+void TestMinimumNorm::compareInverse()
+{
+    QFETCH(QString, method);
+    QFETCH(bool, pick_normal);
+
+    MinimumNorm minimumNorm(m_inverseOperator, 1.0f / 9.0f, method);
+    minimumNorm.doInverseSetup(1, pick_normal);
+
+    MatrixXd matRef = computeReference(minimumNorm, method, pick_normal);
+    double dScale = matRef.cwiseAbs().maxCoeff();
+    QVERIFY( dScale > 0 );
+
+    //Double precision
+    MNESourceEstimate sourceEstimate = minimumNorm.calculateInverse(m_matData, 0.0f, 0.001f);
+
+    QVERIFY( sourceEstimate.data.rows() == matRef.rows() );
+    QVERIFY( sourceEstimate.data.cols() == matRef.cols() );
+    QVERIFY( (sourceEstimate.data - matRef).cwiseAbs().maxCoeff() / dScale < epsilon );
+
+    //Single precision
+    minimumNorm.setUseSinglePrecision(true);
+    MNESourceEstimate sourceEstimateFloat = minimumNorm.calculateInverse(m_matData, 0.0f, 0.001f);
+
+    QVERIFY( sourceEstimateFloat.data.rows() == matRef.rows() );
+    QVERIFY( sourceEstimateFloat.data.cols() == matRef.cols() );
+    QVERIFY( (sourceEstimateFloat.data - matRef).cwiseAbs().maxCoeff() / dScale < epsilonFloat );
+}
+
+
+//*************************************************************************************************************
+
+void TestMinimumNorm::compareTimeUpdate()
+{
+    MinimumNorm minimumNorm(m_inverseOperator, 1.0f / 9.0f, QString("dSPM"));
+    minimumNorm.doInverseSetup(1, false);
+
+    MNESourceEstimate sourceEstimate;
+    QVERIFY( minimumNorm.calculateInverse(m_matData, 0.0f, 0.001f, sourceEstimate) );
+    const double* pData = sourceEstimate.data.data();
+
+    //A new block with the same layout is written into the same buffer, only the time axis follows
+    QVERIFY( minimumNorm.calculateInverse(m_matData, 0.5f, 0.002f, sourceEstimate) );
+
+    QVERIFY( sourceEstimate.data.data() == pData );
+    QVERIFY( sourceEstimate.tmin == 0.5f );
+    QVERIFY( sourceEstimate.tstep == 0.002f );
+    QVERIFY( sourceEstimate.times.size() == m_matData.cols() );
+
+    MNESourceEstimate sourceEstimateNew(sourceEstimate.data, sourceEstimate.vertices, 0.5f, 0.002f);
+    QVERIFY( sourceEstimate.times == sourceEstimateNew.times );
+}
+
+
+//*************************************************************************************************************
+
+void TestMinimumNorm::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestMinimumNorm)
+#include "test_minimum_norm.moc"
@@ -0,0 +1,379 @@
+//=============================================================================================================
+/**
+* @file     test_network_adjacency.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the compact adjacency of Network
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <connectivity/network/network.h>
+#include <connectivity/network/networkadjacency.h>
+#include <connectivity/network/networknode.h>
+#include <connectivity/network/networkedge.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace CONNECTIVITYLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestNetworkAdjacency
+*
+* @brief The TestNetworkAdjacency class checks the dense and CSR storage of NetworkAdjacency against the weight
+* matrix it was built from, and the conversion between the adjacency and the node and edge objects of Network
+*
+*/
+class TestNetworkAdjacency: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestNetworkAdjacency();
+
+private slots:
+    void initTestCase();
+    void compareIteration();
+    void compareSparsify();
+    void compareDegreesAndStrengths();
+    void compareLegacyObjects();
+    void cleanupTestCase();
+
+private:
+    bool compareEntries(const NetworkAdjacency& adjacency, const MatrixXd& matUpper) const;
+
+    double epsilon;
+    double m_dThreshold;
+
+    int m_iNumberNodes;
+
+    MatrixXd m_matWeights;
+    MatrixX3f m_matVert;
+};
+
+
+//*************************************************************************************************************
+
+TestNetworkAdjacency::TestNetworkAdjacency()
+: epsilon(0.0000000001)
+, m_dThreshold(0.5)
+, m_iNumberNodes(12)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::initTestCase()
+{
+    //Symmetric weights with some exact zeros and one row without any edge above the threshold
+    m_matWeights = MatrixXd::Random(m_iNumberNodes, m_iNumberNodes);
+    m_matWeights = (m_matWeights + m_matWeights.transpose()).eval() / 2.0;
+    m_matWeights(1, 4) = m_matWeights(4, 1) = 0.0;
+    m_matWeights(2, 2) = 0.9;
+    m_matWeights.row(7).setConstant(0.1);
+    m_matWeights.col(7).setConstant(0.1);
+
+    m_matVert = MatrixX3f::Random(m_iNumberNodes, 3);
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::compareIteration()
+{
+    NetworkAdjacency adjacency;
+    adjacency.setDenseWeights(m_matWeights);
+
+    QVERIFY( adjacency.getStorageType() == NetworkAdjacency::Dense );
+    QVERIFY( adjacency.getNumberNodes() == m_iNumberNodes );
+    QVERIFY( adjacency.getNumberEntries() == m_iNumberNodes*(m_iNumberNodes+1)/2 );
+    QVERIFY( compareEntries(adjacency, m_matWeights.triangularView<Upper>()) );
+
+    //Reading the lower triangle gives the same adjacency for symmetric weights
+    NetworkAdjacency adjacencyLower;
+    adjacencyLower.setDenseWeights(m_matWeights, false);
+    QVERIFY( compareEntries(adjacencyLower, m_matWeights.triangularView<Upper>()) );
+
+    //Both directions of a pair address the same weight
+    for(int i = 0; i < m_iNumberNodes; ++i) {
+        for(int j = 0; j < m_iNumberNodes; ++j) {
+            QVERIFY( adjacency.getWeight(i, j) == m_matWeights(i, j) );
+        }
+    }
+
+    //The sparse weights keep the first entry of a pair, the upper triangle wins over the lower one
+    std::vector<Triplet<double> > lTriplets;
+    lTriplets.push_back(Triplet<double>(3, 1, 0.3));
+    lTriplets.push_back(Triplet<double>(1, 3, 0.7));
+    lTriplets.push_back(Triplet<double>(5, 5, 0.2));
+    lTriplets.push_back(Triplet<double>(0, 9, -0.4));
+    lTriplets.push_back(Triplet<double>(0, 9, 0.8));
+
+    NetworkAdjacency adjacencySparse;
+    adjacencySparse.setSparseWeights(m_iNumberNodes, lTriplets);
+
+    MatrixXd matUpper = MatrixXd::Zero(m_iNumberNodes, m_iNumberNodes);
+    matUpper(1, 3) = 0.7;
+    matUpper(5, 5) = 0.2;
+    matUpper(0, 9) = -0.4;
+
+    QVERIFY( adjacencySparse.getStorageType() == NetworkAdjacency::Sparse );
+    QVERIFY( adjacencySparse.getNumberEntries() == 3 );
+    QVERIFY( compareEntries(adjacencySparse, matUpper) );
+
+    //No entries at all
+    NetworkAdjacency adjacencyEmpty;
+    adjacencyEmpty.setSparseWeights(m_iNumberNodes, std::vector<Triplet<double> >());
+    QVERIFY( adjacencyEmpty.begin() == adjacencyEmpty.end() );
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::compareSparsify()
+{
+    NetworkAdjacency adjacency;
+    adjacency.setDenseWeights(m_matWeights);
+
+    MatrixXd matUpper = m_matWeights.triangularView<Upper>();
+    MatrixXd matThresholded = (matUpper.array().abs() >= m_dThreshold).select(matUpper, 0.0);
+
+    //With self loops
+    NetworkAdjacency adjacencyLoops = adjacency.sparsify(m_dThreshold, true);
+    QVERIFY( adjacencyLoops.getStorageType() == NetworkAdjacency::Sparse );
+    QVERIFY( adjacencyLoops.getNumberEntries() == (matThresholded.array() != 0.0).count() );
+    QVERIFY( compareEntries(adjacencyLoops, matThresholded) );
+
+    //Without self loops
+    matThresholded.diagonal().setZero();
+    NetworkAdjacency adjacencySparse = adjacency.sparsify(m_dThreshold);
+    QVERIFY( adjacencySparse.getNumberEntries() == (matThresholded.array() != 0.0).count() );
+    QVERIFY( compareEntries(adjacencySparse, matThresholded) );
+
+    //Sparsifying again keeps everything above the threshold
+    QVERIFY( compareEntries(adjacencySparse.sparsify(m_dThreshold), matThresholded) );
+
+    //Network switches to the sparsified adjacency and regenerates the edges from it
+    Network network;
+    network.setNodeVertices(m_matVert);
+    network.setAdjacency(adjacency);
+    QVERIFY( network.getEdges().size() == adjacency.getNumberEntries() );
+
+    network.sparsify(m_dThreshold);
+    QVERIFY( network.getAdjacency().getStorageType() == NetworkAdjacency::Sparse );
+    QVERIFY( compareEntries(network.getAdjacency(), matThresholded) );
+    QVERIFY( network.getEdges().size() == adjacencySparse.getNumberEntries() );
+
+    for(const NetworkEdge::SPtr& pEdge : network.getEdges()) {
+        QVERIFY( std::fabs(pEdge->getWeight()) >= m_dThreshold );
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::compareDegreesAndStrengths()
+{
+    NetworkAdjacency adjacency;
+    adjacency.setDenseWeights(m_matWeights);
+
+    QList<double> lThresholds;
+    lThresholds << 0.0 << m_dThreshold;
+
+    for(double dThreshold : lThresholds) {
+        //Direct count over the full symmetric matrix without the diagonal
+        MatrixXd matEdges = (m_matWeights.array().abs() >= dThreshold).select(m_matWeights, 0.0);
+        MatrixXi matIsEdge = (m_matWeights.array().abs() >= dThreshold).cast<int>();
+        matEdges.diagonal().setZero();
+        matIsEdge.diagonal().setZero();
+
+        VectorXi vecDegrees = matIsEdge.rowwise().sum();
+        VectorXd vecStrengths = matEdges.rowwise().sum();
+
+        QVERIFY( adjacency.getDegrees(dThreshold) == vecDegrees );
+        QVERIFY( (adjacency.getStrengths(dThreshold) - vecStrengths).cwiseAbs().maxCoeff() < epsilon );
+
+        //The same for the CSR storage
+        NetworkAdjacency adjacencySparse = adjacency.sparsify(dThreshold, true);
+        QVERIFY( adjacencySparse.getDegrees(dThreshold) == vecDegrees );
+        QVERIFY( (adjacencySparse.getStrengths(dThreshold) - vecStrengths).cwiseAbs().maxCoeff() < epsilon );
+
+        //One index pair per edge above the diagonal
+        MatrixXi matIndices = adjacency.getEdgeIndices(dThreshold);
+        QVERIFY( 2*matIndices.rows() == matIsEdge.sum() );
+        for(int k = 0; k < matIndices.rows(); ++k) {
+            QVERIFY( matIndices(k, 0) < matIndices(k, 1) );
+            QVERIFY( matIsEdge(matIndices(k, 0), matIndices(k, 1)) == 1 );
+        }
+    }
+
+    //The node without strong edges
+    QVERIFY( adjacency.getDegrees(m_dThreshold)[7] == 0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::compareLegacyObjects()
+{
+    //
+    //   Network built from node and edge objects, the edges of each pair i <= j are added to node i
+    //
+    Network networkObjects;
+
+    for(int i = 0; i < m_iNumberNodes; ++i) {
+        networkObjects << NetworkNode::SPtr(new NetworkNode(i, m_matVert.row(i)));
+    }
+
+    QList<NetworkNode::SPtr> lNodes = networkObjects.getNodes();
+
+    for(int i = 0; i < m_iNumberNodes; ++i) {
+        for(int j = i; j < m_iNumberNodes; ++j) {
+            NetworkEdge::SPtr pEdge = NetworkEdge::SPtr(new NetworkEdge(lNodes[i], lNodes[j], m_matWeights(i, j)));
+
+            *lNodes[i] << pEdge;
+            networkObjects << pEdge;
+        }
+    }
+
+    qint16 iDistribution = 0;
+    for(const NetworkNode::SPtr& pNode : lNodes) {
+        iDistribution += pNode->getDegree();
+    }
+
+    QVERIFY( networkObjects.getNumberNodes() == m_iNumberNodes );
+    QVERIFY( networkObjects.getNodeVertices() == m_matVert );
+    QVERIFY( networkObjects.getDistribution() == iDistribution );
+
+    //Objects -> adjacency
+    const NetworkAdjacency& adjacency = networkObjects.getAdjacency();
+    QVERIFY( adjacency.getNumberNodes() == m_iNumberNodes );
+    QVERIFY( compareEntries(adjacency, m_matWeights.triangularView<Upper>()) );
+    QVERIFY( networkObjects.getConnectivityMatrix() == MatrixXd(m_matWeights.triangularView<Upper>()) );
+
+    //
+    //   Adjacency -> objects
+    //
+    Network networkAdjacency;
+    networkAdjacency.setNodeVertices(m_matVert);
+    networkAdjacency.setAdjacency(adjacency);
+
+    //The distribution is the same before and after the objects are created
+    QVERIFY( networkAdjacency.getDistribution() == iDistribution );
+
+    QList<NetworkNode::SPtr> lNodesAdjacency = networkAdjacency.getNodes();
+    QList<NetworkEdge::SPtr> lEdgesAdjacency = networkAdjacency.getEdges();
+
+    QVERIFY( networkAdjacency.getDistribution() == iDistribution );
+    QVERIFY( lNodesAdjacency.size() == m_iNumberNodes );
+    QVERIFY( lEdgesAdjacency.size() == m_iNumberNodes*(m_iNumberNodes+1)/2 );
+
+    for(int i = 0; i < m_iNumberNodes; ++i) {
+        QVERIFY( lNodesAdjacency[i]->getId() == i );
+        QVERIFY( lNodesAdjacency[i]->getVert() == m_matVert.row(i) );
+        QVERIFY( lNodesAdjacency[i]->getDegree() == lNodes[i]->getDegree() );
+    }
+
+    for(const NetworkEdge::SPtr& pEdge : lEdgesAdjacency) {
+        int i = pEdge->getStartNode()->getId();
+        int j = pEdge->getEndNode()->getId();
+        QVERIFY( i <= j );
+        QVERIFY( pEdge->getWeight() == m_matWeights(i, j) );
+    }
+
+    //A copy shares the adjacency and yields the same objects
+    Network networkCopy(networkAdjacency);
+    QVERIFY( networkCopy.getEdges().size() == lEdgesAdjacency.size() );
+    QVERIFY( networkCopy.getConnectivityMatrix() == networkObjects.getConnectivityMatrix() );
+}
+
+
+//*************************************************************************************************************
+
+void TestNetworkAdjacency::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+bool TestNetworkAdjacency::compareEntries(const NetworkAdjacency& adjacency, const MatrixXd& matUpper) const
+{
+    //Every stored entry in row-major order, and nothing else
+    MatrixXd matVisited = MatrixXd::Zero(adjacency.getNumberNodes(), adjacency.getNumberNodes());
+    int iLastRow = 0;
+    int iLastCol = -1;
+    qint64 iNumberEntries = 0;
+
+    for(NetworkAdjacency::ConstIterator it = adjacency.begin(); it != adjacency.end(); ++it) {
+        if(it.row() > it.col() || it.row() < iLastRow || (it.row() == iLastRow && it.col() <= iLastCol)) {
+            return false;
+        }
+        if(it.weight() != matUpper(it.row(), it.col()) || adjacency.getWeight(it.row(), it.col()) != it.weight()) {
+            return false;
+        }
+
+        matVisited(it.row(), it.col()) = it.weight();
+        iLastRow = it.row();
+        iLastCol = it.col();
+        ++iNumberEntries;
+    }
+
+    return iNumberEntries == adjacency.getNumberEntries() && matVisited == matUpper && adjacency.toDense() == matUpper;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestNetworkAdjacency)
+#include "test_network_adjacency.moc"
@@ -0,0 +1,339 @@
+//=============================================================================================================
+/**
+* @file     test_rap_music.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the batched pair scan of RapMusic and the coarse to fine search of PwlRapMusic
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <inverse/rapMusic/rapmusic.h>
+#include <inverse/rapMusic/pwlrapmusic.h>
+
+#include <mne/mne_forwardsolution.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Exposes the scan helpers of RapMusic for a lead field which is set up without a forward solution.
+*/
+class RapMusicScan : public RapMusic
+{
+public:
+    RapMusicScan(int p_iNumGridPoints, int p_iNumChannels)
+    {
+        m_iNumGridPoints = p_iNumGridPoints;
+        m_iNumChannels = p_iNumChannels;
+    }
+
+    using RapMusic::subcorr;
+    using RapMusic::calcOrthLeadField;
+    using RapMusic::calcPairCorrelations;
+    using RapMusic::updateProjection;
+    using RapMusic::calcOrthProj;
+    using RapMusic::getPointPair;
+    using RapMusic::getGainMatrixPair;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRapMusic
+*
+* @brief The TestRapMusic class compares the batched pair scan and projection update of RapMusic against the SVD
+* based subspace correlation and the orthogonal projector, and the coarse to fine search of PwlRapMusic against
+* the exhaustive search
+*
+*/
+class TestRapMusic: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRapMusic();
+
+private slots:
+    void initTestCase();
+    void comparePairCorrelations();
+    void compareProjection();
+    void compareCoarseToFine();
+    void cleanupTestCase();
+
+private:
+    void sphereForwardSolution(int p_iNumGridPoints, MNEForwardSolution& p_Fwd) const;
+    bool findSamePair(const MNEForwardSolution& p_Fwd, RapMusic& p_RapMusic, PwlRapMusic& p_PwlRapMusic, int p_iNumTrials) const;
+
+    double epsilon;
+
+    int m_iNumGridPoints;
+    int m_iNumChannels;
+
+    MatrixXd m_matLeadField;
+    MatrixXd m_matPhi_s;
+};
+
+
+//*************************************************************************************************************
+
+TestRapMusic::TestRapMusic()
+: epsilon(0.0000000001)
+, m_iNumGridPoints(40)
+, m_iNumChannels(60)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::initTestCase()
+{
+    m_matLeadField = MatrixXd::Random(m_iNumChannels, 3*m_iNumGridPoints);
+
+    //A grid point with a rank deficient lead field and two grid points which share their lead field
+    m_matLeadField.col(3*3+2) = m_matLeadField.col(3*3) + m_matLeadField.col(3*3+1);
+    m_matLeadField.middleCols(3*8, 3) = m_matLeadField.middleCols(3*7, 3);
+
+    m_matPhi_s = MatrixXd::Random(m_iNumChannels, 5);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::comparePairCorrelations()
+{
+    RapMusicScan rapMusic(m_iNumGridPoints, m_iNumChannels);
+
+    //Orthonormal basis of the signal subspace
+    HouseholderQR<MatrixXd> qrPhi_s(m_matPhi_s);
+    MatrixXd matU_B = qrPhi_s.householderQ() * MatrixXd::Identity(m_iNumChannels, m_matPhi_s.cols());
+
+    //Batched scan
+    MatrixXd matOrthLeadField;
+    rapMusic.calcOrthLeadField(m_matLeadField, matOrthLeadField);
+
+    MatrixXd matW = matOrthLeadField.transpose() * matU_B;
+
+    VectorXd vecRoh;
+    rapMusic.calcPairCorrelations(matOrthLeadField, matW, vecRoh);
+
+    int iNumCombinations = m_iNumGridPoints*(m_iNumGridPoints+1)/2;
+    QVERIFY( vecRoh.size() == iNumCombinations );
+
+    //SVD of each pair's lead field
+    RapMusic::MatrixX6T matProj_G(m_iNumChannels, 6);
+    double dError = 0.0;
+
+    for(int i = 0; i < iNumCombinations; ++i) {
+        int iIdx1, iIdx2;
+        RapMusicScan::getPointPair(m_iNumGridPoints, i, iIdx1, iIdx2);
+        RapMusicScan::getGainMatrixPair(m_matLeadField, matProj_G, iIdx1, iIdx2);
+
+        dError = qMax(dError, std::fabs(vecRoh(i) - RapMusicScan::subcorr(matProj_G, matU_B)));
+    }
+
+    printf("Maximal difference of the pair correlations: %e\n", dError);
+
+    QVERIFY( dError < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::compareProjection()
+{
+    RapMusicScan rapMusic(m_iNumGridPoints, m_iNumChannels);
+
+    //Three found topographies, the last one lies in the span of the first two
+    MatrixXd matA = MatrixXd::Random(m_iNumChannels, 3);
+    matA.col(2) = matA.col(0) - 2.0*matA.col(1);
+
+    MatrixXd matOrthBasis_A = MatrixXd::Zero(m_iNumChannels, matA.cols());
+    int iRank_A = 0;
+    MatrixXd matProj_LeadField = m_matLeadField;
+    MatrixXd matProj_Phi_s = m_matPhi_s;
+
+    for(int i = 0; i < matA.cols(); ++i)
+        RapMusicScan::updateProjection(matA.col(i), matOrthBasis_A, iRank_A, matProj_LeadField, matProj_Phi_s);
+
+    QVERIFY( iRank_A == 2 );
+
+    //Orthogonal projector of all found topographies
+    MatrixXd matOrthProj;
+    rapMusic.calcOrthProj(matA, matOrthProj);
+
+    QVERIFY( (matOrthProj*m_matLeadField - matProj_LeadField).cwiseAbs().maxCoeff() < epsilon );
+    QVERIFY( (matOrthProj*m_matPhi_s - matProj_Phi_s).cwiseAbs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::compareCoarseToFine()
+{
+    MNEForwardSolution fwd;
+    sphereForwardSolution(300, fwd);
+
+    RapMusic rapMusic(fwd, false, 1);
+    PwlRapMusic pwlRapMusic(fwd, false, 1);
+
+    //Decimation 1 refines every pair of grid points -> same as the exhaustive search
+    pwlRapMusic.setCoarseToFine(1);
+    QVERIFY( findSamePair(fwd, rapMusic, pwlRapMusic, 20) );
+
+    //Default decimation on well separated pairs
+    pwlRapMusic.setCoarseToFine(5);
+    QVERIFY( findSamePair(fwd, rapMusic, pwlRapMusic, 7) );
+
+    //A new forward solution with fewer grid points has to rebuild the coarse grid
+    MNEForwardSolution fwdSmall;
+    sphereForwardSolution(200, fwdSmall);
+
+    rapMusic.init(fwdSmall, false, 1);
+    pwlRapMusic.init(fwdSmall, false, 1);
+    QVERIFY( findSamePair(fwdSmall, rapMusic, pwlRapMusic, 5) );
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::sphereForwardSolution(int p_iNumGridPoints, MNEForwardSolution& p_Fwd) const
+{
+    int iNumSensors = 80;
+
+    //Grid points evenly spread over a sphere with 6 cm radius, sensor points over the upper half of a sphere with
+    //10 cm radius
+    MatrixX3f matRR(p_iNumGridPoints, 3);
+    for(int i = 0; i < p_iNumGridPoints; ++i) {
+        double z = 1.0 - 2.0*(i + 0.5)/p_iNumGridPoints;
+        double r = std::sqrt(1.0 - z*z);
+        double phi = i*M_PI*(3.0 - std::sqrt(5.0));
+        matRR.row(i) << 0.06*r*std::cos(phi), 0.06*r*std::sin(phi), 0.06*z;
+    }
+
+    MatrixX3d matSensors(iNumSensors, 3);
+    for(int j = 0; j < iNumSensors; ++j) {
+        double z = 1.0 - (j + 0.5)/iNumSensors;
+        double r = std::sqrt(1.0 - z*z);
+        double phi = j*M_PI*(3.0 - std::sqrt(5.0));
+        matSensors.row(j) << 0.1*r*std::cos(phi), 0.1*r*std::sin(phi), 0.1*z;
+    }
+
+    //Radial field of a current dipole in an infinite homogeneous medium
+    MatrixXd matLeadField(iNumSensors, 3*p_iNumGridPoints);
+    for(int j = 0; j < iNumSensors; ++j) {
+        Vector3d vecSensor = matSensors.row(j).transpose();
+        for(int i = 0; i < p_iNumGridPoints; ++i) {
+            Vector3d vecDiff = vecSensor - matRR.row(i).transpose().cast<double>();
+            double dDist3 = std::pow(vecDiff.norm(), 3);
+            for(int k = 0; k < 3; ++k)
+                matLeadField(j, 3*i+k) = Vector3d::Unit(k).cross(vecDiff).dot(vecSensor.normalized()) / dDist3;
+        }
+    }
+
+    //The rank of the measurement is found with an absolute threshold
+    p_Fwd.sol->data = matLeadField / matLeadField.cwiseAbs().maxCoeff();
+    p_Fwd.source_rr = matRR;
+}
+
+
+//*************************************************************************************************************
+
+bool TestRapMusic::findSamePair(const MNEForwardSolution& p_Fwd, RapMusic& p_RapMusic, PwlRapMusic& p_PwlRapMusic, int p_iNumTrials) const
+{
+    const MatrixXd& matLeadField = p_Fwd.sol->data;
+    int iNumGridPoints = matLeadField.cols()/3;
+
+    RowVectorXd vecTimeCourse = RowVectorXd::LinSpaced(20, 0.1, 2.0).array().sin();
+
+    for(int t = 0; t < p_iNumTrials; ++t) {
+        //Deterministic pairs and orientations
+        int iIdx1 = (37*t + 5) % iNumGridPoints;
+        int iIdx2 = (iIdx1 + iNumGridPoints/3 + 17*t) % iNumGridPoints;
+        Vector3d vecOri1(std::cos(0.7*t), std::sin(0.7*t), 0.3);
+        Vector3d vecOri2(0.2, std::cos(1.3*t), std::sin(1.3*t));
+
+        MatrixXd matMeasurement = (matLeadField.middleCols(3*iIdx1, 3)*vecOri1
+                                   + matLeadField.middleCols(3*iIdx2, 3)*vecOri2) * vecTimeCourse;
+
+        QList< DipolePair<double> > rapDipoles, pwlDipoles;
+        p_RapMusic.calculateInverse(matMeasurement, rapDipoles);
+        p_PwlRapMusic.calculateInverse(matMeasurement, pwlDipoles);
+
+        if(rapDipoles.isEmpty() || pwlDipoles.isEmpty())
+            return false;
+
+        printf("Trial %d: exhaustive %d - %d, coarse to fine %d - %d\n", t, rapDipoles[0].m_iIdx1, rapDipoles[0].m_iIdx2,
+               pwlDipoles[0].m_iIdx1, pwlDipoles[0].m_iIdx2);
+
+        if(rapDipoles[0].m_iIdx1 != pwlDipoles[0].m_iIdx1 || rapDipoles[0].m_iIdx2 != pwlDipoles[0].m_iIdx2)
+            return false;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusic::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRapMusic)
+#include "test_rap_music.moc"
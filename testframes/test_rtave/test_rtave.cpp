@@ -0,0 +1,249 @@
+//=============================================================================================================
+/**
+* @file     test_rtave.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the running mean and standard error of the real-time averaging
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtave.h>
+
+#include <fiff/fiff_info.h>
+
+#include <stdlib.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Exposes the running accumulators of RtAve.
+*/
+class RtAveAccumulators : public RtAve
+{
+public:
+    RtAveAccumulators(quint32 numAverages)
+    : RtAve(numAverages, 0, 0, 0, 0, 0, FiffInfo::SPtr(new FiffInfo))
+    {
+    }
+
+    using RtAve::addToAverage;
+    using RtAve::removeFromAverage;
+    using RtAve::refreshAverage;
+    using RtAve::m_mapStimAve;
+    using RtAve::m_mapStimAveMean;
+    using RtAve::m_mapStimAveCount;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtAve
+*
+* @brief The TestRtAve class compares the running mean and standard error of RtAve against the mean and standard
+* error computed directly from the retained epochs
+*
+*/
+class TestRtAve : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtAve();
+
+private slots:
+    void initTestCase();
+    void compareRunningAverage();
+    void compareRefreshedAverage();
+    void cleanupTestCase();
+
+private:
+    void appendEpoch(RtAveAccumulators& rtAve, double dTriggerType, const MatrixXd& epoch, int iNumAverages) const;
+    bool compareToEpochs(RtAveAccumulators& rtAve, double dTriggerType) const;
+
+    double epsilon;
+
+    int m_iNumAverages;
+    QList<MatrixXd> m_qListEpochs;
+};
+
+
+//*************************************************************************************************************
+
+TestRtAve::TestRtAve()
+: epsilon(0.000000001)
+, m_iNumAverages(5)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::initTestCase()
+{
+    //
+    //   Epochs with a large offset, so a drifting running mean or variance would show up
+    //
+    srand(42);
+
+    for(int i = 0; i < 40; ++i) {
+        m_qListEpochs.append(MatrixXd::Constant(8, 30, 100.0) + MatrixXd::Random(8, 30));
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::compareRunningAverage()
+{
+    RtAveAccumulators rtAve(m_iNumAverages);
+
+    //Two interleaved trigger types, the first one evicts epochs (and is recalculated every m_iNumAverages evictions)
+    for(int i = 0; i < m_qListEpochs.size(); ++i) {
+        double dTriggerType = (i % 4 == 3) ? 2.0 : 1.0;
+
+        appendEpoch(rtAve, dTriggerType, m_qListEpochs.at(i), m_iNumAverages);
+
+        QVERIFY( rtAve.m_mapStimAve[dTriggerType].size() <= m_iNumAverages );
+        QVERIFY( rtAve.m_mapStimAveCount[dTriggerType] == rtAve.m_mapStimAve[dTriggerType].size() );
+        QVERIFY( compareToEpochs(rtAve, dTriggerType) );
+    }
+
+    //A single epoch has no standard error
+    RtAveAccumulators rtAveSingle(m_iNumAverages);
+    appendEpoch(rtAveSingle, 1.0, m_qListEpochs.at(0), m_iNumAverages);
+    QVERIFY( compareToEpochs(rtAveSingle, 1.0) );
+    QVERIFY( rtAveSingle.getStdErr(1.0).cwiseAbs().maxCoeff() == 0.0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::compareRefreshedAverage()
+{
+    RtAveAccumulators rtAve(m_iNumAverages);
+
+    for(int i = 0; i < m_qListEpochs.size(); ++i) {
+        appendEpoch(rtAve, 1.0, m_qListEpochs.at(i), m_iNumAverages);
+
+        MatrixXd matMean = rtAve.m_mapStimAveMean[1.0];
+        MatrixXd matStdErr = rtAve.getStdErr(1.0);
+
+        //The recalculation from the stored epochs agrees with the running update
+        rtAve.refreshAverage(1.0);
+
+        QVERIFY( compareToEpochs(rtAve, 1.0) );
+        QVERIFY( (rtAve.m_mapStimAveMean[1.0] - matMean).cwiseAbs().maxCoeff() <= epsilon * matMean.cwiseAbs().maxCoeff() );
+        QVERIFY( (rtAve.getStdErr(1.0) - matStdErr).cwiseAbs().maxCoeff() <= epsilon * qMax(matStdErr.cwiseAbs().maxCoeff(), 1.0) );
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::appendEpoch(RtAveAccumulators& rtAve, double dTriggerType, const MatrixXd& epoch, int iNumAverages) const
+{
+    //Same order as in RtAve::mergeData: the evicted epoch is removed from the accumulators before it is popped
+    rtAve.m_mapStimAve[dTriggerType].append(epoch);
+    rtAve.addToAverage(dTriggerType, epoch);
+
+    if(rtAve.m_mapStimAve[dTriggerType].size() > iNumAverages) {
+        rtAve.removeFromAverage(dTriggerType, rtAve.m_mapStimAve[dTriggerType].first());
+        rtAve.m_mapStimAve[dTriggerType].pop_front();
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool TestRtAve::compareToEpochs(RtAveAccumulators& rtAve, double dTriggerType) const
+{
+    const QList<MatrixXd>& lEpochs = rtAve.m_mapStimAve[dTriggerType];
+    int n = lEpochs.size();
+
+    MatrixXd matMean = MatrixXd::Zero(lEpochs.first().rows(), lEpochs.first().cols());
+    for(int i = 0; i < n; ++i) {
+        matMean += lEpochs.at(i);
+    }
+    matMean /= n;
+
+    MatrixXd matStdErr = MatrixXd::Zero(matMean.rows(), matMean.cols());
+    if(n > 1) {
+        for(int i = 0; i < n; ++i) {
+            matStdErr.array() += (lEpochs.at(i) - matMean).array().square();
+        }
+        matStdErr = (matStdErr.array() / (n - 1) / n).sqrt().matrix();
+    }
+
+    double dMeanError = (rtAve.m_mapStimAveMean[dTriggerType] - matMean).cwiseAbs().maxCoeff();
+    double dStdErrError = (rtAve.getStdErr(dTriggerType) - matStdErr).cwiseAbs().maxCoeff();
+
+    return dMeanError <= epsilon * matMean.cwiseAbs().maxCoeff()
+            && dStdErrError <= epsilon * qMax(matStdErr.cwiseAbs().maxCoeff(), 1.0);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtAve)
+#include "test_rtave.moc"
@@ -0,0 +1,362 @@
+//=============================================================================================================
+/**
+* @file     test_rtcov.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the real-time covariance estimation
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtcov.h>
+
+#include <fiff/fiff_raw_data.h>
+#include <fiff/fiff_info.h>
+#include <fiff/fiff_cov.h>
+#include <fiff/fiff_constants.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtCov
+*
+* @brief The TestRtCov class compares the streamed covariances of RtCov against directly computed ones
+*
+*/
+class TestRtCov: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtCov();
+
+public slots:
+    void onCovCalculated(FIFFLIB::FiffCov::SPtr pCov);
+
+private slots:
+    void initTestCase();
+    void compareSlidingWindow_data();
+    void compareSlidingWindow();
+    void compareExponentialForgetting_data();
+    void compareExponentialForgetting();
+    void compareRegularization();
+    void cleanupTestCase();
+
+private:
+    FiffInfo::SPtr createMiscInfo(int iNumChannels) const;
+    void runCov(RtCov& rtCov, const MatrixXd& data, int iBlockSize, int iNumCovs);
+    MatrixXd computeCov(const MatrixXd& data, const VectorXd& vecWeights) const;
+    double relativeError(const MatrixXd& matCov, const MatrixXd& matRef) const;
+
+    double epsilon;
+
+    FiffInfo::SPtr m_pFiffInfoRaw;
+    QList<FiffCov::SPtr> m_qListCovs;
+};
+
+
+//*************************************************************************************************************
+
+TestRtCov::TestRtCov()
+: epsilon(0.000000001)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::onCovCalculated(FiffCov::SPtr pCov)
+{
+    m_qListCovs.append(pCov);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::initTestCase()
+{
+    QFile t_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+
+    FiffRawData raw(t_fileIn);
+    m_pFiffInfoRaw = FiffInfo::SPtr(new FiffInfo(raw.info));
+
+    QVERIFY( m_pFiffInfoRaw->nchan > 0 );
+    QVERIFY( m_pFiffInfoRaw->projs.size() > 1 );
+}
+
+
+//*************************************************************************************************************
+
+FiffInfo::SPtr TestRtCov::createMiscInfo(int iNumChannels) const
+{
+    //Misc channels are not regularized, hence the emitted covariances are the plain estimates
+    FiffInfo::SPtr pFiffInfo(new FiffInfo());
+
+    for(int i = 0; i < iNumChannels; ++i) {
+        FiffChInfo chInfo;
+        chInfo.kind = FIFFV_MISC_CH;
+        chInfo.ch_name = QString("MISC %1").arg(i);
+
+        pFiffInfo->chs.append(chInfo);
+        pFiffInfo->ch_names.append(chInfo.ch_name);
+    }
+    pFiffInfo->nchan = iNumChannels;
+
+    return pFiffInfo;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::runCov(RtCov& rtCov, const MatrixXd& data, int iBlockSize, int iNumCovs)
+{
+    for(int i = 0; i + iBlockSize <= data.cols(); i += iBlockSize) {
+        rtCov.append(data.middleCols(i, iBlockSize));
+    }
+
+    QTRY_VERIFY_WITH_TIMEOUT( m_qListCovs.size() >= iNumCovs, 60000 );
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtCov::computeCov(const MatrixXd& data, const VectorXd& vecWeights) const
+{
+    //Two pass weighted covariance
+    double dN = vecWeights.sum();
+    VectorXd vecMean = data * vecWeights / dN;
+    MatrixXd matCentered = data.colwise() - vecMean;
+
+    return matCentered * vecWeights.asDiagonal() * matCentered.transpose() / (dN - 1);
+}
+
+
+//*************************************************************************************************************
+
+double TestRtCov::relativeError(const MatrixXd& matCov, const MatrixXd& matRef) const
+{
+    if(matCov.rows() != matRef.rows() || matCov.cols() != matRef.cols()) {
+        return 1.0;
+    }
+
+    return (matCov - matRef).cwiseAbs().maxCoeff() / matRef.cwiseAbs().maxCoeff();
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::compareSlidingWindow_data()
+{
+    QTest::addColumn<int>("iWindow");
+    QTest::addColumn<int>("iBlockSize");
+    QTest::addColumn<double>("dOffset");
+
+    QTest::newRow("full blocks") << 300 << 100 << 0.0;
+    QTest::newRow("partial blocks") << 250 << 70 << 0.0;
+    QTest::newRow("partial blocks with offset") << 250 << 70 << 10000.0;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::compareSlidingWindow()
+{
+    QFETCH(int, iWindow);
+    QFETCH(int, iBlockSize);
+    QFETCH(double, dOffset);
+
+    int iNumBlocks = 30;
+    MatrixXd data = MatrixXd::Random(20, iNumBlocks * iBlockSize).array() + dOffset;
+
+    m_qListCovs.clear();
+
+    RtCov rtCov(iWindow, createMiscInfo(data.rows()));
+    rtCov.setEmitInterval(iBlockSize);
+    connect(&rtCov, &RtCov::covCalculated, this, &TestRtCov::onCovCalculated);
+
+    //One covariance per block as soon as the window is filled
+    int iFirstBlock = (iWindow + iBlockSize - 1) / iBlockSize;
+    int iNumCovs = iNumBlocks - iFirstBlock + 1;
+
+    rtCov.start();
+    runCov(rtCov, data, iBlockSize, iNumCovs);
+    rtCov.stop();
+    rtCov.wait();
+
+    for(int i = 0; i < iNumCovs; ++i) {
+        int iEnd = (iFirstBlock + i) * iBlockSize;
+        MatrixXd matRef = computeCov(data.middleCols(iEnd - iWindow, iWindow), VectorXd::Ones(iWindow));
+
+        QVERIFY( relativeError(m_qListCovs[i]->data, matRef) < epsilon );
+        QVERIFY( m_qListCovs[i]->nfree == iWindow );
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::compareExponentialForgetting_data()
+{
+    QTest::addColumn<int>("iWindow");
+    QTest::addColumn<int>("iBlockSize");
+    QTest::addColumn<double>("dOffset");
+
+    QTest::newRow("no offset") << 250 << 70 << 0.0;
+    QTest::newRow("offset") << 250 << 70 << 10000.0;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::compareExponentialForgetting()
+{
+    QFETCH(int, iWindow);
+    QFETCH(int, iBlockSize);
+    QFETCH(double, dOffset);
+
+    int iNumBlocks = 30;
+    MatrixXd data = MatrixXd::Random(20, iNumBlocks * iBlockSize).array() + dOffset;
+
+    m_qListCovs.clear();
+
+    RtCov rtCov(iWindow, createMiscInfo(data.rows()));
+    rtCov.setEstimationMode(RtCov::ExponentialForgetting);
+    rtCov.setEmitInterval(iBlockSize);
+    connect(&rtCov, &RtCov::covCalculated, this, &TestRtCov::onCovCalculated);
+
+    int iFirstBlock = (iWindow + iBlockSize - 1) / iBlockSize;
+    int iNumCovs = iNumBlocks - iFirstBlock + 1;
+
+    rtCov.start();
+    runCov(rtCov, data, iBlockSize, iNumCovs);
+    rtCov.stop();
+    rtCov.wait();
+
+    for(int i = 0; i < iNumCovs; ++i) {
+        //All samples of a block are weighted with exp(-1/window) per sample since the block arrived
+        int iBlocks = iFirstBlock + i;
+        VectorXd vecWeights(iBlocks * iBlockSize);
+        for(int b = 0; b < iBlocks; ++b) {
+            vecWeights.segment(b * iBlockSize, iBlockSize).setConstant(exp(-(double)((iBlocks - 1 - b) * iBlockSize) / (double)iWindow));
+        }
+
+        MatrixXd matRef = computeCov(data.leftCols(iBlocks * iBlockSize), vecWeights);
+
+        QVERIFY( relativeError(m_qListCovs[i]->data, matRef) < epsilon );
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::compareRegularization()
+{
+    int iWindow = 400;
+    int iBlockSize = 100;
+    MatrixXd data = MatrixXd::Random(m_pFiffInfoRaw->nchan, 2 * iWindow);
+
+    QStringList exclude;
+    for(int i = 0; i < m_pFiffInfoRaw->chs.size(); ++i) {
+        if(m_pFiffInfoRaw->chs[i].kind == FIFFV_STIM_CH) {
+            exclude << m_pFiffInfoRaw->chs[i].ch_name;
+        }
+    }
+
+    m_qListCovs.clear();
+
+    RtCov rtCov(iWindow, m_pFiffInfoRaw);
+    connect(&rtCov, &RtCov::covCalculated, this, &TestRtCov::onCovCalculated);
+
+    rtCov.start();
+
+    //
+    //   First window with all projectors
+    //
+    runCov(rtCov, data.leftCols(iWindow), iBlockSize, 1);
+
+    FiffCov covRef(*m_qListCovs[0]);
+    covRef.data = computeCov(data.leftCols(iWindow), VectorXd::Ones(iWindow));
+    covRef = covRef.regularize(*m_pFiffInfoRaw, 0.05, 0.05, 0.1, true, exclude);
+
+    QVERIFY( relativeError(m_qListCovs[0]->data, covRef.data) < epsilon );
+
+    //
+    //   Second window after the projectors of the measurement info changed
+    //
+    m_pFiffInfoRaw->projs = m_pFiffInfoRaw->projs.mid(0, 1);
+
+    runCov(rtCov, data.rightCols(iWindow), iBlockSize, 2);
+    rtCov.stop();
+    rtCov.wait();
+
+    covRef = FiffCov(*m_qListCovs[1]);
+    covRef.data = computeCov(data.rightCols(iWindow), VectorXd::Ones(iWindow));
+    covRef = covRef.regularize(*m_pFiffInfoRaw, 0.05, 0.05, 0.1, true, exclude);
+
+    QVERIFY( relativeError(m_qListCovs[1]->data, covRef.data) < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtCov::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_MAIN(TestRtCov)
+#include "test_rtcov.moc"
@@ -0,0 +1,341 @@
+//=============================================================================================================
+/**
+* @file     test_rtfilter.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the real-time overlap-save filtering
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtfilter.h>
+
+#include <utils/filterTools/filterdata.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtFilter
+*
+* @brief The TestRtFilter class compares the overlap-save filtering of RtFilter against the convolution of the stream
+*
+*/
+class TestRtFilter: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtFilter();
+
+private slots:
+    void initTestCase();
+    void compareOverlapAdd();
+    void compareSeries();
+    void compareFloat();
+    void benchmarkChannels();
+    void cleanupTestCase();
+
+private:
+    MatrixXd filterOverlapAdd(const FilterData& filter, const MatrixXd& matData, int iBlockSize) const;
+    MatrixXd filterConvolution(const QList<FilterData>& lFilters, const MatrixXd& matData) const;
+    MatrixXd filterStream(RtFilter& rtFilter, const MatrixXd& matData, int iBlockSize, const QList<FilterData>& lFilters, int iMaxFilterLength) const;
+    double compareRows(const MatrixXd& matOut, const MatrixXd& matRef, const QVector<int>& lRows) const;
+
+    double epsilon;
+    double epsilonFloat;
+    double m_dSFreq;
+    int m_iBlockSize;
+
+    MatrixXd m_matData;
+    QVector<int> m_lFilterChannels;
+    QVector<int> m_lPassChannels;
+};
+
+
+//*************************************************************************************************************
+
+TestRtFilter::TestRtFilter()
+: epsilon(0.0000000001)
+, epsilonFloat(0.0001)
+, m_dSFreq(1000.0)
+, m_iBlockSize(200)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::initTestCase()
+{
+    m_matData = MatrixXd::Random(16, 10 * m_iBlockSize);
+
+    //Filter every other channel, the list is not sorted to check the channel mapping
+    for(int i = m_matData.rows() - 1; i >= 0; --i) {
+        if(i % 2 == 0) {
+            m_lFilterChannels.append(i);
+        } else {
+            m_lPassChannels.append(i);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtFilter::filterOverlapAdd(const FilterData& filter, const MatrixXd& matData, int iBlockSize) const
+{
+    //The overlap-add filtering RtFilter did before, one FFT filtered block per channel
+    const int iTaps = filter.m_dCoeffA.cols();
+
+    MatrixXd matOut(matData.rows(), matData.cols());
+    MatrixXd matOverlap = MatrixXd::Zero(matData.rows(), iTaps);
+
+    for(int b = 0; b < matData.cols(); b += iBlockSize) {
+        for(int r = 0; r < matData.rows(); ++r) {
+            RowVectorXd vecFiltered = filter.applyFFTFilter(RowVectorXd(matData.row(r).segment(b, iBlockSize)), true, FilterData::ZeroPad);
+
+            RowVectorXd vecOut = vecFiltered;
+            vecOut.head(iTaps) += matOverlap.row(r);
+
+            matOut.row(r).segment(b, iBlockSize) = vecOut.head(iBlockSize);
+            matOverlap.row(r) = vecFiltered.tail(iTaps);
+        }
+    }
+
+    return matOut;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtFilter::filterConvolution(const QList<FilterData>& lFilters, const MatrixXd& matData) const
+{
+    //Causal convolution of the whole stream, the filters are applied in series
+    MatrixXd matOut = matData;
+
+    for(int f = 0; f < lFilters.size(); ++f) {
+        const RowVectorXd& vecCoeffs = lFilters[f].m_dCoeffA;
+        MatrixXd matIn = matOut;
+        matOut.setZero();
+
+        for(int n = 0; n < matIn.cols(); ++n) {
+            for(int k = 0; k < vecCoeffs.cols() && k <= n; ++k) {
+                matOut.col(n) += vecCoeffs[k] * matIn.col(n-k);
+            }
+        }
+    }
+
+    return matOut;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtFilter::filterStream(RtFilter& rtFilter, const MatrixXd& matData, int iBlockSize, const QList<FilterData>& lFilters, int iMaxFilterLength) const
+{
+    MatrixXd matOut(matData.rows(), matData.cols());
+    MatrixXd matBlock;
+
+    for(int b = 0; b < matData.cols(); b += iBlockSize) {
+        rtFilter.filterChannelsConcurrently(matData.middleCols(b, iBlockSize), matBlock, iMaxFilterLength, m_lFilterChannels, lFilters);
+        matOut.middleCols(b, iBlockSize) = matBlock;
+    }
+
+    return matOut;
+}
+
+
+//*************************************************************************************************************
+
+double TestRtFilter::compareRows(const MatrixXd& matOut, const MatrixXd& matRef, const QVector<int>& lRows) const
+{
+    double dError = 0.0;
+    double dScale = 0.0;
+
+    for(int i = 0; i < lRows.size(); ++i) {
+        dError = qMax(dError, (matOut.row(lRows[i]) - matRef.row(lRows[i])).cwiseAbs().maxCoeff());
+        dScale = qMax(dScale, matRef.row(lRows[i]).cwiseAbs().maxCoeff());
+    }
+
+    return dError / dScale;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::compareOverlapAdd()
+{
+    FilterData filter("BPF", FilterData::BPF, 128, 20.0/(m_dSFreq/2), 20.0/(m_dSFreq/2), 5.0/(m_dSFreq/2), m_dSFreq, 1024, FilterData::Cosine);
+    int iTaps = filter.m_dCoeffA.cols();
+
+    QList<FilterData> lFilters;
+    lFilters << filter;
+
+    RtFilter rtFilter;
+    MatrixXd matOut = filterStream(rtFilter, m_matData, m_iBlockSize, lFilters, iTaps);
+
+    //Filtered channels
+    MatrixXd matRef = filterOverlapAdd(filter, m_matData, m_iBlockSize);
+    QVERIFY( compareRows(matOut, matRef, m_lFilterChannels) < epsilon );
+
+    //The other channels are delayed by half of the filter length
+    MatrixXd matDelayed = MatrixXd::Zero(m_matData.rows(), m_matData.cols());
+    matDelayed.rightCols(m_matData.cols() - iTaps/2) = m_matData.leftCols(m_matData.cols() - iTaps/2);
+    QVERIFY( compareRows(matOut, matDelayed, m_lPassChannels) < epsilon );
+
+    //A reset starts from an empty history again
+    rtFilter.reset();
+    MatrixXd matOutReset = filterStream(rtFilter, m_matData, m_iBlockSize, lFilters, iTaps);
+    QVERIFY( (matOutReset - matOut).cwiseAbs().maxCoeff() < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::compareSeries()
+{
+    FilterData filterLow("LPF", FilterData::LPF, 64, 40.0/(m_dSFreq/2), 0.0, 5.0/(m_dSFreq/2), m_dSFreq, 1024, FilterData::Cosine);
+    FilterData filterHigh("HPF", FilterData::HPF, 128, 5.0/(m_dSFreq/2), 0.0, 2.0/(m_dSFreq/2), m_dSFreq, 1024, FilterData::Cosine);
+
+    QList<FilterData> lFilters;
+    lFilters << filterLow << filterHigh;
+
+    //Blocks which are shorter than the combined kernel
+    int iBlockSize = 50;
+
+    RtFilter rtFilter;
+    MatrixXd matOut = filterStream(rtFilter, m_matData, iBlockSize, lFilters, 128);
+    MatrixXd matRef = filterConvolution(lFilters, m_matData);
+
+    QVERIFY( compareRows(matOut, matRef, m_lFilterChannels) < epsilon );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::compareFloat()
+{
+    FilterData filter("BPF", FilterData::BPF, 128, 20.0/(m_dSFreq/2), 20.0/(m_dSFreq/2), 5.0/(m_dSFreq/2), m_dSFreq, 1024, FilterData::Cosine);
+
+    QList<FilterData> lFilters;
+    lFilters << filter;
+
+    RtFilter rtFilter;
+    MatrixXd matOut(m_matData.rows(), m_matData.cols());
+    MatrixXf matBlock;
+
+    for(int b = 0; b < m_matData.cols(); b += m_iBlockSize) {
+        rtFilter.filterChannelsConcurrently(MatrixXf(m_matData.middleCols(b, m_iBlockSize).cast<float>()), matBlock, filter.m_dCoeffA.cols(), m_lFilterChannels, lFilters);
+        matOut.middleCols(b, m_iBlockSize) = matBlock.cast<double>();
+    }
+
+    MatrixXd matRef = filterConvolution(lFilters, m_matData);
+
+    QVERIFY( compareRows(matOut, matRef, m_lFilterChannels) < epsilonFloat );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::benchmarkChannels()
+{
+    //1024 channels at 5 kHz in blocks of 100 samples, with the filter length limited to the block size as in MNE Scan
+    double dSFreq = 5000.0;
+    int iBlockSize = 100;
+    int iNumBlocks = 50;
+
+    MatrixXd matBlock = MatrixXd::Random(1024, iBlockSize);
+    MatrixXd matOut;
+
+    QVector<int> lChannels;
+    for(int i = 0; i < matBlock.rows(); ++i) {
+        lChannels.append(i);
+    }
+
+    FilterData filter("BPF", FilterData::BPF, iBlockSize, 40.0/(dSFreq/2), 78.0/(dSFreq/2), 5.0/(dSFreq/2), dSFreq, 1024, FilterData::Cosine);
+
+    QList<FilterData> lFilters;
+    lFilters << filter;
+
+    RtFilter rtFilter;
+
+    //One second of data, reported against the duration of a block but not asserted since it depends on the machine
+    QElapsedTimer timer;
+    timer.start();
+
+    for(int i = 0; i < iNumBlocks; ++i) {
+        rtFilter.filterChannelsConcurrently(matBlock, matOut, iBlockSize, lChannels, lFilters);
+    }
+
+    printf("RtFilter: %f ms per block of %f ms\n", (double)timer.elapsed() / iNumBlocks, 1000.0 * iBlockSize / dSFreq);
+
+    QBENCHMARK {
+        rtFilter.filterChannelsConcurrently(matBlock, matOut, iBlockSize, lChannels, lFilters);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtFilter)
+#include "test_rtfilter.moc"
@@ -0,0 +1,248 @@
+//=============================================================================================================
+/**
+* @file     test_rtinvop.cpp
+* @author   Lorenz Esch <lorenz.esch@tu-ilmenau.de>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the incremental update of the real-time inverse operator
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtinvop.h>
+
+#include <mne/mne_inverse_operator.h>
+#include <mne/mne_forwardsolution.h>
+
+#include <fiff/fiff_raw_data.h>
+#include <fiff/fiff_info.h>
+#include <fiff/fiff_cov.h>
+
+#include <limits>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Exposes the inverse operator update of RtInvOp.
+*/
+class RtInvOpUpdate : public RtInvOp
+{
+public:
+    RtInvOpUpdate(FiffInfo::SPtr &p_pFiffInfo, MNEForwardSolution::SPtr &p_pFwd)
+    : RtInvOp(p_pFiffInfo, p_pFwd)
+    {
+    }
+
+    using RtInvOp::updateInvOp;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtInvOp
+*
+* @brief The TestRtInvOp class compares the incrementally updated inverse operators of RtInvOp against fully
+* computed ones
+*
+*/
+class TestRtInvOp: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtInvOp();
+
+private slots:
+    void initTestCase();
+    void compareUpdate();
+    void cleanupTestCase();
+
+private:
+    bool compareInvOp(const MNEInverseOperator& inv, const MNEInverseOperator& ref) const;
+
+    double epsilon;
+
+    FiffInfo::SPtr m_pFiffInfo;
+    MNEForwardSolution::SPtr m_pFwd;
+    FiffCov m_noiseCov;
+};
+
+
+//*************************************************************************************************************
+
+TestRtInvOp::TestRtInvOp()
+: epsilon(0.000001)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtInvOp::initTestCase()
+{
+    QFile t_fileRaw("./MNE-sample-data/MEG/sample/sample_audvis_raw.fif");
+    QFile t_fileFwd("./MNE-sample-data/MEG/sample/sample_audvis-meg-eeg-oct-6-fwd.fif");
+    QFile t_fileCov("./MNE-sample-data/MEG/sample/sample_audvis-cov.fif");
+
+    FiffRawData raw(t_fileRaw);
+    m_pFiffInfo = FiffInfo::SPtr(new FiffInfo(raw.info));
+    m_pFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(t_fileFwd, false, true));
+    m_noiseCov = FiffCov(t_fileCov);
+
+    QVERIFY( m_pFiffInfo->nchan > 0 );
+    QVERIFY( !m_pFwd->isEmpty() );
+    QVERIFY( m_noiseCov.dim > 0 );
+}
+
+
+//*************************************************************************************************************
+
+void TestRtInvOp::compareUpdate()
+{
+    RtInvOpUpdate rtInvOp(m_pFiffInfo, m_pFwd);
+
+    //Same channel selection as in RtInvOp::run
+    MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
+
+    //The first covariance runs the full computation
+    MNEInverseOperator::SPtr pInvOpFirst = rtInvOp.updateInvOp(t_forwardMeg, m_noiseCov);
+    MNEInverseOperator invOpFirstRef(*m_pFiffInfo.data(), t_forwardMeg, m_noiseCov, 0.2f, 0.8f);
+    QVERIFY( compareInvOp(*pInvOpFirst, invOpFirstRef) );
+
+    //A differently regularized covariance changes the whitener per channel type and is updated incrementally
+    FiffCov t_noiseCovReg = m_noiseCov.regularize(*m_pFiffInfo.data(), 0.2, 0.05, 0.1, true);
+
+    MNEInverseOperator::SPtr pInvOpReg = rtInvOp.updateInvOp(t_forwardMeg, t_noiseCovReg);
+    MNEInverseOperator invOpRegRef(*m_pFiffInfo.data(), t_forwardMeg, t_noiseCovReg, 0.2f, 0.8f);
+    QVERIFY( compareInvOp(*pInvOpReg, invOpRegRef) );
+
+    //Going back to the first covariance from the cached gain
+    MNEInverseOperator::SPtr pInvOpBack = rtInvOp.updateInvOp(t_forwardMeg, m_noiseCov);
+    QVERIFY( compareInvOp(*pInvOpBack, invOpFirstRef) );
+}
+
+
+//*************************************************************************************************************
+
+bool TestRtInvOp::compareInvOp(const MNEInverseOperator& inv, const MNEInverseOperator& ref) const
+{
+    if(inv.sing.size() != ref.sing.size() || ref.sing.size() == 0
+            || inv.eigen_fields->data.rows() != ref.eigen_fields->data.rows()
+            || inv.eigen_fields->data.cols() != ref.eigen_fields->data.cols()
+            || inv.eigen_leads->data.rows() != ref.eigen_leads->data.rows()
+            || inv.eigen_leads->data.cols() != ref.eigen_leads->data.cols()) {
+        return false;
+    }
+
+    double dSingMax = ref.sing[0];
+
+    if((inv.sing - ref.sing).cwiseAbs().maxCoeff() > epsilon * dSingMax) {
+        return false;
+    }
+
+    //Source covariance including the scaling which makes trace(G*R*G') equal the rank
+    if((inv.source_cov->data - ref.source_cov->data).cwiseAbs().maxCoeff() > epsilon * ref.source_cov->data.cwiseAbs().maxCoeff()) {
+        return false;
+    }
+
+    //The singular vectors are only unique up to their sign, and only if the singular value is well separated
+    int iNumCompared = 0;
+
+    for(int i = 0; i < ref.sing.size(); ++i) {
+        double dSing2 = ref.sing[i] * ref.sing[i];
+        double dGap = std::numeric_limits<double>::max();
+        if(i > 0) {
+            dGap = qMin(dGap, ref.sing[i-1] * ref.sing[i-1] - dSing2);
+        }
+        if(i < ref.sing.size() - 1) {
+            dGap = qMin(dGap, dSing2 - ref.sing[i+1] * ref.sing[i+1]);
+        }
+
+        if(ref.sing[i] < 0.001 * dSingMax || dGap < 0.000001 * dSingMax * dSingMax) {
+            continue;
+        }
+
+        VectorXd vecField = inv.eigen_fields->data.row(i).transpose();
+        VectorXd vecFieldRef = ref.eigen_fields->data.row(i).transpose();
+        double dSign = vecField.dot(vecFieldRef) < 0.0 ? -1.0 : 1.0;
+
+        if((dSign * vecField - vecFieldRef).norm() > epsilon * vecFieldRef.norm()) {
+            return false;
+        }
+
+        //The eigen leads flip together with the eigen fields
+        if((dSign * inv.eigen_leads->data.col(i) - ref.eigen_leads->data.col(i)).norm() > epsilon * ref.eigen_leads->data.col(i).norm()) {
+            return false;
+        }
+
+        ++iNumCompared;
+    }
+
+    return iNumCompared > 10;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtInvOp::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtInvOp)
+#include "test_rtinvop.moc"
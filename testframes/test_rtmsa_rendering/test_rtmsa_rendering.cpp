@@ -0,0 +1,304 @@
+//=============================================================================================================
+/**
+* @file     test_rtmsa_rendering.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    The real-time multi sample array rendering test and benchmark
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <scDisp/helpers/realtimemultisamplearraymodel.h>
+#include <scDisp/helpers/realtimemultisamplearraydelegate.h>
+#include <scMeas/realtimesamplearraychinfo.h>
+#include <fiff/fiff_info.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QImage>
+#include <QPainter>
+#include <QStyleOptionViewItem>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCDISPLIB;
+using namespace SCMEASLIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtmsaRendering
+*
+* @brief The TestRtmsaRendering class verifies the min/max pyramid of the RealTimeMultiSampleArrayModel and
+*        compares the frame rate of the decimated and the full resolution plot paths.
+*
+*/
+class TestRtmsaRendering : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtmsaRendering();
+
+private slots:
+    void initTestCase();
+    void testMinMaxPyramid();
+    void benchmarkRendering();
+    void cleanupTestCase();
+
+private:
+    double renderFrames(RealTimeMultiSampleArrayModel& model, RealTimeMultiSampleArrayDelegate& delegate, int iNumFrames);
+    void initModel(RealTimeMultiSampleArrayModel& model);
+
+    FiffInfo::SPtr              m_pFiffInfo;
+    QList<RealTimeSampleArrayChInfo> m_qListChInfo;
+    QList<MatrixXd>             m_qListBlocks;
+
+    int                         m_iNumChannels;
+    int                         m_iBlockSize;
+    int                         m_iNumFrames;
+    float                       m_fSFreq;
+    int                         m_iWindowSize;
+    int                         m_iImageWidth;
+    int                         m_iRowHeight;
+};
+
+
+//*************************************************************************************************************
+
+TestRtmsaRendering::TestRtmsaRendering()
+: m_iNumChannels(400)
+, m_iBlockSize(500)
+, m_iNumFrames(20)
+, m_fSFreq(5000.0f)
+, m_iWindowSize(10)
+, m_iImageWidth(1920)
+, m_iRowHeight(20)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtmsaRendering::initTestCase()
+{
+    m_pFiffInfo = FiffInfo::SPtr(new FiffInfo());
+    m_pFiffInfo->sfreq = m_fSFreq;
+
+    for(int i = 0; i < m_iNumChannels; ++i) {
+        FiffChInfo t_chInfo;
+        t_chInfo.kind = FIFFV_MEG_CH;
+        t_chInfo.unit = FIFF_UNIT_T_M;
+        t_chInfo.ch_name = QString("MEG %1").arg(i, 4, 10, QChar('0'));
+        m_pFiffInfo->chs.append(t_chInfo);
+        m_pFiffInfo->ch_names.append(t_chInfo.ch_name);
+
+        RealTimeSampleArrayChInfo t_rtChInfo;
+        t_rtChInfo.setChannelName(t_chInfo.ch_name);
+        t_rtChInfo.setKind(t_chInfo.kind);
+        t_rtChInfo.setUnit(t_chInfo.unit);
+        m_qListChInfo.append(t_rtChInfo);
+    }
+    m_pFiffInfo->nchan = m_iNumChannels;
+
+    //Noisy oscillations with a few large spikes, so every pixel column has a distinct envelope
+    qsrand(42);
+    int iNumBlocks = (int)(m_fSFreq * m_iWindowSize) / m_iBlockSize + m_iNumFrames;
+    for(int b = 0; b < iNumBlocks; ++b) {
+        MatrixXd t_matBlock(m_iNumChannels, m_iBlockSize);
+        for(int s = 0; s < m_iBlockSize; ++s) {
+            double t = (b * m_iBlockSize + s) / m_fSFreq;
+            for(int c = 0; c < m_iNumChannels; ++c) {
+                double dNoise = (double)qrand() / RAND_MAX - 0.5;
+                t_matBlock(c, s) = 1e-11 * (sin(2.0 * M_PI * (5.0 + c % 20) * t) + 0.3 * dNoise);
+            }
+        }
+        t_matBlock(b % m_iNumChannels, b % m_iBlockSize) += 1e-10;
+        m_qListBlocks.append(t_matBlock);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtmsaRendering::initModel(RealTimeMultiSampleArrayModel& model)
+{
+    model.setFiffInfo(m_pFiffInfo);
+    model.setChannelInfo(m_qListChInfo);
+    model.setSamplingInfo(m_fSFreq, m_iWindowSize);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtmsaRendering::testMinMaxPyramid()
+{
+    RealTimeMultiSampleArrayModel model;
+    initModel(model);
+
+    //Fill the window and wrap around once so the pyramid is updated across the buffer boundary
+    int iNumBlocks = (int)(m_fSFreq * m_iWindowSize) / m_iBlockSize + m_iBlockSize / 100;
+    for(int b = 0; b < iNumBlocks; ++b) {
+        model.addData(QList<MatrixXd>() << m_qListBlocks[b % m_qListBlocks.size()]);
+    }
+
+    QVERIFY(model.getNumMinMaxLevels() > 0);
+
+    QList<int> t_qListRows;
+    t_qListRows << 0 << m_iNumChannels / 2 << m_iNumChannels - 1;
+
+    for(int r : t_qListRows) {
+        RowVectorPair t_data = model.data(model.index(r, 1), Qt::DisplayRole).value<RowVectorPair>();
+        QVERIFY(t_data.second > 0);
+
+        for(int l = 0; l < model.getNumMinMaxLevels(); ++l) {
+            MinMaxRowPair t_minMax = model.getMinMaxRow(r, l);
+            QVERIFY(t_minMax.first != 0 && t_minMax.second != 0);
+
+            int iBucketSize = RealTimeMultiSampleArrayModel::getMinMaxBucketSize(l);
+            int iNumBuckets = t_data.second / iBucketSize;
+
+            for(int k = 0; k < iNumBuckets; ++k) {
+                float fMin = (float)t_data.first[k * iBucketSize];
+                float fMax = fMin;
+                for(int s = k * iBucketSize + 1; s < (k + 1) * iBucketSize; ++s) {
+                    fMin = qMin(fMin, (float)t_data.first[s]);
+                    fMax = qMax(fMax, (float)t_data.first[s]);
+                }
+                QCOMPARE(t_minMax.first[k], fMin);
+                QCOMPARE(t_minMax.second[k], fMax);
+            }
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+double TestRtmsaRendering::renderFrames(RealTimeMultiSampleArrayModel& model,
+                                        RealTimeMultiSampleArrayDelegate& delegate,
+                                        int iNumFrames)
+{
+    QImage t_image(m_iImageWidth + 20, m_iNumChannels * m_iRowHeight, QImage::Format_ARGB32_Premultiplied);
+    int iOffset = (int)(m_fSFreq * m_iWindowSize) / m_iBlockSize;
+
+    QElapsedTimer t_timer;
+    t_timer.start();
+
+    for(int f = 0; f < iNumFrames; ++f) {
+        model.addData(QList<MatrixXd>() << m_qListBlocks[iOffset + f]);
+
+        t_image.fill(Qt::white);
+        QPainter t_painter(&t_image);
+
+        for(int r = 0; r < m_iNumChannels; ++r) {
+            QStyleOptionViewItem t_option;
+            t_option.rect = QRect(20, r * m_iRowHeight, m_iImageWidth, m_iRowHeight);
+            delegate.paint(&t_painter, t_option, model.index(r, 1));
+        }
+    }
+
+    qint64 iElapsed = t_timer.elapsed();
+
+    return iElapsed > 0 ? 1000.0 * iNumFrames / iElapsed : 0.0;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtmsaRendering::benchmarkRendering()
+{
+    double dFps[2];
+
+    for(int i = 0; i < 2; ++i) {
+        RealTimeMultiSampleArrayModel model;
+        initModel(model);
+
+        //Fill the whole window before measuring
+        int iNumBlocks = (int)(m_fSFreq * m_iWindowSize) / m_iBlockSize;
+        for(int b = 0; b < iNumBlocks; ++b) {
+            model.addData(QList<MatrixXd>() << m_qListBlocks[b]);
+        }
+
+        RealTimeMultiSampleArrayDelegate delegate;
+        delegate.setMinMaxDecimation(i == 0);
+        delegate.initPainterPaths(&model);
+
+        dFps[i] = renderFrames(model, delegate, m_iNumFrames);
+    }
+
+    qDebug() << "[TestRtmsaRendering] channels:" << m_iNumChannels
+             << "samples per row:" << (int)(m_fSFreq * m_iWindowSize)
+             << "width:" << m_iImageWidth;
+    qDebug() << "[TestRtmsaRendering] min/max decimation:" << dFps[0] << "fps";
+    qDebug() << "[TestRtmsaRendering] full resolution:" << dFps[1] << "fps";
+
+    QVERIFY(dFps[0] > 0.0);
+    QVERIFY(dFps[0] >= dFps[1]);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtmsaRendering::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_MAIN(TestRtmsaRendering)
+#include "test_rtmsa_rendering.moc"
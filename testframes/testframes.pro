@@ -46,11 +46,27 @@ SUBDIRS += \
     test_fiff_cov \
     test_fiff_digitizer \
     test_mne_msh_display_surface_set \
+    test_circularmatrixbuffer \
+    test_hpi_fit \
+    test_fwd_sphere_field \
+    test_fwd_bem_solution \
+    test_fwd_compute_forward \
+    test_minimum_norm \
+    test_rap_music \
+    test_network_adjacency \
+    test_connectivity_measures \
+    test_guess_data \
+    test_rtave \
+    test_rtinvop \
+    test_rtcov \
+    test_iir_filter \
+    test_rtfilter \
 
 !contains(MNECPP_CONFIG, minimalVersion) {
     qtHaveModule(charts) {
         SUBDIRS += \
             test_interpolation \
             test_geometryinfo \
+            test_rtmsa_rendering \
     }
 }